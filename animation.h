@@ -0,0 +1,41 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include "cglm/types.h"
+
+// Every this many steps animate_spins also renormalizes the rotations
+#define ANIMATION_RENORMALIZE 64
+
+// Animation of many instances as a stage of whole arrays, run before any
+// drawing so that the math goes through the batch kernels of simd.h
+// instead of being spread over the draw loop one object at a time.
+
+// Turns rotations by their spins, a unit axis and a speed in radians per
+// millisecond, over time milliseconds. Step counts the calls; every
+// ANIMATION_RENORMALIZE-th one pulls the rotations back to unit length.
+void animate_spins(versor* rotations, vec4* spins, float time, unsigned step, unsigned count);
+
+#endif // ANIMATION_H
@@ -0,0 +1,453 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SDL_MAIN_HANDLED
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_main.h>
+#include "cglm/affine.h"
+#include "cglm/box.h"
+#include "cglm/cam.h"
+#include "cglm/frustum.h"
+#include "cglm/quat.h"
+#include "common.h"
+#include "mesh_buffer.h"
+#include "static_batch.h"
+#include "texture_manager.h"
+
+#define OBJECTS_X 128
+#define OBJECTS_Z 128
+#define OBJECTS_COUNT (OBJECTS_X * OBJECTS_Z)
+#define PRISMS_COUNT 3
+#define MESHES_COUNT (PRISMS_COUNT + 1)
+#define MATERIALS_COUNT (sizeof(material_files) / sizeof(material_files[0]))
+#define PRISM_MAX_SIDES 24
+#define PRISM_MAX_VERTICES (PRISM_MAX_SIDES * 6 + 2)
+#define PRISM_MAX_INDICES (PRISM_MAX_SIDES * 12)
+#define CHUNK_SIZE 16.0f
+
+static const float cube_vertices[] =
+{
+	// Position				| Normal				| Tex Coord
+	// Front
+	 0.5f,  0.5f,  0.5f,	 0.0f,  0.0,  1.0,		1.0f, 1.0f,		//   0 RU
+	 0.5f, -0.5f,  0.5f,	 0.0f,  0.0,  1.0,		1.0f, 0.0f,		//   1 RD
+	-0.5f, -0.5f,  0.5f,	 0.0f,  0.0,  1.0,		0.0f, 0.0f,		//   2 LD
+	-0.5f,  0.5f,  0.5f,	 0.0f,  0.0,  1.0,		0.0f, 1.0f,		//   3 LU
+
+	// Back
+	-0.5f,  0.5f, -0.5f,	 0.0f,  0.0, -1.0,		1.0f, 1.0f,		//   4 RU
+	-0.5f, -0.5f, -0.5f,	 0.0f,  0.0, -1.0,		1.0f, 0.0f,		//   5 RD
+	 0.5f, -0.5f, -0.5f,	 0.0f,  0.0, -1.0,		0.0f, 0.0f,		//   6 LD
+	 0.5f,  0.5f, -0.5f,	 0.0f,  0.0, -1.0,		0.0f, 1.0f,		//   7 LU
+
+	// Top
+	 0.5f,  0.5f, -0.5f,	 0.0f,  1.0,  0.0,		1.0f, 1.0f,		//   8 RU
+	 0.5f,  0.5f,  0.5f,	 0.0f,  1.0,  0.0,		1.0f, 0.0f,		//   9 RD
+	-0.5f,  0.5f,  0.5f,	 0.0f,  1.0,  0.0,		0.0f, 0.0f,		//  10 LD
+	-0.5f,  0.5f, -0.5f,	 0.0f,  1.0,  0.0,		0.0f, 1.0f,		//  11 LU
+
+	// Bottom
+	 0.5f, -0.5f,  0.5f,	 0.0f, -1.0,  0.0,		1.0f, 1.0f,		//  12 RU
+	 0.5f, -0.5f, -0.5f,	 0.0f, -1.0,  0.0,		1.0f, 0.0f,		//  13 RD
+	-0.5f, -0.5f, -0.5f,	 0.0f, -1.0,  0.0,		0.0f, 0.0f,		//  14 LD
+	-0.5f, -0.5f,  0.5f,	 0.0f, -1.0,  0.0,		0.0f, 1.0f,		//  15 LU
+
+	// Left
+	-0.5f,  0.5f,  0.5f,	-1.0f,  0.0,  0.0,		1.0f, 1.0f,		//  16 LU
+	-0.5f, -0.5f,  0.5f,	-1.0f,  0.0,  0.0,		1.0f, 0.0f,		//  17 LD
+	-0.5f, -0.5f, -0.5f,	-1.0f,  0.0,  0.0,		0.0f, 0.0f,		//  18 RD
+	-0.5f,  0.5f, -0.5f,	-1.0f,  0.0,  0.0,		0.0f, 1.0f,		//  19 RU
+
+	// Right
+	 0.5f,  0.5f, -0.5f,	 1.0f,  0.0,  0.0,		1.0f, 1.0f,		//   4 RU
+	 0.5f, -0.5f, -0.5f,	 1.0f,  0.0,  0.0,		1.0f, 0.0f,		//   5 RD
+	 0.5f, -0.5f,  0.5f,	 1.0f,  0.0,  0.0,		0.0f, 0.0f,		//   1 RD
+	 0.5f,  0.5f,  0.5f,	 1.0f,  0.0,  0.0,		0.0f, 1.0f		//   0 RU
+};
+
+static const unsigned cube_indices[] =
+{
+	 0,  1,  2,  2,  3,  0,	// Front
+	 4,  5,  6,  6,  7,  4,	// Back
+	 8,  9, 10, 10, 11,  8,	// Top
+	12, 13, 14, 14, 15, 12,	// Bottom
+	16, 17, 18, 18, 19, 16,	// Left
+	20, 21, 22, 22, 23, 20	// Right
+};
+
+static const unsigned prism_sides[PRISMS_COUNT] = { 3, 6, PRISM_MAX_SIDES };
+
+static const char* material_files[][2] =
+{
+	{ "data/textures/crate_diffuse.tex", "data/textures/crate_specular.tex" },
+	{ "data/textures/crate_dark_diffuse.tex", "data/textures/crate_dark_specular.tex" },
+	{ "data/textures/crate_painted_diffuse.tex", "data/textures/crate_painted_specular.tex" }
+};
+
+int main(int argc, char** argv)
+{
+	// =====================================
+	// Initialisation
+	// =====================================
+	// SDL
+
+	if (SDL_Init(SDL_INIT_VIDEO) < 0)
+	{
+		error("SDL Error", SDL_GetError());
+		return 1;
+	}
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_Window* window = SDL_CreateWindow("OpenGL Tutorial 15",
+										  SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+										  1024, 768, SDL_WINDOW_OPENGL);
+	if (!window)
+	{
+		error("SDL Error", SDL_GetError());
+		SDL_Quit();
+		return 1;
+	}
+	SDL_GLContext context = SDL_GL_CreateContext(window);
+	if (!context)
+	{
+		error("SDL Error", SDL_GetError());
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	SDL_ShowCursor(SDL_DISABLE);
+	SDL_SetRelativeMouseMode(SDL_TRUE);
+
+	// GLEW
+	glewExperimental = GL_TRUE;
+	if (glewInit() != GLEW_OK)
+	{
+		error("GLEW Error", glewGetErrorString(glGetError()));
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// OpenGL
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_CULL_FACE);
+	glCullFace(GL_BACK);
+	glFrontFace(GL_CW);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+	// Pass -unbatched to draw every object on its own for comparison
+	const int batched = !(argc > 1 && !strcmp(argv[1], "-unbatched"));
+
+	// Meshes
+	// The source meshes stay on the CPU as well, the batcher copies them
+	unsigned i;
+	float* mesh_vertices[MESHES_COUNT];
+	unsigned* mesh_indices[MESHES_COUNT];
+	unsigned mesh_vertices_count[MESHES_COUNT];
+	unsigned mesh_indices_count[MESHES_COUNT];
+	struct mesh_buffer meshes;
+	if (!create_mesh_buffer(&meshes, 24 + PRISMS_COUNT * PRISM_MAX_VERTICES, 36 + PRISMS_COUNT * PRISM_MAX_INDICES, MESHES_COUNT))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	mesh_vertices[0] = (float*)cube_vertices;
+	mesh_indices[0] = (unsigned*)cube_indices;
+	mesh_vertices_count[0] = sizeof(cube_vertices) / sizeof(float) / MESH_VERTEX_FLOATS;
+	mesh_indices_count[0] = sizeof(cube_indices) / sizeof(unsigned);
+	for (i = 1; i < MESHES_COUNT; ++i)
+	{
+		mesh_vertices[i] = (float*)malloc(PRISM_MAX_VERTICES * MESH_VERTEX_FLOATS * sizeof(float));
+		mesh_indices[i] = (unsigned*)malloc(PRISM_MAX_INDICES * sizeof(unsigned));
+		build_prism_mesh(mesh_vertices[i], &mesh_vertices_count[i], mesh_indices[i], &mesh_indices_count[i], prism_sides[i - 1]);
+	}
+	int success = 1;
+	for (i = 0; i < MESHES_COUNT && success; ++i)
+		success = add_mesh(&meshes, mesh_vertices[i], mesh_vertices_count[i], mesh_indices[i], mesh_indices_count[i]) >= 0;
+	if (!success)
+	{
+		destroy_mesh_buffer(&meshes);
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Shader
+	const unsigned program = create_program("data/shaders/15_batching");
+	if (!program)
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Textures
+	struct texture_array diffuse_array, specular_array;
+	create_texture_array(&diffuse_array, MATERIALS_COUNT);
+	create_texture_array(&specular_array, MATERIALS_COUNT);
+	for (i = 0; i < MATERIALS_COUNT; ++i)
+		if (add_texture_layer(&diffuse_array, material_files[i][0]) != (int)i ||
+			add_texture_layer(&specular_array, material_files[i][1]) != (int)i)
+		{
+			destroy_texture_array(&specular_array);
+			destroy_texture_array(&diffuse_array);
+			SDL_GL_DeleteContext(context);
+			SDL_DestroyWindow(window);
+			SDL_Quit();
+			return 1;
+		}
+
+	// Shader Uniforms
+	const int uniform_viewproj = glGetUniformLocation(program, "cViewProj");
+	const int uniform_view_pos = glGetUniformLocation(program, "cViewPos");
+	const int uniform_model = glGetUniformLocation(program, "cModel");
+	const int uniform_material = glGetUniformLocation(program, "cMaterial");
+
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "sDiffuse"), 0);
+	glUniform1i(glGetUniformLocation(program, "sSpecular"), 1);
+	glUniform1f(glGetUniformLocation(program, "cShininess"), 32.0f);
+	glUniform3f(glGetUniformLocation(program, "cAmbientColor"), 0.2f, 0.2f, 0.2f);
+	glUniform3f(glGetUniformLocation(program, "cLight.direction"), -0.2f, -1.0f, -0.3f);
+	glUniform3f(glGetUniformLocation(program, "cLight.diffuse"), 1.0f, 0.8f, 0.6f);
+	glUniform3f(glGetUniformLocation(program, "cLight.specular"), 0.5f, 0.5f, 0.5f);
+	glUseProgram(0);
+
+	if (!validate_gl("Shader Uniforms Error"))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// =====================================
+	// Scene
+	// =====================================
+	// Objects
+	// None of the objects ever moves, so the batcher bakes them into world
+	// space once. The transforms are kept for the unbatched path only.
+	struct static_instance* instances = (struct static_instance*)malloc(OBJECTS_COUNT * sizeof(struct static_instance));
+	vec3 (*boxes)[2] = (vec3(*)[2])malloc(OBJECTS_COUNT * sizeof(vec3[2]));
+	unsigned* object_meshes = (unsigned*)malloc(OBJECTS_COUNT * sizeof(unsigned));
+	vec3 unit_box[2] = { { -0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, 0.5f } };
+	vec3 position, axis = { 0.0f, 1.0f, 0.0f };
+	unsigned mesh;
+	float scale;
+
+	for (i = 0; i < OBJECTS_COUNT; ++i)
+	{
+		mesh = (unsigned)rand() % MESHES_COUNT;
+		object_meshes[i] = mesh;
+		position[0] = ((float)(i % OBJECTS_X) - OBJECTS_X * 0.5f) * 2.0f;
+		position[1] = (float)(rand() % 100) * 0.01f - 2.0f;
+		position[2] = -(float)(i / OBJECTS_X) * 2.0f - 2.0f;
+		scale = 0.5f + (float)(rand() % 100) * 0.005f;
+		glm_translate_make(instances[i].transform, position);
+		glm_rotate(instances[i].transform, (float)(rand() % 360) * GLM_PIf / 180.0f, axis);
+		glm_scale_uni(instances[i].transform, scale);
+		glm_aabb_transform(unit_box, instances[i].transform, boxes[i]);
+		instances[i].vertices = mesh_vertices[mesh];
+		instances[i].indices = mesh_indices[mesh];
+		instances[i].vertices_count = mesh_vertices_count[mesh];
+		instances[i].indices_count = mesh_indices_count[mesh];
+		instances[i].material = (unsigned)rand() % MATERIALS_COUNT;
+	}
+
+	// Static Batch
+	struct static_batch batch;
+	Uint64 build_start = SDL_GetPerformanceCounter();
+	if (!build_static_batch(&batch, instances, OBJECTS_COUNT, CHUNK_SIZE))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+	const double build_time = (double)(SDL_GetPerformanceCounter() - build_start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+	for (i = 1; i < MESHES_COUNT; ++i)
+	{
+		free(mesh_indices[i]);
+		free(mesh_vertices[i]);
+	}
+
+	// Camera
+	vec3 camera_position = { 0.0f, 0.0f, 3.0f };
+	vec3 camera_direction;
+	vec3 camera_up;
+	versor camera_rotation = GLM_QUAT_IDENTITY_INIT;
+
+	// =====================================
+	// Rendering
+	// =====================================
+	// Matrices
+	mat4 view, viewproj;
+	mat4 identity = GLM_MAT4_IDENTITY_INIT;
+	vec4 planes[6];
+
+	// Projection Matrix
+	mat4 proj;
+	glm_perspective(glm_rad(45.0f), 1024.0f / 768.0f, 0.01f, 300.0f, proj);
+
+	// Textures
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, diffuse_array.texture);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, specular_array.texture);
+	glActiveTexture(GL_TEXTURE0);
+
+	// Statistics
+	char title[256];
+	const struct mesh* draw_mesh;
+	unsigned draws = 0;
+	unsigned unbatched_draws;
+	Uint64 submit_start;
+	Uint64 submit_time = 0;
+	unsigned frames = 0;
+	float title_time = 0.0f;
+
+	int run = 1;
+	float tick_delta;
+	float tick_curr;
+	float tick_prev = 0.0f;
+	unsigned short controls = 0;
+	while (run)
+	{
+		tick_curr = (float)SDL_GetTicks();
+		tick_delta = tick_curr - tick_prev;
+		process_events(camera_position, camera_direction, camera_rotation, &controls, &run, tick_delta);
+		tick_prev = tick_curr;
+
+		// =================================
+		// Camera
+		// =================================
+		// Look
+		glm_quat_rotatev(camera_rotation, GLM_FORWARD, camera_direction);
+
+		// View Matrix
+		glm_quat_rotatev(camera_rotation, GLM_YUP, camera_up);
+		glm_look(camera_position, camera_direction, camera_up, view);
+
+		// View and Projection Matrix
+		glm_mat4_mul_sse2(proj, view, viewproj);
+		glm_frustum_planes(viewproj, planes);
+
+		// Rendering
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		submit_start = SDL_GetPerformanceCounter();
+		glUseProgram(program);
+		glUniformMatrix4fv(uniform_viewproj, 1, GL_FALSE, viewproj[0]);
+		glUniform3fv(uniform_view_pos, 1, camera_position);
+		if (batched)
+		{
+			// Batched vertices are already in world space
+			glUniformMatrix4fv(uniform_model, 1, GL_FALSE, identity[0]);
+			glBindVertexArray(batch.meshes.vao);
+			draws = draw_static_batch(&batch, planes, uniform_material);
+		}
+		else
+		{
+			glBindVertexArray(meshes.vao);
+			for (i = 0, draws = 0; i < OBJECTS_COUNT; ++i)
+			{
+				if (!glm_aabb_frustum(boxes[i], planes))
+					continue;
+				draw_mesh = &meshes.meshes[object_meshes[i]];
+				glUniformMatrix4fv(uniform_model, 1, GL_FALSE, instances[i].transform[0]);
+				glUniform1ui(uniform_material, instances[i].material);
+				glDrawElementsBaseVertex(GL_TRIANGLES, (int)draw_mesh->index_count, GL_UNSIGNED_INT,
+										 (void*)(draw_mesh->first_index * sizeof(unsigned)), draw_mesh->base_vertex);
+				++draws;
+			}
+		}
+		glBindVertexArray(0);
+		glUseProgram(0);
+		submit_time += SDL_GetPerformanceCounter() - submit_start;
+
+		// Statistics
+		++frames;
+		title_time += tick_delta;
+		if (title_time >= 1000.0f)
+		{
+			// Draws the same view would take one object at a time
+			for (i = 0, unbatched_draws = 0; i < OBJECTS_COUNT; ++i)
+				unbatched_draws += glm_aabb_frustum(boxes[i], planes);
+			snprintf(title, sizeof(title), "OpenGL Tutorial 15: %u objects, %u draws unbatched, %u of %u chunks %s, %.1f ms build, %.1f us submit",
+					 OBJECTS_COUNT, unbatched_draws, batched ? draws : 0, batch.chunks_count, batched ? "drawn" : "unused", build_time,
+					 (double)submit_time * 1000000.0 / (double)SDL_GetPerformanceFrequency() / frames);
+			SDL_SetWindowTitle(window, title);
+			submit_time = 0;
+			frames = 0;
+			title_time = 0.0f;
+		}
+
+		if (validate_gl("Open GL Rendering Error"))
+			SDL_GL_SwapWindow(window);
+		else
+			run = 0;
+	}
+
+	// =====================================
+	// Destruction
+	// =====================================
+	// Scene
+	free(object_meshes);
+	free(boxes);
+	free(instances);
+
+	// Texture
+	destroy_texture_array(&specular_array);
+	destroy_texture_array(&diffuse_array);
+
+	// Shader
+	glDeleteProgram(program);
+
+	// Vertex Buffers
+	destroy_static_batch(&batch);
+	destroy_mesh_buffer(&meshes);
+
+	// SDL
+	SDL_GL_DeleteContext(context);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+
+	return 0;
+}
+
+__declspec(dllexport) unsigned NvOptimusEnablement = 1;
+__declspec(dllexport) int AmdPowerXpressRequestHighPerformance = 1;
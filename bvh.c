@@ -0,0 +1,960 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL_atomic.h>
+#include "cglm/vec3.h"
+#include "bvh.h"
+#include "jobs.h"
+
+#define TRAVERSAL_COST 1.0f
+#define MAX_SAH_DEPTH 64
+#define STACK_SIZE 128
+#define CHUNK_SIZE 16384
+#define SLOTS_PER_JOB 4096
+#define OUTSIDE 0x40u
+
+struct bin
+{
+	vec3 min;
+	unsigned count;
+	vec3 max;
+};
+
+// Objects are moved around during the build with their boxes, every pass
+// over a range reads memory in order
+struct build_object
+{
+	vec3 min;
+	unsigned object;
+	vec3 max;
+	unsigned padding;
+};
+
+// Boxes of the objects of a range and of their centroids
+struct range_bounds
+{
+	vec3 min;
+	vec3 max;
+	vec3 centroid_min;
+	vec3 centroid_max;
+};
+
+// Bounds of both children come out of the partition of their parent.
+// Children is ~0u once the range became a leaf. Next is the first free
+// node of the block reserved for a subtree.
+struct build_range
+{
+	struct range_bounds bounds;
+	struct range_bounds child_bounds[2];
+	unsigned node;
+	unsigned first;
+	unsigned count;
+	unsigned depth;
+	unsigned children;
+	unsigned left_count;
+	unsigned next;
+};
+
+struct build_job
+{
+	struct bvh* bvh;
+	vec3 (*boxes)[2];
+	struct build_object* objects;
+	struct build_range* ranges;
+	struct range_bounds* chunk_bounds;
+	struct bin (*chunk_bins)[3][BVH_BINS];
+	const struct range_bounds* bounds;
+	unsigned first;
+	unsigned count;
+	SDL_atomic_t nodes_count;
+};
+
+struct refit_job
+{
+	struct bvh* bvh;
+	vec3 (*boxes)[2];
+};
+
+// =====================================
+// Build
+// =====================================
+static void reset_bounds(struct range_bounds* bounds)
+{
+	glm_vec3_fill(bounds->min, FLT_MAX);
+	glm_vec3_fill(bounds->max, -FLT_MAX);
+	glm_vec3_fill(bounds->centroid_min, FLT_MAX);
+	glm_vec3_fill(bounds->centroid_max, -FLT_MAX);
+}
+
+static void merge_bounds(struct range_bounds* dest, struct range_bounds* bounds)
+{
+	glm_vec3_minv(dest->min, bounds->min, dest->min);
+	glm_vec3_maxv(dest->max, bounds->max, dest->max);
+	glm_vec3_minv(dest->centroid_min, bounds->centroid_min, dest->centroid_min);
+	glm_vec3_maxv(dest->centroid_max, bounds->centroid_max, dest->centroid_max);
+}
+
+static void add_bounds(struct build_object* object, struct range_bounds* bounds)
+{
+	vec3 centroid;
+	glm_vec3_center(object->min, object->max, centroid);
+	glm_vec3_minv(bounds->min, object->min, bounds->min);
+	glm_vec3_maxv(bounds->max, object->max, bounds->max);
+	glm_vec3_minv(bounds->centroid_min, centroid, bounds->centroid_min);
+	glm_vec3_maxv(bounds->centroid_max, centroid, bounds->centroid_max);
+}
+
+static void compute_bounds(const struct build_job* job, unsigned first, unsigned count, struct range_bounds* bounds)
+{
+	struct build_object* objects = job->objects + first;
+	unsigned i;
+
+	reset_bounds(bounds);
+	for (i = 0; i < count; ++i)
+		add_bounds(&objects[i], bounds);
+}
+
+static void reset_bins(struct bin bins[3][BVH_BINS])
+{
+	unsigned axis, i;
+	for (axis = 0; axis < 3; ++axis)
+		for (i = 0; i < BVH_BINS; ++i)
+		{
+			glm_vec3_fill(bins[axis][i].min, FLT_MAX);
+			glm_vec3_fill(bins[axis][i].max, -FLT_MAX);
+			bins[axis][i].count = 0;
+		}
+}
+
+static void merge_bins(struct bin dest[3][BVH_BINS], struct bin bins[3][BVH_BINS])
+{
+	unsigned axis, i;
+	for (axis = 0; axis < 3; ++axis)
+		for (i = 0; i < BVH_BINS; ++i)
+		{
+			glm_vec3_minv(dest[axis][i].min, bins[axis][i].min, dest[axis][i].min);
+			glm_vec3_maxv(dest[axis][i].max, bins[axis][i].max, dest[axis][i].max);
+			dest[axis][i].count += bins[axis][i].count;
+		}
+}
+
+// Zero scale puts everything into the first bin of a flat axis
+static float bin_scale(const struct range_bounds* bounds, unsigned axis)
+{
+	const float extent = bounds->centroid_max[axis] - bounds->centroid_min[axis];
+	return extent > 0.0f ? (float)BVH_BINS * 0.9999f / extent : 0.0f;
+}
+
+static unsigned bin_index(float centroid, float min, float scale)
+{
+	const unsigned bin = (unsigned)((centroid - min) * scale);
+	return bin < BVH_BINS ? bin : BVH_BINS - 1;
+}
+
+static void fill_bins(const struct build_job* job, unsigned first, unsigned count,
+					  const struct range_bounds* bounds, struct bin bins[3][BVH_BINS])
+{
+	const struct build_object* objects = job->objects + first;
+	struct bin* bin;
+	vec3 min, max, centroid;
+	float scale[3];
+	unsigned axis, i;
+
+	for (axis = 0; axis < 3; ++axis)
+		scale[axis] = bin_scale(bounds, axis);
+	for (i = 0; i < count; ++i)
+	{
+		// Local copies, bins could alias the objects as far as the compiler knows
+		glm_vec3_copy((float*)objects[i].min, min);
+		glm_vec3_copy((float*)objects[i].max, max);
+		glm_vec3_center(min, max, centroid);
+		for (axis = 0; axis < 3; ++axis)
+		{
+			bin = &bins[axis][bin_index(centroid[axis], bounds->centroid_min[axis], scale[axis])];
+			glm_vec3_minv(bin->min, min, bin->min);
+			glm_vec3_maxv(bin->max, max, bin->max);
+			++bin->count;
+		}
+	}
+}
+
+static float half_area(const float* min, const float* max)
+{
+	const float x = max[0] - min[0];
+	const float y = max[1] - min[1];
+	const float z = max[2] - min[2];
+	return x * y + y * z + z * x;
+}
+
+// Sweeps the bins of every axis from both sides and returns the cheapest
+// split as the last bin going to the left
+static int find_split(const struct range_bounds* bounds, struct bin bins[3][BVH_BINS],
+					  unsigned* split_axis, unsigned* split_bin, float* split_cost)
+{
+	float right_areas[BVH_BINS];
+	unsigned right_counts[BVH_BINS];
+	vec3 min, max;
+	float cost, best = FLT_MAX;
+	unsigned axis, i, count;
+
+	for (axis = 0; axis < 3; ++axis)
+	{
+		if (bounds->centroid_max[axis] <= bounds->centroid_min[axis])
+			continue;
+
+		glm_vec3_fill(min, FLT_MAX);
+		glm_vec3_fill(max, -FLT_MAX);
+		count = 0;
+		for (i = BVH_BINS - 1; i > 0; --i)
+		{
+			glm_vec3_minv(min, bins[axis][i].min, min);
+			glm_vec3_maxv(max, bins[axis][i].max, max);
+			count += bins[axis][i].count;
+			right_counts[i] = count;
+			right_areas[i] = count ? half_area(min, max) : 0.0f;
+		}
+
+		glm_vec3_fill(min, FLT_MAX);
+		glm_vec3_fill(max, -FLT_MAX);
+		count = 0;
+		for (i = 0; i < BVH_BINS - 1; ++i)
+		{
+			glm_vec3_minv(min, bins[axis][i].min, min);
+			glm_vec3_maxv(max, bins[axis][i].max, max);
+			count += bins[axis][i].count;
+			if (!count || !right_counts[i + 1])
+				continue;
+			cost = half_area(min, max) * (float)count + right_areas[i + 1] * (float)right_counts[i + 1];
+			if (cost < best)
+			{
+				best = cost;
+				*split_axis = axis;
+				*split_bin = i;
+			}
+		}
+	}
+
+	if (best == FLT_MAX)
+		return 0;
+	*split_cost = TRAVERSAL_COST + best / glm_max(half_area(bounds->min, bounds->max), FLT_MIN);
+	return 1;
+}
+
+static unsigned partition(struct build_job* job, struct build_range* range, unsigned axis, unsigned split_bin)
+{
+	struct build_object* objects = job->objects;
+	struct build_object object;
+	const float scale = bin_scale(&range->bounds, axis);
+	unsigned i = range->first, j = range->first + range->count;
+
+	reset_bounds(&range->child_bounds[0]);
+	reset_bounds(&range->child_bounds[1]);
+	while (i < j)
+	{
+		object = objects[i];
+		if (bin_index((object.min[axis] + object.max[axis]) * 0.5f, range->bounds.centroid_min[axis], scale) <= split_bin)
+		{
+			add_bounds(&object, &range->child_bounds[0]);
+			++i;
+		}
+		else
+		{
+			add_bounds(&object, &range->child_bounds[1]);
+			objects[i] = objects[--j];
+			objects[j] = object;
+		}
+	}
+	return i - range->first;
+}
+
+// Returns the number of objects partitioned to the left, zero for a leaf
+static unsigned choose_split(struct build_job* job, struct build_range* range, struct bin bins[3][BVH_BINS])
+{
+	unsigned axis = 0, bin = 0, left;
+	float cost;
+
+	if (range->count <= BVH_LEAF_SIZE)
+		return 0;
+	if (range->depth < MAX_SAH_DEPTH && find_split(&range->bounds, bins, &axis, &bin, &cost))
+	{
+		if (cost >= (float)range->count && range->count <= BVH_MAX_LEAF_SIZE)
+			return 0;
+		return partition(job, range, axis, bin);
+	}
+	if (range->count <= BVH_MAX_LEAF_SIZE)
+		return 0;
+
+	// Centroids that can not be told apart, or a tree gone too deep to
+	// trust the heuristic: just halve the range to bound the depth
+	left = range->count / 2;
+	compute_bounds(job, range->first, left, &range->child_bounds[0]);
+	compute_bounds(job, range->first + left, range->count - left, &range->child_bounds[1]);
+	return left;
+}
+
+// Children are taken from the block of the subtree when next is given and
+// from the shared counter otherwise
+static void split_node(struct build_job* job, struct build_range* range, struct bin bins[3][BVH_BINS], unsigned* next)
+{
+	struct bvh* bvh = job->bvh;
+	struct bvh_node* node = &bvh->nodes[range->node];
+	unsigned i, children;
+
+	glm_vec3_copy(range->bounds.min, node->min);
+	glm_vec3_copy(range->bounds.max, node->max);
+
+	range->left_count = choose_split(job, range, bins);
+	if (!range->left_count)
+	{
+		node->first = range->first;
+		node->count = range->count;
+		for (i = 0; i < range->count; ++i)
+			bvh->leaves[range->first + i] = range->node;
+		range->children = ~0u;
+		return;
+	}
+
+	if (next)
+	{
+		children = *next;
+		*next += 2;
+	}
+	else
+		children = (unsigned)SDL_AtomicAdd(&job->nodes_count, 2);
+	node->first = children;
+	node->count = 0;
+	bvh->parents[children] = range->node;
+	bvh->parents[children + 1] = range->node;
+	range->children = children;
+}
+
+static void split_range(struct build_job* job, struct build_range* range, unsigned* next)
+{
+	struct bin bins[3][BVH_BINS];
+
+	if (range->count > BVH_LEAF_SIZE)
+	{
+		reset_bins(bins);
+		fill_bins(job, range->first, range->count, &range->bounds, bins);
+	}
+	split_node(job, range, bins, next);
+}
+
+static void bounds_chunk_job(void* data, unsigned begin, unsigned end)
+{
+	struct build_job* job = (struct build_job*)data;
+	unsigned chunk, first;
+
+	for (chunk = begin; chunk < end; ++chunk)
+	{
+		first = chunk * CHUNK_SIZE;
+		compute_bounds(job, job->first + first, glm_min(CHUNK_SIZE, job->count - first), &job->chunk_bounds[chunk]);
+	}
+}
+
+static void bins_chunk_job(void* data, unsigned begin, unsigned end)
+{
+	struct build_job* job = (struct build_job*)data;
+	unsigned chunk, first;
+
+	for (chunk = begin; chunk < end; ++chunk)
+	{
+		first = chunk * CHUNK_SIZE;
+		reset_bins(job->chunk_bins[chunk]);
+		fill_bins(job, job->first + first, glm_min(CHUNK_SIZE, job->count - first), job->bounds, job->chunk_bins[chunk]);
+	}
+}
+
+static void compute_large_bounds(struct build_job* job, unsigned first, unsigned count, struct range_bounds* bounds)
+{
+	const unsigned chunks = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	unsigned i;
+
+	job->first = first;
+	job->count = count;
+	jobs_parallel_for(bounds_chunk_job, job, chunks, 1);
+	reset_bounds(bounds);
+	for (i = 0; i < chunks; ++i)
+		merge_bounds(bounds, &job->chunk_bounds[i]);
+}
+
+// Top of the tree, while there are fewer ranges than threads: bins are
+// gathered per chunk on the job threads, partition stays serial
+static void split_large_range(struct build_job* job, struct build_range* range)
+{
+	struct bin bins[3][BVH_BINS];
+	const unsigned chunks = (range->count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	unsigned i;
+
+	job->first = range->first;
+	job->count = range->count;
+	job->bounds = &range->bounds;
+	jobs_parallel_for(bins_chunk_job, job, chunks, 1);
+	reset_bins(bins);
+	for (i = 0; i < chunks; ++i)
+		merge_bins(bins, job->chunk_bins[i]);
+
+	split_node(job, range, bins, NULL);
+}
+
+static void split_ranges_job(void* data, unsigned begin, unsigned end)
+{
+	struct build_job* job = (struct build_job*)data;
+	unsigned i;
+	for (i = begin; i < end; ++i)
+		split_range(job, &job->ranges[i], NULL);
+}
+
+static void build_subtree(struct build_job* job, struct build_range range, unsigned* next)
+{
+	struct build_range child;
+
+	split_range(job, &range, next);
+	if (range.children == ~0u)
+		return;
+
+	child.bounds = range.child_bounds[0];
+	child.node = range.children;
+	child.first = range.first;
+	child.count = range.left_count;
+	child.depth = range.depth + 1;
+	build_subtree(job, child, next);
+
+	child.bounds = range.child_bounds[1];
+	child.node = range.children + 1;
+	child.first = range.first + range.left_count;
+	child.count = range.count - range.left_count;
+	build_subtree(job, child, next);
+}
+
+static void build_subtrees_job(void* data, unsigned begin, unsigned end)
+{
+	struct build_job* job = (struct build_job*)data;
+	unsigned i;
+	for (i = begin; i < end; ++i)
+		build_subtree(job, job->ranges[i], &job->ranges[i].next);
+}
+
+static void prepare_job(void* data, unsigned begin, unsigned end)
+{
+	struct build_job* job = (struct build_job*)data;
+	unsigned i;
+	for (i = begin; i < end; ++i)
+	{
+		glm_vec3_copy(job->boxes[i][0], job->objects[i].min);
+		glm_vec3_copy(job->boxes[i][1], job->objects[i].max);
+		job->objects[i].object = i;
+	}
+}
+
+static void slots_job(void* data, unsigned begin, unsigned end)
+{
+	struct build_job* job = (struct build_job*)data;
+	struct bvh* bvh = job->bvh;
+	unsigned slot;
+	for (slot = begin; slot < end; ++slot)
+	{
+		glm_vec3_copy(job->objects[slot].min, bvh->boxes[slot][0]);
+		glm_vec3_copy(job->objects[slot].max, bvh->boxes[slot][1]);
+		bvh->objects[slot] = job->objects[slot].object;
+		bvh->slots[job->objects[slot].object] = slot;
+	}
+}
+
+static int push_range(struct build_range** ranges, unsigned* count, unsigned* capacity, const struct build_range* range)
+{
+	struct build_range* grown;
+	if (*count == *capacity)
+	{
+		*capacity = *capacity ? *capacity * 2 : 64;
+		grown = (struct build_range*)realloc(*ranges, *capacity * sizeof(struct build_range));
+		if (!grown)
+			return 0;
+		*ranges = grown;
+	}
+	(*ranges)[(*count)++] = *range;
+	return 1;
+}
+
+int build_bvh(struct bvh* bvh, vec3 (*boxes)[2], unsigned count)
+{
+	struct build_job job;
+	struct build_range range;
+	struct build_range *frontier = NULL, *next = NULL, *tasks = NULL, *swap;
+	unsigned frontier_count = 0, frontier_capacity = 0;
+	unsigned next_count, next_capacity = 0;
+	unsigned tasks_count = 0, tasks_capacity = 0;
+	unsigned i, child, nodes_count;
+	const unsigned chunks = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	int success = 1;
+
+	memset(bvh, 0, sizeof(struct bvh));
+	bvh->objects_count = count;
+	if (!count)
+		return 1;
+
+	bvh->nodes = (struct bvh_node*)malloc(2 * count * sizeof(struct bvh_node));
+	bvh->boxes = (vec3(*)[2])malloc(count * sizeof(vec3[2]));
+	bvh->objects = (unsigned*)malloc(count * sizeof(unsigned));
+	bvh->slots = (unsigned*)malloc(count * sizeof(unsigned));
+	bvh->leaves = (unsigned*)malloc(count * sizeof(unsigned));
+	bvh->parents = (unsigned*)malloc(2 * count * sizeof(unsigned));
+	bvh->subtrees = (unsigned*)malloc(count * sizeof(unsigned));
+	bvh->top = (unsigned*)malloc(count * sizeof(unsigned));
+	memset(&job, 0, sizeof(job));
+	job.bvh = bvh;
+	job.boxes = boxes;
+	job.objects = (struct build_object*)malloc(count * sizeof(struct build_object));
+	job.chunk_bounds = (struct range_bounds*)malloc(chunks * sizeof(struct range_bounds));
+	job.chunk_bins = (struct bin(*)[3][BVH_BINS])malloc(chunks * sizeof(struct bin[3][BVH_BINS]));
+	if (!bvh->nodes || !bvh->boxes || !bvh->objects || !bvh->slots || !bvh->leaves || !bvh->parents ||
+		!bvh->subtrees || !bvh->top || !job.objects || !job.chunk_bounds || !job.chunk_bins)
+	{
+		success = 0;
+		goto done;
+	}
+	jobs_parallel_for(prepare_job, &job, count, SLOTS_PER_JOB);
+
+	compute_large_bounds(&job, 0, count, &range.bounds);
+	range.node = 0;
+	range.first = 0;
+	range.count = count;
+	range.depth = 0;
+	bvh->parents[0] = ~0u;
+	SDL_AtomicSet(&job.nodes_count, 1);
+	if (!push_range(count > BVH_SUBTREE_SIZE ? &frontier : &tasks,
+					count > BVH_SUBTREE_SIZE ? &frontier_count : &tasks_count,
+					count > BVH_SUBTREE_SIZE ? &frontier_capacity : &tasks_capacity, &range))
+	{
+		success = 0;
+		goto done;
+	}
+
+	// Top of the tree, level by level
+	while (frontier_count)
+	{
+		if (frontier_count < jobs_thread_count())
+			for (i = 0; i < frontier_count; ++i)
+				split_large_range(&job, &frontier[i]);
+		else
+		{
+			job.ranges = frontier;
+			jobs_parallel_for(split_ranges_job, &job, frontier_count, 1);
+		}
+
+		next_count = 0;
+		for (i = 0; i < frontier_count; ++i)
+		{
+			if (frontier[i].children == ~0u)
+				continue;
+			bvh->top[bvh->top_count++] = frontier[i].node;
+			for (child = 0; child < 2; ++child)
+			{
+				range.bounds = frontier[i].child_bounds[child];
+				range.node = frontier[i].children + child;
+				range.first = child ? frontier[i].first + frontier[i].left_count : frontier[i].first;
+				range.count = child ? frontier[i].count - frontier[i].left_count : frontier[i].left_count;
+				range.depth = frontier[i].depth + 1;
+				if (range.count > BVH_SUBTREE_SIZE)
+					success = push_range(&next, &next_count, &next_capacity, &range);
+				else
+					success = push_range(&tasks, &tasks_count, &tasks_capacity, &range);
+				if (!success)
+					goto done;
+			}
+		}
+
+		swap = frontier;
+		frontier = next;
+		next = swap;
+		i = frontier_capacity;
+		frontier_capacity = next_capacity;
+		next_capacity = i;
+		frontier_count = next_count;
+	}
+
+	// Subtrees, each in its own block of nodes: n objects never take more
+	// than 2n - 2 nodes below the root of their subtree
+	nodes_count = (unsigned)SDL_AtomicGet(&job.nodes_count);
+	for (i = 0; i < tasks_count; ++i)
+	{
+		tasks[i].next = nodes_count;
+		nodes_count += 2 * tasks[i].count - 2;
+		bvh->subtrees[i] = tasks[i].node;
+	}
+	bvh->subtrees_count = tasks_count;
+	bvh->nodes_count = nodes_count;
+	job.ranges = tasks;
+	jobs_parallel_for(build_subtrees_job, &job, tasks_count, 1);
+
+	jobs_parallel_for(slots_job, &job, count, SLOTS_PER_JOB);
+
+done:
+	free(tasks);
+	free(next);
+	free(frontier);
+	free(job.chunk_bins);
+	free(job.chunk_bounds);
+	free(job.objects);
+	if (!success)
+		destroy_bvh(bvh);
+	return success;
+}
+
+void destroy_bvh(struct bvh* bvh)
+{
+	free(bvh->top);
+	free(bvh->subtrees);
+	free(bvh->parents);
+	free(bvh->leaves);
+	free(bvh->slots);
+	free(bvh->objects);
+	free(bvh->boxes);
+	free(bvh->nodes);
+	memset(bvh, 0, sizeof(struct bvh));
+}
+
+// =====================================
+// Refit
+// =====================================
+static void refit_node(struct bvh* bvh, unsigned index)
+{
+	struct bvh_node* node = &bvh->nodes[index];
+	const struct bvh_node* children;
+	unsigned i;
+
+	if (node->count)
+	{
+		glm_vec3_copy(bvh->boxes[node->first][0], node->min);
+		glm_vec3_copy(bvh->boxes[node->first][1], node->max);
+		for (i = 1; i < node->count; ++i)
+		{
+			glm_vec3_minv(node->min, bvh->boxes[node->first + i][0], node->min);
+			glm_vec3_maxv(node->max, bvh->boxes[node->first + i][1], node->max);
+		}
+	}
+	else
+	{
+		children = &bvh->nodes[node->first];
+		glm_vec3_minv((float*)children[0].min, (float*)children[1].min, node->min);
+		glm_vec3_maxv((float*)children[0].max, (float*)children[1].max, node->max);
+	}
+}
+
+static void refit_subtree(struct bvh* bvh, unsigned index)
+{
+	if (!bvh->nodes[index].count)
+	{
+		refit_subtree(bvh, bvh->nodes[index].first);
+		refit_subtree(bvh, bvh->nodes[index].first + 1);
+	}
+	refit_node(bvh, index);
+}
+
+static void refit_boxes_job(void* data, unsigned begin, unsigned end)
+{
+	struct refit_job* job = (struct refit_job*)data;
+	struct bvh* bvh = job->bvh;
+	unsigned slot;
+	for (slot = begin; slot < end; ++slot)
+	{
+		glm_vec3_copy(job->boxes[bvh->objects[slot]][0], bvh->boxes[slot][0]);
+		glm_vec3_copy(job->boxes[bvh->objects[slot]][1], bvh->boxes[slot][1]);
+	}
+}
+
+static void refit_subtrees_job(void* data, unsigned begin, unsigned end)
+{
+	struct refit_job* job = (struct refit_job*)data;
+	unsigned i;
+	for (i = begin; i < end; ++i)
+		refit_subtree(job->bvh, job->bvh->subtrees[i]);
+}
+
+void refit_bvh(struct bvh* bvh, vec3 (*boxes)[2])
+{
+	struct refit_job job;
+	unsigned i;
+
+	job.bvh = bvh;
+	job.boxes = boxes;
+	jobs_parallel_for(refit_boxes_job, &job, bvh->objects_count, SLOTS_PER_JOB);
+	jobs_parallel_for(refit_subtrees_job, &job, bvh->subtrees_count, 1);
+	for (i = bvh->top_count; i > 0; --i)
+		refit_node(bvh, bvh->top[i - 1]);
+}
+
+void update_bvh_object(struct bvh* bvh, unsigned object, vec3 box[2])
+{
+	const unsigned slot = bvh->slots[object];
+	struct bvh_node* node;
+	vec3 min, max;
+	unsigned index;
+
+	glm_vec3_copy(box[0], bvh->boxes[slot][0]);
+	glm_vec3_copy(box[1], bvh->boxes[slot][1]);
+	for (index = bvh->leaves[slot]; index != ~0u; index = bvh->parents[index])
+	{
+		node = &bvh->nodes[index];
+		glm_vec3_copy(node->min, min);
+		glm_vec3_copy(node->max, max);
+		refit_node(bvh, index);
+		if (glm_vec3_eqv(min, node->min) && glm_vec3_eqv(max, node->max))
+			break;
+	}
+}
+
+// =====================================
+// Queries
+// =====================================
+// Returns the planes the box still straddles, or OUTSIDE
+static unsigned clip_box(const float* min, const float* max, vec4 planes[6], unsigned mask)
+{
+	float far, near;
+	unsigned i;
+
+	for (i = 0; i < 6; ++i)
+	{
+		if (!(mask & (1u << i)))
+			continue;
+		far = planes[i][0] * (planes[i][0] > 0.0f ? max[0] : min[0]) +
+			  planes[i][1] * (planes[i][1] > 0.0f ? max[1] : min[1]) +
+			  planes[i][2] * (planes[i][2] > 0.0f ? max[2] : min[2]);
+		if (far < -planes[i][3])
+			return OUTSIDE;
+		near = planes[i][0] * (planes[i][0] > 0.0f ? min[0] : max[0]) +
+			   planes[i][1] * (planes[i][1] > 0.0f ? min[1] : max[1]) +
+			   planes[i][2] * (planes[i][2] > 0.0f ? min[2] : max[2]);
+		if (near >= -planes[i][3])
+			mask &= ~(1u << i);
+	}
+	return mask;
+}
+
+static int boxes_overlap(const float* min, const float* max, vec3 box[2])
+{
+	return min[0] <= box[1][0] && max[0] >= box[0][0] &&
+		   min[1] <= box[1][1] && max[1] >= box[0][1] &&
+		   min[2] <= box[1][2] && max[2] >= box[0][2];
+}
+
+static int box_sphere_overlap(const float* min, const float* max, const float* sphere)
+{
+	const float x = sphere[0] - glm_clamp(sphere[0], min[0], max[0]);
+	const float y = sphere[1] - glm_clamp(sphere[1], min[1], max[1]);
+	const float z = sphere[2] - glm_clamp(sphere[2], min[2], max[2]);
+	return x * x + y * y + z * z <= sphere[3] * sphere[3];
+}
+
+// Entry distance of the ray into the box, clamped to [0, max_distance]
+static int ray_box(const float* min, const float* max, const float* origin, const float* inverse,
+				   float max_distance, float* distance)
+{
+	float t0, t1, near = 0.0f, far = max_distance;
+	unsigned axis;
+
+	for (axis = 0; axis < 3; ++axis)
+	{
+		t0 = (min[axis] - origin[axis]) * inverse[axis];
+		t1 = (max[axis] - origin[axis]) * inverse[axis];
+		near = glm_max(near, glm_min(t0, t1));
+		far = glm_min(far, glm_max(t0, t1));
+	}
+	*distance = near;
+	return near <= far;
+}
+
+// Whole subtrees inside the frustum are collected without any more tests
+unsigned query_bvh_frustum(const struct bvh* bvh, vec4 planes[6], unsigned* objects)
+{
+	unsigned stack[STACK_SIZE];
+	unsigned masks[STACK_SIZE];
+	const struct bvh_node* node;
+	unsigned size = 1, found = 0, mask, i;
+
+	if (!bvh->objects_count)
+		return 0;
+
+	stack[0] = 0;
+	masks[0] = 0x3f;
+	while (size)
+	{
+		--size;
+		node = &bvh->nodes[stack[size]];
+		mask = masks[size];
+		if (mask && (mask = clip_box(node->min, node->max, planes, mask)) == OUTSIDE)
+			continue;
+
+		if (!node->count)
+		{
+			stack[size] = node->first + 1;
+			masks[size++] = mask;
+			stack[size] = node->first;
+			masks[size++] = mask;
+		}
+		else if (!mask)
+			for (i = node->first; i < node->first + node->count; ++i)
+				objects[found++] = bvh->objects[i];
+		else
+			for (i = node->first; i < node->first + node->count; ++i)
+				if (clip_box(bvh->boxes[i][0], bvh->boxes[i][1], planes, mask) != OUTSIDE)
+					objects[found++] = bvh->objects[i];
+	}
+	return found;
+}
+
+unsigned query_bvh_box(const struct bvh* bvh, vec3 box[2], unsigned* objects)
+{
+	unsigned stack[STACK_SIZE];
+	const struct bvh_node* node;
+	unsigned size = 1, found = 0, i;
+
+	if (!bvh->objects_count)
+		return 0;
+
+	stack[0] = 0;
+	while (size)
+	{
+		node = &bvh->nodes[stack[--size]];
+		if (!boxes_overlap(node->min, node->max, box))
+			continue;
+
+		if (!node->count)
+		{
+			stack[size++] = node->first + 1;
+			stack[size++] = node->first;
+		}
+		else
+			for (i = node->first; i < node->first + node->count; ++i)
+				if (boxes_overlap(bvh->boxes[i][0], bvh->boxes[i][1], box))
+					objects[found++] = bvh->objects[i];
+	}
+	return found;
+}
+
+unsigned query_bvh_sphere(const struct bvh* bvh, vec4 sphere, unsigned* objects)
+{
+	unsigned stack[STACK_SIZE];
+	const struct bvh_node* node;
+	unsigned size = 1, found = 0, i;
+
+	if (!bvh->objects_count)
+		return 0;
+
+	stack[0] = 0;
+	while (size)
+	{
+		node = &bvh->nodes[stack[--size]];
+		if (!box_sphere_overlap(node->min, node->max, sphere))
+			continue;
+
+		if (!node->count)
+		{
+			stack[size++] = node->first + 1;
+			stack[size++] = node->first;
+		}
+		else
+			for (i = node->first; i < node->first + node->count; ++i)
+				if (box_sphere_overlap(bvh->boxes[i][0], bvh->boxes[i][1], sphere))
+					objects[found++] = bvh->objects[i];
+	}
+	return found;
+}
+
+// The nearer child is visited first and anything entered past the closest
+// hit so far is skipped
+int raycast_bvh(const struct bvh* bvh, vec3 origin, vec3 direction, float max_distance,
+				bvh_ray_func func, void* data, unsigned* object, float* distance)
+{
+	unsigned stack[STACK_SIZE];
+	float entries[STACK_SIZE];
+	const struct bvh_node* node;
+	vec3 inverse;
+	float best = max_distance, left_entry, right_entry, hit_distance;
+	unsigned size = 0, hit = ~0u, left, right, i;
+	int left_hit, right_hit;
+
+	if (!bvh->objects_count)
+		return 0;
+
+	inverse[0] = 1.0f / direction[0];
+	inverse[1] = 1.0f / direction[1];
+	inverse[2] = 1.0f / direction[2];
+	if (ray_box(bvh->nodes[0].min, bvh->nodes[0].max, origin, inverse, best, &entries[0]))
+		stack[size++] = 0;
+
+	while (size)
+	{
+		--size;
+		if (entries[size] > best)
+			continue;
+		node = &bvh->nodes[stack[size]];
+
+		if (node->count)
+		{
+			for (i = node->first; i < node->first + node->count; ++i)
+			{
+				if (!ray_box(bvh->boxes[i][0], bvh->boxes[i][1], origin, inverse, best, &hit_distance))
+					continue;
+				if (func && !func(data, bvh->objects[i], origin, direction, &hit_distance))
+					continue;
+				if (hit_distance <= best)
+				{
+					best = hit_distance;
+					hit = bvh->objects[i];
+				}
+			}
+			continue;
+		}
+
+		left = node->first;
+		right = node->first + 1;
+		left_hit = ray_box(bvh->nodes[left].min, bvh->nodes[left].max, origin, inverse, best, &left_entry);
+		right_hit = ray_box(bvh->nodes[right].min, bvh->nodes[right].max, origin, inverse, best, &right_entry);
+		if (left_hit && right_hit && left_entry > right_entry)
+		{
+			stack[size] = left;
+			entries[size++] = left_entry;
+			left_hit = 0;
+		}
+		if (right_hit)
+		{
+			stack[size] = right;
+			entries[size++] = right_entry;
+		}
+		if (left_hit)
+		{
+			stack[size] = left;
+			entries[size++] = left_entry;
+		}
+	}
+
+	if (hit == ~0u)
+		return 0;
+	*object = hit;
+	*distance = best;
+	return 1;
+}
@@ -0,0 +1,92 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef BVH_H
+#define BVH_H
+
+#include "cglm/types.h"
+
+#define BVH_BINS 16
+#define BVH_LEAF_SIZE 4
+#define BVH_MAX_LEAF_SIZE 8
+#define BVH_SUBTREE_SIZE 4096
+
+// Bounding volume hierarchy over object boxes. Splits are picked with the
+// surface area heuristic over binned centroids: the top of the tree is
+// split level by level, then the remaining ranges are built as independent
+// subtrees on the job threads.
+//
+// Inner nodes have a zero count and keep both children next to each other
+// starting at first. Leaves own count slots starting at first: boxes and
+// objects are stored in leaf order, slots and leaves map objects to slots
+// and slots to leaves. Subtrees are the roots of the ranges built on the
+// job threads and top are the inner nodes above them, parents first.
+struct bvh_node
+{
+	vec3 min;
+	unsigned first;
+	vec3 max;
+	unsigned count;
+};
+
+struct bvh
+{
+	struct bvh_node* nodes;
+	vec3 (*boxes)[2];
+	unsigned* objects;
+	unsigned* slots;
+	unsigned* leaves;
+	unsigned* parents;
+	unsigned* subtrees;
+	unsigned* top;
+	unsigned nodes_count;
+	unsigned objects_count;
+	unsigned subtrees_count;
+	unsigned top_count;
+};
+
+// Exact test of a ray against an object whose box it hits, for example
+// glm_ray_triangle() over its mesh. Returns nonzero and the distance on hit.
+typedef int (*bvh_ray_func)(void* data, unsigned object, vec3 origin, vec3 direction, float* distance);
+
+int build_bvh(struct bvh* bvh, vec3 (*boxes)[2], unsigned count);
+void destroy_bvh(struct bvh* bvh);
+
+// Refits every node to new boxes of the same objects; the topology is kept,
+// so it gets worse as objects move far from where the tree was built.
+void refit_bvh(struct bvh* bvh, vec3 (*boxes)[2]);
+// Refits a single moved object, walking up only while parents change
+void update_bvh_object(struct bvh* bvh, unsigned object, vec3 box[2]);
+
+// Queries write the objects found into objects, which must be able to hold
+// every object of the tree, and return their number
+unsigned query_bvh_frustum(const struct bvh* bvh, vec4 planes[6], unsigned* objects);
+unsigned query_bvh_box(const struct bvh* bvh, vec3 box[2], unsigned* objects);
+unsigned query_bvh_sphere(const struct bvh* bvh, vec4 sphere, unsigned* objects);
+
+// Finds the closest object hit before max_distance. Object boxes are hit
+// tested unless func is given.
+int raycast_bvh(const struct bvh* bvh, vec3 origin, vec3 direction, float max_distance,
+				bvh_ray_func func, void* data, unsigned* object, float* distance);
+
+#endif // BVH_H
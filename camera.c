@@ -24,7 +24,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define STB_IMAGE_IMPLEMENTATION
 #define SDL_MAIN_HANDLED
 #include <GL/glew.h>
 #include <SDL2/SDL.h>
@@ -32,8 +31,10 @@
 #include "cglm/affine.h"
 #include "cglm/cam.h"
 #include "cglm/quat.h"
+#include "animation.h"
 #include "common.h"
-#include "stb_image.h"
+#include "simd.h"
+#include "texture_manager.h"
 
 static const float vertices[] =
 {
@@ -129,8 +130,8 @@ int main(int argc, char** argv)
 	glFrontFace(GL_CW);
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
-	// STB Image
-	stbi_set_flip_vertically_on_load(1);
+	// Math kernels of the widest instruction set the CPU has
+	simd_init();
 
 	// Vertex Buffers
 	unsigned vao;
@@ -237,30 +238,8 @@ int main(int argc, char** argv)
 	free(fragment_shader);
 
 	// Texture
-	unsigned texture;
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	int width, height, channels;
-	unsigned char* texture_data = stbi_load("data/textures/crate_diffuse.png", &width, &height, &channels, 0);
-	if (!texture_data)
-	{
-		error("Texture Loading Error", "Could not found file data/textures/crate_diffuse.png.");
-		SDL_GL_DeleteContext(context);
-		SDL_DestroyWindow(window);
-		SDL_Quit();
-		return 1;
-	}
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, texture_data);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	stbi_image_free(texture_data);
-	if (!validate_gl("VAO Creation Error"))
+	const unsigned texture = load_texture("data/textures/crate_diffuse.tex");
+	if (!texture)
 	{
 		SDL_GL_DeleteContext(context);
 		SDL_DestroyWindow(window);
@@ -319,13 +298,22 @@ int main(int argc, char** argv)
 	mat4 proj;
 	glm_perspective(45.0f, 1024.0f / 720.0f, 0.01f, 100.0f, proj);
 
-	// Rotation
+	// Rotation, every cube spins faster than the one before
+	const unsigned cubes_count = sizeof(positions) / sizeof(vec3);
 	vec3 rotation_axis = { 0.5f, 1.0f, 0.75f };
-	versor rotation;
-	glm_quat_identity(rotation);
+	versor rotations[sizeof(positions) / sizeof(vec3)];
+	vec4 spins[sizeof(positions) / sizeof(vec3)];
+	unsigned spin_step = 0;
+	unsigned i;
+	glm_vec3_normalize(rotation_axis);
+	for (i = 0; i < cubes_count; ++i)
+	{
+		glm_quat_identity(rotations[i]);
+		glm_vec3_copy(rotation_axis, spins[i]);
+		spins[i][3] = 0.0001f * (float)(i + 1u);
+	}
 
 	int run = 1;
-	int i;
 	float tick_delta;
 	float tick_curr;
 	float tick_prev = 0.0f;
@@ -350,6 +338,9 @@ int main(int argc, char** argv)
 		// View and Projection Matrix
 		glm_mat4_mul_sse2(proj, view, viewproj);
 
+		// Animation
+		animate_spins(rotations, spins, tick_delta, ++spin_step, cubes_count);
+
 		// Rendering
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		glUseProgram(program);
@@ -358,12 +349,11 @@ int main(int argc, char** argv)
 		glBindVertexArray(vao);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
 		glUniformMatrix4fv(uniform_viewproj, 1, GL_FALSE, viewproj[0]);
-		for (i = 0; i < sizeof(positions) / sizeof(vec3); ++i)
+		for (i = 0; i < cubes_count; ++i)
 		{
 			glm_mat4_identity(model);
 			glm_translate(model, positions[i]);
-			glm_quatv(rotation, tick_curr * 0.0001f * (i + 1), rotation_axis);
-			glm_quat_rotate(model, rotation, model);
+			glm_quat_rotate(model, rotations[i], model);
 			glUniformMatrix4fv(uniform_model, 1, GL_FALSE, model[0]);
 			glDrawElements(GL_TRIANGLES, sizeof(vertices) / sizeof(float), GL_UNSIGNED_INT, 0);
 		}
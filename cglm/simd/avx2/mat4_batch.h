@@ -0,0 +1,310 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ Functions:
+   CGLM_INLINE void glm_mat4_mul_batch_avx2(mat4* a, mat4* b, mat4* dest, size_t count);
+   CGLM_INLINE void glm_mat4_mul_left_batch_avx2(mat4 left, mat4* right, mat4* dest, size_t count);
+   CGLM_INLINE void glm_mat4_inv_batch_avx2(mat4* mat, mat4* dest, size_t count);
+   CGLM_INLINE void glm_mat4_inv_affine_batch_avx2(mat4* mat, mat4* dest, size_t count);
+   CGLM_INLINE void glm_mat4_transpose_batch_avx2(mat4* mat, mat4* dest, size_t count);
+   CGLM_INLINE void glm_mat4_mulv_batch_avx2(mat4* m, vec4* v, vec4* dest, size_t count);
+   CGLM_INLINE void glm_mat4_mulv_shared_batch_avx2(mat4 m, vec4* v, vec4* dest, size_t count);
+
+   SoA layout, sixteen runs of stride floats per matrix array:
+   CGLM_INLINE void glm_mat4_mul_soa_avx2(float* a, float* b, float* dest, size_t stride, size_t count);
+   CGLM_INLINE void glm_mat4_inv_soa_avx2(float* m, float* dest, size_t stride, size_t count);
+   CGLM_INLINE void glm_mat4_inv_affine_soa_avx2(float* m, float* dest, size_t stride, size_t count);
+   CGLM_INLINE void glm_mat4_transpose_soa_avx2(float* m, float* dest, size_t stride, size_t count);
+   CGLM_INLINE void glm_mat4_mulv_soa_avx2(float* m, float* v, float* dest, size_t stride, size_t count);
+
+ All destinations may alias their sources.
+ */
+
+#ifndef cglm_mat4_batch_avx2_h
+#define cglm_mat4_batch_avx2_h
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+
+#include "../../common.h"
+#include "../../mat4.h"
+#include "../intrin.h"
+
+#include <immintrin.h>
+
+#define GLMM_SOA_T __m256
+#define GLMM_SOA_W 8
+#define GLMM_SOA_FN(name) name##_avx2
+#define GLMM_SOA_LOAD(p) _mm256_loadu_ps(p)
+#define GLMM_SOA_STORE(p, x) _mm256_storeu_ps(p, x)
+#define GLMM_SOA_SET1(x) _mm256_set1_ps(x)
+#define GLMM_SOA_ADD(a, b) _mm256_add_ps(a, b)
+#define GLMM_SOA_SUB(a, b) _mm256_sub_ps(a, b)
+#define GLMM_SOA_MUL(a, b) _mm256_mul_ps(a, b)
+#define GLMM_SOA_DIV(a, b) _mm256_div_ps(a, b)
+#define GLMM_SOA_FMADD(a, b, c) _mm256_fmadd_ps(a, b, c)
+#define GLMM_SOA_FNMADD(a, b, c) _mm256_fnmadd_ps(a, b, c)
+
+#include "../mat4_soa.h"
+
+#undef GLMM_SOA_T
+#undef GLMM_SOA_W
+#undef GLMM_SOA_FN
+#undef GLMM_SOA_LOAD
+#undef GLMM_SOA_STORE
+#undef GLMM_SOA_SET1
+#undef GLMM_SOA_ADD
+#undef GLMM_SOA_SUB
+#undef GLMM_SOA_MUL
+#undef GLMM_SOA_DIV
+#undef GLMM_SOA_FMADD
+#undef GLMM_SOA_FNMADD
+
+/* In place 8x8 transpose: r[j] lane k becomes old r[k] lane j */
+CGLM_INLINE
+void glmm_transpose8_avx2(__m256 r[8])
+{
+	__m256 t0, t1, t2, t3, t4, t5, t6, t7;
+	__m256 s0, s1, s2, s3, s4, s5, s6, s7;
+
+	t0 = _mm256_unpacklo_ps(r[0], r[1]);
+	t1 = _mm256_unpackhi_ps(r[0], r[1]);
+	t2 = _mm256_unpacklo_ps(r[2], r[3]);
+	t3 = _mm256_unpackhi_ps(r[2], r[3]);
+	t4 = _mm256_unpacklo_ps(r[4], r[5]);
+	t5 = _mm256_unpackhi_ps(r[4], r[5]);
+	t6 = _mm256_unpacklo_ps(r[6], r[7]);
+	t7 = _mm256_unpackhi_ps(r[6], r[7]);
+
+	s0 = _mm256_shuffle_ps(t0, t2, 0x44);
+	s1 = _mm256_shuffle_ps(t0, t2, 0xEE);
+	s2 = _mm256_shuffle_ps(t1, t3, 0x44);
+	s3 = _mm256_shuffle_ps(t1, t3, 0xEE);
+	s4 = _mm256_shuffle_ps(t4, t6, 0x44);
+	s5 = _mm256_shuffle_ps(t4, t6, 0xEE);
+	s6 = _mm256_shuffle_ps(t5, t7, 0x44);
+	s7 = _mm256_shuffle_ps(t5, t7, 0xEE);
+
+	r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+	r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+	r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+	r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+	r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+	r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+	r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+	r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+/* Eight AoS matrices into sixteen SoA registers and back */
+CGLM_INLINE
+void glmm_mat4_load8_avx2(mat4* m, __m256 x[16])
+{
+	int k;
+	for (k = 0; k < 8; k++)
+	{
+		x[k] = _mm256_loadu_ps(m[k][0]);
+		x[k + 8] = _mm256_loadu_ps(m[k][2]);
+	}
+	glmm_transpose8_avx2(x);
+	glmm_transpose8_avx2(x + 8);
+}
+
+CGLM_INLINE
+void glmm_mat4_store8_avx2(mat4* m, __m256 x[16])
+{
+	int k;
+	glmm_transpose8_avx2(x);
+	glmm_transpose8_avx2(x + 8);
+	for (k = 0; k < 8; k++)
+	{
+		_mm256_storeu_ps(m[k][0], x[k]);
+		_mm256_storeu_ps(m[k][2], x[k + 8]);
+	}
+}
+
+/* Two columns of a * b, b01 holding the matching two columns of b */
+CGLM_INLINE
+__m256 glmm_mat4_mul2_avx2(__m256 a0, __m256 a1, __m256 a2, __m256 a3, __m256 b01)
+{
+	__m256 r;
+	r = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+	r = _mm256_fmadd_ps(a1, _mm256_permute_ps(b01, 0x55), r);
+	r = _mm256_fmadd_ps(a2, _mm256_permute_ps(b01, 0xAA), r);
+	return _mm256_fmadd_ps(a3, _mm256_permute_ps(b01, 0xFF), r);
+}
+
+/*!
+ * @brief multiplies count pairs of matrices, dest[i] = a[i] * b[i]
+ *
+ * @param[in]  a     left matrices
+ * @param[in]  b     right matrices
+ * @param[out] dest  products
+ * @param[in]  count number of matrices
+ */
+CGLM_INLINE
+void glm_mat4_mul_batch_avx2(mat4* a, mat4* b, mat4* dest, size_t count)
+{
+	__m256 a0, a1, a2, a3, b01, b23;
+	size_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		a0 = _mm256_broadcast_ps((__m128 const*)a[i][0]);
+		a1 = _mm256_broadcast_ps((__m128 const*)a[i][1]);
+		a2 = _mm256_broadcast_ps((__m128 const*)a[i][2]);
+		a3 = _mm256_broadcast_ps((__m128 const*)a[i][3]);
+		b01 = _mm256_loadu_ps(b[i][0]);
+		b23 = _mm256_loadu_ps(b[i][2]);
+
+		_mm256_storeu_ps(dest[i][0], glmm_mat4_mul2_avx2(a0, a1, a2, a3, b01));
+		_mm256_storeu_ps(dest[i][2], glmm_mat4_mul2_avx2(a0, a1, a2, a3, b23));
+	}
+}
+
+/*!
+ * @brief multiplies one matrix by count matrices, dest[i] = left * right[i]
+ */
+CGLM_INLINE
+void glm_mat4_mul_left_batch_avx2(mat4 left, mat4* right, mat4* dest, size_t count)
+{
+	__m256 a0, a1, a2, a3, b01, b23;
+	size_t i;
+
+	a0 = _mm256_broadcast_ps((__m128 const*)left[0]);
+	a1 = _mm256_broadcast_ps((__m128 const*)left[1]);
+	a2 = _mm256_broadcast_ps((__m128 const*)left[2]);
+	a3 = _mm256_broadcast_ps((__m128 const*)left[3]);
+
+	for (i = 0; i < count; i++)
+	{
+		b01 = _mm256_loadu_ps(right[i][0]);
+		b23 = _mm256_loadu_ps(right[i][2]);
+
+		_mm256_storeu_ps(dest[i][0], glmm_mat4_mul2_avx2(a0, a1, a2, a3, b01));
+		_mm256_storeu_ps(dest[i][2], glmm_mat4_mul2_avx2(a0, a1, a2, a3, b23));
+	}
+}
+
+/*!
+ * @brief inverts count matrices, eight at a time in SoA registers
+ */
+CGLM_INLINE
+void glm_mat4_inv_batch_avx2(mat4* mat, mat4* dest, size_t count)
+{
+	__m256 x[16];
+	size_t i;
+
+	for (i = 0; i + 8 <= count; i += 8)
+	{
+		glmm_mat4_load8_avx2(mat + i, x);
+		glmm_mat4_inv_soa_avx2(x, x);
+		glmm_mat4_store8_avx2(dest + i, x);
+	}
+	for (; i < count; i++)
+		glm_mat4_inv(mat[i], dest[i]);
+}
+
+/*!
+ * @brief inverts count affine matrices, last rows must be 0 0 0 1
+ */
+CGLM_INLINE
+void glm_mat4_inv_affine_batch_avx2(mat4* mat, mat4* dest, size_t count)
+{
+	__m256 x[16];
+	size_t i;
+
+	for (i = 0; i + 8 <= count; i += 8)
+	{
+		glmm_mat4_load8_avx2(mat + i, x);
+		glmm_mat4_inv_affine_soa_avx2(x, x);
+		glmm_mat4_store8_avx2(dest + i, x);
+	}
+	for (; i < count; i++)
+		glm_mat4_inv(mat[i], dest[i]);
+}
+
+/*!
+ * @brief transposes count matrices, two per iteration
+ */
+CGLM_INLINE
+void glm_mat4_transpose_batch_avx2(mat4* mat, mat4* dest, size_t count)
+{
+	__m256 c0, c1, c2, c3, t0, t1, t2, t3;
+	size_t i;
+
+	for (i = 0; i + 2 <= count; i += 2)
+	{
+		/* column k of both matrices, one per 128-bit lane */
+		c0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(mat[i][0])), _mm_loadu_ps(mat[i + 1][0]), 1);
+		c1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(mat[i][1])), _mm_loadu_ps(mat[i + 1][1]), 1);
+		c2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(mat[i][2])), _mm_loadu_ps(mat[i + 1][2]), 1);
+		c3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(mat[i][3])), _mm_loadu_ps(mat[i + 1][3]), 1);
+
+		t0 = _mm256_unpacklo_ps(c0, c1);
+		t1 = _mm256_unpackhi_ps(c0, c1);
+		t2 = _mm256_unpacklo_ps(c2, c3);
+		t3 = _mm256_unpackhi_ps(c2, c3);
+
+		c0 = _mm256_shuffle_ps(t0, t2, 0x44);
+		c1 = _mm256_shuffle_ps(t0, t2, 0xEE);
+		c2 = _mm256_shuffle_ps(t1, t3, 0x44);
+		c3 = _mm256_shuffle_ps(t1, t3, 0xEE);
+
+		_mm_storeu_ps(dest[i][0], _mm256_castps256_ps128(c0));
+		_mm_storeu_ps(dest[i + 1][0], _mm256_extractf128_ps(c0, 1));
+		_mm_storeu_ps(dest[i][1], _mm256_castps256_ps128(c1));
+		_mm_storeu_ps(dest[i + 1][1], _mm256_extractf128_ps(c1, 1));
+		_mm_storeu_ps(dest[i][2], _mm256_castps256_ps128(c2));
+		_mm_storeu_ps(dest[i + 1][2], _mm256_extractf128_ps(c2, 1));
+		_mm_storeu_ps(dest[i][3], _mm256_castps256_ps128(c3));
+		_mm_storeu_ps(dest[i + 1][3], _mm256_extractf128_ps(c3, 1));
+	}
+	for (; i < count; i++)
+		glm_mat4_transpose_to(mat[i], dest[i]);
+}
+
+/*!
+ * @brief transforms each vector by its own matrix, dest[i] = m[i] * v[i]
+ */
+CGLM_INLINE
+void glm_mat4_mulv_batch_avx2(mat4* m, vec4* v, vec4* dest, size_t count)
+{
+	__m128 x, r;
+	size_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		x = _mm_loadu_ps(v[i]);
+		r = _mm_mul_ps(_mm_loadu_ps(m[i][0]), _mm_permute_ps(x, 0x00));
+		r = _mm_fmadd_ps(_mm_loadu_ps(m[i][1]), _mm_permute_ps(x, 0x55), r);
+		r = _mm_fmadd_ps(_mm_loadu_ps(m[i][2]), _mm_permute_ps(x, 0xAA), r);
+		r = _mm_fmadd_ps(_mm_loadu_ps(m[i][3]), _mm_permute_ps(x, 0xFF), r);
+		_mm_storeu_ps(dest[i], r);
+	}
+}
+
+/*!
+ * @brief transforms count vectors by one matrix, two per iteration
+ */
+CGLM_INLINE
+void glm_mat4_mulv_shared_batch_avx2(mat4 m, vec4* v, vec4* dest, size_t count)
+{
+	__m256 m0, m1, m2, m3;
+	size_t i;
+
+	m0 = _mm256_broadcast_ps((__m128 const*)m[0]);
+	m1 = _mm256_broadcast_ps((__m128 const*)m[1]);
+	m2 = _mm256_broadcast_ps((__m128 const*)m[2]);
+	m3 = _mm256_broadcast_ps((__m128 const*)m[3]);
+
+	for (i = 0; i + 2 <= count; i += 2)
+		_mm256_storeu_ps(dest[i], glmm_mat4_mul2_avx2(m0, m1, m2, m3, _mm256_loadu_ps(v[i])));
+	for (; i < count; i++)
+		glm_mat4_mulv(m, v[i], dest[i]);
+}
+
+#endif
+#endif /* cglm_mat4_batch_avx2_h */
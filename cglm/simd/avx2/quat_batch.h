@@ -0,0 +1,141 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ Functions:
+   CGLM_INLINE void glm_quat_mul_batch_avx2(versor* a, versor* b, versor* dest, size_t count);
+   CGLM_INLINE void glm_quat_integrate_batch_avx2(versor* q, vec4* spins, float time, size_t count);
+   CGLM_INLINE void glm_quat_normalize_batch_avx2(versor* q, size_t count);
+   CGLM_INLINE void glm_quat_nlerp_batch_avx2(versor* from, versor* to, float* t, versor* dest, size_t count);
+   CGLM_INLINE void glm_quat_slerp_batch_avx2(versor* from, versor* to, float* t, versor* dest, size_t count);
+
+ Eight quaternions per iteration, see quat_soa.h. All destinations may
+ alias their sources.
+ */
+
+#ifndef cglm_quat_batch_avx2_h
+#define cglm_quat_batch_avx2_h
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+
+#include <float.h>
+#include "../../common.h"
+#include "../intrin.h"
+
+#include <immintrin.h>
+
+/* Quaternion j of the first n at p, zeros past them */
+CGLM_INLINE
+__m128 glmm_quat_get_avx2(float* p, size_t j, size_t n)
+{
+	return j < n ? _mm_loadu_ps(p + j * 4) : _mm_setzero_ps();
+}
+
+/* Quaternions j and j + 4 share a register, so a 4x4 transpose within
+   each half puts all eight in order. With n a constant the checks fold
+   away. */
+CGLM_INLINE
+void glmm_quat_load8_avx2(float* p, size_t n, __m256 q[4])
+{
+	__m256 r0, r1, r2, r3, t0, t1, t2, t3;
+
+	r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(glmm_quat_get_avx2(p, 0, n)), glmm_quat_get_avx2(p, 4, n), 1);
+	r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(glmm_quat_get_avx2(p, 1, n)), glmm_quat_get_avx2(p, 5, n), 1);
+	r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(glmm_quat_get_avx2(p, 2, n)), glmm_quat_get_avx2(p, 6, n), 1);
+	r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(glmm_quat_get_avx2(p, 3, n)), glmm_quat_get_avx2(p, 7, n), 1);
+
+	t0 = _mm256_unpacklo_ps(r0, r1);
+	t1 = _mm256_unpacklo_ps(r2, r3);
+	t2 = _mm256_unpackhi_ps(r0, r1);
+	t3 = _mm256_unpackhi_ps(r2, r3);
+
+	q[0] = _mm256_shuffle_ps(t0, t1, 0x44);
+	q[1] = _mm256_shuffle_ps(t0, t1, 0xEE);
+	q[2] = _mm256_shuffle_ps(t2, t3, 0x44);
+	q[3] = _mm256_shuffle_ps(t2, t3, 0xEE);
+}
+
+CGLM_INLINE
+void glmm_quat_store8_avx2(float* p, size_t n, __m256 q[4])
+{
+	__m256 r[4], t0, t1, t2, t3;
+	size_t j;
+
+	t0 = _mm256_unpacklo_ps(q[0], q[1]);
+	t1 = _mm256_unpacklo_ps(q[2], q[3]);
+	t2 = _mm256_unpackhi_ps(q[0], q[1]);
+	t3 = _mm256_unpackhi_ps(q[2], q[3]);
+
+	r[0] = _mm256_shuffle_ps(t0, t1, 0x44);
+	r[1] = _mm256_shuffle_ps(t0, t1, 0xEE);
+	r[2] = _mm256_shuffle_ps(t2, t3, 0x44);
+	r[3] = _mm256_shuffle_ps(t2, t3, 0xEE);
+
+	for (j = 0; j < 4 && j < n; j++)
+		_mm_storeu_ps(p + j * 4, _mm256_castps256_ps128(r[j]));
+	for (j = 4; j < 8 && j < n; j++)
+		_mm_storeu_ps(p + j * 4, _mm256_extractf128_ps(r[j - 4], 1));
+}
+
+CGLM_INLINE
+__m256 glmm_load_n_avx2(float* p, size_t n)
+{
+	__m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	return _mm256_maskload_ps(p, _mm256_cmpgt_epi32(_mm256_set1_epi32((int)n), lanes));
+}
+
+#define GLMM_SOA_T __m256
+#define GLMM_SOA_W 8
+#define GLMM_SOA_FN(name) name##_avx2
+#define GLMM_SOA_LOAD(p) _mm256_loadu_ps(p)
+#define GLMM_SOA_SET1(x) _mm256_set1_ps(x)
+#define GLMM_SOA_ADD(a, b) _mm256_add_ps(a, b)
+#define GLMM_SOA_SUB(a, b) _mm256_sub_ps(a, b)
+#define GLMM_SOA_MUL(a, b) _mm256_mul_ps(a, b)
+#define GLMM_SOA_DIV(a, b) _mm256_div_ps(a, b)
+#define GLMM_SOA_FMADD(a, b, c) _mm256_fmadd_ps(a, b, c)
+#define GLMM_SOA_FNMADD(a, b, c) _mm256_fnmadd_ps(a, b, c)
+#define GLMM_SOA_SQRT(x) _mm256_sqrt_ps(x)
+#define GLMM_SOA_MIN(a, b) _mm256_min_ps(a, b)
+#define GLMM_SOA_MAX(a, b) _mm256_max_ps(a, b)
+#define GLMM_SOA_ROUND(x) _mm256_round_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+#define GLMM_SOA_AND(a, b) _mm256_and_ps(a, b)
+#define GLMM_SOA_XOR(a, b) _mm256_xor_ps(a, b)
+#define GLMM_SOA_SELECT_LT(a, b, x, y) _mm256_blendv_ps(y, x, _mm256_cmp_ps(a, b, _CMP_LT_OQ))
+#define GLMM_SOA_LOADQ(p, q) glmm_quat_load8_avx2(p, 8, q)
+#define GLMM_SOA_STOREQ(p, q) glmm_quat_store8_avx2(p, 8, q)
+#define GLMM_SOA_LOADQ_N(p, n, q) glmm_quat_load8_avx2(p, n, q)
+#define GLMM_SOA_STOREQ_N(p, n, q) glmm_quat_store8_avx2(p, n, q)
+#define GLMM_SOA_LOAD_N(p, n) glmm_load_n_avx2(p, n)
+
+#include "../quat_soa.h"
+
+#undef GLMM_SOA_T
+#undef GLMM_SOA_W
+#undef GLMM_SOA_FN
+#undef GLMM_SOA_LOAD
+#undef GLMM_SOA_SET1
+#undef GLMM_SOA_ADD
+#undef GLMM_SOA_SUB
+#undef GLMM_SOA_MUL
+#undef GLMM_SOA_DIV
+#undef GLMM_SOA_FMADD
+#undef GLMM_SOA_FNMADD
+#undef GLMM_SOA_SQRT
+#undef GLMM_SOA_MIN
+#undef GLMM_SOA_MAX
+#undef GLMM_SOA_ROUND
+#undef GLMM_SOA_AND
+#undef GLMM_SOA_XOR
+#undef GLMM_SOA_SELECT_LT
+#undef GLMM_SOA_LOADQ
+#undef GLMM_SOA_STOREQ
+#undef GLMM_SOA_LOADQ_N
+#undef GLMM_SOA_STOREQ_N
+#undef GLMM_SOA_LOAD_N
+
+#endif
+#endif /* cglm_quat_batch_avx2_h */
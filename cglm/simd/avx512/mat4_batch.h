@@ -0,0 +1,275 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ Functions:
+   CGLM_INLINE void glm_mat4_mul_batch_avx512(mat4* a, mat4* b, mat4* dest, size_t count);
+   CGLM_INLINE void glm_mat4_mul_left_batch_avx512(mat4 left, mat4* right, mat4* dest, size_t count);
+   CGLM_INLINE void glm_mat4_inv_batch_avx512(mat4* mat, mat4* dest, size_t count);
+   CGLM_INLINE void glm_mat4_inv_affine_batch_avx512(mat4* mat, mat4* dest, size_t count);
+   CGLM_INLINE void glm_mat4_transpose_batch_avx512(mat4* mat, mat4* dest, size_t count);
+   CGLM_INLINE void glm_mat4_mulv_batch_avx512(mat4* m, vec4* v, vec4* dest, size_t count);
+   CGLM_INLINE void glm_mat4_mulv_shared_batch_avx512(mat4 m, vec4* v, vec4* dest, size_t count);
+
+   SoA layout, sixteen runs of stride floats per matrix array:
+   CGLM_INLINE void glm_mat4_mul_soa_avx512(float* a, float* b, float* dest, size_t stride, size_t count);
+   CGLM_INLINE void glm_mat4_inv_soa_avx512(float* m, float* dest, size_t stride, size_t count);
+   CGLM_INLINE void glm_mat4_inv_affine_soa_avx512(float* m, float* dest, size_t stride, size_t count);
+   CGLM_INLINE void glm_mat4_transpose_soa_avx512(float* m, float* dest, size_t stride, size_t count);
+   CGLM_INLINE void glm_mat4_mulv_soa_avx512(float* m, float* v, float* dest, size_t stride, size_t count);
+
+ All destinations may alias their sources.
+ */
+
+#ifndef cglm_mat4_batch_avx512_h
+#define cglm_mat4_batch_avx512_h
+#ifdef __AVX512F__
+
+#include "../../common.h"
+#include "../../mat4.h"
+#include "../intrin.h"
+
+#include <immintrin.h>
+
+#define GLMM_SOA_T __m512
+#define GLMM_SOA_W 16
+#define GLMM_SOA_FN(name) name##_avx512
+#define GLMM_SOA_LOAD(p) _mm512_loadu_ps(p)
+#define GLMM_SOA_STORE(p, x) _mm512_storeu_ps(p, x)
+#define GLMM_SOA_SET1(x) _mm512_set1_ps(x)
+#define GLMM_SOA_ADD(a, b) _mm512_add_ps(a, b)
+#define GLMM_SOA_SUB(a, b) _mm512_sub_ps(a, b)
+#define GLMM_SOA_MUL(a, b) _mm512_mul_ps(a, b)
+#define GLMM_SOA_DIV(a, b) _mm512_div_ps(a, b)
+#define GLMM_SOA_FMADD(a, b, c) _mm512_fmadd_ps(a, b, c)
+#define GLMM_SOA_FNMADD(a, b, c) _mm512_fnmadd_ps(a, b, c)
+
+#include "../mat4_soa.h"
+
+#undef GLMM_SOA_T
+#undef GLMM_SOA_W
+#undef GLMM_SOA_FN
+#undef GLMM_SOA_LOAD
+#undef GLMM_SOA_STORE
+#undef GLMM_SOA_SET1
+#undef GLMM_SOA_ADD
+#undef GLMM_SOA_SUB
+#undef GLMM_SOA_MUL
+#undef GLMM_SOA_DIV
+#undef GLMM_SOA_FMADD
+#undef GLMM_SOA_FNMADD
+
+/*
+ * In place 16x16 transpose: a 4x4 transpose inside every 128-bit lane of
+ * each group of four registers, then a 4x4 transpose of the lanes
+ */
+CGLM_INLINE
+void glmm_transpose16_avx512(__m512 r[16])
+{
+	__m512 u[4][4], t0, t1, t2, t3, v0, v1, v2, v3;
+	int g, j;
+
+	for (g = 0; g < 4; g++)
+	{
+		t0 = _mm512_unpacklo_ps(r[g * 4 + 0], r[g * 4 + 1]);
+		t1 = _mm512_unpackhi_ps(r[g * 4 + 0], r[g * 4 + 1]);
+		t2 = _mm512_unpacklo_ps(r[g * 4 + 2], r[g * 4 + 3]);
+		t3 = _mm512_unpackhi_ps(r[g * 4 + 2], r[g * 4 + 3]);
+
+		u[g][0] = _mm512_shuffle_ps(t0, t2, 0x44);
+		u[g][1] = _mm512_shuffle_ps(t0, t2, 0xEE);
+		u[g][2] = _mm512_shuffle_ps(t1, t3, 0x44);
+		u[g][3] = _mm512_shuffle_ps(t1, t3, 0xEE);
+	}
+
+	/* u[g][j] lane l holds element 4l + j of rows 4g .. 4g + 3 */
+	for (j = 0; j < 4; j++)
+	{
+		v0 = _mm512_shuffle_f32x4(u[0][j], u[1][j], 0x44);
+		v1 = _mm512_shuffle_f32x4(u[0][j], u[1][j], 0xEE);
+		v2 = _mm512_shuffle_f32x4(u[2][j], u[3][j], 0x44);
+		v3 = _mm512_shuffle_f32x4(u[2][j], u[3][j], 0xEE);
+
+		r[0 + j] = _mm512_shuffle_f32x4(v0, v2, 0x88);
+		r[4 + j] = _mm512_shuffle_f32x4(v0, v2, 0xDD);
+		r[8 + j] = _mm512_shuffle_f32x4(v1, v3, 0x88);
+		r[12 + j] = _mm512_shuffle_f32x4(v1, v3, 0xDD);
+	}
+}
+
+/* Sixteen AoS matrices into sixteen SoA registers and back */
+CGLM_INLINE
+void glmm_mat4_load16_avx512(mat4* m, __m512 x[16])
+{
+	int k;
+	for (k = 0; k < 16; k++)
+		x[k] = _mm512_loadu_ps(m[k][0]);
+	glmm_transpose16_avx512(x);
+}
+
+CGLM_INLINE
+void glmm_mat4_store16_avx512(mat4* m, __m512 x[16])
+{
+	int k;
+	glmm_transpose16_avx512(x);
+	for (k = 0; k < 16; k++)
+		_mm512_storeu_ps(m[k][0], x[k]);
+}
+
+/* a * b for a whole matrix, a0..a3 holding the columns of a in every lane */
+CGLM_INLINE
+__m512 glmm_mat4_mul4_avx512(__m512 a0, __m512 a1, __m512 a2, __m512 a3, __m512 b)
+{
+	__m512 r;
+	r = _mm512_mul_ps(a0, _mm512_permute_ps(b, 0x00));
+	r = _mm512_fmadd_ps(a1, _mm512_permute_ps(b, 0x55), r);
+	r = _mm512_fmadd_ps(a2, _mm512_permute_ps(b, 0xAA), r);
+	return _mm512_fmadd_ps(a3, _mm512_permute_ps(b, 0xFF), r);
+}
+
+/*!
+ * @brief multiplies count pairs of matrices, dest[i] = a[i] * b[i]
+ *
+ * @param[in]  a     left matrices
+ * @param[in]  b     right matrices
+ * @param[out] dest  products
+ * @param[in]  count number of matrices
+ */
+CGLM_INLINE
+void glm_mat4_mul_batch_avx512(mat4* a, mat4* b, mat4* dest, size_t count)
+{
+	__m512 a0, a1, a2, a3, y;
+	size_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		a0 = _mm512_broadcast_f32x4(_mm_loadu_ps(a[i][0]));
+		a1 = _mm512_broadcast_f32x4(_mm_loadu_ps(a[i][1]));
+		a2 = _mm512_broadcast_f32x4(_mm_loadu_ps(a[i][2]));
+		a3 = _mm512_broadcast_f32x4(_mm_loadu_ps(a[i][3]));
+		y = _mm512_loadu_ps(b[i][0]);
+		_mm512_storeu_ps(dest[i][0], glmm_mat4_mul4_avx512(a0, a1, a2, a3, y));
+	}
+}
+
+/*!
+ * @brief multiplies one matrix by count matrices, dest[i] = left * right[i]
+ */
+CGLM_INLINE
+void glm_mat4_mul_left_batch_avx512(mat4 left, mat4* right, mat4* dest, size_t count)
+{
+	__m512 a0, a1, a2, a3;
+	size_t i;
+
+	a0 = _mm512_broadcast_f32x4(_mm_loadu_ps(left[0]));
+	a1 = _mm512_broadcast_f32x4(_mm_loadu_ps(left[1]));
+	a2 = _mm512_broadcast_f32x4(_mm_loadu_ps(left[2]));
+	a3 = _mm512_broadcast_f32x4(_mm_loadu_ps(left[3]));
+
+	for (i = 0; i < count; i++)
+		_mm512_storeu_ps(dest[i][0], glmm_mat4_mul4_avx512(a0, a1, a2, a3, _mm512_loadu_ps(right[i][0])));
+}
+
+/*!
+ * @brief inverts count matrices, sixteen at a time in SoA registers
+ */
+CGLM_INLINE
+void glm_mat4_inv_batch_avx512(mat4* mat, mat4* dest, size_t count)
+{
+	__m512 x[16];
+	size_t i;
+
+	for (i = 0; i + 16 <= count; i += 16)
+	{
+		glmm_mat4_load16_avx512(mat + i, x);
+		glmm_mat4_inv_soa_avx512(x, x);
+		glmm_mat4_store16_avx512(dest + i, x);
+	}
+	for (; i < count; i++)
+		glm_mat4_inv(mat[i], dest[i]);
+}
+
+/*!
+ * @brief inverts count affine matrices, last rows must be 0 0 0 1
+ */
+CGLM_INLINE
+void glm_mat4_inv_affine_batch_avx512(mat4* mat, mat4* dest, size_t count)
+{
+	__m512 x[16];
+	size_t i;
+
+	for (i = 0; i + 16 <= count; i += 16)
+	{
+		glmm_mat4_load16_avx512(mat + i, x);
+		glmm_mat4_inv_affine_soa_avx512(x, x);
+		glmm_mat4_store16_avx512(dest + i, x);
+	}
+	for (; i < count; i++)
+		glm_mat4_inv(mat[i], dest[i]);
+}
+
+/*!
+ * @brief transposes count matrices, one permute per matrix
+ */
+CGLM_INLINE
+void glm_mat4_transpose_batch_avx512(mat4* mat, mat4* dest, size_t count)
+{
+	__m512i idx;
+	size_t i;
+
+	idx = _mm512_set_epi32(15, 11, 7, 3, 14, 10, 6, 2, 13, 9, 5, 1, 12, 8, 4, 0);
+	for (i = 0; i < count; i++)
+		_mm512_storeu_ps(dest[i][0], _mm512_permutexvar_ps(idx, _mm512_loadu_ps(mat[i][0])));
+}
+
+/*!
+ * @brief transforms each vector by its own matrix, dest[i] = m[i] * v[i]
+ */
+CGLM_INLINE
+void glm_mat4_mulv_batch_avx512(mat4* m, vec4* v, vec4* dest, size_t count)
+{
+	__m512i idx;
+	__m512 x;
+	__m256 y;
+	__m128 r;
+	size_t i;
+
+	/* lane k of the broadcast vector becomes v[k] everywhere */
+	idx = _mm512_set_epi32(3, 3, 3, 3, 2, 2, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0);
+	for (i = 0; i < count; i++)
+	{
+		x = _mm512_permutexvar_ps(idx, _mm512_castps128_ps512(_mm_loadu_ps(v[i])));
+		x = _mm512_mul_ps(_mm512_loadu_ps(m[i][0]), x);
+		y = _mm256_add_ps(_mm512_castps512_ps256(x),
+				_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(x), 1)));
+		r = _mm_add_ps(_mm256_castps256_ps128(y), _mm256_extractf128_ps(y, 1));
+		_mm_storeu_ps(dest[i], r);
+	}
+}
+
+/*!
+ * @brief transforms count vectors by one matrix, four per iteration
+ */
+CGLM_INLINE
+void glm_mat4_mulv_shared_batch_avx512(mat4 m, vec4* v, vec4* dest, size_t count)
+{
+	__m512 m0, m1, m2, m3;
+	size_t i;
+
+	m0 = _mm512_broadcast_f32x4(_mm_loadu_ps(m[0]));
+	m1 = _mm512_broadcast_f32x4(_mm_loadu_ps(m[1]));
+	m2 = _mm512_broadcast_f32x4(_mm_loadu_ps(m[2]));
+	m3 = _mm512_broadcast_f32x4(_mm_loadu_ps(m[3]));
+
+	for (i = 0; i + 4 <= count; i += 4)
+		_mm512_storeu_ps(dest[i], glmm_mat4_mul4_avx512(m0, m1, m2, m3, _mm512_loadu_ps(v[i])));
+	for (; i < count; i++)
+		glm_mat4_mulv(m, v[i], dest[i]);
+}
+
+#endif
+#endif /* cglm_mat4_batch_avx512_h */
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ Functions:
+   CGLM_INLINE void glm_quat_mul_batch_avx512(versor* a, versor* b, versor* dest, size_t count);
+   CGLM_INLINE void glm_quat_integrate_batch_avx512(versor* q, vec4* spins, float time, size_t count);
+   CGLM_INLINE void glm_quat_normalize_batch_avx512(versor* q, size_t count);
+   CGLM_INLINE void glm_quat_nlerp_batch_avx512(versor* from, versor* to, float* t, versor* dest, size_t count);
+   CGLM_INLINE void glm_quat_slerp_batch_avx512(versor* from, versor* to, float* t, versor* dest, size_t count);
+
+ Sixteen quaternions per iteration, see quat_soa.h. All destinations may
+ alias their sources.
+ */
+
+#ifndef cglm_quat_batch_avx512_h
+#define cglm_quat_batch_avx512_h
+#ifdef __AVX512F__
+
+#include <float.h>
+#include <stddef.h>
+#include "../../common.h"
+#include "../intrin.h"
+
+#include <immintrin.h>
+
+/* After a 4x4 transpose inside every 128-bit lane, element 4l + k of a
+   register holds quaternion 4k + l. Swapping l and k is its own inverse,
+   so loads and stores share the index. */
+#define GLMM_QUAT_ORDER_AVX512 \
+	_mm512_setr_epi32(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15)
+
+CGLM_INLINE
+void glmm_quat_load16_avx512(float* p, __m512 q[4])
+{
+	__m512 t0, t1, t2, t3, r0, r1, r2, r3;
+	__m512i order = GLMM_QUAT_ORDER_AVX512;
+
+	r0 = _mm512_loadu_ps(p);
+	r1 = _mm512_loadu_ps(p + 16);
+	r2 = _mm512_loadu_ps(p + 32);
+	r3 = _mm512_loadu_ps(p + 48);
+
+	t0 = _mm512_unpacklo_ps(r0, r1);
+	t1 = _mm512_unpacklo_ps(r2, r3);
+	t2 = _mm512_unpackhi_ps(r0, r1);
+	t3 = _mm512_unpackhi_ps(r2, r3);
+
+	q[0] = _mm512_permutexvar_ps(order, _mm512_shuffle_ps(t0, t1, 0x44));
+	q[1] = _mm512_permutexvar_ps(order, _mm512_shuffle_ps(t0, t1, 0xEE));
+	q[2] = _mm512_permutexvar_ps(order, _mm512_shuffle_ps(t2, t3, 0x44));
+	q[3] = _mm512_permutexvar_ps(order, _mm512_shuffle_ps(t2, t3, 0xEE));
+}
+
+CGLM_INLINE
+void glmm_quat_store16_avx512(float* p, __m512 q[4])
+{
+	__m512 t0, t1, t2, t3, r0, r1, r2, r3;
+	__m512i order = GLMM_QUAT_ORDER_AVX512;
+
+	r0 = _mm512_permutexvar_ps(order, q[0]);
+	r1 = _mm512_permutexvar_ps(order, q[1]);
+	r2 = _mm512_permutexvar_ps(order, q[2]);
+	r3 = _mm512_permutexvar_ps(order, q[3]);
+
+	t0 = _mm512_unpacklo_ps(r0, r1);
+	t1 = _mm512_unpacklo_ps(r2, r3);
+	t2 = _mm512_unpackhi_ps(r0, r1);
+	t3 = _mm512_unpackhi_ps(r2, r3);
+
+	_mm512_storeu_ps(p, _mm512_shuffle_ps(t0, t1, 0x44));
+	_mm512_storeu_ps(p + 16, _mm512_shuffle_ps(t0, t1, 0xEE));
+	_mm512_storeu_ps(p + 32, _mm512_shuffle_ps(t2, t3, 0x44));
+	_mm512_storeu_ps(p + 48, _mm512_shuffle_ps(t2, t3, 0xEE));
+}
+
+/* Lanes of the first f floats of a register */
+CGLM_INLINE
+__mmask16 glmm_mask_avx512(ptrdiff_t f)
+{
+	return f >= 16 ? (__mmask16)0xFFFF : f <= 0 ? (__mmask16)0 : (__mmask16)((1u << f) - 1);
+}
+
+/* The first n quaternions at p, zeros past them */
+CGLM_INLINE
+void glmm_quat_load16_n_avx512(float* p, size_t n, __m512 q[4])
+{
+	__m512 t0, t1, t2, t3, r0, r1, r2, r3;
+	__m512i order = GLMM_QUAT_ORDER_AVX512;
+	ptrdiff_t f = (ptrdiff_t)n * 4;
+
+	r0 = _mm512_maskz_loadu_ps(glmm_mask_avx512(f), p);
+	r1 = _mm512_maskz_loadu_ps(glmm_mask_avx512(f - 16), p + 16);
+	r2 = _mm512_maskz_loadu_ps(glmm_mask_avx512(f - 32), p + 32);
+	r3 = _mm512_maskz_loadu_ps(glmm_mask_avx512(f - 48), p + 48);
+
+	t0 = _mm512_unpacklo_ps(r0, r1);
+	t1 = _mm512_unpacklo_ps(r2, r3);
+	t2 = _mm512_unpackhi_ps(r0, r1);
+	t3 = _mm512_unpackhi_ps(r2, r3);
+
+	q[0] = _mm512_permutexvar_ps(order, _mm512_shuffle_ps(t0, t1, 0x44));
+	q[1] = _mm512_permutexvar_ps(order, _mm512_shuffle_ps(t0, t1, 0xEE));
+	q[2] = _mm512_permutexvar_ps(order, _mm512_shuffle_ps(t2, t3, 0x44));
+	q[3] = _mm512_permutexvar_ps(order, _mm512_shuffle_ps(t2, t3, 0xEE));
+}
+
+CGLM_INLINE
+void glmm_quat_store16_n_avx512(float* p, size_t n, __m512 q[4])
+{
+	__m512 t0, t1, t2, t3, r0, r1, r2, r3;
+	__m512i order = GLMM_QUAT_ORDER_AVX512;
+	ptrdiff_t f = (ptrdiff_t)n * 4;
+
+	r0 = _mm512_permutexvar_ps(order, q[0]);
+	r1 = _mm512_permutexvar_ps(order, q[1]);
+	r2 = _mm512_permutexvar_ps(order, q[2]);
+	r3 = _mm512_permutexvar_ps(order, q[3]);
+
+	t0 = _mm512_unpacklo_ps(r0, r1);
+	t1 = _mm512_unpacklo_ps(r2, r3);
+	t2 = _mm512_unpackhi_ps(r0, r1);
+	t3 = _mm512_unpackhi_ps(r2, r3);
+
+	_mm512_mask_storeu_ps(p, glmm_mask_avx512(f), _mm512_shuffle_ps(t0, t1, 0x44));
+	_mm512_mask_storeu_ps(p + 16, glmm_mask_avx512(f - 16), _mm512_shuffle_ps(t0, t1, 0xEE));
+	_mm512_mask_storeu_ps(p + 32, glmm_mask_avx512(f - 32), _mm512_shuffle_ps(t2, t3, 0x44));
+	_mm512_mask_storeu_ps(p + 48, glmm_mask_avx512(f - 48), _mm512_shuffle_ps(t2, t3, 0xEE));
+}
+
+/* Plain AVX-512F has no floating point logic, only the integer one */
+#define GLMM_SOA_BITS_AVX512(op, a, b) \
+	_mm512_castsi512_ps(op(_mm512_castps_si512(a), _mm512_castps_si512(b)))
+
+#define GLMM_SOA_T __m512
+#define GLMM_SOA_W 16
+#define GLMM_SOA_FN(name) name##_avx512
+#define GLMM_SOA_LOAD(p) _mm512_loadu_ps(p)
+#define GLMM_SOA_SET1(x) _mm512_set1_ps(x)
+#define GLMM_SOA_ADD(a, b) _mm512_add_ps(a, b)
+#define GLMM_SOA_SUB(a, b) _mm512_sub_ps(a, b)
+#define GLMM_SOA_MUL(a, b) _mm512_mul_ps(a, b)
+#define GLMM_SOA_DIV(a, b) _mm512_div_ps(a, b)
+#define GLMM_SOA_FMADD(a, b, c) _mm512_fmadd_ps(a, b, c)
+#define GLMM_SOA_FNMADD(a, b, c) _mm512_fnmadd_ps(a, b, c)
+#define GLMM_SOA_SQRT(x) _mm512_sqrt_ps(x)
+#define GLMM_SOA_MIN(a, b) _mm512_min_ps(a, b)
+#define GLMM_SOA_MAX(a, b) _mm512_max_ps(a, b)
+#define GLMM_SOA_ROUND(x) _mm512_roundscale_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+#define GLMM_SOA_AND(a, b) GLMM_SOA_BITS_AVX512(_mm512_and_si512, a, b)
+#define GLMM_SOA_XOR(a, b) GLMM_SOA_BITS_AVX512(_mm512_xor_si512, a, b)
+#define GLMM_SOA_SELECT_LT(a, b, x, y) _mm512_mask_blend_ps(_mm512_cmp_ps_mask(a, b, _CMP_LT_OQ), y, x)
+#define GLMM_SOA_LOADQ(p, q) glmm_quat_load16_avx512(p, q)
+#define GLMM_SOA_STOREQ(p, q) glmm_quat_store16_avx512(p, q)
+#define GLMM_SOA_LOADQ_N(p, n, q) glmm_quat_load16_n_avx512(p, n, q)
+#define GLMM_SOA_STOREQ_N(p, n, q) glmm_quat_store16_n_avx512(p, n, q)
+#define GLMM_SOA_LOAD_N(p, n) _mm512_maskz_loadu_ps(glmm_mask_avx512((ptrdiff_t)(n)), p)
+
+#include "../quat_soa.h"
+
+#undef GLMM_SOA_T
+#undef GLMM_SOA_W
+#undef GLMM_SOA_FN
+#undef GLMM_SOA_LOAD
+#undef GLMM_SOA_SET1
+#undef GLMM_SOA_ADD
+#undef GLMM_SOA_SUB
+#undef GLMM_SOA_MUL
+#undef GLMM_SOA_DIV
+#undef GLMM_SOA_FMADD
+#undef GLMM_SOA_FNMADD
+#undef GLMM_SOA_SQRT
+#undef GLMM_SOA_MIN
+#undef GLMM_SOA_MAX
+#undef GLMM_SOA_ROUND
+#undef GLMM_SOA_AND
+#undef GLMM_SOA_XOR
+#undef GLMM_SOA_SELECT_LT
+#undef GLMM_SOA_LOADQ
+#undef GLMM_SOA_STOREQ
+#undef GLMM_SOA_LOADQ_N
+#undef GLMM_SOA_STOREQ_N
+#undef GLMM_SOA_LOAD_N
+
+#endif
+#endif /* cglm_quat_batch_avx512_h */
@@ -0,0 +1,421 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Batched mat4 math on registers that hold one element of GLMM_SOA_W
+ * matrices each, included by the AVX2 and AVX-512 batch headers after
+ * they define the macros below. No include guard: every instruction set
+ * instantiates its own copy.
+ *
+ *   GLMM_SOA_T              register type
+ *   GLMM_SOA_W              matrices per register
+ *   GLMM_SOA_FN(name)       name of an instantiated function
+ *   GLMM_SOA_LOAD(p)        unaligned load
+ *   GLMM_SOA_STORE(p, x)    unaligned store
+ *   GLMM_SOA_SET1(x)        broadcast
+ *   GLMM_SOA_ADD, _SUB, _MUL, _DIV
+ *   GLMM_SOA_FMADD(a, b, c) a * b + c
+ *   GLMM_SOA_FNMADD(a, b, c) c - a * b
+ *
+ * Registers are indexed like a flattened column major mat4: column * 4 +
+ * row. SoA arrays keep the sixteen elements in sixteen runs of stride
+ * floats, element e of matrix i at soa[e * stride + i].
+ */
+
+/* d = a * b */
+CGLM_INLINE
+void GLMM_SOA_FN(glmm_mat4_mul_soa)(GLMM_SOA_T a[16], GLMM_SOA_T b[16], GLMM_SOA_T d[16])
+{
+	GLMM_SOA_T r[16];
+
+	r[0] = GLMM_SOA_FMADD(a[12], b[3], GLMM_SOA_FMADD(a[8], b[2], GLMM_SOA_FMADD(a[4], b[1], GLMM_SOA_MUL(a[0], b[0]))));
+	r[1] = GLMM_SOA_FMADD(a[13], b[3], GLMM_SOA_FMADD(a[9], b[2], GLMM_SOA_FMADD(a[5], b[1], GLMM_SOA_MUL(a[1], b[0]))));
+	r[2] = GLMM_SOA_FMADD(a[14], b[3], GLMM_SOA_FMADD(a[10], b[2], GLMM_SOA_FMADD(a[6], b[1], GLMM_SOA_MUL(a[2], b[0]))));
+	r[3] = GLMM_SOA_FMADD(a[15], b[3], GLMM_SOA_FMADD(a[11], b[2], GLMM_SOA_FMADD(a[7], b[1], GLMM_SOA_MUL(a[3], b[0]))));
+	r[4] = GLMM_SOA_FMADD(a[12], b[7], GLMM_SOA_FMADD(a[8], b[6], GLMM_SOA_FMADD(a[4], b[5], GLMM_SOA_MUL(a[0], b[4]))));
+	r[5] = GLMM_SOA_FMADD(a[13], b[7], GLMM_SOA_FMADD(a[9], b[6], GLMM_SOA_FMADD(a[5], b[5], GLMM_SOA_MUL(a[1], b[4]))));
+	r[6] = GLMM_SOA_FMADD(a[14], b[7], GLMM_SOA_FMADD(a[10], b[6], GLMM_SOA_FMADD(a[6], b[5], GLMM_SOA_MUL(a[2], b[4]))));
+	r[7] = GLMM_SOA_FMADD(a[15], b[7], GLMM_SOA_FMADD(a[11], b[6], GLMM_SOA_FMADD(a[7], b[5], GLMM_SOA_MUL(a[3], b[4]))));
+	r[8] = GLMM_SOA_FMADD(a[12], b[11], GLMM_SOA_FMADD(a[8], b[10], GLMM_SOA_FMADD(a[4], b[9], GLMM_SOA_MUL(a[0], b[8]))));
+	r[9] = GLMM_SOA_FMADD(a[13], b[11], GLMM_SOA_FMADD(a[9], b[10], GLMM_SOA_FMADD(a[5], b[9], GLMM_SOA_MUL(a[1], b[8]))));
+	r[10] = GLMM_SOA_FMADD(a[14], b[11], GLMM_SOA_FMADD(a[10], b[10], GLMM_SOA_FMADD(a[6], b[9], GLMM_SOA_MUL(a[2], b[8]))));
+	r[11] = GLMM_SOA_FMADD(a[15], b[11], GLMM_SOA_FMADD(a[11], b[10], GLMM_SOA_FMADD(a[7], b[9], GLMM_SOA_MUL(a[3], b[8]))));
+	r[12] = GLMM_SOA_FMADD(a[12], b[15], GLMM_SOA_FMADD(a[8], b[14], GLMM_SOA_FMADD(a[4], b[13], GLMM_SOA_MUL(a[0], b[12]))));
+	r[13] = GLMM_SOA_FMADD(a[13], b[15], GLMM_SOA_FMADD(a[9], b[14], GLMM_SOA_FMADD(a[5], b[13], GLMM_SOA_MUL(a[1], b[12]))));
+	r[14] = GLMM_SOA_FMADD(a[14], b[15], GLMM_SOA_FMADD(a[10], b[14], GLMM_SOA_FMADD(a[6], b[13], GLMM_SOA_MUL(a[2], b[12]))));
+	r[15] = GLMM_SOA_FMADD(a[15], b[15], GLMM_SOA_FMADD(a[11], b[14], GLMM_SOA_FMADD(a[7], b[13], GLMM_SOA_MUL(a[3], b[12]))));
+
+	d[0] = r[0];
+	d[1] = r[1];
+	d[2] = r[2];
+	d[3] = r[3];
+	d[4] = r[4];
+	d[5] = r[5];
+	d[6] = r[6];
+	d[7] = r[7];
+	d[8] = r[8];
+	d[9] = r[9];
+	d[10] = r[10];
+	d[11] = r[11];
+	d[12] = r[12];
+	d[13] = r[13];
+	d[14] = r[14];
+	d[15] = r[15];
+}
+
+/* Same cofactor expansion as the scalar glm_mat4_inv */
+CGLM_INLINE
+void GLMM_SOA_FN(glmm_mat4_inv_soa)(GLMM_SOA_T m[16], GLMM_SOA_T d[16])
+{
+	GLMM_SOA_T t0, t1, t2, t3, t4, t5, det, r[16];
+	GLMM_SOA_T a = m[0], b = m[1], c = m[2], dd = m[3],
+	           e = m[4], f = m[5], g = m[6], h = m[7],
+	           i = m[8], j = m[9], k = m[10], l = m[11],
+	           mm = m[12], n = m[13], o = m[14], p = m[15];
+
+	t0 = GLMM_SOA_FNMADD(o, l, GLMM_SOA_MUL(k, p));
+	t1 = GLMM_SOA_FNMADD(n, l, GLMM_SOA_MUL(j, p));
+	t2 = GLMM_SOA_FNMADD(n, k, GLMM_SOA_MUL(j, o));
+	t3 = GLMM_SOA_FNMADD(mm, l, GLMM_SOA_MUL(i, p));
+	t4 = GLMM_SOA_FNMADD(mm, k, GLMM_SOA_MUL(i, o));
+	t5 = GLMM_SOA_FNMADD(mm, j, GLMM_SOA_MUL(i, n));
+
+	r[0]  = GLMM_SOA_FMADD(h, t2, GLMM_SOA_FNMADD(g, t1, GLMM_SOA_MUL(f, t0)));
+	r[4]  = GLMM_SOA_FNMADD(h, t4, GLMM_SOA_FMADD(g, t3, GLMM_SOA_MUL(GLMM_SOA_SUB(GLMM_SOA_SET1(0.0f), e), t0)));
+	r[8]  = GLMM_SOA_FMADD(h, t5, GLMM_SOA_FNMADD(f, t3, GLMM_SOA_MUL(e, t1)));
+	r[12] = GLMM_SOA_FNMADD(g, t5, GLMM_SOA_FMADD(f, t4, GLMM_SOA_MUL(GLMM_SOA_SUB(GLMM_SOA_SET1(0.0f), e), t2)));
+
+	r[1]  = GLMM_SOA_FNMADD(dd, t2, GLMM_SOA_FMADD(c, t1, GLMM_SOA_MUL(GLMM_SOA_SUB(GLMM_SOA_SET1(0.0f), b), t0)));
+	r[5]  = GLMM_SOA_FMADD(dd, t4, GLMM_SOA_FNMADD(c, t3, GLMM_SOA_MUL(a, t0)));
+	r[9]  = GLMM_SOA_FNMADD(dd, t5, GLMM_SOA_FMADD(b, t3, GLMM_SOA_MUL(GLMM_SOA_SUB(GLMM_SOA_SET1(0.0f), a), t1)));
+	r[13] = GLMM_SOA_FMADD(c, t5, GLMM_SOA_FNMADD(b, t4, GLMM_SOA_MUL(a, t2)));
+
+	t0 = GLMM_SOA_FNMADD(o, h, GLMM_SOA_MUL(g, p));
+	t1 = GLMM_SOA_FNMADD(n, h, GLMM_SOA_MUL(f, p));
+	t2 = GLMM_SOA_FNMADD(n, g, GLMM_SOA_MUL(f, o));
+	t3 = GLMM_SOA_FNMADD(mm, h, GLMM_SOA_MUL(e, p));
+	t4 = GLMM_SOA_FNMADD(mm, g, GLMM_SOA_MUL(e, o));
+	t5 = GLMM_SOA_FNMADD(mm, f, GLMM_SOA_MUL(e, n));
+
+	r[2]  = GLMM_SOA_FMADD(dd, t2, GLMM_SOA_FNMADD(c, t1, GLMM_SOA_MUL(b, t0)));
+	r[6]  = GLMM_SOA_FNMADD(dd, t4, GLMM_SOA_FMADD(c, t3, GLMM_SOA_MUL(GLMM_SOA_SUB(GLMM_SOA_SET1(0.0f), a), t0)));
+	r[10] = GLMM_SOA_FMADD(dd, t5, GLMM_SOA_FNMADD(b, t3, GLMM_SOA_MUL(a, t1)));
+	r[14] = GLMM_SOA_FNMADD(c, t5, GLMM_SOA_FMADD(b, t4, GLMM_SOA_MUL(GLMM_SOA_SUB(GLMM_SOA_SET1(0.0f), a), t2)));
+
+	t0 = GLMM_SOA_FNMADD(k, h, GLMM_SOA_MUL(g, l));
+	t1 = GLMM_SOA_FNMADD(j, h, GLMM_SOA_MUL(f, l));
+	t2 = GLMM_SOA_FNMADD(j, g, GLMM_SOA_MUL(f, k));
+	t3 = GLMM_SOA_FNMADD(i, h, GLMM_SOA_MUL(e, l));
+	t4 = GLMM_SOA_FNMADD(i, g, GLMM_SOA_MUL(e, k));
+	t5 = GLMM_SOA_FNMADD(i, f, GLMM_SOA_MUL(e, j));
+
+	r[3]  = GLMM_SOA_FNMADD(dd, t2, GLMM_SOA_FMADD(c, t1, GLMM_SOA_MUL(GLMM_SOA_SUB(GLMM_SOA_SET1(0.0f), b), t0)));
+	r[7]  = GLMM_SOA_FMADD(dd, t4, GLMM_SOA_FNMADD(c, t3, GLMM_SOA_MUL(a, t0)));
+	r[11] = GLMM_SOA_FNMADD(dd, t5, GLMM_SOA_FMADD(b, t3, GLMM_SOA_MUL(GLMM_SOA_SUB(GLMM_SOA_SET1(0.0f), a), t1)));
+	r[15] = GLMM_SOA_FMADD(c, t5, GLMM_SOA_FNMADD(b, t4, GLMM_SOA_MUL(a, t2)));
+
+	det = GLMM_SOA_FMADD(dd, r[12], GLMM_SOA_FMADD(c, r[8], GLMM_SOA_FMADD(b, r[4], GLMM_SOA_MUL(a, r[0]))));
+	det = GLMM_SOA_DIV(GLMM_SOA_SET1(1.0f), det);
+
+	d[0] = GLMM_SOA_MUL(r[0], det);
+	d[1] = GLMM_SOA_MUL(r[1], det);
+	d[2] = GLMM_SOA_MUL(r[2], det);
+	d[3] = GLMM_SOA_MUL(r[3], det);
+	d[4] = GLMM_SOA_MUL(r[4], det);
+	d[5] = GLMM_SOA_MUL(r[5], det);
+	d[6] = GLMM_SOA_MUL(r[6], det);
+	d[7] = GLMM_SOA_MUL(r[7], det);
+	d[8] = GLMM_SOA_MUL(r[8], det);
+	d[9] = GLMM_SOA_MUL(r[9], det);
+	d[10] = GLMM_SOA_MUL(r[10], det);
+	d[11] = GLMM_SOA_MUL(r[11], det);
+	d[12] = GLMM_SOA_MUL(r[12], det);
+	d[13] = GLMM_SOA_MUL(r[13], det);
+	d[14] = GLMM_SOA_MUL(r[14], det);
+	d[15] = GLMM_SOA_MUL(r[15], det);
+}
+
+/*
+ * Inverse of a matrix whose last row is 0 0 0 1: rows of the inverse 3x3
+ * are cross products of its columns over the determinant, the translation
+ * is minus the inverse 3x3 times the old translation
+ */
+CGLM_INLINE
+void GLMM_SOA_FN(glmm_mat4_inv_affine_soa)(GLMM_SOA_T m[16], GLMM_SOA_T d[16])
+{
+	GLMM_SOA_T x00, x01, x02, x10, x11, x12, x20, x21, x22, det, t0, t1, t2;
+
+	/* row r of the inverse is column r + 1 cross column r + 2 */
+	x00 = GLMM_SOA_FNMADD(m[6], m[9], GLMM_SOA_MUL(m[5], m[10]));
+	x01 = GLMM_SOA_FNMADD(m[4], m[10], GLMM_SOA_MUL(m[6], m[8]));
+	x02 = GLMM_SOA_FNMADD(m[5], m[8], GLMM_SOA_MUL(m[4], m[9]));
+	x10 = GLMM_SOA_FNMADD(m[10], m[1], GLMM_SOA_MUL(m[9], m[2]));
+	x11 = GLMM_SOA_FNMADD(m[8], m[2], GLMM_SOA_MUL(m[10], m[0]));
+	x12 = GLMM_SOA_FNMADD(m[9], m[0], GLMM_SOA_MUL(m[8], m[1]));
+	x20 = GLMM_SOA_FNMADD(m[2], m[5], GLMM_SOA_MUL(m[1], m[6]));
+	x21 = GLMM_SOA_FNMADD(m[0], m[6], GLMM_SOA_MUL(m[2], m[4]));
+	x22 = GLMM_SOA_FNMADD(m[1], m[4], GLMM_SOA_MUL(m[0], m[5]));
+
+	det = GLMM_SOA_FMADD(m[2], x02, GLMM_SOA_FMADD(m[1], x01, GLMM_SOA_MUL(m[0], x00)));
+	det = GLMM_SOA_DIV(GLMM_SOA_SET1(1.0f), det);
+	t0 = m[12];
+	t1 = m[13];
+	t2 = m[14];
+
+	d[0] = GLMM_SOA_MUL(x00, det);
+	d[4] = GLMM_SOA_MUL(x01, det);
+	d[8] = GLMM_SOA_MUL(x02, det);
+	d[1] = GLMM_SOA_MUL(x10, det);
+	d[5] = GLMM_SOA_MUL(x11, det);
+	d[9] = GLMM_SOA_MUL(x12, det);
+	d[2] = GLMM_SOA_MUL(x20, det);
+	d[6] = GLMM_SOA_MUL(x21, det);
+	d[10] = GLMM_SOA_MUL(x22, det);
+
+	d[12] = GLMM_SOA_SUB(GLMM_SOA_SET1(0.0f), GLMM_SOA_FMADD(d[8], t2, GLMM_SOA_FMADD(d[4], t1, GLMM_SOA_MUL(d[0], t0))));
+	d[13] = GLMM_SOA_SUB(GLMM_SOA_SET1(0.0f), GLMM_SOA_FMADD(d[9], t2, GLMM_SOA_FMADD(d[5], t1, GLMM_SOA_MUL(d[1], t0))));
+	d[14] = GLMM_SOA_SUB(GLMM_SOA_SET1(0.0f), GLMM_SOA_FMADD(d[10], t2, GLMM_SOA_FMADD(d[6], t1, GLMM_SOA_MUL(d[2], t0))));
+
+	d[3] = d[7] = d[11] = GLMM_SOA_SET1(0.0f);
+	d[15] = GLMM_SOA_SET1(1.0f);
+}
+
+CGLM_INLINE
+void GLMM_SOA_FN(glmm_mat4_transpose_soa)(GLMM_SOA_T m[16], GLMM_SOA_T d[16])
+{
+	GLMM_SOA_T t;
+
+	d[0] = m[0];
+	d[5] = m[5];
+	d[10] = m[10];
+	d[15] = m[15];
+	t = m[1];
+	d[1] = m[4];
+	d[4] = t;
+	t = m[2];
+	d[2] = m[8];
+	d[8] = t;
+	t = m[3];
+	d[3] = m[12];
+	d[12] = t;
+	t = m[6];
+	d[6] = m[9];
+	d[9] = t;
+	t = m[7];
+	d[7] = m[13];
+	d[13] = t;
+	t = m[11];
+	d[11] = m[14];
+	d[14] = t;
+}
+
+/* d = m * v */
+CGLM_INLINE
+void GLMM_SOA_FN(glmm_mat4_mulv_soa)(GLMM_SOA_T m[16], GLMM_SOA_T v[4], GLMM_SOA_T d[4])
+{
+	GLMM_SOA_T r0, r1, r2, r3;
+
+	r0 = GLMM_SOA_FMADD(m[12], v[3], GLMM_SOA_FMADD(m[8], v[2], GLMM_SOA_FMADD(m[4], v[1], GLMM_SOA_MUL(m[0], v[0]))));
+	r1 = GLMM_SOA_FMADD(m[13], v[3], GLMM_SOA_FMADD(m[9], v[2], GLMM_SOA_FMADD(m[5], v[1], GLMM_SOA_MUL(m[1], v[0]))));
+	r2 = GLMM_SOA_FMADD(m[14], v[3], GLMM_SOA_FMADD(m[10], v[2], GLMM_SOA_FMADD(m[6], v[1], GLMM_SOA_MUL(m[2], v[0]))));
+	r3 = GLMM_SOA_FMADD(m[15], v[3], GLMM_SOA_FMADD(m[11], v[2], GLMM_SOA_FMADD(m[7], v[1], GLMM_SOA_MUL(m[3], v[0]))));
+
+	d[0] = r0;
+	d[1] = r1;
+	d[2] = r2;
+	d[3] = r3;
+}
+
+CGLM_INLINE
+void GLMM_SOA_FN(glmm_soa_load4)(float* soa, size_t stride, size_t i, GLMM_SOA_T x[4])
+{
+	soa += i;
+	x[0] = GLMM_SOA_LOAD(soa);
+	x[1] = GLMM_SOA_LOAD(soa + stride);
+	x[2] = GLMM_SOA_LOAD(soa + stride * 2);
+	x[3] = GLMM_SOA_LOAD(soa + stride * 3);
+}
+
+CGLM_INLINE
+void GLMM_SOA_FN(glmm_soa_load16)(float* soa, size_t stride, size_t i, GLMM_SOA_T x[16])
+{
+	GLMM_SOA_FN(glmm_soa_load4)(soa, stride, i, x);
+	GLMM_SOA_FN(glmm_soa_load4)(soa + stride * 4, stride, i, x + 4);
+	GLMM_SOA_FN(glmm_soa_load4)(soa + stride * 8, stride, i, x + 8);
+	GLMM_SOA_FN(glmm_soa_load4)(soa + stride * 12, stride, i, x + 12);
+}
+
+CGLM_INLINE
+void GLMM_SOA_FN(glmm_soa_store4)(float* soa, size_t stride, size_t i, GLMM_SOA_T x[4])
+{
+	soa += i;
+	GLMM_SOA_STORE(soa, x[0]);
+	GLMM_SOA_STORE(soa + stride, x[1]);
+	GLMM_SOA_STORE(soa + stride * 2, x[2]);
+	GLMM_SOA_STORE(soa + stride * 3, x[3]);
+}
+
+CGLM_INLINE
+void GLMM_SOA_FN(glmm_soa_store16)(float* soa, size_t stride, size_t i, GLMM_SOA_T x[16])
+{
+	GLMM_SOA_FN(glmm_soa_store4)(soa, stride, i, x);
+	GLMM_SOA_FN(glmm_soa_store4)(soa + stride * 4, stride, i, x + 4);
+	GLMM_SOA_FN(glmm_soa_store4)(soa + stride * 8, stride, i, x + 8);
+	GLMM_SOA_FN(glmm_soa_store4)(soa + stride * 12, stride, i, x + 12);
+}
+
+/* Matrices past the last full register go through the scalar routines */
+CGLM_INLINE
+void GLMM_SOA_FN(glmm_soa_get)(float* soa, size_t stride, size_t i, float* x, int count)
+{
+	int e;
+	for (e = 0; e < count; e++)
+		x[e] = soa[e * stride + i];
+}
+
+CGLM_INLINE
+void GLMM_SOA_FN(glmm_soa_set)(float* soa, size_t stride, size_t i, float* x, int count)
+{
+	int e;
+	for (e = 0; e < count; e++)
+		soa[e * stride + i] = x[e];
+}
+
+/*!
+ * @brief multiplies count pairs of SoA matrices, dest = a * b
+ *
+ * @param[in]  a      left matrices, sixteen runs of stride floats
+ * @param[in]  b      right matrices
+ * @param[out] dest   products, may be a or b
+ * @param[in]  stride floats per element run
+ * @param[in]  count  matrices, at most stride
+ */
+CGLM_INLINE
+void GLMM_SOA_FN(glm_mat4_mul_soa)(float* a, float* b, float* dest, size_t stride, size_t count)
+{
+	GLMM_SOA_T x[16], y[16];
+	mat4 s, t;
+	size_t i;
+
+	for (i = 0; i + GLMM_SOA_W <= count; i += GLMM_SOA_W)
+	{
+		GLMM_SOA_FN(glmm_soa_load16)(a, stride, i, x);
+		GLMM_SOA_FN(glmm_soa_load16)(b, stride, i, y);
+		GLMM_SOA_FN(glmm_mat4_mul_soa)(x, y, x);
+		GLMM_SOA_FN(glmm_soa_store16)(dest, stride, i, x);
+	}
+	for (; i < count; i++)
+	{
+		GLMM_SOA_FN(glmm_soa_get)(a, stride, i, s[0], 16);
+		GLMM_SOA_FN(glmm_soa_get)(b, stride, i, t[0], 16);
+		glm_mat4_mul(s, t, s);
+		GLMM_SOA_FN(glmm_soa_set)(dest, stride, i, s[0], 16);
+	}
+}
+
+/*!
+ * @brief inverts count SoA matrices
+ */
+CGLM_INLINE
+void GLMM_SOA_FN(glm_mat4_inv_soa)(float* m, float* dest, size_t stride, size_t count)
+{
+	GLMM_SOA_T x[16];
+	mat4 s, t;
+	size_t i;
+
+	for (i = 0; i + GLMM_SOA_W <= count; i += GLMM_SOA_W)
+	{
+		GLMM_SOA_FN(glmm_soa_load16)(m, stride, i, x);
+		GLMM_SOA_FN(glmm_mat4_inv_soa)(x, x);
+		GLMM_SOA_FN(glmm_soa_store16)(dest, stride, i, x);
+	}
+	for (; i < count; i++)
+	{
+		GLMM_SOA_FN(glmm_soa_get)(m, stride, i, s[0], 16);
+		glm_mat4_inv(s, t);
+		GLMM_SOA_FN(glmm_soa_set)(dest, stride, i, t[0], 16);
+	}
+}
+
+/*!
+ * @brief inverts count SoA affine matrices, last rows must be 0 0 0 1
+ */
+CGLM_INLINE
+void GLMM_SOA_FN(glm_mat4_inv_affine_soa)(float* m, float* dest, size_t stride, size_t count)
+{
+	GLMM_SOA_T x[16];
+	mat4 s;
+	size_t i;
+
+	for (i = 0; i + GLMM_SOA_W <= count; i += GLMM_SOA_W)
+	{
+		GLMM_SOA_FN(glmm_soa_load16)(m, stride, i, x);
+		GLMM_SOA_FN(glmm_mat4_inv_affine_soa)(x, x);
+		GLMM_SOA_FN(glmm_soa_store16)(dest, stride, i, x);
+	}
+	for (; i < count; i++)
+	{
+		GLMM_SOA_FN(glmm_soa_get)(m, stride, i, s[0], 16);
+		glm_mat4_inv(s, s);
+		GLMM_SOA_FN(glmm_soa_set)(dest, stride, i, s[0], 16);
+	}
+}
+
+/*!
+ * @brief transposes count SoA matrices
+ */
+CGLM_INLINE
+void GLMM_SOA_FN(glm_mat4_transpose_soa)(float* m, float* dest, size_t stride, size_t count)
+{
+	GLMM_SOA_T x[16];
+	mat4 s;
+	size_t i;
+
+	for (i = 0; i + GLMM_SOA_W <= count; i += GLMM_SOA_W)
+	{
+		GLMM_SOA_FN(glmm_soa_load16)(m, stride, i, x);
+		GLMM_SOA_FN(glmm_mat4_transpose_soa)(x, x);
+		GLMM_SOA_FN(glmm_soa_store16)(dest, stride, i, x);
+	}
+	for (; i < count; i++)
+	{
+		GLMM_SOA_FN(glmm_soa_get)(m, stride, i, s[0], 16);
+		glm_mat4_transpose(s);
+		GLMM_SOA_FN(glmm_soa_set)(dest, stride, i, s[0], 16);
+	}
+}
+
+/*!
+ * @brief transforms count SoA vectors by their SoA matrices
+ *
+ * @param[in]  m      matrices, sixteen runs of stride floats
+ * @param[in]  v      vectors, four runs of stride floats
+ * @param[out] dest   transformed vectors, may be v
+ */
+CGLM_INLINE
+void GLMM_SOA_FN(glm_mat4_mulv_soa)(float* m, float* v, float* dest, size_t stride, size_t count)
+{
+	GLMM_SOA_T x[16], y[4];
+	mat4 s;
+	vec4 t;
+	size_t i;
+
+	for (i = 0; i + GLMM_SOA_W <= count; i += GLMM_SOA_W)
+	{
+		GLMM_SOA_FN(glmm_soa_load16)(m, stride, i, x);
+		GLMM_SOA_FN(glmm_soa_load4)(v, stride, i, y);
+		GLMM_SOA_FN(glmm_mat4_mulv_soa)(x, y, y);
+		GLMM_SOA_FN(glmm_soa_store4)(dest, stride, i, y);
+	}
+	for (; i < count; i++)
+	{
+		GLMM_SOA_FN(glmm_soa_get)(m, stride, i, s[0], 16);
+		GLMM_SOA_FN(glmm_soa_get)(v, stride, i, t, 4);
+		glm_mat4_mulv(s, t, t);
+		GLMM_SOA_FN(glmm_soa_set)(dest, stride, i, t, 4);
+	}
+}
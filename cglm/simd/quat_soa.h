@@ -0,0 +1,305 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Batched quaternion math on registers that hold one component of
+ * GLMM_SOA_W quaternions each, included by the AVX2 and AVX-512 batch
+ * headers after they define the macros of mat4_soa.h and the ones below.
+ * No include guard: every instruction set instantiates its own copy.
+ *
+ *   GLMM_SOA_SQRT(x)
+ *   GLMM_SOA_MIN, _MAX
+ *   GLMM_SOA_ROUND(x)          to the nearest integer
+ *   GLMM_SOA_AND, _XOR         bitwise
+ *   GLMM_SOA_SELECT_LT(a, b, x, y) a < b ? x : y
+ *   GLMM_SOA_LOADQ(p, q)       GLMM_SOA_W xyzw quaternions at p into q[4]
+ *   GLMM_SOA_STOREQ(p, q)      and back
+ *   GLMM_SOA_LOADQ_N(p, n, q)  the first n only, zeros in the other lanes
+ *   GLMM_SOA_STOREQ_N(p, n, q)
+ *   GLMM_SOA_LOAD_N(p, n)      n floats
+ *
+ * Lane i of every register belongs to quaternion i, so float arrays load
+ * with GLMM_SOA_LOAD. Tails run the same code on partial registers, all
+ * quaternions of an array get the same rounding.
+ *
+ * Functions:
+ *   void glm_quat_mul_batch(versor *a, versor *b, versor *dest, size_t count);
+ *   void glm_quat_integrate_batch(versor *q, vec4 *spins, float time, size_t count);
+ *   void glm_quat_normalize_batch(versor *q, size_t count);
+ *   void glm_quat_nlerp_batch(versor *from, versor *to, float *t, versor *dest, size_t count);
+ *   void glm_quat_slerp_batch(versor *from, versor *to, float *t, versor *dest, size_t count);
+ */
+
+/* d = a * b, same order as glm_quat_mul */
+CGLM_INLINE
+void GLMM_SOA_FN(glmm_quat_mul_soa)(GLMM_SOA_T a[4], GLMM_SOA_T b[4], GLMM_SOA_T d[4])
+{
+	GLMM_SOA_T x, y, z, w;
+
+	x = GLMM_SOA_FNMADD(a[2], b[1], GLMM_SOA_FMADD(a[1], b[2], GLMM_SOA_FMADD(a[0], b[3], GLMM_SOA_MUL(a[3], b[0]))));
+	y = GLMM_SOA_FMADD(a[2], b[0], GLMM_SOA_FMADD(a[1], b[3], GLMM_SOA_FNMADD(a[0], b[2], GLMM_SOA_MUL(a[3], b[1]))));
+	z = GLMM_SOA_FMADD(a[2], b[3], GLMM_SOA_FNMADD(a[1], b[0], GLMM_SOA_FMADD(a[0], b[1], GLMM_SOA_MUL(a[3], b[2]))));
+	w = GLMM_SOA_FNMADD(a[2], b[2], GLMM_SOA_FNMADD(a[1], b[1], GLMM_SOA_FNMADD(a[0], b[0], GLMM_SOA_MUL(a[3], b[3]))));
+
+	d[0] = x;
+	d[1] = y;
+	d[2] = z;
+	d[3] = w;
+}
+
+/* Taylor series up to x^11 and x^12, good to a few ulp on [-pi/2, pi/2] */
+CGLM_INLINE
+GLMM_SOA_T GLMM_SOA_FN(glmm_sin_soa)(GLMM_SOA_T x)
+{
+	GLMM_SOA_T xx = GLMM_SOA_MUL(x, x), p;
+
+	p = GLMM_SOA_FMADD(xx, GLMM_SOA_SET1(-2.5052108e-8f), GLMM_SOA_SET1(2.7557319e-6f));
+	p = GLMM_SOA_FMADD(xx, p, GLMM_SOA_SET1(-1.9841270e-4f));
+	p = GLMM_SOA_FMADD(xx, p, GLMM_SOA_SET1(8.3333333e-3f));
+	p = GLMM_SOA_FMADD(xx, p, GLMM_SOA_SET1(-1.6666667e-1f));
+	return GLMM_SOA_FMADD(GLMM_SOA_MUL(xx, x), p, x);
+}
+
+CGLM_INLINE
+GLMM_SOA_T GLMM_SOA_FN(glmm_cos_soa)(GLMM_SOA_T x)
+{
+	GLMM_SOA_T xx = GLMM_SOA_MUL(x, x), p;
+
+	p = GLMM_SOA_FMADD(xx, GLMM_SOA_SET1(2.0876757e-9f), GLMM_SOA_SET1(-2.7557319e-7f));
+	p = GLMM_SOA_FMADD(xx, p, GLMM_SOA_SET1(2.4801587e-5f));
+	p = GLMM_SOA_FMADD(xx, p, GLMM_SOA_SET1(-1.3888889e-3f));
+	p = GLMM_SOA_FMADD(xx, p, GLMM_SOA_SET1(4.1666667e-2f));
+	p = GLMM_SOA_FMADD(xx, p, GLMM_SOA_SET1(-0.5f));
+	return GLMM_SOA_FMADD(xx, p, GLMM_SOA_SET1(1.0f));
+}
+
+/* Any angle: reduced to [-pi, pi], then halved into the range of the
+   series and doubled back */
+CGLM_INLINE
+void GLMM_SOA_FN(glmm_sincos_soa)(GLMM_SOA_T x, GLMM_SOA_T *s, GLMM_SOA_T *c)
+{
+	GLMM_SOA_T k, hs, hc;
+
+	k = GLMM_SOA_ROUND(GLMM_SOA_MUL(x, GLMM_SOA_SET1(0.15915494f)));
+	x = GLMM_SOA_FNMADD(k, GLMM_SOA_SET1(6.28125f), x);
+	x = GLMM_SOA_FNMADD(k, GLMM_SOA_SET1(1.9353072e-3f), x);
+	x = GLMM_SOA_MUL(x, GLMM_SOA_SET1(0.5f));
+
+	hs = GLMM_SOA_FN(glmm_sin_soa)(x);
+	hc = GLMM_SOA_FN(glmm_cos_soa)(x);
+	*s = GLMM_SOA_MUL(GLMM_SOA_ADD(hs, hs), hc);
+	*c = GLMM_SOA_FNMADD(GLMM_SOA_ADD(hs, hs), hs, GLMM_SOA_SET1(1.0f));
+}
+
+/* acos on [0, 1], Abramowitz and Stegun 4.4.46 */
+CGLM_INLINE
+GLMM_SOA_T GLMM_SOA_FN(glmm_acos_soa)(GLMM_SOA_T x)
+{
+	GLMM_SOA_T p;
+
+	p = GLMM_SOA_FMADD(x, GLMM_SOA_SET1(-0.0012624911f), GLMM_SOA_SET1(0.0066700901f));
+	p = GLMM_SOA_FMADD(x, p, GLMM_SOA_SET1(-0.0170881256f));
+	p = GLMM_SOA_FMADD(x, p, GLMM_SOA_SET1(0.0308918810f));
+	p = GLMM_SOA_FMADD(x, p, GLMM_SOA_SET1(-0.0501743046f));
+	p = GLMM_SOA_FMADD(x, p, GLMM_SOA_SET1(0.0889789874f));
+	p = GLMM_SOA_FMADD(x, p, GLMM_SOA_SET1(-0.2145988016f));
+	p = GLMM_SOA_FMADD(x, p, GLMM_SOA_SET1(1.5707963050f));
+	return GLMM_SOA_MUL(GLMM_SOA_SQRT(GLMM_SOA_SUB(GLMM_SOA_SET1(1.0f), x)), p);
+}
+
+CGLM_INLINE
+GLMM_SOA_T GLMM_SOA_FN(glmm_quat_dot_soa)(GLMM_SOA_T a[4], GLMM_SOA_T b[4])
+{
+	return GLMM_SOA_FMADD(a[3], b[3], GLMM_SOA_FMADD(a[2], b[2], GLMM_SOA_FMADD(a[1], b[1], GLMM_SOA_MUL(a[0], b[0]))));
+}
+
+CGLM_INLINE
+void GLMM_SOA_FN(glmm_quat_normalize_soa)(GLMM_SOA_T q[4])
+{
+	GLMM_SOA_T n;
+
+	n = GLMM_SOA_FN(glmm_quat_dot_soa)(q, q);
+	n = GLMM_SOA_DIV(GLMM_SOA_SET1(1.0f), GLMM_SOA_SQRT(GLMM_SOA_MAX(n, GLMM_SOA_SET1(FLT_MIN))));
+	q[0] = GLMM_SOA_MUL(q[0], n);
+	q[1] = GLMM_SOA_MUL(q[1], n);
+	q[2] = GLMM_SOA_MUL(q[2], n);
+	q[3] = GLMM_SOA_MUL(q[3], n);
+}
+
+/* q = quatv(time * spin.w, spin.xyz) * q, spin axes of unit length */
+CGLM_INLINE
+void GLMM_SOA_FN(glmm_quat_integrate_soa)(GLMM_SOA_T q[4], GLMM_SOA_T spin[4], GLMM_SOA_T time)
+{
+	GLMM_SOA_T s, c, step[4];
+
+	GLMM_SOA_FN(glmm_sincos_soa)(GLMM_SOA_MUL(GLMM_SOA_MUL(time, spin[3]), GLMM_SOA_SET1(0.5f)), &s, &c);
+	step[0] = GLMM_SOA_MUL(spin[0], s);
+	step[1] = GLMM_SOA_MUL(spin[1], s);
+	step[2] = GLMM_SOA_MUL(spin[2], s);
+	step[3] = c;
+	GLMM_SOA_FN(glmm_quat_mul_soa)(step, q, q);
+}
+
+/* Flips b onto the hemisphere of a, returns the cosine of the angle */
+CGLM_INLINE
+GLMM_SOA_T GLMM_SOA_FN(glmm_quat_shortest_soa)(GLMM_SOA_T a[4], GLMM_SOA_T b[4])
+{
+	GLMM_SOA_T dot, sign;
+
+	dot = GLMM_SOA_FN(glmm_quat_dot_soa)(a, b);
+	sign = GLMM_SOA_AND(dot, GLMM_SOA_SET1(-0.0f));
+	b[0] = GLMM_SOA_XOR(b[0], sign);
+	b[1] = GLMM_SOA_XOR(b[1], sign);
+	b[2] = GLMM_SOA_XOR(b[2], sign);
+	b[3] = GLMM_SOA_XOR(b[3], sign);
+	return GLMM_SOA_XOR(dot, sign);
+}
+
+CGLM_INLINE
+void GLMM_SOA_FN(glmm_quat_nlerp_soa)(GLMM_SOA_T a[4], GLMM_SOA_T b[4], GLMM_SOA_T t, GLMM_SOA_T d[4])
+{
+	GLMM_SOA_FN(glmm_quat_shortest_soa)(a, b);
+	d[0] = GLMM_SOA_FMADD(t, GLMM_SOA_SUB(b[0], a[0]), a[0]);
+	d[1] = GLMM_SOA_FMADD(t, GLMM_SOA_SUB(b[1], a[1]), a[1]);
+	d[2] = GLMM_SOA_FMADD(t, GLMM_SOA_SUB(b[2], a[2]), a[2]);
+	d[3] = GLMM_SOA_FMADD(t, GLMM_SOA_SUB(b[3], a[3]), a[3]);
+	GLMM_SOA_FN(glmm_quat_normalize_soa)(d);
+}
+
+/* t in [0, 1], so every sine argument stays within [0, pi/2]. Nearly
+   equal rotations fall back to a plain lerp like glm_quat_slerp. The sine
+   of the angle comes from the series, 1 - cos^2 cancels out there. */
+CGLM_INLINE
+void GLMM_SOA_FN(glmm_quat_slerp_soa)(GLMM_SOA_T a[4], GLMM_SOA_T b[4], GLMM_SOA_T t, GLMM_SOA_T d[4])
+{
+	GLMM_SOA_T cosine, sine, angle, wa, wb, one;
+
+	one = GLMM_SOA_SET1(1.0f);
+	cosine = GLMM_SOA_MIN(GLMM_SOA_FN(glmm_quat_shortest_soa)(a, b), one);
+	angle = GLMM_SOA_FN(glmm_acos_soa)(cosine);
+	sine = GLMM_SOA_FN(glmm_sin_soa)(angle);
+
+	wa = GLMM_SOA_FN(glmm_sin_soa)(GLMM_SOA_MUL(GLMM_SOA_SUB(one, t), angle));
+	wb = GLMM_SOA_FN(glmm_sin_soa)(GLMM_SOA_MUL(t, angle));
+	sine = GLMM_SOA_DIV(one, GLMM_SOA_MAX(sine, GLMM_SOA_SET1(0.001f)));
+	wa = GLMM_SOA_SELECT_LT(cosine, GLMM_SOA_SET1(0.9999995f), GLMM_SOA_MUL(wa, sine), GLMM_SOA_SUB(one, t));
+	wb = GLMM_SOA_SELECT_LT(cosine, GLMM_SOA_SET1(0.9999995f), GLMM_SOA_MUL(wb, sine), t);
+
+	d[0] = GLMM_SOA_FMADD(wb, b[0], GLMM_SOA_MUL(wa, a[0]));
+	d[1] = GLMM_SOA_FMADD(wb, b[1], GLMM_SOA_MUL(wa, a[1]));
+	d[2] = GLMM_SOA_FMADD(wb, b[2], GLMM_SOA_MUL(wa, a[2]));
+	d[3] = GLMM_SOA_FMADD(wb, b[3], GLMM_SOA_MUL(wa, a[3]));
+}
+
+CGLM_INLINE
+void GLMM_SOA_FN(glm_quat_mul_batch)(versor *a, versor *b, versor *dest, size_t count)
+{
+	GLMM_SOA_T x[4], y[4];
+	size_t i;
+
+	for (i = 0; i + GLMM_SOA_W <= count; i += GLMM_SOA_W)
+	{
+		GLMM_SOA_LOADQ(a[i], x);
+		GLMM_SOA_LOADQ(b[i], y);
+		GLMM_SOA_FN(glmm_quat_mul_soa)(x, y, x);
+		GLMM_SOA_STOREQ(dest[i], x);
+	}
+	if (i < count)
+	{
+		GLMM_SOA_LOADQ_N(a[i], count - i, x);
+		GLMM_SOA_LOADQ_N(b[i], count - i, y);
+		GLMM_SOA_FN(glmm_quat_mul_soa)(x, y, x);
+		GLMM_SOA_STOREQ_N(dest[i], count - i, x);
+	}
+}
+
+CGLM_INLINE
+void GLMM_SOA_FN(glm_quat_integrate_batch)(versor *q, vec4 *spins, float time, size_t count)
+{
+	GLMM_SOA_T x[4], s[4], t;
+	size_t i;
+
+	t = GLMM_SOA_SET1(time);
+	for (i = 0; i + GLMM_SOA_W <= count; i += GLMM_SOA_W)
+	{
+		GLMM_SOA_LOADQ(q[i], x);
+		GLMM_SOA_LOADQ(spins[i], s);
+		GLMM_SOA_FN(glmm_quat_integrate_soa)(x, s, t);
+		GLMM_SOA_STOREQ(q[i], x);
+	}
+	if (i < count)
+	{
+		GLMM_SOA_LOADQ_N(q[i], count - i, x);
+		GLMM_SOA_LOADQ_N(spins[i], count - i, s);
+		GLMM_SOA_FN(glmm_quat_integrate_soa)(x, s, t);
+		GLMM_SOA_STOREQ_N(q[i], count - i, x);
+	}
+}
+
+CGLM_INLINE
+void GLMM_SOA_FN(glm_quat_normalize_batch)(versor *q, size_t count)
+{
+	GLMM_SOA_T x[4];
+	size_t i;
+
+	for (i = 0; i + GLMM_SOA_W <= count; i += GLMM_SOA_W)
+	{
+		GLMM_SOA_LOADQ(q[i], x);
+		GLMM_SOA_FN(glmm_quat_normalize_soa)(x);
+		GLMM_SOA_STOREQ(q[i], x);
+	}
+	if (i < count)
+	{
+		GLMM_SOA_LOADQ_N(q[i], count - i, x);
+		GLMM_SOA_FN(glmm_quat_normalize_soa)(x);
+		GLMM_SOA_STOREQ_N(q[i], count - i, x);
+	}
+}
+
+CGLM_INLINE
+void GLMM_SOA_FN(glm_quat_nlerp_batch)(versor *from, versor *to, float *t, versor *dest, size_t count)
+{
+	GLMM_SOA_T a[4], b[4];
+	size_t i;
+
+	for (i = 0; i + GLMM_SOA_W <= count; i += GLMM_SOA_W)
+	{
+		GLMM_SOA_LOADQ(from[i], a);
+		GLMM_SOA_LOADQ(to[i], b);
+		GLMM_SOA_FN(glmm_quat_nlerp_soa)(a, b, GLMM_SOA_LOAD(t + i), a);
+		GLMM_SOA_STOREQ(dest[i], a);
+	}
+	if (i < count)
+	{
+		GLMM_SOA_LOADQ_N(from[i], count - i, a);
+		GLMM_SOA_LOADQ_N(to[i], count - i, b);
+		GLMM_SOA_FN(glmm_quat_nlerp_soa)(a, b, GLMM_SOA_LOAD_N(t + i, count - i), a);
+		GLMM_SOA_STOREQ_N(dest[i], count - i, a);
+	}
+}
+
+CGLM_INLINE
+void GLMM_SOA_FN(glm_quat_slerp_batch)(versor *from, versor *to, float *t, versor *dest, size_t count)
+{
+	GLMM_SOA_T a[4], b[4];
+	size_t i;
+
+	for (i = 0; i + GLMM_SOA_W <= count; i += GLMM_SOA_W)
+	{
+		GLMM_SOA_LOADQ(from[i], a);
+		GLMM_SOA_LOADQ(to[i], b);
+		GLMM_SOA_FN(glmm_quat_slerp_soa)(a, b, GLMM_SOA_LOAD(t + i), a);
+		GLMM_SOA_STOREQ(dest[i], a);
+	}
+	if (i < count)
+	{
+		GLMM_SOA_LOADQ_N(from[i], count - i, a);
+		GLMM_SOA_LOADQ_N(to[i], count - i, b);
+		GLMM_SOA_FN(glmm_quat_slerp_soa)(a, b, GLMM_SOA_LOAD_N(t + i, count - i), a);
+		GLMM_SOA_STOREQ_N(dest[i], count - i, a);
+	}
+}
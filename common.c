@@ -21,6 +21,10 @@
 //
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STB_IMAGE_IMPLEMENTATION
 #include <GL/glew.h>
 #include <SDL_events.h>
 #include <SDL_keycode.h>
@@ -29,6 +33,8 @@
 #include "cglm/quat.h"
 #include "cglm/vec3.h"
 #include "common.h"
+#include "resource.h"
+#include "stb_image.h"
 
 #define CAMERA_SENSITIVITY -0.00125f
 #define CAMERA_SENSITIVITY_MOUSE -0.00025f
@@ -107,56 +113,213 @@ int validate_gl(const char* title)
 	}
 }
 
+static int load_text(char** text, const char* filename)
+{
+	struct resource resource;
+	if (!load_resource(&resource, filename))
+		return 0;
+	*text = (char*)malloc(resource.size + 1);
+	memcpy(*text, resource.data, resource.size);
+	(*text)[resource.size] = '\0';
+	free_resource(&resource);
+	return 1;
+}
+
 int load_shaders_text(char** vertex_shader, char** fragment_shader, const char* filename)
 {
 	char shadername[FILENAME_BUFFER_SIZE];
 
 	sprintf(shadername, "%s.vs.glsl", filename);
-	FILE* file = fopen(shadername, "r");
-	if (!file)
+	if (!load_text(vertex_shader, shadername))
+		return 0;
+
+	sprintf(shadername, "%s.fs.glsl", filename);
+	if (!load_text(fragment_shader, shadername))
 	{
-		error("Shader Loading Error", "Failed to open file %s.", shadername);
+		free(*vertex_shader);
+		*vertex_shader = NULL;
 		return 0;
 	}
-	fseek(file, 0, SEEK_END);
-	unsigned size = ftell(file);
-	if (!size)
+	return 1;
+}
+
+int load_compute_shader_text(char** compute_shader, const char* filename)
+{
+	char shadername[FILENAME_BUFFER_SIZE];
+	sprintf(shadername, "%s.cs.glsl", filename);
+	return load_text(compute_shader, shadername);
+}
+
+// Shared text, when given, goes right after the #version line, which has to come first
+static unsigned compile_shader(unsigned type, const char* text, const char* shared, const char* title)
+{
+	char message[ERROR_BUFFER_SIZE];
+	const char* sources[3];
+	int lengths[3];
+	const char* body;
+	unsigned shader;
+	int success;
+
+	shader = glCreateShader(type);
+	body = shared ? strchr(text, '\n') : NULL;
+	if (body)
+	{
+		++body;
+		sources[0] = text;
+		lengths[0] = (int)(body - text);
+		sources[1] = shared;
+		lengths[1] = -1;
+		sources[2] = body;
+		lengths[2] = -1;
+		glShaderSource(shader, 3, sources, lengths);
+	}
+	else
+		glShaderSource(shader, 1, &text, NULL);
+	glCompileShader(shader);
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+	if (!success)
 	{
-		error("Shader Loading Error", "File %s is empty.", shadername);
-		fclose(file);
+		glGetShaderInfoLog(shader, ERROR_BUFFER_SIZE, NULL, message);
+		error(title, message);
+		glDeleteShader(shader);
 		return 0;
 	}
-	rewind(file);
-	*vertex_shader = (char*)malloc(size + 1);
-	fread(*vertex_shader, 1, size, file);
-	(*vertex_shader)[size] = '\0';
-	fclose(file);
+	return shader;
+}
 
-	sprintf(shadername, "%s.fs.glsl", filename);
-	file = fopen(shadername, "r");
-	if (!file)
+// Varyings are captured interleaved by transform feedback, when given
+static unsigned link_program(unsigned first, unsigned second, const char* const* varyings, unsigned varyings_count)
+{
+	char message[ERROR_BUFFER_SIZE];
+	unsigned program;
+	int success;
+
+	program = glCreateProgram();
+	glAttachShader(program, first);
+	if (second)
+		glAttachShader(program, second);
+	if (varyings_count)
+		glTransformFeedbackVaryings(program, (int)varyings_count, varyings, GL_INTERLEAVED_ATTRIBS);
+	glLinkProgram(program);
+	glDeleteShader(first);
+	if (second)
+		glDeleteShader(second);
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
 	{
-		error("Shader Loading Error", "Failed to open file %s.", shadername);
-		free(*vertex_shader);
-		*vertex_shader = NULL;
+		glGetProgramInfoLog(program, ERROR_BUFFER_SIZE, NULL, message);
+		error("Shader Program Error", message);
+		glDeleteProgram(program);
 		return 0;
 	}
-	fseek(file, 0, SEEK_END);
-	size = ftell(file);
-	if (!size)
+	return program;
+}
+
+// Loads, compiles and links filename.vs.glsl and filename.fs.glsl, returns 0 on failure
+unsigned create_program(const char* filename)
+{
+	return create_program_stages(filename, filename);
+}
+
+// Same with stages from different files, so samples can share one stage
+unsigned create_program_stages(const char* vertex_filename, const char* fragment_filename)
+{
+	char shadername[FILENAME_BUFFER_SIZE];
+	char* vertex_shader = NULL;
+	char* fragment_shader = NULL;
+	unsigned vertex, fragment;
+
+	sprintf(shadername, "%s.vs.glsl", vertex_filename);
+	if (!load_text(&vertex_shader, shadername))
+		return 0;
+	sprintf(shadername, "%s.fs.glsl", fragment_filename);
+	if (!load_text(&fragment_shader, shadername))
 	{
-		error("Shader Loading Error", "File %s is empty.", shadername);
-		free(*vertex_shader);
-		*vertex_shader = NULL;
-		fclose(file);
+		free(vertex_shader);
 		return 0;
 	}
-	rewind(file);
-	*fragment_shader = (char*)malloc(size + 1);
-	fread(*fragment_shader, 1, size, file);
-	(*fragment_shader)[size] = '\0';
-	fclose(file);
-	return 1;
+	vertex = compile_shader(GL_VERTEX_SHADER, vertex_shader, NULL, "Vertex Shader Error");
+	fragment = vertex ? compile_shader(GL_FRAGMENT_SHADER, fragment_shader, NULL, "Fragment Shader Error") : 0;
+	free(vertex_shader);
+	free(fragment_shader);
+	if (!fragment)
+	{
+		if (vertex)
+			glDeleteShader(vertex);
+		return 0;
+	}
+	return link_program(vertex, fragment, NULL, 0);
+}
+
+// Loads, compiles and links filename.cs.glsl, returns 0 on failure. Functions
+// in shared_filename, if given, are compiled in.
+unsigned create_compute_program(const char* filename, const char* shared_filename)
+{
+	char* compute_shader = NULL;
+	char* shared = NULL;
+	unsigned compute;
+
+	if (shared_filename && !load_text(&shared, shared_filename))
+		return 0;
+	if (!load_compute_shader_text(&compute_shader, filename))
+	{
+		free(shared);
+		return 0;
+	}
+	compute = compile_shader(GL_COMPUTE_SHADER, compute_shader, shared, "Compute Shader Error");
+	free(compute_shader);
+	free(shared);
+	return compute ? link_program(compute, 0, NULL, 0) : 0;
+}
+
+// Loads, compiles and links filename.vs.glsl and filename.gs.glsl for
+// transform feedback of varyings, with no fragment stage. Functions in
+// shared_filename, if given, are compiled into both. Returns 0 on failure.
+unsigned create_feedback_program(const char* filename, const char* shared_filename, const char* const* varyings, unsigned varyings_count)
+{
+	char shadername[FILENAME_BUFFER_SIZE];
+	char* vertex_shader = NULL;
+	char* geometry_shader = NULL;
+	char* shared = NULL;
+	unsigned vertex, geometry;
+
+	if (shared_filename && !load_text(&shared, shared_filename))
+		return 0;
+	sprintf(shadername, "%s.vs.glsl", filename);
+	if (!load_text(&vertex_shader, shadername))
+	{
+		free(shared);
+		return 0;
+	}
+	sprintf(shadername, "%s.gs.glsl", filename);
+	if (!load_text(&geometry_shader, shadername))
+	{
+		free(vertex_shader);
+		free(shared);
+		return 0;
+	}
+	vertex = compile_shader(GL_VERTEX_SHADER, vertex_shader, shared, "Vertex Shader Error");
+	geometry = vertex ? compile_shader(GL_GEOMETRY_SHADER, geometry_shader, shared, "Geometry Shader Error") : 0;
+	free(vertex_shader);
+	free(geometry_shader);
+	free(shared);
+	if (!geometry)
+	{
+		if (vertex)
+			glDeleteShader(vertex);
+		return 0;
+	}
+	return link_program(vertex, geometry, varyings, varyings_count);
+}
+
+unsigned char* load_image(const char* filename, int* width, int* height, int* channels)
+{
+	const struct resource* embedded = find_resource(filename);
+	// Bottom row first as OpenGL expects, the same as texcook cooks them
+	stbi_set_flip_vertically_on_load(1);
+	if (embedded)
+		return stbi_load_from_memory(embedded->data, embedded->size, width, height, channels, 0);
+	return stbi_load(filename, width, height, channels, 0);
 }
 
 void process_events(vec3 position, vec3 direction, versor rotation, unsigned short* controls, int* run, float frame_time)
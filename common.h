@@ -23,6 +23,7 @@
 #ifndef COMMON_H
 #define COMMON_H
 
+#include <SDL_events.h>
 #include "cglm/types.h"
 
 #define ERROR_BUFFER_SIZE 2048
@@ -32,6 +33,12 @@ typedef SDL_Event SDL_Event;
 void error(const char* title, const char* format, ...);
 int validate_gl(const char* title);
 int load_shaders_text(char** vertex_shader, char** fragment_shader, const char* filename);
+int load_compute_shader_text(char** compute_shader, const char* filename);
+unsigned create_program(const char* filename);
+unsigned create_program_stages(const char* vertex_filename, const char* fragment_filename);
+unsigned create_compute_program(const char* filename, const char* shared_filename);
+unsigned create_feedback_program(const char* filename, const char* shared_filename, const char* const* varyings, unsigned varyings_count);
+unsigned char* load_image(const char* filename, int* width, int* height, int* channels);
 void process_events(vec3 position, vec3 direction, versor rotation, unsigned short* controls, int* run, float frame_time);
 
 #endif // COMMON_H
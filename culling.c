@@ -0,0 +1,890 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SDL_MAIN_HANDLED
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_main.h>
+#include "cglm/affine.h"
+#include "cglm/box.h"
+#include "cglm/cam.h"
+#include "cglm/frustum.h"
+#include "cglm/quat.h"
+#include "bvh.h"
+#include "common.h"
+#include "depth_pyramid.h"
+#include "draw_list.h"
+#include "jobs.h"
+#include "mesh_buffer.h"
+#include "occlusion.h"
+#include "simd.h"
+#include "texture_manager.h"
+
+#define OBJECTS_X 64
+#define OBJECTS_Z 64
+#define WALLS_X 4
+#define WALLS_Z 3
+#define WALLS_COUNT (WALLS_X * WALLS_Z)
+#define OBJECTS_COUNT (OBJECTS_X * OBJECTS_Z + WALLS_COUNT)
+#define PRISMS_COUNT 3
+#define MESHES_COUNT (PRISMS_COUNT + 1)
+#define MATERIALS_COUNT (sizeof(material_files) / sizeof(material_files[0]))
+#define GROUPS_COUNT (MESHES_COUNT * MATERIALS_COUNT)
+#define PRISM_MAX_SIDES 24
+#define PRISM_MAX_VERTICES (PRISM_MAX_SIDES * 6 + 2)
+#define PRISM_MAX_INDICES (PRISM_MAX_SIDES * 12)
+#define CULL_GROUP_SIZE 64
+#define NEAR_W 0.0001f
+#define READBACK_FRAMES 3
+#define WIDTH 1024
+#define HEIGHT 768
+#define WALL_WIDTH 24.0f
+#define WALL_HEIGHT 6.0f
+#define WALL_DEPTH 0.5f
+#define WALL_TRIANGLES 12
+
+static const float cube_vertices[] =
+{
+	// Position				| Normal				| Tex Coord
+	// Front
+	 0.5f,  0.5f,  0.5f,	 0.0f,  0.0,  1.0,		1.0f, 1.0f,		//   0 RU
+	 0.5f, -0.5f,  0.5f,	 0.0f,  0.0,  1.0,		1.0f, 0.0f,		//   1 RD
+	-0.5f, -0.5f,  0.5f,	 0.0f,  0.0,  1.0,		0.0f, 0.0f,		//   2 LD
+	-0.5f,  0.5f,  0.5f,	 0.0f,  0.0,  1.0,		0.0f, 1.0f,		//   3 LU
+
+	// Back
+	-0.5f,  0.5f, -0.5f,	 0.0f,  0.0, -1.0,		1.0f, 1.0f,		//   4 RU
+	-0.5f, -0.5f, -0.5f,	 0.0f,  0.0, -1.0,		1.0f, 0.0f,		//   5 RD
+	 0.5f, -0.5f, -0.5f,	 0.0f,  0.0, -1.0,		0.0f, 0.0f,		//   6 LD
+	 0.5f,  0.5f, -0.5f,	 0.0f,  0.0, -1.0,		0.0f, 1.0f,		//   7 LU
+
+	// Top
+	 0.5f,  0.5f, -0.5f,	 0.0f,  1.0,  0.0,		1.0f, 1.0f,		//   8 RU
+	 0.5f,  0.5f,  0.5f,	 0.0f,  1.0,  0.0,		1.0f, 0.0f,		//   9 RD
+	-0.5f,  0.5f,  0.5f,	 0.0f,  1.0,  0.0,		0.0f, 0.0f,		//  10 LD
+	-0.5f,  0.5f, -0.5f,	 0.0f,  1.0,  0.0,		0.0f, 1.0f,		//  11 LU
+
+	// Bottom
+	 0.5f, -0.5f,  0.5f,	 0.0f, -1.0,  0.0,		1.0f, 1.0f,		//  12 RU
+	 0.5f, -0.5f, -0.5f,	 0.0f, -1.0,  0.0,		1.0f, 0.0f,		//  13 RD
+	-0.5f, -0.5f, -0.5f,	 0.0f, -1.0,  0.0,		0.0f, 0.0f,		//  14 LD
+	-0.5f, -0.5f,  0.5f,	 0.0f, -1.0,  0.0,		0.0f, 1.0f,		//  15 LU
+
+	// Left
+	-0.5f,  0.5f,  0.5f,	-1.0f,  0.0,  0.0,		1.0f, 1.0f,		//  16 LU
+	-0.5f, -0.5f,  0.5f,	-1.0f,  0.0,  0.0,		1.0f, 0.0f,		//  17 LD
+	-0.5f, -0.5f, -0.5f,	-1.0f,  0.0,  0.0,		0.0f, 0.0f,		//  18 RD
+	-0.5f,  0.5f, -0.5f,	-1.0f,  0.0,  0.0,		0.0f, 1.0f,		//  19 RU
+
+	// Right
+	 0.5f,  0.5f, -0.5f,	 1.0f,  0.0,  0.0,		1.0f, 1.0f,		//   4 RU
+	 0.5f, -0.5f, -0.5f,	 1.0f,  0.0,  0.0,		1.0f, 0.0f,		//   5 RD
+	 0.5f, -0.5f,  0.5f,	 1.0f,  0.0,  0.0,		0.0f, 0.0f,		//   1 RD
+	 0.5f,  0.5f,  0.5f,	 1.0f,  0.0,  0.0,		0.0f, 1.0f		//   0 RU
+};
+
+static const unsigned cube_indices[] =
+{
+	 0,  1,  2,  2,  3,  0,	// Front
+	 4,  5,  6,  6,  7,  4,	// Back
+	 8,  9, 10, 10, 11,  8,	// Top
+	12, 13, 14, 14, 15, 12,	// Bottom
+	16, 17, 18, 18, 19, 16,	// Left
+	20, 21, 22, 22, 23, 20	// Right
+};
+
+static const unsigned prism_sides[PRISMS_COUNT] = { 3, 6, PRISM_MAX_SIDES };
+
+static const char* material_files[][2] =
+{
+	{ "data/textures/crate_diffuse.tex", "data/textures/crate_specular.tex" },
+	{ "data/textures/crate_dark_diffuse.tex", "data/textures/crate_dark_specular.tex" },
+	{ "data/textures/crate_painted_diffuse.tex", "data/textures/crate_painted_specular.tex" }
+};
+
+// Coarse test of a sphere against the CPU copy of the depth pyramid, seen
+// from the camera the copy was built with. Spheres that reach behind that
+// camera or out of its view are kept.
+static int pyramid_occluded(const struct depth_pyramid* pyramid, const vec4 sphere)
+{
+	vec4 position, centre, corner;
+	float min_x = FLT_MAX, min_y = FLT_MAX, min_z = FLT_MAX;
+	float max_x = -FLT_MAX, max_y = -FLT_MAX;
+	unsigned i, axis, c;
+
+	glm_vec4((float*)sphere, 1.0f, position);
+	glm_mat4_mulv((vec4*)pyramid->cpu_viewproj, position, centre);
+	for (i = 0; i < 8; ++i)
+	{
+		for (c = 0; c < 4; ++c)
+		{
+			corner[c] = centre[c];
+			for (axis = 0; axis < 3; ++axis)
+				corner[c] += i & (1 << axis) ? pyramid->cpu_viewproj[axis][c] * sphere[3] : -pyramid->cpu_viewproj[axis][c] * sphere[3];
+		}
+		if (corner[3] < NEAR_W)
+			return 0;
+		min_x = fminf(min_x, corner[0] / corner[3]);
+		min_y = fminf(min_y, corner[1] / corner[3]);
+		min_z = fminf(min_z, corner[2] / corner[3]);
+		max_x = fmaxf(max_x, corner[0] / corner[3]);
+		max_y = fmaxf(max_y, corner[1] / corner[3]);
+	}
+	if (min_x < -1.0f || max_x > 1.0f || min_y < -1.0f || max_y > 1.0f)
+		return 0;
+	return min_z * 0.5f + 0.5f > sample_depth_pyramid(pyramid, min_x * 0.5f + 0.5f, min_y * 0.5f + 0.5f,
+													   max_x * 0.5f + 0.5f, max_y * 0.5f + 0.5f);
+}
+
+int main(int argc, char** argv)
+{
+	// =====================================
+	// Initialisation
+	// =====================================
+	// SDL
+
+	if (SDL_Init(SDL_INIT_VIDEO) < 0)
+	{
+		error("SDL Error", SDL_GetError());
+		return 1;
+	}
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_Window* window = SDL_CreateWindow("OpenGL Tutorial 13",
+										  SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+										  WIDTH, HEIGHT, SDL_WINDOW_OPENGL);
+	if (!window)
+	{
+		error("SDL Error", SDL_GetError());
+		SDL_Quit();
+		return 1;
+	}
+	SDL_GLContext context = SDL_GL_CreateContext(window);
+	if (!context)
+	{
+		// Without compute shaders objects are culled on the CPU, which works with 3.3
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+		context = SDL_GL_CreateContext(window);
+	}
+	if (!context)
+	{
+		error("SDL Error", SDL_GetError());
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	SDL_ShowCursor(SDL_DISABLE);
+	SDL_SetRelativeMouseMode(SDL_TRUE);
+
+	// GLEW
+	glewExperimental = GL_TRUE;
+	if (glewInit() != GLEW_OK)
+	{
+		error("GLEW Error", glewGetErrorString(glGetError()));
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Pass -cpu to cull on the CPU with a driver that has compute shaders
+	const int gpu_culling = GLEW_VERSION_4_3 && !(argc > 1 && !strcmp(argv[1], "-cpu"));
+	// Math kernels of the widest instruction set the CPU has
+	simd_init();
+	if (!gpu_culling && !jobs_init(0))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// OpenGL
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_CULL_FACE);
+	glCullFace(GL_BACK);
+	glFrontFace(GL_CW);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+	// Meshes
+	unsigned i;
+	struct mesh_buffer meshes;
+	if (!create_mesh_buffer(&meshes, 24 + PRISMS_COUNT * PRISM_MAX_VERTICES, 36 + PRISMS_COUNT * PRISM_MAX_INDICES, MESHES_COUNT))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	float prism_vertices[PRISM_MAX_VERTICES * MESH_VERTEX_FLOATS];
+	unsigned prism_indices[PRISM_MAX_INDICES];
+	unsigned prism_vertices_count, prism_indices_count;
+	int success = add_mesh(&meshes, cube_vertices, sizeof(cube_vertices) / sizeof(float) / MESH_VERTEX_FLOATS,
+						   cube_indices, sizeof(cube_indices) / sizeof(unsigned)) >= 0;
+	for (i = 0; i < PRISMS_COUNT && success; ++i)
+	{
+		build_prism_mesh(prism_vertices, &prism_vertices_count, prism_indices, &prism_indices_count, prism_sides[i]);
+		success = add_mesh(&meshes, prism_vertices, prism_vertices_count, prism_indices, prism_indices_count) >= 0;
+	}
+	if (!success)
+	{
+		destroy_mesh_buffer(&meshes);
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Shader
+	char* vertex_shader = NULL;
+	char* fragment_shader = NULL;
+
+	if (!load_shaders_text(&vertex_shader, &fragment_shader, "data/shaders/13_culling"))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	unsigned vertex = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(vertex, 1, (const char* const*)&vertex_shader, NULL);
+	glCompileShader(vertex);
+	glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		char message[ERROR_BUFFER_SIZE];
+		glGetShaderInfoLog(vertex, ERROR_BUFFER_SIZE, NULL, message);
+		error("Vertex Shader Error", message);
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	unsigned fragment = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(fragment, 1, (const char* const*)&fragment_shader, NULL);
+	glCompileShader(fragment);
+	glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		char message[ERROR_BUFFER_SIZE];
+		glGetShaderInfoLog(fragment, ERROR_BUFFER_SIZE, NULL, message);
+		error("Fragment Shader Error", message);
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	const unsigned program = glCreateProgram();
+	glAttachShader(program, vertex);
+	glAttachShader(program, fragment);
+	glLinkProgram(program);
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		char message[ERROR_BUFFER_SIZE];
+		glGetProgramInfoLog(program, ERROR_BUFFER_SIZE, NULL, message);
+		error("Fragment Shader Error", message);
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	glDeleteShader(vertex);
+	glDeleteShader(fragment);
+	free(vertex_shader);
+	free(fragment_shader);
+
+	// Compute Shaders
+	const unsigned cull_program = gpu_culling ? create_compute_program("data/shaders/13_cull", NULL) : 0;
+	if (gpu_culling && !cull_program)
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Textures
+	struct texture_array diffuse_array, specular_array;
+	create_texture_array(&diffuse_array, MATERIALS_COUNT);
+	create_texture_array(&specular_array, MATERIALS_COUNT);
+	for (i = 0; i < MATERIALS_COUNT; ++i)
+		if (add_texture_layer(&diffuse_array, material_files[i][0]) != (int)i ||
+			add_texture_layer(&specular_array, material_files[i][1]) != (int)i)
+		{
+			destroy_texture_array(&specular_array);
+			destroy_texture_array(&diffuse_array);
+			SDL_GL_DeleteContext(context);
+			SDL_DestroyWindow(window);
+			SDL_Quit();
+			return 1;
+		}
+
+	// Shader Uniforms
+	const int uniform_viewproj = glGetUniformLocation(program, "cViewProj");
+	const int uniform_view_pos = glGetUniformLocation(program, "cViewPos");
+	const int uniform_draw_offset = glGetUniformLocation(program, "cDrawOffset");
+	int uniform_planes = -1;
+	int uniform_prev_viewproj = -1;
+	int uniform_occlusion = -1;
+
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "sDiffuse"), 0);
+	glUniform1i(glGetUniformLocation(program, "sSpecular"), 1);
+	glUniform1i(glGetUniformLocation(program, "sInstances"), 2);
+	glUniform1i(glGetUniformLocation(program, "sDraws"), 3);
+	glUniform1i(glGetUniformLocation(program, "sVisible"), 4);
+	glUniform1f(glGetUniformLocation(program, "cShininess"), 32.0f);
+	glUniform3f(glGetUniformLocation(program, "cAmbientColor"), 0.2f, 0.2f, 0.2f);
+	glUniform3f(glGetUniformLocation(program, "cLight.direction"), -0.2f, -1.0f, -0.3f);
+	glUniform3f(glGetUniformLocation(program, "cLight.diffuse"), 1.0f, 0.8f, 0.6f);
+	glUniform3f(glGetUniformLocation(program, "cLight.specular"), 0.5f, 0.5f, 0.5f);
+	if (gpu_culling)
+	{
+		uniform_planes = glGetUniformLocation(cull_program, "cPlanes");
+		uniform_prev_viewproj = glGetUniformLocation(cull_program, "cPrevViewProj");
+		uniform_occlusion = glGetUniformLocation(cull_program, "cOcclusion");
+		glUseProgram(cull_program);
+		glUniform1ui(glGetUniformLocation(cull_program, "cObjects"), OBJECTS_COUNT);
+		glUniform1i(glGetUniformLocation(cull_program, "sPyramid"), 5);
+	}
+	glUseProgram(0);
+
+	if (!validate_gl("Shader Uniforms Error"))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// =====================================
+	// Scene
+	// =====================================
+	// Objects
+	// Objects are grouped by mesh and material as in the previous tutorial,
+	// but nothing is sorted on the CPU: every frame the cull shader packs the
+	// objects that pass into the visible list, group after group, and counts
+	// them straight into the instance counts of the draw list. Without
+	// compute shaders the CPU does the same after testing the objects
+	// against the walls rasterized in software.
+	unsigned object_groups[OBJECTS_COUNT];
+	unsigned object_draws[OBJECTS_COUNT];
+	unsigned group_sizes[GROUPS_COUNT];
+	unsigned group_draws[GROUPS_COUNT];
+	unsigned draw_data[GROUPS_COUNT * 4];
+	unsigned first;
+	mat4 wall_transforms[WALLS_COUNT];
+	mat4* transforms = (mat4*)malloc(OBJECTS_COUNT * sizeof(mat4));
+	vec4* bounds = (vec4*)malloc(OBJECTS_COUNT * sizeof(vec4));
+	vec3 (*boxes)[2] = (vec3(*)[2])malloc(OBJECTS_COUNT * sizeof(vec3[2]));
+	vec3 unit_box[2] = { { -0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, 0.5f } };
+	vec3 position, axis = { 0.0f, 1.0f, 0.0f };
+	vec3 wall_size = { WALL_WIDTH, WALL_HEIGHT, WALL_DEPTH };
+	float scale;
+
+	for (i = 0; i < OBJECTS_X * OBJECTS_Z; ++i)
+	{
+		object_groups[i] = (unsigned)rand() % GROUPS_COUNT;
+		position[0] = ((float)(i % OBJECTS_X) - OBJECTS_X * 0.5f) * 2.0f;
+		position[1] = (float)(rand() % 100) * 0.01f - 2.0f;
+		position[2] = -(float)(i / OBJECTS_X) * 2.0f - 2.0f;
+		scale = 0.5f + (float)(rand() % 100) * 0.005f;
+		glm_translate_make(transforms[i], position);
+		glm_rotate(transforms[i], (float)(rand() % 360) * GLM_PIf / 180.0f, axis);
+		glm_scale_uni(transforms[i], scale);
+		// Every mesh fits into the unit cube
+		glm_vec4(position, scale * 0.5f * sqrtf(3.0f), bounds[i]);
+		glm_aabb_transform(unit_box, transforms[i], boxes[i]);
+	}
+
+	// Walls hide whole blocks of the field behind them
+	for (i = 0; i < WALLS_COUNT; ++i)
+	{
+		const unsigned object = OBJECTS_X * OBJECTS_Z + i;
+		object_groups[object] = 1;
+		position[0] = ((float)(i % WALLS_X) - (WALLS_X - 1) * 0.5f) * (WALL_WIDTH + 8.0f);
+		position[1] = WALL_HEIGHT * 0.5f - 2.0f;
+		position[2] = -(float)(i / WALLS_X) * 32.0f - 24.0f;
+		glm_translate_make(transforms[object], position);
+		glm_scale(transforms[object], wall_size);
+		glm_mat4_copy(transforms[object], wall_transforms[i]);
+		glm_vec4(position, glm_vec3_norm(wall_size) * 0.5f, bounds[object]);
+		glm_aabb_transform(unit_box, transforms[object], boxes[object]);
+	}
+
+	memset(group_sizes, 0, sizeof(group_sizes));
+	for (i = 0; i < OBJECTS_COUNT; ++i)
+		++group_sizes[object_groups[i]];
+
+	struct draw_list draws;
+	if (!create_draw_list(&draws, GROUPS_COUNT))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+	// Instance counts start at zero and are filled in by the cull shader,
+	// each group owns as many visible list slots as it has objects
+	for (i = 0, first = 0; i < GROUPS_COUNT; ++i)
+	{
+		if (!group_sizes[i])
+			continue;
+		const int draw = add_draw(&draws, &meshes.meshes[i / MATERIALS_COUNT], 0, first);
+		group_draws[i] = (unsigned)draw;
+		draw_data[draw * 4] = first;
+		draw_data[draw * 4 + 1] = i % MATERIALS_COUNT;
+		draw_data[draw * 4 + 2] = 0;
+		draw_data[draw * 4 + 3] = 0;
+		first += group_sizes[i];
+	}
+	for (i = 0; i < OBJECTS_COUNT; ++i)
+		object_draws[i] = group_draws[object_groups[i]];
+	upload_draw_list(&draws);
+
+	// The vertex shader reads through buffer textures as in the previous
+	// tutorial, the cull shader goes through shader storage blocks
+	unsigned instance_buffer, instance_texture;
+	glGenBuffers(1, &instance_buffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, instance_buffer);
+	glBufferData(GL_TEXTURE_BUFFER, OBJECTS_COUNT * sizeof(mat4), transforms, GL_STATIC_DRAW);
+	glGenTextures(1, &instance_texture);
+	glBindTexture(GL_TEXTURE_BUFFER, instance_texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, instance_buffer);
+
+	unsigned draw_buffer, draw_texture;
+	glGenBuffers(1, &draw_buffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, draw_buffer);
+	glBufferData(GL_TEXTURE_BUFFER, draws.count * 4 * sizeof(unsigned), draw_data, GL_STATIC_DRAW);
+	glGenTextures(1, &draw_texture);
+	glBindTexture(GL_TEXTURE_BUFFER, draw_texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, draw_buffer);
+
+	unsigned visible_buffer, visible_texture;
+	glGenBuffers(1, &visible_buffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, visible_buffer);
+	glBufferData(GL_TEXTURE_BUFFER, OBJECTS_COUNT * sizeof(unsigned), NULL, GL_DYNAMIC_COPY);
+	glGenTextures(1, &visible_texture);
+	glBindTexture(GL_TEXTURE_BUFFER, visible_texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, visible_buffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	unsigned bounds_buffer = 0, object_draw_buffer = 0, counter_buffer = 0;
+	const unsigned counters_zero[2] = { 0, 0 };
+	if (gpu_culling)
+	{
+		glGenBuffers(1, &bounds_buffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, bounds_buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, OBJECTS_COUNT * sizeof(vec4), bounds, GL_STATIC_DRAW);
+		glGenBuffers(1, &object_draw_buffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, object_draw_buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, OBJECTS_COUNT * sizeof(unsigned), object_draws, GL_STATIC_DRAW);
+		glGenBuffers(1, &counter_buffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, counter_buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(counters_zero), counters_zero, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, bounds_buffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, object_draw_buffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, draws.buffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, visible_buffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, counter_buffer);
+	}
+	free(transforms);
+
+	// Culled counts are copied into one of these every frame and read back
+	// once its fence has passed, so the CPU never waits for the cull shader
+	unsigned readback_buffers[READBACK_FRAMES];
+	GLsync readback_fences[READBACK_FRAMES];
+	unsigned culled[2] = { 0, 0 };
+	unsigned pyramid_culled = 0;
+	unsigned readback;
+	memset(readback_buffers, 0, sizeof(readback_buffers));
+	memset(readback_fences, 0, sizeof(readback_fences));
+	if (gpu_culling)
+	{
+		glGenBuffers(READBACK_FRAMES, readback_buffers);
+		for (i = 0; i < READBACK_FRAMES; ++i)
+		{
+			glBindBuffer(GL_COPY_WRITE_BUFFER, readback_buffers[i]);
+			glBufferData(GL_COPY_WRITE_BUFFER, sizeof(culled), NULL, GL_STREAM_READ);
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+	if (!validate_gl("Buffer Creation Error"))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Framebuffer
+	// The scene is drawn into a depth texture so the pyramid can be built from it
+	unsigned framebuffer, color_buffer, depth_texture;
+	glGenRenderbuffers(1, &color_buffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, color_buffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WIDTH, HEIGHT);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glGenTextures(1, &depth_texture);
+	glBindTexture(GL_TEXTURE_2D, depth_texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, WIDTH, HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_buffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth_texture, 0);
+	success = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (!success)
+	{
+		error("OpenGL Error", "Scene framebuffer is incomplete.");
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Depth Pyramid
+	struct depth_pyramid pyramid;
+	memset(&pyramid, 0, sizeof(pyramid));
+	// The CPU path builds it the way a driver without compute shaders would
+	// and culls against a copy read back a few frames later
+	if (!create_depth_pyramid(&pyramid, WIDTH, HEIGHT, gpu_culling ? 0 : DEPTH_PYRAMID_CPU_COPY | DEPTH_PYRAMID_FRAGMENT))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Software Occlusion
+	// Only the walls are worth rasterizing, the field would mostly hide itself.
+	// The frustum is tested against a hierarchy of the object boxes.
+	struct occlusion_buffer occlusion;
+	struct bvh bvh;
+	unsigned char* visible = NULL;
+	unsigned* visible_list = NULL;
+	unsigned* frustum_list = NULL;
+	unsigned frustum_count;
+	memset(&occlusion, 0, sizeof(occlusion));
+	memset(&bvh, 0, sizeof(bvh));
+	if (!gpu_culling)
+	{
+		if (!create_occlusion_buffer(&occlusion, WALLS_COUNT * WALL_TRIANGLES))
+		{
+			SDL_GL_DeleteContext(context);
+			SDL_DestroyWindow(window);
+			SDL_Quit();
+			return 1;
+		}
+		if (!build_bvh(&bvh, boxes, OBJECTS_COUNT))
+		{
+			error("Culling Error", "Could not allocate a hierarchy of %u objects.", OBJECTS_COUNT);
+			SDL_GL_DeleteContext(context);
+			SDL_DestroyWindow(window);
+			SDL_Quit();
+			return 1;
+		}
+		visible = (unsigned char*)malloc(OBJECTS_COUNT);
+		visible_list = (unsigned*)malloc(OBJECTS_COUNT * sizeof(unsigned));
+		frustum_list = (unsigned*)malloc(OBJECTS_COUNT * sizeof(unsigned));
+	}
+	free(boxes);
+
+	// Camera
+	vec3 camera_position = { 0.0f, 0.0f, 3.0f };
+	vec3 camera_direction;
+	vec3 camera_up;
+	versor camera_rotation = GLM_QUAT_IDENTITY_INIT;
+
+	// =====================================
+	// Rendering
+	// =====================================
+	// Matrices
+	mat4 view, viewproj;
+	vec4 planes[6];
+
+	// Projection Matrix
+	mat4 proj;
+	glm_perspective(45.0f, (float)WIDTH / (float)HEIGHT, 0.01f, 200.0f, proj);
+
+	// Textures
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, diffuse_array.texture);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, specular_array.texture);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_BUFFER, instance_texture);
+	glActiveTexture(GL_TEXTURE3);
+	glBindTexture(GL_TEXTURE_BUFFER, draw_texture);
+	glActiveTexture(GL_TEXTURE4);
+	glBindTexture(GL_TEXTURE_BUFFER, visible_texture);
+	glActiveTexture(GL_TEXTURE5);
+	glBindTexture(GL_TEXTURE_2D, pyramid.texture);
+	glActiveTexture(GL_TEXTURE0);
+
+	// Statistics
+	char title[256];
+	unsigned frame = 0;
+	unsigned frames = 0;
+	float title_time = 0.0f;
+	float cull_time = 0.0f;
+	Uint64 cull_start;
+	struct draw_command* command;
+
+	int run = 1;
+	float tick_delta;
+	float tick_curr;
+	float tick_prev = 0.0f;
+	unsigned short controls = 0;
+	while (run)
+	{
+		tick_curr = (float)SDL_GetTicks();
+		tick_delta = tick_curr - tick_prev;
+		process_events(camera_position, camera_direction, camera_rotation, &controls, &run, tick_delta);
+		tick_prev = tick_curr;
+
+		// =================================
+		// Camera
+		// =================================
+		// Look
+		glm_quat_rotatev(camera_rotation, GLM_FORWARD, camera_direction);
+
+		// View Matrix
+		glm_quat_rotatev(camera_rotation, GLM_YUP, camera_up);
+		glm_look(camera_position, camera_direction, camera_up, view);
+
+		// View and Projection Matrix
+		glm_mat4_mul_sse2(proj, view, viewproj);
+
+		// =================================
+		// Culling
+		// =================================
+		// Objects are tested against this frame's frustum and against the
+		// depth pyramid of the previous frame, seen from the previous camera.
+		// Anything that was hidden last frame and shows up now is one frame
+		// late, which is the usual price of reusing the last depth buffer.
+		// The software path has no such lag for the walls: they are rasterized
+		// from the current camera before anything is tested against them.
+		// The rest of the field hides objects through the CPU copy of the
+		// pyramid, which is a few frames older still.
+		glm_frustum_planes(viewproj, planes);
+		if (gpu_culling)
+		{
+			upload_draw_list(&draws);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, counter_buffer);
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(counters_zero), counters_zero);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+			glUseProgram(cull_program);
+			glUniform4fv(uniform_planes, 6, planes[0]);
+			glUniformMatrix4fv(uniform_prev_viewproj, 1, GL_FALSE, pyramid.viewproj[0]);
+			glUniform1i(uniform_occlusion, pyramid.ready);
+			glDispatchCompute((OBJECTS_COUNT + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+			glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+			// Culled Counts
+			readback = frame % READBACK_FRAMES;
+			if (readback_fences[readback])
+			{
+				success = glClientWaitSync(readback_fences[readback], 0, 0);
+				if (success == GL_ALREADY_SIGNALED || success == GL_CONDITION_SATISFIED)
+				{
+					glBindBuffer(GL_COPY_READ_BUFFER, readback_buffers[readback]);
+					glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(culled), culled);
+				}
+				glDeleteSync(readback_fences[readback]);
+			}
+			glBindBuffer(GL_COPY_READ_BUFFER, counter_buffer);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, readback_buffers[readback]);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(culled));
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+			readback_fences[readback] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+		else
+		{
+			cull_start = SDL_GetPerformanceCounter();
+
+			// Frustum
+			frustum_count = query_bvh_frustum(&bvh, planes, frustum_list);
+			memset(visible, 0, OBJECTS_COUNT);
+			for (i = 0; i < frustum_count; ++i)
+				visible[frustum_list[i]] = 1;
+			culled[0] = OBJECTS_COUNT - frustum_count;
+
+			// Occluders
+			begin_occlusion(&occlusion, viewproj);
+			for (i = 0; i < WALLS_COUNT; ++i)
+				add_occluder(&occlusion, cube_vertices, MESH_VERTEX_FLOATS, cube_indices,
+							 sizeof(cube_indices) / sizeof(unsigned), wall_transforms[i]);
+			rasterize_occluders(&occlusion);
+			culled[1] = cull_occluded(&occlusion, bounds, OBJECTS_COUNT, visible);
+
+			// The rest of the field, as the depth pyramid saw it a few frames ago
+			pyramid_culled = 0;
+			for (i = 0; i < OBJECTS_COUNT; ++i)
+				if (visible[i] && pyramid_occluded(&pyramid, bounds[i]))
+				{
+					visible[i] = 0;
+					++pyramid_culled;
+				}
+
+			// Visible list, packed per draw like the cull shader does
+			for (i = 0; i < draws.count; ++i)
+				draws.commands[i].instance_count = 0;
+			for (i = 0; i < OBJECTS_COUNT; ++i)
+				if (visible[i])
+				{
+					command = &draws.commands[object_draws[i]];
+					visible_list[command->base_instance + command->instance_count++] = i;
+				}
+			draws.dirty = 1;
+			glBindBuffer(GL_TEXTURE_BUFFER, visible_buffer);
+			glBufferSubData(GL_TEXTURE_BUFFER, 0, OBJECTS_COUNT * sizeof(unsigned), visible_list);
+			glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+			cull_time += (float)((double)(SDL_GetPerformanceCounter() - cull_start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+		}
+
+		// =================================
+		// Rendering
+		// =================================
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		glUseProgram(program);
+		glUniformMatrix4fv(uniform_viewproj, 1, GL_FALSE, viewproj[0]);
+		glUniform3fv(uniform_view_pos, 1, camera_position);
+		glBindVertexArray(meshes.vao);
+		submit_draw_list(&draws, uniform_draw_offset);
+		glBindVertexArray(0);
+		glUseProgram(0);
+
+		// Depth pyramid for the next frame
+		build_depth_pyramid(&pyramid, depth_texture, viewproj);
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		glBlitFramebuffer(0, 0, WIDTH, HEIGHT, 0, 0, WIDTH, HEIGHT, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		// Statistics
+		++frame;
+		++frames;
+		title_time += tick_delta;
+		if (title_time >= 1000.0f)
+		{
+			if (gpu_culling)
+				snprintf(title, sizeof(title), "OpenGL Tutorial 13: %u objects, %u outside the frustum, %u occluded on the GPU, %.2f ms frame",
+						 OBJECTS_COUNT, culled[0], culled[1], (double)title_time / frames);
+			else
+				snprintf(title, sizeof(title), "OpenGL Tutorial 13: %u objects, %u outside the frustum, %u occluded in software, %u by the depth pyramid, %.3f ms cull, %.2f ms frame",
+						 OBJECTS_COUNT, culled[0], culled[1], pyramid_culled, (double)cull_time / frames, (double)title_time / frames);
+			SDL_SetWindowTitle(window, title);
+			frames = 0;
+			title_time = 0.0f;
+			cull_time = 0.0f;
+		}
+
+		if (validate_gl("Open GL Rendering Error"))
+			SDL_GL_SwapWindow(window);
+		else
+			run = 0;
+	}
+
+	// =====================================
+	// Destruction
+	// =====================================
+	// Culled Counts
+	for (i = 0; i < READBACK_FRAMES; ++i)
+		if (readback_fences[i])
+			glDeleteSync(readback_fences[i]);
+	glDeleteBuffers(READBACK_FRAMES, readback_buffers);
+
+	// Software Occlusion
+	free(frustum_list);
+	free(visible_list);
+	free(visible);
+	destroy_bvh(&bvh);
+	destroy_occlusion_buffer(&occlusion);
+	free(bounds);
+
+	// Framebuffer
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &color_buffer);
+
+	// Texture
+	destroy_depth_pyramid(&pyramid);
+	glDeleteTextures(1, &depth_texture);
+	glDeleteTextures(1, &visible_texture);
+	glDeleteTextures(1, &draw_texture);
+	glDeleteTextures(1, &instance_texture);
+	destroy_texture_array(&specular_array);
+	destroy_texture_array(&diffuse_array);
+
+	// Shader
+	glDeleteProgram(cull_program);
+	glDeleteProgram(program);
+
+	// Vertex Buffers
+	glDeleteBuffers(1, &counter_buffer);
+	glDeleteBuffers(1, &object_draw_buffer);
+	glDeleteBuffers(1, &bounds_buffer);
+	glDeleteBuffers(1, &visible_buffer);
+	glDeleteBuffers(1, &draw_buffer);
+	glDeleteBuffers(1, &instance_buffer);
+	destroy_draw_list(&draws);
+	destroy_mesh_buffer(&meshes);
+
+	// Jobs
+	if (!gpu_culling)
+		jobs_shutdown();
+
+	// SDL
+	SDL_GL_DeleteContext(context);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+
+	return 0;
+}
+
+__declspec(dllexport) unsigned NvOptimusEnablement = 1;
+__declspec(dllexport) int AmdPowerXpressRequestHighPerformance = 1;
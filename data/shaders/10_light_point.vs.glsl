@@ -4,9 +4,9 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormals;
 layout (location = 2) in vec2 aTexCoord;
 
-uniform mat4 cViewProj;
+uniform mat4 cModelViewProj;
 uniform mat4 cModel;
-uniform mat4 cModelInv;
+uniform mat3 cNormalMatrix;
 
 out vec2 vTexCoord;
 out vec3 vNormal;
@@ -15,7 +15,7 @@ out vec3 vFragPos;
 void main()
 {
 	vTexCoord = aTexCoord;
-	vNormal = mat3(cModelInv) * aNormals;
+	vNormal = cNormalMatrix * aNormals;
 	vFragPos = (cModel * vec4(aPos, 1.0)).xyz;
-	gl_Position = cViewProj * cModel * vec4(aPos, 1.0);
+	gl_Position = cModelViewProj * vec4(aPos, 1.0);
 }
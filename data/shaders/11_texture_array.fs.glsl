@@ -0,0 +1,46 @@
+#version 330 core
+
+uniform sampler2DArray sDiffuse;
+uniform sampler2DArray sSpecular;
+
+layout (std140) uniform Frame
+{
+	mat4 cViewProj;
+	vec4 cViewPos;
+	vec4 cAmbientColor;
+	vec4 cLightPosition;
+	vec4 cLightDiffuse;
+	vec4 cLightSpecular;
+	vec4 cLightAttenuation; // constant, linear, quadratic, shininess
+};
+
+in vec2 vTexCoord;
+in vec3 vNormal;
+in vec3 vFragPos;
+flat in uint vMaterial;
+
+out vec4 vFragColor;
+
+void main()
+{
+	vec4 diffuseInput = texture(sDiffuse, vec3(vTexCoord, vMaterial));
+	vec4 specularInput = texture(sSpecular, vec3(vTexCoord, vMaterial));
+	
+	vec3 ambient = cAmbientColor.rgb * diffuseInput.rgb;
+
+	float distance = length(cLightPosition.xyz - vFragPos);
+	float attenuation = 1.0 / (cLightAttenuation.x + cLightAttenuation.y * distance + cLightAttenuation.z * (distance * distance));
+	
+	vec3 normal = normalize(vNormal);
+	vec3 lightDir = normalize(cLightPosition.xyz - vFragPos);
+	float lightFactor = max(dot(normal, lightDir), 0.0);
+	vec3 diffuse = cLightDiffuse.rgb * (lightFactor * diffuseInput.rgb) * attenuation;
+
+	vec3 viewDir = normalize(cViewPos.xyz - vFragPos);
+	vec3 reflectDir = reflect(-lightDir, normal);
+	float specularFactor = pow(max(dot(viewDir, reflectDir), 0.0), cLightAttenuation.w);
+	vec3 specular = cLightDiffuse.rgb * (specularFactor * specularInput.rgb) * attenuation;
+
+	vFragColor.rgb = ambient + diffuse + specular;
+	vFragColor.a = 1.0;
+}
@@ -0,0 +1,41 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormals;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in vec4 aRotation;
+layout (location = 4) in vec3 aPosition;
+layout (location = 5) in float aScale;
+layout (location = 7) in uint aMaterial;
+
+layout (std140) uniform Frame
+{
+	mat4 cViewProj;
+	vec4 cViewPos;
+	vec4 cAmbientColor;
+	vec4 cLightPosition;
+	vec4 cLightDiffuse;
+	vec4 cLightSpecular;
+	vec4 cLightAttenuation; // constant, linear, quadratic, shininess
+};
+
+out vec2 vTexCoord;
+out vec3 vNormal;
+out vec3 vFragPos;
+flat out uint vMaterial;
+
+vec3 rotate(vec4 q, vec3 v)
+{
+	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main()
+{
+	vec4 worldPos = vec4(aPosition + rotate(aRotation, aPos * aScale), 1.0);
+	vTexCoord = aTexCoord;
+	// The scale is uniform, so rotating the normal keeps it perpendicular
+	vNormal = rotate(aRotation, aNormals);
+	vFragPos = worldPos.xyz;
+	vMaterial = aMaterial;
+	gl_Position = cViewProj * worldPos;
+}
@@ -0,0 +1,50 @@
+#version 430 core
+#extension GL_ARB_bindless_texture : require
+
+// Resident texture handles, diffuse and specular of each material in turn
+layout (std430, binding = 0) readonly buffer Materials
+{
+	uvec2 cTextures[];
+};
+
+layout (std140) uniform Frame
+{
+	mat4 cViewProj;
+	vec4 cViewPos;
+	vec4 cAmbientColor;
+	vec4 cLightPosition;
+	vec4 cLightDiffuse;
+	vec4 cLightSpecular;
+	vec4 cLightAttenuation; // constant, linear, quadratic, shininess
+};
+
+in vec2 vTexCoord;
+in vec3 vNormal;
+in vec3 vFragPos;
+flat in uint vMaterial;
+
+out vec4 vFragColor;
+
+void main()
+{
+	vec4 diffuseInput = texture(sampler2D(cTextures[vMaterial * 2u]), vTexCoord);
+	vec4 specularInput = texture(sampler2D(cTextures[vMaterial * 2u + 1u]), vTexCoord);
+	
+	vec3 ambient = cAmbientColor.rgb * diffuseInput.rgb;
+
+	float distance = length(cLightPosition.xyz - vFragPos);
+	float attenuation = 1.0 / (cLightAttenuation.x + cLightAttenuation.y * distance + cLightAttenuation.z * (distance * distance));
+	
+	vec3 normal = normalize(vNormal);
+	vec3 lightDir = normalize(cLightPosition.xyz - vFragPos);
+	float lightFactor = max(dot(normal, lightDir), 0.0);
+	vec3 diffuse = cLightDiffuse.rgb * (lightFactor * diffuseInput.rgb) * attenuation;
+
+	vec3 viewDir = normalize(cViewPos.xyz - vFragPos);
+	vec3 reflectDir = reflect(-lightDir, normal);
+	float specularFactor = pow(max(dot(viewDir, reflectDir), 0.0), cLightAttenuation.w);
+	vec3 specular = cLightDiffuse.rgb * (specularFactor * specularInput.rgb) * attenuation;
+
+	vFragColor.rgb = ambient + diffuse + specular;
+	vFragColor.a = 1.0;
+}
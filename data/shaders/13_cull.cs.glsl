@@ -0,0 +1,101 @@
+#version 430 core
+
+layout (local_size_x = 64) in;
+
+struct DrawCommand
+{
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+};
+
+layout (std430, binding = 0) readonly buffer Bounds { vec4 bBounds[]; };		// Centre and radius per object
+layout (std430, binding = 1) readonly buffer Draws { uint bDraws[]; };			// Draw of each object
+layout (std430, binding = 2) buffer Commands { DrawCommand bCommands[]; };
+layout (std430, binding = 3) writeonly buffer Visible { uint bVisible[]; };
+layout (std430, binding = 4) buffer Counters
+{
+	uint bFrustumCulled;
+	uint bOcclusionCulled;
+};
+
+uniform uint cObjects;
+uniform vec4 cPlanes[6];			// Current frustum, normals point inside
+uniform mat4 cPrevViewProj;			// Camera the pyramid was rendered with
+uniform bool cOcclusion;
+uniform sampler2D sPyramid;			// Farthest depth per texel, level zero is the depth buffer
+
+bool outsideFrustum(vec4 sphere)
+{
+	for (int i = 0; i < 6; ++i)
+		if (dot(cPlanes[i].xyz, sphere.xyz) + cPlanes[i].w < -sphere.w)
+			return true;
+	return false;
+}
+
+bool occluded(vec4 sphere)
+{
+	vec2 minUV = vec2(1.0);
+	vec2 maxUV = vec2(0.0);
+	float minDepth = 1.0;
+	for (int i = 0; i < 8; ++i)
+	{
+		vec3 corner = sphere.xyz + sphere.w * vec3((i & 1) != 0 ? 1.0 : -1.0,
+												   (i & 2) != 0 ? 1.0 : -1.0,
+												   (i & 4) != 0 ? 1.0 : -1.0);
+		vec4 clip = cPrevViewProj * vec4(corner, 1.0);
+		// Crossing the camera plane: the projected rectangle is unbounded
+		if (clip.w <= 0.0)
+			return false;
+		vec3 ndc = clip.xyz / clip.w;
+		minUV = min(minUV, ndc.xy * 0.5 + 0.5);
+		maxUV = max(maxUV, ndc.xy * 0.5 + 0.5);
+		minDepth = min(minDepth, ndc.z * 0.5 + 0.5);
+	}
+
+	// Texel rectangle at level zero. A pyramid level with 2^level times fewer
+	// texels than the rectangle is wide holds it in at most two by two texels.
+	ivec2 size = textureSize(sPyramid, 0);
+	ivec2 first = clamp(ivec2(floor(minUV * vec2(size))), ivec2(0), size - 1);
+	ivec2 last = clamp(ivec2(floor(maxUV * vec2(size))), ivec2(0), size - 1);
+	int span = max(last.x - first.x, last.y - first.y);
+	int level = min(span > 0 ? findMSB(span) + 1 : 0, textureQueryLevels(sPyramid) - 1);
+
+	// Levels halve with rounding down and the last texel absorbs the odd
+	// row or column, so a texel maps to its index shifted and clamped.
+	// The size is worked out here because llvmpipe answers textureSize with
+	// a non-constant level from one level too far.
+	ivec2 levelSize = max(size >> level, ivec2(1));
+	first = min(first >> level, levelSize - 1);
+	last = min(last >> level, levelSize - 1);
+	float maxDepth = max(max(texelFetch(sPyramid, first, level).r,
+							 texelFetch(sPyramid, ivec2(last.x, first.y), level).r),
+						 max(texelFetch(sPyramid, ivec2(first.x, last.y), level).r,
+							 texelFetch(sPyramid, last, level).r));
+	return minDepth > maxDepth;
+}
+
+void main()
+{
+	uint object = gl_GlobalInvocationID.x;
+	if (object >= cObjects)
+		return;
+
+	vec4 sphere = bBounds[object];
+	if (outsideFrustum(sphere))
+	{
+		atomicAdd(bFrustumCulled, 1u);
+		return;
+	}
+	if (cOcclusion && occluded(sphere))
+	{
+		atomicAdd(bOcclusionCulled, 1u);
+		return;
+	}
+
+	uint draw = bDraws[object];
+	uint slot = atomicAdd(bCommands[draw].instanceCount, 1u);
+	bVisible[bCommands[draw].baseInstance + slot] = object;
+}
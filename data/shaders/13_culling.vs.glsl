@@ -0,0 +1,40 @@
+#version 330 core
+#extension GL_ARB_shader_draw_parameters : enable
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormals;
+layout (location = 2) in vec2 aTexCoord;
+
+uniform mat4 cViewProj;
+uniform uint cDrawOffset;
+uniform samplerBuffer sInstances;	// Four texels of model matrix per object
+uniform usamplerBuffer sDraws;		// First visible slot and material per draw
+uniform usamplerBuffer sVisible;	// Objects that passed culling, packed per draw
+
+out vec2 vTexCoord;
+out vec3 vNormal;
+out vec3 vFragPos;
+flat out uint vMaterial;
+
+void main()
+{
+#ifdef GL_ARB_shader_draw_parameters
+	uint drawID = cDrawOffset + uint(gl_DrawIDARB);
+#else
+	uint drawID = cDrawOffset;
+#endif
+	uvec4 draw = texelFetch(sDraws, int(drawID));
+	int instance = int(texelFetch(sVisible, int(draw.x) + gl_InstanceID).x) * 4;
+	mat4 model = mat4(texelFetch(sInstances, instance),
+					  texelFetch(sInstances, instance + 1),
+					  texelFetch(sInstances, instance + 2),
+					  texelFetch(sInstances, instance + 3));
+
+	vec4 worldPos = model * vec4(aPos, 1.0);
+	vTexCoord = aTexCoord;
+	// Objects are rotated and scaled along their own axes only, normals are renormalised in the fragment shader
+	vNormal = mat3(model) * aNormals;
+	vFragPos = worldPos.xyz;
+	vMaterial = draw.y;
+	gl_Position = cViewProj * worldPos;
+}
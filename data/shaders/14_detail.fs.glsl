@@ -0,0 +1,63 @@
+#version 330 core
+
+struct LightEnv
+{
+	vec3 direction;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+uniform sampler2DArray sDiffuse;
+uniform sampler2DArray sSpecular;
+uniform float cShininess;
+uniform LightEnv cLight;
+uniform vec3 cAmbientColor;
+uniform vec3 cViewPos;
+uniform uint cSpecularLevels;	// Coarser levels are lit without specular
+
+in vec2 vTexCoord;
+in vec3 vNormal;
+in vec3 vFragPos;
+flat in uint vMaterial;
+flat in uint vLevel;
+flat in uint vFade;
+
+out vec4 vFragColor;
+
+const float bayer[16] = float[16](
+	 0.0,  8.0,  2.0, 10.0,
+	12.0,  4.0, 14.0,  6.0,
+	 3.0, 11.0,  1.0,  9.0,
+	15.0,  7.0, 13.0,  5.0);
+
+void main()
+{
+	// Cross-fade by dithering: the incoming level keeps the pixels below
+	// the fade and the outgoing one the rest, so together they cover the
+	// object exactly once without blending or sorting
+	ivec2 pixel = ivec2(gl_FragCoord.xy) & 3;
+	float threshold = (bayer[pixel.y * 4 + pixel.x] + 0.5) / 16.0;
+	float fade = float(vFade & 127u) / 127.0;
+	if ((vFade & 128u) != 0u ? threshold < fade : threshold >= fade)
+		discard;
+
+	vec4 diffuseInput = texture(sDiffuse, vec3(vTexCoord, vMaterial));
+	
+	vec3 ambient = cAmbientColor * diffuseInput.rgb;
+	
+	vec3 normal = normalize(vNormal);
+	vec3 lightDir = normalize(-cLight.direction);
+	float lightFactor = max(dot(normal, lightDir), 0.0);
+	vec3 diffuse = cLight.diffuse * (lightFactor * diffuseInput.rgb);
+
+	vFragColor.rgb = ambient + diffuse;
+	vFragColor.a = 1.0;
+	if (vLevel < cSpecularLevels)
+	{
+		vec4 specularInput = texture(sSpecular, vec3(vTexCoord, vMaterial));
+		vec3 viewDir = normalize(cViewPos - vFragPos);
+		vec3 reflectDir = reflect(-lightDir, normal);
+		float specularFactor = pow(max(dot(viewDir, reflectDir), 0.0), cShininess);
+		vFragColor.rgb += cLight.specular * (specularFactor * specularInput.rgb);
+	}
+}
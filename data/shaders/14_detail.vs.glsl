@@ -0,0 +1,49 @@
+#version 330 core
+#extension GL_ARB_shader_draw_parameters : enable
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormals;
+layout (location = 2) in vec2 aTexCoord;
+
+uniform mat4 cViewProj;
+uniform uint cDrawOffset;
+uniform samplerBuffer sInstances;	// Rotation, then position and scale per instance
+uniform usamplerBuffer sDraws;		// First entry, material and detail level per draw
+uniform usamplerBuffer sVisible;	// Object and fade of every drawn instance
+
+out vec2 vTexCoord;
+out vec3 vNormal;
+out vec3 vFragPos;
+flat out uint vMaterial;
+flat out uint vLevel;
+flat out uint vFade;
+
+// Rotates a vector by a unit quaternion
+vec3 rotate(vec4 q, vec3 v)
+{
+	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main()
+{
+#ifdef GL_ARB_shader_draw_parameters
+	uint drawID = cDrawOffset + uint(gl_DrawIDARB);
+#else
+	uint drawID = cDrawOffset;
+#endif
+	uvec4 draw = texelFetch(sDraws, int(drawID));
+	uint entry = texelFetch(sVisible, int(draw.x) + gl_InstanceID).x;
+	int instance = int(entry & 0xFFFFFFu) * 2;
+	vec4 rotation = texelFetch(sInstances, instance);
+	vec4 placement = texelFetch(sInstances, instance + 1);
+
+	vec4 worldPos = vec4(placement.xyz + rotate(rotation, aPos * placement.w), 1.0);
+	vTexCoord = aTexCoord;
+	// The scale is uniform, so the rotation alone turns the normals
+	vNormal = rotate(rotation, aNormals);
+	vFragPos = worldPos.xyz;
+	vMaterial = draw.y;
+	vLevel = draw.z;
+	vFade = entry >> 24;
+	gl_Position = cViewProj * worldPos;
+}
@@ -0,0 +1,56 @@
+#version 330 core
+
+struct LightEnv
+{
+	vec3 direction;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+uniform sampler2DArray sAlbedo;	// Atlas of frames per material, coverage in alpha
+uniform sampler2D sNormals;		// Object space normals of the same frames
+uniform LightEnv cLight;
+uniform vec3 cAmbientColor;
+
+in vec2 vTexCoord;
+flat in vec4 vRotation;
+flat in uint vMaterial;
+flat in uint vFade;
+
+out vec4 vFragColor;
+
+const float bayer[16] = float[16](
+	 0.0,  8.0,  2.0, 10.0,
+	12.0,  4.0, 14.0,  6.0,
+	 3.0, 11.0,  1.0,  9.0,
+	15.0,  7.0, 13.0,  5.0);
+
+// Rotates a vector by a unit quaternion
+vec3 rotate(vec4 q, vec3 v)
+{
+	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main()
+{
+	// Same dithered cross-fade as the meshes
+	ivec2 pixel = ivec2(gl_FragCoord.xy) & 3;
+	float threshold = (bayer[pixel.y * 4 + pixel.x] + 0.5) / 16.0;
+	float fade = float(vFade & 127u) / 127.0;
+	if ((vFade & 128u) != 0u ? threshold < fade : threshold >= fade)
+		discard;
+
+	vec4 albedo = texture(sAlbedo, vec3(vTexCoord, vMaterial));
+	if (albedo.a < 0.5)
+		discard;
+
+	vec3 ambient = cAmbientColor * albedo.rgb;
+
+	vec3 normal = normalize(rotate(vRotation, texture(sNormals, vTexCoord).xyz * 2.0 - 1.0));
+	vec3 lightDir = normalize(-cLight.direction);
+	float lightFactor = max(dot(normal, lightDir), 0.0);
+	vec3 diffuse = cLight.diffuse * (lightFactor * albedo.rgb);
+
+	vFragColor.rgb = ambient + diffuse;
+	vFragColor.a = 1.0;
+}
@@ -0,0 +1,73 @@
+#version 330 core
+#extension GL_ARB_shader_draw_parameters : enable
+
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 cViewProj;
+uniform vec3 cViewPos;
+uniform uint cDrawOffset;
+uniform uint cDrawBase;				// Impostor draws come after the mesh draws in sDraws
+uniform uint cFrames;				// Frames along each side of the octahedral atlas
+uniform float cRadius;				// Bounding radius the frames were baked with
+uniform samplerBuffer sInstances;	// Rotation, then position and scale per instance
+uniform usamplerBuffer sDraws;		// First entry, material and detail level per draw
+uniform usamplerBuffer sVisible;	// Object and fade of every drawn instance
+
+out vec2 vTexCoord;
+flat out vec4 vRotation;
+flat out uint vMaterial;
+flat out uint vFade;
+
+// Rotates a vector by a unit quaternion
+vec3 rotate(vec4 q, vec3 v)
+{
+	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+// Octahedral mapping of a direction onto [-1, 1] with +Y in the centre
+vec2 encodeOctahedron(vec3 dir)
+{
+	dir /= abs(dir.x) + abs(dir.y) + abs(dir.z);
+	vec2 p = dir.xz;
+	if (dir.y < 0.0)
+		p = (1.0 - abs(p.yx)) * vec2(p.x < 0.0 ? -1.0 : 1.0, p.y < 0.0 ? -1.0 : 1.0);
+	return p;
+}
+
+vec3 decodeOctahedron(vec2 p)
+{
+	vec3 dir = vec3(p.x, 1.0 - abs(p.x) - abs(p.y), p.y);
+	if (dir.y < 0.0)
+		dir.xz = (1.0 - abs(p.yx)) * vec2(p.x < 0.0 ? -1.0 : 1.0, p.y < 0.0 ? -1.0 : 1.0);
+	return normalize(dir);
+}
+
+void main()
+{
+#ifdef GL_ARB_shader_draw_parameters
+	uint drawID = cDrawBase + cDrawOffset + uint(gl_DrawIDARB);
+#else
+	uint drawID = cDrawBase + cDrawOffset;
+#endif
+	uvec4 draw = texelFetch(sDraws, int(drawID));
+	uint entry = texelFetch(sVisible, int(draw.x) + gl_InstanceID).x;
+	int instance = int(entry & 0xFFFFFFu) * 2;
+	vec4 rotation = texelFetch(sInstances, instance);
+	vec4 placement = texelFetch(sInstances, instance + 1);
+
+	// Pick the frame baked closest to the direction of the camera in object
+	// space and turn the quad to face along it, so the picture lines up
+	// with the object exactly as it was baked
+	vec3 viewDir = normalize(rotate(vec4(-rotation.xyz, rotation.w), cViewPos - placement.xyz));
+	vec2 frame = floor((encodeOctahedron(viewDir) * 0.5 + 0.5) * float(cFrames - 1u) + 0.5);
+	vec3 frameDir = decodeOctahedron(frame / float(cFrames - 1u) * 2.0 - 1.0);
+	vec3 right = normalize(cross(abs(frameDir.y) > 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0), frameDir));
+	vec3 up = cross(frameDir, right);
+
+	vec4 worldPos = vec4(placement.xyz + rotate(rotation, (right * aPos.x + up * aPos.y) * cRadius * placement.w), 1.0);
+	vTexCoord = (frame + aPos.xy * 0.5 + 0.5) / float(cFrames);
+	vRotation = rotation;
+	vMaterial = draw.y;
+	vFade = entry >> 24;
+	gl_Position = cViewProj * worldPos;
+}
@@ -0,0 +1,43 @@
+#version 330 core
+
+struct LightEnv
+{
+	vec3 direction;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+uniform sampler2DArray sDiffuse;
+uniform sampler2DArray sSpecular;
+uniform float cShininess;
+uniform LightEnv cLight;
+uniform vec3 cAmbientColor;
+uniform vec3 cViewPos;
+uniform uint cMaterial;
+
+in vec2 vTexCoord;
+in vec3 vNormal;
+in vec3 vFragPos;
+
+out vec4 vFragColor;
+
+void main()
+{
+	vec4 diffuseInput = texture(sDiffuse, vec3(vTexCoord, cMaterial));
+	vec4 specularInput = texture(sSpecular, vec3(vTexCoord, cMaterial));
+	
+	vec3 ambient = cAmbientColor * diffuseInput.rgb;
+	
+	vec3 normal = normalize(vNormal);
+	vec3 lightDir = normalize(-cLight.direction);
+	float lightFactor = max(dot(normal, lightDir), 0.0);
+	vec3 diffuse = cLight.diffuse * (lightFactor * diffuseInput.rgb);
+
+	vec3 viewDir = normalize(cViewPos - vFragPos);
+	vec3 reflectDir = reflect(-lightDir, normal);
+	float specularFactor = pow(max(dot(viewDir, reflectDir), 0.0), cShininess);
+	vec3 specular = cLight.specular * (specularFactor * specularInput.rgb);
+
+	vFragColor.rgb = ambient + diffuse + specular;
+	vFragColor.a = 1.0;
+}
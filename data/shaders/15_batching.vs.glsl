@@ -0,0 +1,22 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormals;
+layout (location = 2) in vec2 aTexCoord;
+
+uniform mat4 cViewProj;
+uniform mat4 cModel;	// Identity for static batches, already in world space
+
+out vec2 vTexCoord;
+out vec3 vNormal;
+out vec3 vFragPos;
+
+void main()
+{
+	vec4 worldPos = cModel * vec4(aPos, 1.0);
+	vTexCoord = aTexCoord;
+	// Objects are rotated and uniformly scaled only, normals are renormalised in the fragment shader
+	vNormal = mat3(cModel) * aNormals;
+	vFragPos = worldPos.xyz;
+	gl_Position = cViewProj * worldPos;
+}
@@ -0,0 +1,37 @@
+#version 330 core
+
+struct LightEnv
+{
+	vec3 direction;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+uniform vec3 cColor;
+uniform float cShininess;
+uniform LightEnv cLight;
+uniform vec3 cAmbientColor;
+uniform vec3 cViewPos;
+
+in vec3 vNormal;
+in vec3 vFragPos;
+
+out vec4 vFragColor;
+
+void main()
+{
+	vec3 ambient = cAmbientColor * cColor;
+
+	vec3 normal = normalize(vNormal);
+	vec3 lightDir = normalize(-cLight.direction);
+	float lightFactor = max(dot(normal, lightDir), 0.0);
+	vec3 diffuse = cLight.diffuse * (lightFactor * cColor);
+
+	vec3 viewDir = normalize(cViewPos - vFragPos);
+	vec3 reflectDir = reflect(-lightDir, normal);
+	float specularFactor = pow(max(dot(viewDir, reflectDir), 0.0), cShininess);
+	vec3 specular = cLight.specular * specularFactor;
+
+	vFragColor.rgb = ambient + diffuse + specular;
+	vFragColor.a = 1.0;
+}
@@ -0,0 +1,17 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormals;
+
+uniform mat4 cViewProj;
+
+out vec3 vNormal;
+out vec3 vFragPos;
+
+void main()
+{
+	// Skinned on the CPU, already in world space
+	vNormal = aNormals;
+	vFragPos = aPos;
+	gl_Position = cViewProj * vec4(aPos, 1.0);
+}
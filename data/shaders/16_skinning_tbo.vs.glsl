@@ -0,0 +1,38 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormals;
+layout (location = 2) in uvec4 aJoints;
+layout (location = 3) in vec4 aWeights;
+
+// Palettes of all characters of the frame, one after another, four texels
+// per matrix. The offset is where this frame starts in the stream buffer.
+uniform samplerBuffer sPalettes;
+uniform int cPaletteOffset;
+uniform int cJointsCount;
+uniform mat4 cViewProj;
+
+out vec3 vNormal;
+out vec3 vFragPos;
+
+mat4 joint(uint index)
+{
+	int texel = cPaletteOffset + (gl_InstanceID * cJointsCount + int(index)) * 4;
+	return mat4(texelFetch(sPalettes, texel),
+				texelFetch(sPalettes, texel + 1),
+				texelFetch(sPalettes, texel + 2),
+				texelFetch(sPalettes, texel + 3));
+}
+
+void main()
+{
+	mat4 skin = joint(aJoints.x) * aWeights.x +
+				joint(aJoints.y) * aWeights.y +
+				joint(aJoints.z) * aWeights.z +
+				joint(aJoints.w) * aWeights.w;
+	vec4 worldPos = skin * vec4(aPos, 1.0);
+	// Joints only rotate and move, normals are renormalised in the fragment shader
+	vNormal = mat3(skin) * aNormals;
+	vFragPos = worldPos.xyz;
+	gl_Position = cViewProj * worldPos;
+}
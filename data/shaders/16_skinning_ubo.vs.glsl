@@ -0,0 +1,30 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormals;
+layout (location = 2) in uvec4 aJoints;
+layout (location = 3) in vec4 aWeights;
+
+// Palette of the character being drawn, SKELETON_MAX_JOINTS matrices
+layout (std140) uniform Palette
+{
+	mat4 cJoints[64];
+};
+
+uniform mat4 cViewProj;
+
+out vec3 vNormal;
+out vec3 vFragPos;
+
+void main()
+{
+	mat4 skin = cJoints[aJoints.x] * aWeights.x +
+				cJoints[aJoints.y] * aWeights.y +
+				cJoints[aJoints.z] * aWeights.z +
+				cJoints[aJoints.w] * aWeights.w;
+	vec4 worldPos = skin * vec4(aPos, 1.0);
+	// Joints only rotate and move, normals are renormalised in the fragment shader
+	vNormal = mat3(skin) * aNormals;
+	vFragPos = worldPos.xyz;
+	gl_Position = cViewProj * worldPos;
+}
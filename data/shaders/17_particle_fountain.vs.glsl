@@ -0,0 +1,22 @@
+#version 330 core
+
+layout (location = 0) in vec2 aCorner;
+layout (location = 1) in float aX;
+layout (location = 2) in float aY;
+layout (location = 3) in float aZ;
+layout (location = 4) in float aLife;
+
+// One quad per particle, turned to face the camera and shrinking as the
+// particle burns out
+uniform mat4 cModelViewProj;
+uniform vec3 cCameraRight;
+uniform vec3 cCameraUp;
+uniform float cSize;
+uniform float cLife;
+
+void main()
+{
+	float size = cSize * clamp(aLife / cLife, 0.0, 1.0);
+	vec3 pos = vec3(aX, aY, aZ) + (cCameraRight * aCorner.x + cCameraUp * aCorner.y) * size;
+	gl_Position = cModelViewProj * vec4(pos, 1.0);
+}
@@ -0,0 +1,15 @@
+#version 330 core
+
+uniform vec3 cColor;
+
+in float vFade;
+
+out vec4 FragColor;
+
+void main()
+{
+	// Round sparks, dimming as they burn out
+	vec2 offset = gl_PointCoord * 2.0 - 1.0;
+	float falloff = max(1.0 - dot(offset, offset), 0.0);
+	FragColor = vec4(cColor * falloff * vFade, 1.0);
+}
@@ -0,0 +1,16 @@
+#version 330 core
+
+layout (location = 0) in vec4 aPosition;	// Life left in w
+layout (location = 1) in vec4 aVelocity;	// Life at birth in w
+
+uniform mat4 cViewProj;
+uniform float cPointSize;	// Particle size times the pixels per unit at distance one
+
+out float vFade;
+
+void main()
+{
+	vFade = clamp(aPosition.w / aVelocity.w, 0.0, 1.0);
+	gl_Position = cViewProj * vec4(aPosition.xyz, 1.0);
+	gl_PointSize = max(cPointSize / gl_Position.w, 1.0);
+}
@@ -0,0 +1,16 @@
+#version 330 core
+
+uniform vec3 cColor;
+uniform vec3 cLightDir;		// Towards the light
+
+in vec3 vNormal;
+
+out vec4 FragColor;
+
+const float AMBIENT = 0.2;
+
+void main()
+{
+	float diffuse = max(dot(normalize(vNormal), cLightDir), 0.0);
+	FragColor = vec4(cColor * (AMBIENT + (1.0 - AMBIENT) * diffuse), 1.0);
+}
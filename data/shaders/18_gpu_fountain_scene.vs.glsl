@@ -0,0 +1,14 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormals;
+
+uniform mat4 cViewProj;
+
+out vec3 vNormal;
+
+void main()
+{
+	vNormal = aNormals;
+	gl_Position = cViewProj * vec4(aPos, 1.0);
+}
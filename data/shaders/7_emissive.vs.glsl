@@ -2,10 +2,9 @@
 
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 cModel;
-uniform mat4 cViewProj;
+uniform mat4 cModelViewProj;
 
 void main()
 {
-	gl_Position = cViewProj * cModel * vec4(aPos, 1.0);
+	gl_Position = cModelViewProj * vec4(aPos, 1.0);
 }
@@ -0,0 +1,33 @@
+#version 430 core
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+uniform int cLevel;
+uniform sampler2D sDepth;								// Depth buffer, read for level zero
+layout (r32f, binding = 0) readonly uniform image2D iSource;	// Previous level
+layout (r32f, binding = 1) writeonly uniform image2D iDest;
+
+void main()
+{
+	ivec2 dest = ivec2(gl_GlobalInvocationID.xy);
+	ivec2 destSize = imageSize(iDest);
+	if (any(greaterThanEqual(dest, destSize)))
+		return;
+
+	if (cLevel == 0)
+	{
+		imageStore(iDest, dest, vec4(texelFetch(sDepth, dest, 0).r));
+		return;
+	}
+
+	// Levels halve with rounding down, so the last texel of a level below an
+	// odd sized one also covers the odd column or row
+	ivec2 sourceSize = imageSize(iSource);
+	ivec2 first = dest * 2;
+	ivec2 last = min(first + 1 + ivec2(equal(dest, destSize - 1)) * (sourceSize & 1), sourceSize - 1);
+	float depth = 0.0;
+	for (int y = first.y; y <= last.y; ++y)
+		for (int x = first.x; x <= last.x; ++x)
+			depth = max(depth, imageLoad(iSource, ivec2(x, y)).r);
+	imageStore(iDest, dest, vec4(depth));
+}
@@ -0,0 +1,28 @@
+#version 330 core
+
+uniform int cLevel;
+uniform sampler2D sSource;	// Depth buffer for level zero, otherwise the previous level as the base level
+
+out vec4 vFragColor;
+
+void main()
+{
+	ivec2 dest = ivec2(gl_FragCoord.xy);
+	if (cLevel == 0)
+	{
+		vFragColor = vec4(texelFetch(sSource, dest, 0).r);
+		return;
+	}
+
+	// Levels halve with rounding down, so the last texel of a level below an
+	// odd sized one also covers the odd column or row
+	ivec2 sourceSize = textureSize(sSource, 0);
+	ivec2 destSize = max(sourceSize >> 1, ivec2(1));
+	ivec2 first = dest * 2;
+	ivec2 last = min(first + 1 + ivec2(equal(dest, destSize - 1)) * (sourceSize & 1), sourceSize - 1);
+	float depth = 0.0;
+	for (int y = first.y; y <= last.y; ++y)
+		for (int x = first.x; x <= last.x; ++x)
+			depth = max(depth, texelFetch(sSource, ivec2(x, y), 0).r);
+	vFragColor = vec4(depth);
+}
@@ -0,0 +1,7 @@
+#version 330 core
+
+// One triangle covering the viewport, drawn without vertex buffers
+void main()
+{
+	gl_Position = vec4(float((gl_VertexID & 1) * 4 - 1), float((gl_VertexID & 2) * 2 - 1), 0.0, 1.0);
+}
@@ -0,0 +1,56 @@
+#version 430 core
+
+layout (local_size_x = 256) in;
+
+struct Particle
+{
+	vec4 position;	// Life left in w
+	vec4 velocity;	// Life at birth in w
+};
+
+layout (std430, binding = 0) readonly buffer Source { Particle bSource[]; };
+layout (std430, binding = 1) writeonly buffer Dest { Particle bDest[]; };
+layout (std430, binding = 2) buffer Counters
+{
+	uvec4 bDraws[2];	// Draw arrays command per buffer, counting its live particles
+	uint bDispatch[3];
+	uint bEmitCount;	// What fits beside the live particles
+};
+
+uniform uint cSource;
+uniform bool cPrepare;			// Size the dispatch instead of simulating
+uniform uint cEmitCount;
+
+// emit() and simulate() come from gpu_particles.glsl
+
+void main()
+{
+	uint dest = 1u - cSource;
+	uint live = bDraws[cSource].x;
+	if (cPrepare)
+	{
+		// Survivors are at most the live, so with the emitted clamped to the
+		// room left every particle appended gets a slot
+		bEmitCount = min(cEmitCount, uint(bDest.length()) - live);
+		bDispatch[0] = (live + bEmitCount + 255u) / 256u;
+		bDraws[dest].x = 0u;
+		return;
+	}
+
+	uint id = gl_GlobalInvocationID.x;
+	vec4 position, velocity;
+	if (id < live)
+	{
+		position = bSource[id].position;
+		velocity = bSource[id].velocity;
+		simulate(position, velocity);
+		if (position.w <= 0.0)
+			return;
+	}
+	else if (id < live + bEmitCount)
+		emit(id - live, position, velocity);
+	else
+		return;
+
+	bDest[atomicAdd(bDraws[dest].x, 1u)] = Particle(position, velocity);
+}
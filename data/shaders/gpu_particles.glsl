@@ -0,0 +1,109 @@
+// Shared by the compute and the transform feedback simulation, compiled in
+// right after the #version line of each
+
+uniform uint cSeed;
+uniform vec3 cEmitterPosition;
+uniform vec3 cEmitterVelocity;
+uniform vec3 cEmitterSpread;
+uniform vec2 cEmitterLife;		// Life and how far it may differ
+uniform vec3 cAcceleration;
+uniform float cDrag;
+uniform float cRestitution;
+uniform float cTime;
+uniform mat4 cViewProj;			// Camera of the depth buffer
+uniform mat4 cInvViewProj;
+uniform sampler2D sDepth;
+
+uint hash(uint x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+// -1 to 1
+float random(inout uint state)
+{
+	state = hash(state);
+	return float(state >> 8) / 8388608.0 - 1.0;
+}
+
+void emit(uint index, out vec4 position, out vec4 velocity)
+{
+	uint state = hash(index ^ hash(cSeed));
+	vec3 offset, direction;
+	offset.x = random(state);
+	offset.y = random(state);
+	offset.z = random(state);
+	direction.x = random(state);
+	direction.y = random(state);
+	direction.z = random(state);
+	float life = cEmitterLife.x + cEmitterLife.y * random(state);
+	position = vec4(cEmitterPosition + cEmitterSpread * offset, life);
+	velocity = vec4(cEmitterVelocity + cEmitterSpread * direction, life);
+}
+
+// Texel of the depth buffer a point falls in, false off screen
+bool project(vec3 point, out ivec2 texel)
+{
+	vec4 clip = cViewProj * vec4(point, 1.0);
+	if (clip.w <= 0.0)
+		return false;
+	vec3 ndc = clip.xyz / clip.w;
+	if (any(greaterThan(abs(ndc), vec3(1.0))))
+		return false;
+
+	ivec2 size = textureSize(sDepth, 0);
+	texel = min(ivec2((ndc.xy * 0.5 + 0.5) * vec2(size)), size - 2);
+	return true;
+}
+
+vec3 unproject(ivec2 texel, vec2 size)
+{
+	float depth = texelFetch(sDepth, texel, 0).r;
+	vec4 point = cInvViewProj * vec4((vec2(texel) + 0.5) / size * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+	return point.xyz / point.w;
+}
+
+// A step ending behind the surface the depth buffer holds there, and
+// starting in front of it, is undone and the velocity reflected off the
+// surface. Both ends are measured against the plane of the surface, its
+// normal taken from the neighbouring texels, as texels seen at a shallow
+// angle span far more depth than a step is long. The start may be behind
+// by as much as the step is long, which keeps particles resting on the
+// surface there despite the depth precision, while a step that goes behind
+// a nearer object usually starts much deeper behind it.
+void collide(vec3 start, inout vec4 position, inout vec4 velocity)
+{
+	ivec2 texel;
+	if (!project(position.xyz, texel))
+		return;
+
+	vec2 size = vec2(textureSize(sDepth, 0));
+	vec3 surface = unproject(texel, size);
+	vec3 normal = cross(unproject(texel + ivec2(1, 0), size) - surface,
+						unproject(texel + ivec2(0, 1), size) - surface);
+	if (dot(normal, normal) <= 0.0)
+		return;
+	// Facing the camera, the point clip space puts at w = 0
+	if (dot(normal, cInvViewProj[2].xyz / cInvViewProj[2].w - surface) < 0.0)
+		normal = -normal;
+	normal = normalize(normal);
+	if (dot(start - surface, normal) < -distance(start, position.xyz) || dot(position.xyz - surface, normal) >= 0.0)
+		return;
+
+	position.xyz = start;
+	velocity.xyz = reflect(velocity.xyz, normal) * cRestitution;
+}
+
+void simulate(inout vec4 position, inout vec4 velocity)
+{
+	vec3 start = position.xyz;
+	velocity.xyz = (velocity.xyz + cAcceleration * cTime) * max(1.0 - cDrag * cTime, 0.0);
+	position.xyz += velocity.xyz * cTime;
+	position.w -= cTime;
+	collide(start, position, velocity);
+}
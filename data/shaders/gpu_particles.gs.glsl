@@ -0,0 +1,22 @@
+#version 330 core
+
+// Only live particles are captured, packed, so the transform feedback
+// object counts them for the next draw
+layout (points) in;
+layout (points, max_vertices = 1) out;
+
+in vec4 vPosition[];
+in vec4 vVelocity[];
+
+out vec4 fPosition;
+out vec4 fVelocity;
+
+void main()
+{
+	if (vPosition[0].w <= 0.0)
+		return;
+	fPosition = vPosition[0];
+	fVelocity = vVelocity[0];
+	EmitVertex();
+	EndPrimitive();
+}
@@ -0,0 +1,21 @@
+#version 330 core
+
+layout (location = 0) in vec4 aPosition;	// Life left in w
+layout (location = 1) in vec4 aVelocity;	// Life at birth in w
+
+uniform bool cEmitting;			// Make new particles from the vertex index, ignoring the attributes
+
+out vec4 vPosition;
+out vec4 vVelocity;
+
+// emit() and simulate() come from gpu_particles.glsl
+
+void main()
+{
+	vPosition = aPosition;
+	vVelocity = aVelocity;
+	if (cEmitting)
+		emit(uint(gl_VertexID), vPosition, vVelocity);
+	else
+		simulate(vPosition, vVelocity);
+}
@@ -0,0 +1,267 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <GL/glew.h>
+#include <SDL_events.h>
+#include "cglm/mat4.h"
+#include "common.h"
+#include "depth_pyramid.h"
+
+#define GROUP_SIZE 8
+
+static unsigned level_size(unsigned size, unsigned level)
+{
+	return size >> level ? size >> level : 1;
+}
+
+int create_depth_pyramid(struct depth_pyramid* pyramid, unsigned width, unsigned height, unsigned flags)
+{
+	unsigned i;
+
+	memset(pyramid, 0, sizeof(struct depth_pyramid));
+	pyramid->width = width;
+	pyramid->height = height;
+	pyramid->levels = 1;
+	while ((width | height) >> pyramid->levels)
+		++pyramid->levels;
+	while (pyramid->cpu_level + 1 < pyramid->levels && level_size(width, pyramid->cpu_level) > DEPTH_PYRAMID_CPU_WIDTH)
+		++pyramid->cpu_level;
+	pyramid->cpu_width = level_size(width, pyramid->cpu_level);
+	pyramid->cpu_height = level_size(height, pyramid->cpu_level);
+	pyramid->compute = GLEW_VERSION_4_3 && !(flags & DEPTH_PYRAMID_FRAGMENT);
+
+	if (pyramid->compute)
+		pyramid->program = create_compute_program("data/shaders/depth_pyramid", NULL);
+	else
+		pyramid->program = create_program("data/shaders/depth_pyramid");
+	if (!pyramid->program)
+		return 0;
+	pyramid->level_location = glGetUniformLocation(pyramid->program, "cLevel");
+	glUseProgram(pyramid->program);
+	glUniform1i(glGetUniformLocation(pyramid->program, pyramid->compute ? "sDepth" : "sSource"), DEPTH_PYRAMID_UNIT);
+	glUseProgram(0);
+
+	glGenTextures(1, &pyramid->texture);
+	glBindTexture(GL_TEXTURE_2D, pyramid->texture);
+	for (i = 0; i < pyramid->levels; ++i)
+		glTexImage2D(GL_TEXTURE_2D, i, GL_R32F, level_size(width, i), level_size(height, i), 0, GL_RED, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, pyramid->levels - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if (!pyramid->compute)
+	{
+		glGenFramebuffers(1, &pyramid->framebuffer);
+		glGenVertexArrays(1, &pyramid->vao);
+	}
+
+	if (flags & DEPTH_PYRAMID_CPU_COPY)
+	{
+		pyramid->cpu_depth = (float*)malloc(pyramid->cpu_width * pyramid->cpu_height * sizeof(float));
+		glGenBuffers(DEPTH_PYRAMID_READBACKS, pyramid->readback_buffers);
+		for (i = 0; i < DEPTH_PYRAMID_READBACKS; ++i)
+		{
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, pyramid->readback_buffers[i]);
+			glBufferData(GL_PIXEL_PACK_BUFFER, pyramid->cpu_width * pyramid->cpu_height * sizeof(float), NULL, GL_STREAM_READ);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+
+	if (!validate_gl("Depth Pyramid Creation Error"))
+	{
+		destroy_depth_pyramid(pyramid);
+		return 0;
+	}
+	return 1;
+}
+
+void destroy_depth_pyramid(struct depth_pyramid* pyramid)
+{
+	unsigned i;
+	for (i = 0; i < DEPTH_PYRAMID_READBACKS; ++i)
+		if (pyramid->readback_fences[i])
+			glDeleteSync((GLsync)pyramid->readback_fences[i]);
+	if (pyramid->readback_buffers[0])
+		glDeleteBuffers(DEPTH_PYRAMID_READBACKS, pyramid->readback_buffers);
+	if (pyramid->vao)
+		glDeleteVertexArrays(1, &pyramid->vao);
+	if (pyramid->framebuffer)
+		glDeleteFramebuffers(1, &pyramid->framebuffer);
+	if (pyramid->texture)
+		glDeleteTextures(1, &pyramid->texture);
+	if (pyramid->program)
+		glDeleteProgram(pyramid->program);
+	free(pyramid->cpu_depth);
+	memset(pyramid, 0, sizeof(struct depth_pyramid));
+}
+
+static void build_compute(struct depth_pyramid* pyramid)
+{
+	unsigned level;
+
+	for (level = 0; level < pyramid->levels; ++level)
+	{
+		glUniform1i(pyramid->level_location, (int)level);
+		glBindImageTexture(0, pyramid->texture, level ? level - 1 : 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+		glBindImageTexture(1, pyramid->texture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+		glDispatchCompute((level_size(pyramid->width, level) + GROUP_SIZE - 1) / GROUP_SIZE,
+						  (level_size(pyramid->height, level) + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+		if (level + 1 < pyramid->levels)
+			glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+	}
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+}
+
+// Every pass samples the previous level as the only level in reach, which
+// keeps it apart from the level it renders into
+static void build_fragment(struct depth_pyramid* pyramid)
+{
+	int viewport[4], framebuffer;
+	const GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+	const GLboolean cull_face = glIsEnabled(GL_CULL_FACE);
+	unsigned level;
+
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_CULL_FACE);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, pyramid->framebuffer);
+	glBindVertexArray(pyramid->vao);
+
+	for (level = 0; level < pyramid->levels; ++level)
+	{
+		if (level == 1)
+			glBindTexture(GL_TEXTURE_2D, pyramid->texture);
+		if (level > 0)
+		{
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+		}
+		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pyramid->texture, level);
+		glViewport(0, 0, level_size(pyramid->width, level), level_size(pyramid->height, level));
+		glUniform1i(pyramid->level_location, (int)level);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+	}
+
+	if (pyramid->levels > 1)
+	{
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, pyramid->levels - 1);
+	}
+	glBindVertexArray(0);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (unsigned)framebuffer);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	if (depth_test)
+		glEnable(GL_DEPTH_TEST);
+	if (cull_face)
+		glEnable(GL_CULL_FACE);
+}
+
+// Picks up the oldest copy if the GPU is done with it and queues a new one
+static void read_back(struct depth_pyramid* pyramid, mat4 viewproj)
+{
+	const unsigned slot = pyramid->readback;
+	GLenum status;
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, pyramid->readback_buffers[slot]);
+	if (pyramid->readback_fences[slot])
+	{
+		status = glClientWaitSync((GLsync)pyramid->readback_fences[slot], 0, 0);
+		if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+		{
+			glGetBufferSubData(GL_PIXEL_PACK_BUFFER, 0, pyramid->cpu_width * pyramid->cpu_height * sizeof(float), pyramid->cpu_depth);
+			glm_mat4_copy(pyramid->readback_viewproj[slot], pyramid->cpu_viewproj);
+			pyramid->cpu_ready = 1;
+		}
+		glDeleteSync((GLsync)pyramid->readback_fences[slot]);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, pyramid->texture);
+	glGetTexImage(GL_TEXTURE_2D, pyramid->cpu_level, GL_RED, GL_FLOAT, (void*)0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	pyramid->readback_fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glm_mat4_copy(viewproj, pyramid->readback_viewproj[slot]);
+	pyramid->readback = (slot + 1) % DEPTH_PYRAMID_READBACKS;
+}
+
+// Call after the opaque pass with its single level depth texture and camera.
+// Leaves the program unbound and GL_TEXTURE0 active.
+void build_depth_pyramid(struct depth_pyramid* pyramid, unsigned depth_texture, mat4 viewproj)
+{
+	glUseProgram(pyramid->program);
+	glActiveTexture(GL_TEXTURE0 + DEPTH_PYRAMID_UNIT);
+	glBindTexture(GL_TEXTURE_2D, depth_texture);
+	if (pyramid->compute)
+		build_compute(pyramid);
+	else
+		build_fragment(pyramid);
+	glUseProgram(0);
+
+	if (pyramid->cpu_depth)
+		read_back(pyramid, viewproj);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+
+	glm_mat4_copy(viewproj, pyramid->viewproj);
+	pyramid->ready = 1;
+}
+
+static unsigned cpu_texel(const struct depth_pyramid* pyramid, float coord, unsigned size, unsigned cpu_size)
+{
+	unsigned texel;
+	if (coord <= 0.0f)
+		return 0;
+	texel = coord < 1.0f ? (unsigned)(coord * (float)size) : size - 1;
+	texel >>= pyramid->cpu_level;
+	return texel < cpu_size ? texel : cpu_size - 1;
+}
+
+// Farthest depth over a rectangle of [0, 1] viewport coordinates in the CPU
+// copy, as seen by cpu_viewproj. Returns the far plane until a copy arrives
+// and without DEPTH_PYRAMID_CPU_COPY.
+float sample_depth_pyramid(const struct depth_pyramid* pyramid, float min_u, float min_v, float max_u, float max_v)
+{
+	unsigned x, y, first_x, first_y, last_x, last_y;
+	const float* row;
+	float depth = 0.0f;
+
+	if (!pyramid->cpu_ready)
+		return 1.0f;
+	first_x = cpu_texel(pyramid, min_u, pyramid->width, pyramid->cpu_width);
+	first_y = cpu_texel(pyramid, min_v, pyramid->height, pyramid->cpu_height);
+	last_x = cpu_texel(pyramid, max_u, pyramid->width, pyramid->cpu_width);
+	last_y = cpu_texel(pyramid, max_v, pyramid->height, pyramid->cpu_height);
+	for (y = first_y; y <= last_y; ++y)
+	{
+		row = pyramid->cpu_depth + y * pyramid->cpu_width;
+		for (x = first_x; x <= last_x; ++x)
+			depth = fmaxf(depth, row[x]);
+	}
+	return depth;
+}
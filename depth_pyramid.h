@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef DEPTH_PYRAMID_H
+#define DEPTH_PYRAMID_H
+
+#include "cglm/types.h"
+
+#define DEPTH_PYRAMID_UNIT 15
+#define DEPTH_PYRAMID_READBACKS 3
+#define DEPTH_PYRAMID_CPU_WIDTH 128
+
+// Creation flags
+#define DEPTH_PYRAMID_CPU_COPY 1
+#define DEPTH_PYRAMID_FRAGMENT 2
+
+// Farthest depth mip chain of a depth buffer, for occlusion tests and
+// screen space effects. Level zero is a copy of the depth buffer, every
+// next level halves with rounding down like texture mips, and its last
+// column and row also cover the odd column and row above them. So a
+// level zero texel is found on level n at its index shifted right by n
+// and clamped to the level size.
+//
+// Built by a compute shader on 4.3, by a chain of fragment passes on 3.3
+// or with DEPTH_PYRAMID_FRAGMENT. Building uses texture unit
+// DEPTH_PYRAMID_UNIT and, with compute, image units 0 and 1. With
+// DEPTH_PYRAMID_CPU_COPY a coarse level no wider than DEPTH_PYRAMID_CPU_WIDTH
+// is copied back to the CPU without stalling and arrives a few builds later.
+struct depth_pyramid
+{
+	mat4 viewproj;
+	mat4 cpu_viewproj;
+	mat4 readback_viewproj[DEPTH_PYRAMID_READBACKS];
+	void* readback_fences[DEPTH_PYRAMID_READBACKS];
+	unsigned readback_buffers[DEPTH_PYRAMID_READBACKS];
+	float* cpu_depth;
+	unsigned texture;
+	unsigned program;
+	unsigned framebuffer;
+	unsigned vao;
+	unsigned width;
+	unsigned height;
+	unsigned levels;
+	unsigned cpu_level;
+	unsigned cpu_width;
+	unsigned cpu_height;
+	unsigned readback;
+	int level_location;
+	int compute;
+	int ready;
+	int cpu_ready;
+};
+
+int create_depth_pyramid(struct depth_pyramid* pyramid, unsigned width, unsigned height, unsigned flags);
+void destroy_depth_pyramid(struct depth_pyramid* pyramid);
+
+void build_depth_pyramid(struct depth_pyramid* pyramid, unsigned depth_texture, mat4 viewproj);
+float sample_depth_pyramid(const struct depth_pyramid* pyramid, float min_u, float min_v, float max_u, float max_v);
+
+#endif // DEPTH_PYRAMID_H
@@ -0,0 +1,658 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SDL_MAIN_HANDLED
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_main.h>
+#include "cglm/affine.h"
+#include "cglm/box.h"
+#include "cglm/cam.h"
+#include "cglm/frustum.h"
+#include "cglm/quat.h"
+#include "bvh.h"
+#include "common.h"
+#include "draw_list.h"
+#include "jobs.h"
+#include "lod.h"
+#include "mesh_buffer.h"
+#include "packed_instance.h"
+#include "texture_manager.h"
+
+#define OBJECTS_X 256
+#define OBJECTS_Z 256
+#define OBJECTS_COUNT (OBJECTS_X * OBJECTS_Z)
+#define MESH_LEVELS 4
+#define LEVELS_COUNT (MESH_LEVELS + 1)
+#define MATERIALS_COUNT (sizeof(material_files) / sizeof(material_files[0]))
+#define DRAWS_COUNT (MESH_LEVELS * MATERIALS_COUNT)
+#define ROUNDING 0.08f
+#define MAX_SEGMENTS 12
+#define MAX_VERTICES (6 * (MAX_SEGMENTS + 1) * (MAX_SEGMENTS + 1))
+#define MAX_INDICES (36 * MAX_SEGMENTS * MAX_SEGMENTS)
+
+// Must match the impostorbake options in CMakeLists.txt
+#define IMPOSTOR_FRAMES 16
+#define IMPOSTOR_RADIUS 0.8660254f
+
+// Segments along every edge of a face, the last level is a plain cube
+static const unsigned level_segments[MESH_LEVELS] = { MAX_SEGMENTS, 6, 3, 1 };
+
+// Levels switch at 20%, 8%, 3% and 1.2% of the screen height, 15% either
+// way. Below the last mesh level crates become impostors.
+static const struct lod_levels crate_levels =
+{
+	{ 0.2f, 0.08f, 0.03f, 0.012f, 0.0f }, LEVELS_COUNT, 0.15f, 300.0f
+};
+
+// Normal, tangent and bitangent of every face
+static const float face_axes[6][3][3] =
+{
+	{ {  0.0f,  0.0f,  1.0f }, {  1.0f,  0.0f,  0.0f }, { 0.0f, 1.0f,  0.0f } },
+	{ {  0.0f,  0.0f, -1.0f }, { -1.0f,  0.0f,  0.0f }, { 0.0f, 1.0f,  0.0f } },
+	{ {  0.0f,  1.0f,  0.0f }, {  1.0f,  0.0f,  0.0f }, { 0.0f, 0.0f, -1.0f } },
+	{ {  0.0f, -1.0f,  0.0f }, {  1.0f,  0.0f,  0.0f }, { 0.0f, 0.0f,  1.0f } },
+	{ { -1.0f,  0.0f,  0.0f }, {  0.0f,  0.0f,  1.0f }, { 0.0f, 1.0f,  0.0f } },
+	{ {  1.0f,  0.0f,  0.0f }, {  0.0f,  0.0f, -1.0f }, { 0.0f, 1.0f,  0.0f } }
+};
+
+// Diffuse, specular and impostor atlas of every material
+static const char* material_files[][3] =
+{
+	{ "data/textures/crate_diffuse.tex", "data/textures/crate_specular.tex", "data/impostors/crate_diffuse.tex" },
+	{ "data/textures/crate_dark_diffuse.tex", "data/textures/crate_dark_specular.tex", "data/impostors/crate_dark_diffuse.tex" },
+	{ "data/textures/crate_painted_diffuse.tex", "data/textures/crate_painted_specular.tex", "data/impostors/crate_painted_diffuse.tex" }
+};
+
+// Unit crate with rounded edges: every face is a grid pushed out from an
+// inner box by the rounding radius. One segment gives a plain cube.
+static void build_rounded_box(float* vertices, unsigned* vertices_count, unsigned* indices, unsigned* indices_count, unsigned segments)
+{
+	const float inner = 0.5f - ROUNDING;
+	unsigned face, row, column, first;
+	vec3 point, center, normal;
+	float u, v;
+
+	*vertices_count = 0;
+	*indices_count = 0;
+	for (face = 0; face < 6; ++face)
+	{
+		first = *vertices_count;
+		for (row = 0; row <= segments; ++row)
+			for (column = 0; column <= segments; ++column)
+			{
+				u = (float)column / segments;
+				v = (float)row / segments;
+				glm_vec3_scale((float*)face_axes[face][0], 0.5f, point);
+				glm_vec3_muladds((float*)face_axes[face][1], u - 0.5f, point);
+				glm_vec3_muladds((float*)face_axes[face][2], v - 0.5f, point);
+				if (segments > 1)
+				{
+					center[0] = glm_clamp(point[0], -inner, inner);
+					center[1] = glm_clamp(point[1], -inner, inner);
+					center[2] = glm_clamp(point[2], -inner, inner);
+					glm_vec3_sub(point, center, normal);
+					glm_vec3_normalize(normal);
+					glm_vec3_copy(center, point);
+					glm_vec3_muladds(normal, ROUNDING, point);
+				}
+				else
+					glm_vec3_copy((float*)face_axes[face][0], normal);
+				add_mesh_vertex(vertices, vertices_count, point[0], point[1], point[2], normal, u, v);
+			}
+		for (row = 0; row < segments; ++row)
+			for (column = 0; column < segments; ++column)
+			{
+				const unsigned corner = first + row * (segments + 1) + column;
+				add_mesh_triangle(indices, indices_count, vertices, corner, corner + 1, corner + segments + 2);
+				add_mesh_triangle(indices, indices_count, vertices, corner + segments + 2, corner + segments + 1, corner);
+			}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	// =====================================
+	// Initialisation
+	// =====================================
+	// SDL
+
+	if (SDL_Init(SDL_INIT_VIDEO) < 0)
+	{
+		error("SDL Error", SDL_GetError());
+		return 1;
+	}
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_Window* window = SDL_CreateWindow("OpenGL Tutorial 14",
+										  SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+										  1024, 768, SDL_WINDOW_OPENGL);
+	if (!window)
+	{
+		error("SDL Error", SDL_GetError());
+		SDL_Quit();
+		return 1;
+	}
+	SDL_GLContext context = SDL_GL_CreateContext(window);
+	if (!context)
+	{
+		// Multi draw indirect needs a 4.3 driver, the fallback loop works with 3.3
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+		context = SDL_GL_CreateContext(window);
+	}
+	if (!context)
+	{
+		error("SDL Error", SDL_GetError());
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	SDL_ShowCursor(SDL_DISABLE);
+	SDL_SetRelativeMouseMode(SDL_TRUE);
+
+	// GLEW
+	glewExperimental = GL_TRUE;
+	if (glewInit() != GLEW_OK)
+	{
+		error("GLEW Error", glewGetErrorString(glGetError()));
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Jobs
+	if (!jobs_init(0))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// OpenGL
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_CULL_FACE);
+	glCullFace(GL_BACK);
+	glFrontFace(GL_CW);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+	// Meshes
+	// One mesh per detail level and the impostor quad
+	unsigned i;
+	struct mesh_buffer meshes;
+	if (!create_mesh_buffer(&meshes, MESH_LEVELS * MAX_VERTICES + 4, MESH_LEVELS * MAX_INDICES + 6, LEVELS_COUNT))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	float* box_vertices = (float*)malloc(MAX_VERTICES * MESH_VERTEX_FLOATS * sizeof(float));
+	unsigned* box_indices = (unsigned*)malloc(MAX_INDICES * sizeof(unsigned));
+	unsigned box_vertices_count, box_indices_count;
+	int success = 1;
+	vec3 quad_normal = { 0.0f, 0.0f, 1.0f };
+	for (i = 0; i < MESH_LEVELS && success; ++i)
+	{
+		build_rounded_box(box_vertices, &box_vertices_count, box_indices, &box_indices_count, level_segments[i]);
+		success = add_mesh(&meshes, box_vertices, box_vertices_count, box_indices, box_indices_count) >= 0;
+	}
+	if (success)
+	{
+		// The impostor shader turns the quad to face along the baked view
+		box_vertices_count = 0;
+		box_indices_count = 0;
+		add_mesh_vertex(box_vertices, &box_vertices_count, -1.0f, -1.0f, 0.0f, quad_normal, 0.0f, 0.0f);
+		add_mesh_vertex(box_vertices, &box_vertices_count, 1.0f, -1.0f, 0.0f, quad_normal, 1.0f, 0.0f);
+		add_mesh_vertex(box_vertices, &box_vertices_count, 1.0f, 1.0f, 0.0f, quad_normal, 1.0f, 1.0f);
+		add_mesh_vertex(box_vertices, &box_vertices_count, -1.0f, 1.0f, 0.0f, quad_normal, 0.0f, 1.0f);
+		add_mesh_triangle(box_indices, &box_indices_count, box_vertices, 0, 1, 2);
+		add_mesh_triangle(box_indices, &box_indices_count, box_vertices, 2, 3, 0);
+		success = add_mesh(&meshes, box_vertices, box_vertices_count, box_indices, box_indices_count) >= 0;
+	}
+	free(box_indices);
+	free(box_vertices);
+	if (!success)
+	{
+		destroy_mesh_buffer(&meshes);
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Shader
+	const unsigned program = create_program("data/shaders/14_detail");
+	const unsigned impostor_program = create_program("data/shaders/14_impostor");
+	if (!program || !impostor_program)
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Textures
+	struct texture_array diffuse_array, specular_array, impostor_array;
+	create_texture_array(&diffuse_array, MATERIALS_COUNT);
+	create_texture_array(&specular_array, MATERIALS_COUNT);
+	create_texture_array(&impostor_array, MATERIALS_COUNT);
+	for (i = 0; i < MATERIALS_COUNT; ++i)
+		if (add_texture_layer(&diffuse_array, material_files[i][0]) != (int)i ||
+			add_texture_layer(&specular_array, material_files[i][1]) != (int)i ||
+			add_texture_layer(&impostor_array, material_files[i][2]) != (int)i)
+		{
+			destroy_texture_array(&impostor_array);
+			destroy_texture_array(&specular_array);
+			destroy_texture_array(&diffuse_array);
+			SDL_GL_DeleteContext(context);
+			SDL_DestroyWindow(window);
+			SDL_Quit();
+			return 1;
+		}
+	const unsigned impostor_normals = load_texture("data/impostors/crate_normals.tex");
+	if (!impostor_normals)
+	{
+		destroy_texture_array(&impostor_array);
+		destroy_texture_array(&specular_array);
+		destroy_texture_array(&diffuse_array);
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Shader Uniforms
+	const int uniform_viewproj = glGetUniformLocation(program, "cViewProj");
+	const int uniform_view_pos = glGetUniformLocation(program, "cViewPos");
+	const int uniform_draw_offset = glGetUniformLocation(program, "cDrawOffset");
+
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "sDiffuse"), 0);
+	glUniform1i(glGetUniformLocation(program, "sSpecular"), 1);
+	glUniform1i(glGetUniformLocation(program, "sInstances"), 2);
+	glUniform1i(glGetUniformLocation(program, "sDraws"), 3);
+	glUniform1i(glGetUniformLocation(program, "sVisible"), 4);
+	glUniform1ui(glGetUniformLocation(program, "cSpecularLevels"), 2);
+	glUniform1f(glGetUniformLocation(program, "cShininess"), 32.0f);
+	glUniform3f(glGetUniformLocation(program, "cAmbientColor"), 0.2f, 0.2f, 0.2f);
+	glUniform3f(glGetUniformLocation(program, "cLight.direction"), -0.2f, -1.0f, -0.3f);
+	glUniform3f(glGetUniformLocation(program, "cLight.diffuse"), 1.0f, 0.8f, 0.6f);
+	glUniform3f(glGetUniformLocation(program, "cLight.specular"), 0.5f, 0.5f, 0.5f);
+
+	const int uniform_impostor_viewproj = glGetUniformLocation(impostor_program, "cViewProj");
+	const int uniform_impostor_view_pos = glGetUniformLocation(impostor_program, "cViewPos");
+	const int uniform_impostor_draw_offset = glGetUniformLocation(impostor_program, "cDrawOffset");
+
+	glUseProgram(impostor_program);
+	glUniform1i(glGetUniformLocation(impostor_program, "sAlbedo"), 5);
+	glUniform1i(glGetUniformLocation(impostor_program, "sNormals"), 6);
+	glUniform1i(glGetUniformLocation(impostor_program, "sInstances"), 2);
+	glUniform1i(glGetUniformLocation(impostor_program, "sDraws"), 3);
+	glUniform1i(glGetUniformLocation(impostor_program, "sVisible"), 4);
+	glUniform1ui(glGetUniformLocation(impostor_program, "cDrawBase"), DRAWS_COUNT);
+	glUniform1ui(glGetUniformLocation(impostor_program, "cFrames"), IMPOSTOR_FRAMES);
+	glUniform1f(glGetUniformLocation(impostor_program, "cRadius"), IMPOSTOR_RADIUS);
+	glUniform3f(glGetUniformLocation(impostor_program, "cAmbientColor"), 0.2f, 0.2f, 0.2f);
+	glUniform3f(glGetUniformLocation(impostor_program, "cLight.direction"), -0.2f, -1.0f, -0.3f);
+	glUniform3f(glGetUniformLocation(impostor_program, "cLight.diffuse"), 1.0f, 0.8f, 0.6f);
+	glUseProgram(0);
+
+	if (!validate_gl("Shader Uniforms Error"))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// =====================================
+	// Scene
+	// =====================================
+	// Objects
+	// Objects are sorted by material as in the previous tutorials. Every
+	// detail level of every material is its own instanced draw, with a
+	// region of the visible list as large as the material group: an object
+	// is in at most one region per level, two levels while it cross-fades.
+	// Impostors are drawn by their own program from a second list, their
+	// draw data follows the mesh draws.
+	unsigned* object_materials = (unsigned*)malloc(OBJECTS_COUNT * sizeof(unsigned));
+	unsigned* slot_materials = (unsigned*)malloc(OBJECTS_COUNT * sizeof(unsigned));
+	unsigned material_sizes[MATERIALS_COUNT];
+	unsigned material_first[MATERIALS_COUNT];
+	unsigned draw_data[(DRAWS_COUNT + MATERIALS_COUNT) * 4];
+	struct packed_instance* instances = (struct packed_instance*)malloc(OBJECTS_COUNT * sizeof(struct packed_instance));
+	vec4* bounds = (vec4*)malloc(OBJECTS_COUNT * sizeof(vec4));
+	vec3 (*boxes)[2] = (vec3(*)[2])malloc(OBJECTS_COUNT * sizeof(vec3[2]));
+	vec3 unit_box[2] = { { -0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, 0.5f } };
+	vec3 position, axis = { 0.0f, 1.0f, 0.0f };
+	mat4 transform;
+	unsigned material, level;
+	float scale;
+
+	memset(material_sizes, 0, sizeof(material_sizes));
+	for (i = 0; i < OBJECTS_COUNT; ++i)
+	{
+		object_materials[i] = (unsigned)rand() % MATERIALS_COUNT;
+		++material_sizes[object_materials[i]];
+	}
+	for (i = 0, material_first[0] = 0; i + 1 < MATERIALS_COUNT; ++i)
+		material_first[i + 1] = material_first[i] + material_sizes[i];
+
+	memset(material_sizes, 0, sizeof(material_sizes));
+	for (i = 0; i < OBJECTS_COUNT; ++i)
+	{
+		const unsigned slot = material_first[object_materials[i]] + material_sizes[object_materials[i]]++;
+		slot_materials[slot] = object_materials[i];
+		position[0] = ((float)(i % OBJECTS_X) - OBJECTS_X * 0.5f) * 2.0f;
+		position[1] = (float)(rand() % 100) * 0.01f - 2.0f;
+		position[2] = -(float)(i / OBJECTS_X) * 2.0f - 2.0f;
+		scale = 0.5f + (float)(rand() % 100) * 0.005f;
+		glm_quatv(instances[slot].rotation, (float)(rand() % 360) * GLM_PIf / 180.0f, axis);
+		glm_vec3_copy(position, instances[slot].position);
+		instances[slot].scale = scale;
+		packed_instance_matrix(&instances[slot], transform);
+		glm_vec4(position, scale * 0.5f * sqrtf(3.0f), bounds[slot]);
+		glm_aabb_transform(unit_box, transform, boxes[slot]);
+	}
+
+	struct bvh bvh;
+	if (!build_bvh(&bvh, boxes, OBJECTS_COUNT))
+	{
+		error("Scene Error", "Could not allocate a hierarchy of %u objects.", OBJECTS_COUNT);
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+	free(boxes);
+	free(object_materials);
+
+	struct draw_list draws, impostor_draws;
+	if (!create_draw_list(&draws, DRAWS_COUNT) || !create_draw_list(&impostor_draws, MATERIALS_COUNT))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+	for (level = 0; level < LEVELS_COUNT; ++level)
+		for (material = 0; material < MATERIALS_COUNT; ++material)
+		{
+			const unsigned first = level * OBJECTS_COUNT + material_first[material];
+			const int draw = level < MESH_LEVELS ? add_draw(&draws, &meshes.meshes[level], 0, first)
+												 : (int)DRAWS_COUNT + add_draw(&impostor_draws, &meshes.meshes[level], 0, first);
+			draw_data[draw * 4] = first;
+			draw_data[draw * 4 + 1] = material;
+			draw_data[draw * 4 + 2] = level;
+			draw_data[draw * 4 + 3] = 0;
+		}
+
+	// Per instance and per draw data are read through buffer textures, which 3.3 has as well
+	unsigned instance_buffer, instance_texture;
+	glGenBuffers(1, &instance_buffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, instance_buffer);
+	glBufferData(GL_TEXTURE_BUFFER, OBJECTS_COUNT * sizeof(struct packed_instance), instances, GL_STATIC_DRAW);
+	glGenTextures(1, &instance_texture);
+	glBindTexture(GL_TEXTURE_BUFFER, instance_texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, instance_buffer);
+
+	unsigned draw_buffer, draw_texture;
+	glGenBuffers(1, &draw_buffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, draw_buffer);
+	glBufferData(GL_TEXTURE_BUFFER, sizeof(draw_data), draw_data, GL_STATIC_DRAW);
+	glGenTextures(1, &draw_texture);
+	glBindTexture(GL_TEXTURE_BUFFER, draw_texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, draw_buffer);
+
+	// Objects of every draw with their fade, rewritten every frame
+	unsigned visible_buffer, visible_texture;
+	glGenBuffers(1, &visible_buffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, visible_buffer);
+	glBufferData(GL_TEXTURE_BUFFER, LEVELS_COUNT * OBJECTS_COUNT * sizeof(unsigned), NULL, GL_STREAM_DRAW);
+	glGenTextures(1, &visible_texture);
+	glBindTexture(GL_TEXTURE_BUFFER, visible_texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, visible_buffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	free(instances);
+	if (!validate_gl("Buffer Texture Creation Error"))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Detail Levels
+	struct lod_instance* lods = (struct lod_instance*)malloc(OBJECTS_COUNT * sizeof(struct lod_instance));
+	unsigned* visible_list = (unsigned*)malloc(LEVELS_COUNT * OBJECTS_COUNT * sizeof(unsigned));
+	unsigned* frustum_list = (unsigned*)malloc(OBJECTS_COUNT * sizeof(unsigned));
+	unsigned frustum_count, entries_count, draw;
+	unsigned entry_levels[2], entries[2];
+	init_lod_instances(lods, OBJECTS_COUNT);
+
+	// Camera
+	vec3 camera_position = { 0.0f, 0.0f, 3.0f };
+	vec3 camera_direction;
+	vec3 camera_up;
+	versor camera_rotation = GLM_QUAT_IDENTITY_INIT;
+
+	// =====================================
+	// Rendering
+	// =====================================
+	// Matrices
+	mat4 view, viewproj;
+	vec4 planes[6];
+
+	// Projection Matrix
+	mat4 proj;
+	glm_perspective(glm_rad(45.0f), 1024.0f / 768.0f, 0.01f, 600.0f, proj);
+
+	// Textures
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, diffuse_array.texture);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, specular_array.texture);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_BUFFER, instance_texture);
+	glActiveTexture(GL_TEXTURE3);
+	glBindTexture(GL_TEXTURE_BUFFER, draw_texture);
+	glActiveTexture(GL_TEXTURE4);
+	glBindTexture(GL_TEXTURE_BUFFER, visible_texture);
+	glActiveTexture(GL_TEXTURE5);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, impostor_array.texture);
+	glActiveTexture(GL_TEXTURE6);
+	glBindTexture(GL_TEXTURE_2D, impostor_normals);
+	glActiveTexture(GL_TEXTURE0);
+
+	// Statistics
+	char title[256];
+	unsigned level_counts[LEVELS_COUNT];
+	struct draw_command* command;
+	unsigned fading;
+	double triangles;
+	Uint64 select_start;
+	Uint64 select_time = 0;
+	unsigned frames = 0;
+	float title_time = 0.0f;
+
+	int run = 1;
+	float tick_delta;
+	float tick_curr;
+	float tick_prev = 0.0f;
+	unsigned short controls = 0;
+	while (run)
+	{
+		tick_curr = (float)SDL_GetTicks();
+		tick_delta = tick_curr - tick_prev;
+		process_events(camera_position, camera_direction, camera_rotation, &controls, &run, tick_delta);
+		tick_prev = tick_curr;
+
+		// =================================
+		// Camera
+		// =================================
+		// Look
+		glm_quat_rotatev(camera_rotation, GLM_FORWARD, camera_direction);
+
+		// View Matrix
+		glm_quat_rotatev(camera_rotation, GLM_YUP, camera_up);
+		glm_look(camera_position, camera_direction, camera_up, view);
+
+		// View and Projection Matrix
+		glm_mat4_mul_sse2(proj, view, viewproj);
+
+		// =================================
+		// Detail Levels
+		// =================================
+		// Only objects in the frustum get a level; the rest keep theirs and
+		// fade to the right one when they come back into view
+		select_start = SDL_GetPerformanceCounter();
+		glm_frustum_planes(viewproj, planes);
+		frustum_count = query_bvh_frustum(&bvh, planes, frustum_list);
+		for (draw = 0; draw < draws.count; ++draw)
+			draws.commands[draw].instance_count = 0;
+		for (draw = 0; draw < impostor_draws.count; ++draw)
+			impostor_draws.commands[draw].instance_count = 0;
+		fading = 0;
+		for (i = 0; i < frustum_count; ++i)
+		{
+			const unsigned object = frustum_list[i];
+			update_lod(&crate_levels, &lods[object], lod_projected_size(proj, camera_position, bounds[object]), tick_delta);
+			entries_count = lod_entries(&lods[object], object, entry_levels, entries);
+			fading += entries_count > 1;
+			while (entries_count--)
+			{
+				level = entry_levels[entries_count];
+				command = level < MESH_LEVELS ? &draws.commands[level * MATERIALS_COUNT + slot_materials[object]]
+											  : &impostor_draws.commands[slot_materials[object]];
+				visible_list[command->base_instance + command->instance_count++] = entries[entries_count];
+			}
+		}
+		draws.dirty = 1;
+		impostor_draws.dirty = 1;
+		glBindBuffer(GL_TEXTURE_BUFFER, visible_buffer);
+		glBufferSubData(GL_TEXTURE_BUFFER, 0, LEVELS_COUNT * OBJECTS_COUNT * sizeof(unsigned), visible_list);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+		select_time += SDL_GetPerformanceCounter() - select_start;
+
+		// =================================
+		// Rendering
+		// =================================
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		glUseProgram(program);
+		glUniformMatrix4fv(uniform_viewproj, 1, GL_FALSE, viewproj[0]);
+		glUniform3fv(uniform_view_pos, 1, camera_position);
+		glBindVertexArray(meshes.vao);
+		submit_draw_list(&draws, uniform_draw_offset);
+		glUseProgram(impostor_program);
+		glUniformMatrix4fv(uniform_impostor_viewproj, 1, GL_FALSE, viewproj[0]);
+		glUniform3fv(uniform_impostor_view_pos, 1, camera_position);
+		submit_draw_list(&impostor_draws, uniform_impostor_draw_offset);
+		glBindVertexArray(0);
+		glUseProgram(0);
+
+		// Statistics
+		++frames;
+		title_time += tick_delta;
+		if (title_time >= 1000.0f)
+		{
+			memset(level_counts, 0, sizeof(level_counts));
+			triangles = 0.0;
+			for (draw = 0; draw < draws.count + impostor_draws.count; ++draw)
+			{
+				command = draw < draws.count ? &draws.commands[draw] : &impostor_draws.commands[draw - draws.count];
+				level_counts[draw / MATERIALS_COUNT] += command->instance_count;
+				triangles += (double)command->instance_count * command->count / 3.0;
+			}
+			snprintf(title, sizeof(title), "OpenGL Tutorial 14: %u objects, %u/%u/%u/%u per level, %u impostors, %u fading, %.2f M triangles, %.1f us select",
+					 OBJECTS_COUNT, level_counts[0], level_counts[1], level_counts[2], level_counts[3], level_counts[4], fading, triangles / 1000000.0,
+					 (double)select_time * 1000000.0 / (double)SDL_GetPerformanceFrequency() / frames);
+			SDL_SetWindowTitle(window, title);
+			select_time = 0;
+			frames = 0;
+			title_time = 0.0f;
+		}
+
+		if (validate_gl("Open GL Rendering Error"))
+			SDL_GL_SwapWindow(window);
+		else
+			run = 0;
+	}
+
+	// =====================================
+	// Destruction
+	// =====================================
+	// Detail Levels
+	free(frustum_list);
+	free(visible_list);
+	free(lods);
+	free(slot_materials);
+	destroy_bvh(&bvh);
+	free(bounds);
+
+	// Texture
+	glDeleteTextures(1, &visible_texture);
+	glDeleteTextures(1, &draw_texture);
+	glDeleteTextures(1, &instance_texture);
+	glDeleteTextures(1, &impostor_normals);
+	destroy_texture_array(&impostor_array);
+	destroy_texture_array(&specular_array);
+	destroy_texture_array(&diffuse_array);
+
+	// Shader
+	glDeleteProgram(impostor_program);
+	glDeleteProgram(program);
+
+	// Vertex Buffers
+	glDeleteBuffers(1, &visible_buffer);
+	glDeleteBuffers(1, &draw_buffer);
+	glDeleteBuffers(1, &instance_buffer);
+	destroy_draw_list(&impostor_draws);
+	destroy_draw_list(&draws);
+	destroy_mesh_buffer(&meshes);
+
+	// Jobs
+	jobs_shutdown();
+
+	// SDL
+	SDL_GL_DeleteContext(context);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+
+	return 0;
+}
+
+__declspec(dllexport) unsigned NvOptimusEnablement = 1;
+__declspec(dllexport) int AmdPowerXpressRequestHighPerformance = 1;
@@ -0,0 +1,135 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <GL/glew.h>
+#include <SDL_events.h>
+#include "common.h"
+#include "draw_list.h"
+#include "mesh_buffer.h"
+
+int create_draw_list(struct draw_list* list, unsigned capacity)
+{
+	memset(list, 0, sizeof(struct draw_list));
+	list->commands = (struct draw_command*)malloc(capacity * sizeof(struct draw_command));
+	list->capacity = capacity;
+	list->indirect = (GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect) && (GLEW_VERSION_4_6 || GLEW_ARB_shader_draw_parameters);
+	if (!GLEW_VERSION_4_0 && !GLEW_ARB_draw_indirect)
+		return 1;
+
+	glGenBuffers(1, &list->buffer);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, list->buffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, capacity * sizeof(struct draw_command), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	if (!validate_gl("Draw List Creation Error"))
+	{
+		destroy_draw_list(list);
+		return 0;
+	}
+	return 1;
+}
+
+void destroy_draw_list(struct draw_list* list)
+{
+	if (list->buffer)
+		glDeleteBuffers(1, &list->buffer);
+	free(list->commands);
+	memset(list, 0, sizeof(struct draw_list));
+}
+
+void clear_draw_list(struct draw_list* list)
+{
+	list->count = 0;
+	list->dirty = 1;
+}
+
+// Returns the draw index seen by shaders, or -1 when the list is full
+int add_draw(struct draw_list* list, const struct mesh* mesh, unsigned instance_count, unsigned base_instance)
+{
+	struct draw_command* command;
+
+	if (list->count >= list->capacity)
+	{
+		error("Draw List Error", "Draw list is full (%u draws).", list->capacity);
+		return -1;
+	}
+	command = &list->commands[list->count];
+	command->count = mesh->index_count;
+	command->instance_count = instance_count;
+	command->first_index = mesh->first_index;
+	command->base_vertex = mesh->base_vertex;
+	command->base_instance = base_instance;
+	list->dirty = 1;
+	return (int)list->count++;
+}
+
+// Copies the commands into the indirect buffer, overwriting whatever the GPU wrote there
+void upload_draw_list(struct draw_list* list)
+{
+	list->dirty = 0;
+	if (!list->buffer)
+		return;
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, list->buffer);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, list->count * sizeof(struct draw_command), list->commands);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+// Expects the program and the VAO of the mesh buffer to be bound
+void submit_draw_list(struct draw_list* list, int draw_offset_location)
+{
+	const struct draw_command* command;
+	unsigned i;
+
+	if (list->dirty)
+		upload_draw_list(list);
+
+	if (list->indirect)
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, list->buffer);
+		glUniform1ui(draw_offset_location, 0);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0, list->count, 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		return;
+	}
+
+	if (list->buffer)
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, list->buffer);
+		for (i = 0; i < list->count; ++i)
+		{
+			glUniform1ui(draw_offset_location, i);
+			glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(i * sizeof(struct draw_command)));
+		}
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		return;
+	}
+
+	for (i = 0; i < list->count; ++i)
+	{
+		command = &list->commands[i];
+		glUniform1ui(draw_offset_location, i);
+		glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command->count, GL_UNSIGNED_INT, (void*)(command->first_index * sizeof(unsigned)),
+										  command->instance_count, command->base_vertex);
+	}
+}
@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef DRAW_LIST_H
+#define DRAW_LIST_H
+
+struct mesh;
+
+// Same layout as the DrawElementsIndirectCommand read by glMultiDrawElementsIndirect
+struct draw_command
+{
+	unsigned count;
+	unsigned instance_count;
+	unsigned first_index;
+	int base_vertex;
+	unsigned base_instance;
+};
+
+// Draws from one mesh buffer submitted together. With multi draw indirect
+// and ARB_shader_draw_parameters the whole list is one call and shaders
+// tell the draws apart by gl_DrawIDARB; otherwise each command becomes its
+// own draw and the draw index goes through a uniform instead. Shaders add
+// both, so the same shader works on either path:
+//
+//     uint drawID = cDrawOffset + gl_DrawIDARB;
+//
+// The loop cannot pass base_instance on 3.3, so shaders should find their
+// instance data through per-draw data rather than gl_BaseInstanceARB.
+//
+// Whenever glDrawElementsIndirect is there (4.0 or ARB_draw_indirect) the
+// commands live in a GPU buffer and the loop reads them from it as well, so
+// a compute pass may fill instance counts in after upload_draw_list.
+struct draw_list
+{
+	struct draw_command* commands;
+	unsigned buffer;
+	unsigned count;
+	unsigned capacity;
+	int indirect;
+	int dirty;
+};
+
+int create_draw_list(struct draw_list* list, unsigned capacity);
+void destroy_draw_list(struct draw_list* list);
+
+void clear_draw_list(struct draw_list* list);
+int add_draw(struct draw_list* list, const struct mesh* mesh, unsigned instance_count, unsigned base_instance);
+void upload_draw_list(struct draw_list* list);
+void submit_draw_list(struct draw_list* list, int draw_offset_location);
+
+#endif // DRAW_LIST_H
@@ -0,0 +1,555 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <SDL_mutex.h>
+#include "common.h"
+#include "ecs.h"
+#include "jobs.h"
+
+#define ECS_INDEX_MASK ((1u << ECS_INDEX_BITS) - 1)
+#define ECS_GENERATION_MASK ((1u << (32 - ECS_INDEX_BITS)) - 1)
+#define ECS_ALIGNMENT 16
+#define RECORD_FREE 0xFFFFFFFFu
+#define RECORD_PENDING 0xFFFFFFFEu
+#define NO_VALUE 0xFFFFFFFFu
+
+enum command_type
+{
+	COMMAND_CREATE,
+	COMMAND_DESTROY,
+	COMMAND_ADD,
+	COMMAND_REMOVE
+};
+
+struct each_job
+{
+	struct ecs_view* views;
+	ecs_system system;
+	void* data;
+};
+
+static unsigned align_up(unsigned value)
+{
+	return (value + ECS_ALIGNMENT - 1) & ~(unsigned)(ECS_ALIGNMENT - 1);
+}
+
+static ecs_entity make_entity(const struct ecs_world* world, unsigned index)
+{
+	return index | world->records[index].generation << ECS_INDEX_BITS;
+}
+
+static struct ecs_record* find_record(const struct ecs_world* world, ecs_entity entity)
+{
+	unsigned index = entity & ECS_INDEX_MASK;
+	struct ecs_record* record;
+	if (entity == ECS_NULL_ENTITY || index >= world->records_count)
+		return NULL;
+	record = &world->records[index];
+	if (record->archetype == RECORD_FREE || record->generation != entity >> ECS_INDEX_BITS)
+		return NULL;
+	return record;
+}
+
+static ecs_entity reserve_entity(struct ecs_world* world)
+{
+	unsigned index;
+	if (world->free_record != RECORD_FREE)
+	{
+		index = world->free_record;
+		world->free_record = world->records[index].chunk;
+	}
+	else if (world->records_count < world->records_capacity)
+		index = world->records_count++;
+	else
+		return ECS_NULL_ENTITY;
+	world->records[index].archetype = RECORD_PENDING;
+	return make_entity(world, index);
+}
+
+static void release_entity(struct ecs_world* world, unsigned index)
+{
+	struct ecs_record* record = &world->records[index];
+	record->archetype = RECORD_FREE;
+	record->generation = (record->generation + 1) & ECS_GENERATION_MASK;
+	record->chunk = world->free_record;
+	world->free_record = index;
+}
+
+static unsigned find_archetype(struct ecs_world* world, ecs_mask mask)
+{
+	struct ecs_archetype* archetype;
+	unsigned i, component, entity_bytes, components_count = 0, offset;
+
+	for (i = 0; i < world->archetypes_count; ++i)
+		if (world->archetypes[i].mask == mask)
+			return i;
+
+	if (world->archetypes_count == world->archetypes_capacity)
+	{
+		unsigned capacity = world->archetypes_capacity ? world->archetypes_capacity * 2 : 16;
+		archetype = (struct ecs_archetype*)realloc(world->archetypes, capacity * sizeof(struct ecs_archetype));
+		if (!archetype)
+		{
+			error("ECS Error", "Could not allocate %u archetypes.", capacity);
+			return RECORD_FREE;
+		}
+		world->archetypes = archetype;
+		world->archetypes_capacity = capacity;
+	}
+
+	archetype = &world->archetypes[world->archetypes_count];
+	memset(archetype, 0, sizeof(struct ecs_archetype));
+	archetype->mask = mask;
+
+	// As many entities as fit a chunk once every column is padded
+	entity_bytes = sizeof(ecs_entity);
+	for (component = 0; component < ECS_MAX_COMPONENTS; ++component)
+		if (mask & ECS_MASK(component))
+		{
+			entity_bytes += world->sizes[component];
+			++components_count;
+		}
+	archetype->capacity = (ECS_CHUNK_BYTES - (components_count + 1) * ECS_ALIGNMENT) / entity_bytes;
+	if (!archetype->capacity)
+		archetype->capacity = 1;
+
+	offset = align_up(archetype->capacity * sizeof(ecs_entity));
+	for (component = 0; component < ECS_MAX_COMPONENTS; ++component)
+		if (mask & ECS_MASK(component))
+		{
+			archetype->offsets[component] = offset;
+			offset = align_up(offset + archetype->capacity * world->sizes[component]);
+		}
+	archetype->bytes = offset;
+	return world->archetypes_count++;
+}
+
+static unsigned char* component_at(const struct ecs_world* world, const struct ecs_record* record, unsigned component)
+{
+	const struct ecs_archetype* archetype = &world->archetypes[record->archetype];
+	return archetype->chunks[record->chunk].memory + archetype->offsets[component] + record->row * world->sizes[component];
+}
+
+// Appends a row to the last chunk, which is the only one with free rows
+static int allocate_row(struct ecs_world* world, unsigned archetype_index, ecs_entity entity, struct ecs_record* record)
+{
+	struct ecs_archetype* archetype = &world->archetypes[archetype_index];
+	struct ecs_chunk* chunk;
+
+	if (!archetype->chunks_count || archetype->chunks[archetype->chunks_count - 1].count == archetype->capacity)
+	{
+		if (archetype->chunks_count == archetype->chunks_allocated)
+		{
+			chunk = (struct ecs_chunk*)realloc(archetype->chunks, (archetype->chunks_allocated + 1) * sizeof(struct ecs_chunk));
+			if (!chunk)
+			{
+				error("ECS Error", "Could not allocate chunk list of %u chunks.", archetype->chunks_allocated + 1);
+				return 0;
+			}
+			archetype->chunks = chunk;
+			chunk = &archetype->chunks[archetype->chunks_allocated];
+			chunk->memory = (unsigned char*)malloc(archetype->bytes);
+			if (!chunk->memory)
+			{
+				error("ECS Error", "Could not allocate chunk of %u bytes.", archetype->bytes);
+				return 0;
+			}
+			++archetype->chunks_allocated;
+		}
+		archetype->chunks[archetype->chunks_count++].count = 0;
+	}
+
+	record->archetype = archetype_index;
+	record->chunk = archetype->chunks_count - 1;
+	record->row = archetype->chunks[record->chunk].count++;
+	((ecs_entity*)archetype->chunks[record->chunk].memory)[record->row] = entity;
+	return 1;
+}
+
+// Fills the hole with the very last row, so all chunks but the last stay full
+static void free_row(struct ecs_world* world, const struct ecs_record* record)
+{
+	struct ecs_archetype* archetype = &world->archetypes[record->archetype];
+	struct ecs_chunk* last = &archetype->chunks[archetype->chunks_count - 1];
+	struct ecs_chunk* chunk = &archetype->chunks[record->chunk];
+	struct ecs_record* moved;
+	unsigned component, last_row = last->count - 1, size;
+	ecs_entity entity;
+
+	if (chunk != last || record->row != last_row)
+	{
+		entity = ((ecs_entity*)last->memory)[last_row];
+		((ecs_entity*)chunk->memory)[record->row] = entity;
+		for (component = 0; component < ECS_MAX_COMPONENTS; ++component)
+			if (archetype->mask & ECS_MASK(component))
+			{
+				size = world->sizes[component];
+				memcpy(chunk->memory + archetype->offsets[component] + record->row * size,
+					   last->memory + archetype->offsets[component] + last_row * size, size);
+			}
+		moved = &world->records[entity & ECS_INDEX_MASK];
+		moved->chunk = record->chunk;
+		moved->row = record->row;
+	}
+
+	if (!--last->count)
+		--archetype->chunks_count;
+}
+
+// Moves an entity to the archetype of mask, keeping shared components and
+// zeroing new ones. Entities still pending come from nowhere.
+static int move_entity(struct ecs_world* world, ecs_entity entity, ecs_mask mask)
+{
+	struct ecs_record* record = &world->records[entity & ECS_INDEX_MASK];
+	struct ecs_record old = *record;
+	ecs_mask old_mask = 0;
+	unsigned archetype, component;
+
+	archetype = find_archetype(world, mask);
+	if (archetype == RECORD_FREE)
+		return 0;
+	if (old.archetype != RECORD_PENDING)
+		old_mask = world->archetypes[old.archetype].mask;
+	if (!allocate_row(world, archetype, entity, record))
+	{
+		*record = old;
+		return 0;
+	}
+
+	for (component = 0; component < ECS_MAX_COMPONENTS; ++component)
+		if (mask & ECS_MASK(component))
+		{
+			if (old_mask & ECS_MASK(component))
+				memcpy(component_at(world, record, component), component_at(world, &old, component), world->sizes[component]);
+			else
+				memset(component_at(world, record, component), 0, world->sizes[component]);
+		}
+
+	if (old.archetype != RECORD_PENDING)
+		free_row(world, &old);
+	return 1;
+}
+
+int create_ecs_world(struct ecs_world* world, unsigned max_entities)
+{
+	memset(world, 0, sizeof(struct ecs_world));
+	world->free_record = RECORD_FREE;
+	if (max_entities > ECS_INDEX_MASK)
+	{
+		error("ECS Error", "At most %u entities are supported, %u requested.", ECS_INDEX_MASK, max_entities);
+		return 0;
+	}
+	world->records = (struct ecs_record*)calloc(max_entities, sizeof(struct ecs_record));
+	world->lock = SDL_CreateMutex();
+	if (!world->records || !world->lock)
+	{
+		error("ECS Error", "Could not allocate %u entities.", max_entities);
+		destroy_ecs_world(world);
+		return 0;
+	}
+	world->records_capacity = max_entities;
+	return 1;
+}
+
+void destroy_ecs_world(struct ecs_world* world)
+{
+	unsigned i, j;
+	for (i = 0; i < world->archetypes_count; ++i)
+	{
+		for (j = 0; j < world->archetypes[i].chunks_allocated; ++j)
+			free(world->archetypes[i].chunks[j].memory);
+		free(world->archetypes[i].chunks);
+	}
+	if (world->lock)
+		SDL_DestroyMutex(world->lock);
+	free(world->views);
+	free(world->values);
+	free(world->commands);
+	free(world->records);
+	free(world->archetypes);
+	memset(world, 0, sizeof(struct ecs_world));
+}
+
+void ecs_register_component(struct ecs_world* world, unsigned component, unsigned size)
+{
+	world->sizes[component] = size;
+	world->registered |= ECS_MASK(component);
+}
+
+ecs_entity ecs_create(struct ecs_world* world, ecs_mask mask)
+{
+	ecs_entity entity = reserve_entity(world);
+	if (entity == ECS_NULL_ENTITY)
+	{
+		error("ECS Error", "Entity limit of %u reached.", world->records_capacity);
+		return ECS_NULL_ENTITY;
+	}
+	if (!move_entity(world, entity, mask))
+	{
+		release_entity(world, entity & ECS_INDEX_MASK);
+		return ECS_NULL_ENTITY;
+	}
+	return entity;
+}
+
+void ecs_destroy(struct ecs_world* world, ecs_entity entity)
+{
+	struct ecs_record* record = find_record(world, entity);
+	if (!record)
+		return;
+	if (record->archetype != RECORD_PENDING)
+		free_row(world, record);
+	release_entity(world, entity & ECS_INDEX_MASK);
+}
+
+int ecs_add(struct ecs_world* world, ecs_entity entity, unsigned component, const void* value)
+{
+	struct ecs_record* record = find_record(world, entity);
+	ecs_mask mask;
+	if (!record)
+		return 0;
+	mask = record->archetype == RECORD_PENDING ? 0 : world->archetypes[record->archetype].mask;
+	if (!(mask & ECS_MASK(component)) && !move_entity(world, entity, mask | ECS_MASK(component)))
+		return 0;
+	if (value)
+		memcpy(component_at(world, record, component), value, world->sizes[component]);
+	return 1;
+}
+
+int ecs_remove(struct ecs_world* world, ecs_entity entity, unsigned component)
+{
+	struct ecs_record* record = find_record(world, entity);
+	ecs_mask mask;
+	if (!record || record->archetype == RECORD_PENDING)
+		return 0;
+	mask = world->archetypes[record->archetype].mask;
+	if (!(mask & ECS_MASK(component)))
+		return 1;
+	return move_entity(world, entity, mask & ~ECS_MASK(component));
+}
+
+int ecs_alive(const struct ecs_world* world, ecs_entity entity)
+{
+	return find_record(world, entity) != NULL;
+}
+
+void* ecs_get(const struct ecs_world* world, ecs_entity entity, unsigned component)
+{
+	const struct ecs_record* record = find_record(world, entity);
+	if (!record || record->archetype == RECORD_PENDING || !(world->archetypes[record->archetype].mask & ECS_MASK(component)))
+		return NULL;
+	return component_at(world, record, component);
+}
+
+// Called with the lock held
+static int push_command(struct ecs_world* world, unsigned type, ecs_entity entity, unsigned component, const void* value)
+{
+	struct ecs_command* command;
+	unsigned offset = NO_VALUE, size;
+
+	if (world->commands_count == world->commands_capacity)
+	{
+		unsigned capacity = world->commands_capacity ? world->commands_capacity * 2 : 256;
+		command = (struct ecs_command*)realloc(world->commands, capacity * sizeof(struct ecs_command));
+		if (!command)
+			return 0;
+		world->commands = command;
+		world->commands_capacity = capacity;
+	}
+	if (value)
+	{
+		size = align_up(world->sizes[component]);
+		if (world->values_size + size > world->values_capacity)
+		{
+			unsigned capacity = world->values_capacity ? world->values_capacity * 2 : 4096;
+			unsigned char* values;
+			while (capacity < world->values_size + size)
+				capacity *= 2;
+			values = (unsigned char*)realloc(world->values, capacity);
+			if (!values)
+				return 0;
+			world->values = values;
+			world->values_capacity = capacity;
+		}
+		offset = world->values_size;
+		memcpy(world->values + offset, value, world->sizes[component]);
+		world->values_size += size;
+	}
+
+	command = &world->commands[world->commands_count++];
+	command->type = type;
+	command->entity = entity;
+	command->component = component;
+	command->value = offset;
+	return 1;
+}
+
+ecs_entity ecs_defer_create(struct ecs_world* world, ecs_mask mask)
+{
+	ecs_entity entity;
+	SDL_LockMutex(world->lock);
+	entity = reserve_entity(world);
+	if (entity != ECS_NULL_ENTITY && !push_command(world, COMMAND_CREATE, entity, mask, NULL))
+	{
+		release_entity(world, entity & ECS_INDEX_MASK);
+		entity = ECS_NULL_ENTITY;
+	}
+	SDL_UnlockMutex(world->lock);
+	return entity;
+}
+
+void ecs_defer_destroy(struct ecs_world* world, ecs_entity entity)
+{
+	SDL_LockMutex(world->lock);
+	push_command(world, COMMAND_DESTROY, entity, 0, NULL);
+	SDL_UnlockMutex(world->lock);
+}
+
+void ecs_defer_add(struct ecs_world* world, ecs_entity entity, unsigned component, const void* value)
+{
+	SDL_LockMutex(world->lock);
+	push_command(world, COMMAND_ADD, entity, component, value);
+	SDL_UnlockMutex(world->lock);
+}
+
+void ecs_defer_remove(struct ecs_world* world, ecs_entity entity, unsigned component)
+{
+	SDL_LockMutex(world->lock);
+	push_command(world, COMMAND_REMOVE, entity, component, NULL);
+	SDL_UnlockMutex(world->lock);
+}
+
+int ecs_flush(struct ecs_world* world)
+{
+	const struct ecs_command* command;
+	unsigned i;
+	int success = 1;
+
+	for (i = 0; i < world->commands_count; ++i)
+	{
+		command = &world->commands[i];
+		switch (command->type)
+		{
+		case COMMAND_CREATE:
+			if (find_record(world, command->entity) && !move_entity(world, command->entity, command->component))
+			{
+				release_entity(world, command->entity & ECS_INDEX_MASK);
+				success = 0;
+			}
+			break;
+		case COMMAND_DESTROY:
+			ecs_destroy(world, command->entity);
+			break;
+		case COMMAND_ADD:
+			if (find_record(world, command->entity))
+				success &= ecs_add(world, command->entity, command->component,
+								   command->value == NO_VALUE ? NULL : world->values + command->value);
+			break;
+		case COMMAND_REMOVE:
+			if (find_record(world, command->entity))
+				success &= ecs_remove(world, command->entity, command->component);
+			break;
+		}
+	}
+	world->commands_count = 0;
+	world->values_size = 0;
+	return success;
+}
+
+static void fill_view(const struct ecs_archetype* archetype, unsigned chunk, struct ecs_view* view)
+{
+	unsigned component;
+	for (component = 0; component < ECS_MAX_COMPONENTS; ++component)
+		view->columns[component] = archetype->mask & ECS_MASK(component) ?
+			archetype->chunks[chunk].memory + archetype->offsets[component] : NULL;
+	view->entities = (ecs_entity*)archetype->chunks[chunk].memory;
+	view->count = archetype->chunks[chunk].count;
+}
+
+void ecs_each(struct ecs_world* world, ecs_mask mask, ecs_system system, void* data)
+{
+	struct ecs_view view;
+	unsigned i, chunk;
+	for (i = 0; i < world->archetypes_count; ++i)
+		if ((world->archetypes[i].mask & mask) == mask)
+			for (chunk = 0; chunk < world->archetypes[i].chunks_count; ++chunk)
+			{
+				fill_view(&world->archetypes[i], chunk, &view);
+				system(data, &view);
+			}
+}
+
+static void each_job(void* data, unsigned begin, unsigned end)
+{
+	struct each_job* job = (struct each_job*)data;
+	unsigned i;
+	for (i = begin; i < end; ++i)
+		job->system(job->data, &job->views[i]);
+}
+
+// Views of every matching chunk are gathered first and handed out one by
+// one; a chunk is a few thousand entities at most, which is plenty per job
+void ecs_each_parallel(struct ecs_world* world, ecs_mask mask, ecs_system system, void* data)
+{
+	struct each_job job;
+	struct ecs_view* views;
+	unsigned i, chunk, count = 0;
+
+	for (i = 0; i < world->archetypes_count; ++i)
+		if ((world->archetypes[i].mask & mask) == mask)
+			count += world->archetypes[i].chunks_count;
+	if (count > world->views_capacity)
+	{
+		views = (struct ecs_view*)realloc(world->views, count * sizeof(struct ecs_view));
+		if (!views)
+		{
+			ecs_each(world, mask, system, data);
+			return;
+		}
+		world->views = views;
+		world->views_capacity = count;
+	}
+
+	count = 0;
+	for (i = 0; i < world->archetypes_count; ++i)
+		if ((world->archetypes[i].mask & mask) == mask)
+			for (chunk = 0; chunk < world->archetypes[i].chunks_count; ++chunk)
+				fill_view(&world->archetypes[i], chunk, &world->views[count++]);
+
+	job.views = world->views;
+	job.system = system;
+	job.data = data;
+	jobs_parallel_for(each_job, &job, count, 1);
+}
+
+unsigned ecs_count(const struct ecs_world* world, ecs_mask mask)
+{
+	unsigned i, chunk, count = 0;
+	for (i = 0; i < world->archetypes_count; ++i)
+		if ((world->archetypes[i].mask & mask) == mask)
+			for (chunk = 0; chunk < world->archetypes[i].chunks_count; ++chunk)
+				count += world->archetypes[i].chunks[chunk].count;
+	return count;
+}
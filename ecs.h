@@ -0,0 +1,149 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef ECS_H
+#define ECS_H
+
+#define ECS_MAX_COMPONENTS 32
+#define ECS_CHUNK_BYTES 16384
+#define ECS_INDEX_BITS 22
+#define ECS_NULL_ENTITY 0xFFFFFFFFu
+#define ECS_MASK(component) (1u << (component))
+
+// Entity component storage grouped by archetype: every entity with the
+// same set of components lives in the chunks of one archetype, and every
+// chunk keeps each component in its own contiguous array, so systems walk
+// plain arrays of positions, matrices and so on. Arrays start on 16 byte
+// boundaries and can go straight to the cglm SIMD routines or simd.h.
+//
+// Components are numbered by the caller, 0 to ECS_MAX_COMPONENTS - 1, and
+// registered with their size before use. Entities are an index in the low
+// ECS_INDEX_BITS and a generation above it, so a stale handle of a
+// destroyed entity never reaches the one reusing its slot.
+//
+// The immediate calls move entities between archetypes on the spot and
+// may only run between systems. Systems, even parallel ones, record the
+// same changes with the ecs_defer_* calls instead, which take a lock and
+// are applied in order by ecs_flush, usually once a frame.
+typedef unsigned ecs_entity;
+typedef unsigned ecs_mask;
+
+// One chunk as a system sees it. Columns of components the archetype does
+// not have are NULL.
+struct ecs_view
+{
+	void* columns[ECS_MAX_COMPONENTS];
+	ecs_entity* entities;
+	unsigned count;
+};
+
+typedef void (*ecs_system)(void* data, struct ecs_view* view);
+
+struct ecs_chunk
+{
+	unsigned char* memory;
+	unsigned count;
+};
+
+// Chunks past chunks_count are empty ones kept for reuse
+struct ecs_archetype
+{
+	ecs_mask mask;
+	unsigned offsets[ECS_MAX_COMPONENTS];
+	unsigned entities_offset;
+	unsigned capacity;
+	unsigned bytes;
+	struct ecs_chunk* chunks;
+	unsigned chunks_count;
+	unsigned chunks_allocated;
+};
+
+// Where an entity lives. Free slots chain through chunk.
+struct ecs_record
+{
+	unsigned archetype;
+	unsigned chunk;
+	unsigned row;
+	unsigned generation;
+};
+
+struct ecs_command
+{
+	unsigned type;
+	ecs_entity entity;
+	unsigned component;
+	unsigned value;
+};
+
+struct ecs_world
+{
+	unsigned sizes[ECS_MAX_COMPONENTS];
+	ecs_mask registered;
+	struct ecs_archetype* archetypes;
+	unsigned archetypes_count;
+	unsigned archetypes_capacity;
+	struct ecs_record* records;
+	unsigned records_count;
+	unsigned records_capacity;
+	unsigned free_record;
+	struct ecs_command* commands;
+	unsigned commands_count;
+	unsigned commands_capacity;
+	unsigned char* values;
+	unsigned values_size;
+	unsigned values_capacity;
+	struct ecs_view* views;
+	unsigned views_capacity;
+	struct SDL_mutex* lock;
+};
+
+// Entity slots are allocated up front, so that deferred creation from job
+// threads never moves them under systems reading other entities
+int create_ecs_world(struct ecs_world* world, unsigned max_entities);
+void destroy_ecs_world(struct ecs_world* world);
+void ecs_register_component(struct ecs_world* world, unsigned component, unsigned size);
+
+// New components start zeroed, or as a copy of value when there is one
+ecs_entity ecs_create(struct ecs_world* world, ecs_mask mask);
+void ecs_destroy(struct ecs_world* world, ecs_entity entity);
+int ecs_add(struct ecs_world* world, ecs_entity entity, unsigned component, const void* value);
+int ecs_remove(struct ecs_world* world, ecs_entity entity, unsigned component);
+int ecs_alive(const struct ecs_world* world, ecs_entity entity);
+// NULL when the entity is gone or lacks the component
+void* ecs_get(const struct ecs_world* world, ecs_entity entity, unsigned component);
+
+// Entities from ecs_defer_create are alive at once but get their
+// components when the command buffer is flushed
+ecs_entity ecs_defer_create(struct ecs_world* world, ecs_mask mask);
+void ecs_defer_destroy(struct ecs_world* world, ecs_entity entity);
+void ecs_defer_add(struct ecs_world* world, ecs_entity entity, unsigned component, const void* value);
+void ecs_defer_remove(struct ecs_world* world, ecs_entity entity, unsigned component);
+int ecs_flush(struct ecs_world* world);
+
+// Runs a system over every chunk whose archetype has all components of
+// mask. The parallel version hands chunks to the job threads.
+void ecs_each(struct ecs_world* world, ecs_mask mask, ecs_system system, void* data);
+void ecs_each_parallel(struct ecs_world* world, ecs_mask mask, ecs_system system, void* data);
+unsigned ecs_count(const struct ecs_world* world, ecs_mask mask);
+
+#endif // ECS_H
@@ -0,0 +1,468 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SDL_MAIN_HANDLED
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_main.h>
+#include "cglm/affine.h"
+#include "cglm/cam.h"
+#include "cglm/quat.h"
+#include "common.h"
+#include "gpu_particles.h"
+
+#define WIDTH 1024
+#define HEIGHT 768
+#define PARTICLES_CAPACITY (1 << 20)
+#define PARTICLE_LIFE 3000.0f
+#define PARTICLE_LIFE_SPREAD 1000.0f
+#define PARTICLE_SIZE 0.03f
+#define GRAVITY -0.00001f
+#define DRAG 0.0002f
+#define RESTITUTION 0.5f
+// Longer steps would carry particles through the surfaces
+#define MAX_STEP 33.0f
+#define BOXES_COUNT 4
+#define BOX_VERTICES 36
+
+// Benchmark: a full system at a reduced resolution, simulated in fixed steps
+#define BENCH_PARTICLES 10000000
+#define BENCH_WIDTH 320
+#define BENCH_HEIGHT 240
+#define BENCH_STEP 16.0f
+#define BENCH_WARMUP_FRAMES 3
+#define BENCH_FRAMES 20
+
+// Floor and crates for the sparks to bounce off: centre and half size
+static const float boxes[BOXES_COUNT][2][3] =
+{
+	{ { 0.0f, -2.1f, -8.0f }, { 8.0f, 0.1f, 8.0f } },
+	{ { -2.0f, -1.5f, -8.0f }, { 0.5f, 0.5f, 0.5f } },
+	{ { 1.8f, -1.25f, -7.0f }, { 0.6f, 0.75f, 0.6f } },
+	{ { 0.5f, -1.6f, -10.5f }, { 1.5f, 0.4f, 0.5f } }
+};
+
+// Two triangles per face, positions and normals
+static void build_box(float* vertices, const float* centre, const float* half)
+{
+	static const float corners[6][2] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f },
+										 { -1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+	unsigned face, corner, axis, u, v, i;
+	float side;
+
+	for (face = 0; face < 6; ++face)
+	{
+		axis = face / 2;
+		side = face & 1 ? 1.0f : -1.0f;
+		u = (axis + 1) % 3;
+		v = (axis + 2) % 3;
+		for (corner = 0; corner < 6; ++corner, vertices += 6)
+		{
+			vertices[axis] = centre[axis] + side * half[axis];
+			vertices[u] = centre[u] + corners[corner][0] * half[u];
+			vertices[v] = centre[v] + corners[corner][1] * half[v];
+			for (i = 0; i < 3; ++i)
+				vertices[3 + i] = i == axis ? side : 0.0f;
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	// =====================================
+	// Initialisation
+	// =====================================
+	// Pass -tf to simulate with transform feedback where compute shaders
+	// exist, -bench to time BENCH_FRAMES frames of BENCH_PARTICLES and quit
+	int compute = 1;
+	int bench = 0;
+	int i;
+	for (i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "-tf"))
+			compute = 0;
+		else if (!strcmp(argv[i], "-bench"))
+			bench = 1;
+	}
+	const int width = bench ? BENCH_WIDTH : WIDTH;
+	const int height = bench ? BENCH_HEIGHT : HEIGHT;
+	const unsigned capacity = bench ? BENCH_PARTICLES : PARTICLES_CAPACITY;
+
+	// SDL
+
+	if (SDL_Init(SDL_INIT_VIDEO) < 0)
+	{
+		error("SDL Error", SDL_GetError());
+		return 1;
+	}
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_Window* window = SDL_CreateWindow("OpenGL Tutorial 18",
+										  SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+										  width, height, SDL_WINDOW_OPENGL);
+	if (!window)
+	{
+		error("SDL Error", SDL_GetError());
+		SDL_Quit();
+		return 1;
+	}
+	SDL_GLContext context = SDL_GL_CreateContext(window);
+	if (!context)
+	{
+		// Without compute shaders particles run on transform feedback, which works with 3.3
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+		context = SDL_GL_CreateContext(window);
+	}
+	if (!context)
+	{
+		error("SDL Error", SDL_GetError());
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	SDL_ShowCursor(SDL_DISABLE);
+	SDL_SetRelativeMouseMode(SDL_TRUE);
+
+	// GLEW
+	glewExperimental = GL_TRUE;
+	if (glewInit() != GLEW_OK)
+	{
+		error("GLEW Error", glewGetErrorString(glGetError()));
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// OpenGL
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_PROGRAM_POINT_SIZE);
+	glBlendFunc(GL_ONE, GL_ONE);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+	// Vertex Buffers
+	// The scene is static and already in world space
+	float vertices[BOXES_COUNT * BOX_VERTICES * 6];
+	for (i = 0; i < BOXES_COUNT; ++i)
+		build_box(vertices + i * BOX_VERTICES * 6, boxes[i][0], boxes[i][1]);
+
+	unsigned vbo;
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+	unsigned vao;
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (!validate_gl("Vertex Buffer Error"))
+	{
+		glDeleteVertexArrays(1, &vao);
+		glDeleteBuffers(1, &vbo);
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Shaders
+	const unsigned scene_program = create_program("data/shaders/18_gpu_fountain_scene");
+	const unsigned particle_program = scene_program ? create_program("data/shaders/18_gpu_fountain") : 0;
+	if (!particle_program)
+	{
+		glDeleteProgram(scene_program);
+		glDeleteVertexArrays(1, &vao);
+		glDeleteBuffers(1, &vbo);
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Projection Matrix
+	mat4 proj;
+	glm_perspective(glm_rad(45.0f), (float)width / (float)height, 0.01f, 100.0f, proj);
+
+	// Shader Uniforms
+	const int uniform_scene_viewproj = glGetUniformLocation(scene_program, "cViewProj");
+	const int uniform_particle_viewproj = glGetUniformLocation(particle_program, "cViewProj");
+
+	glUseProgram(scene_program);
+	glUniform3f(glGetUniformLocation(scene_program, "cColor"), 0.35f, 0.35f, 0.4f);
+	glUniform3f(glGetUniformLocation(scene_program, "cLightDir"), 0.267f, 0.802f, 0.535f);
+	glUseProgram(particle_program);
+	glUniform3f(glGetUniformLocation(particle_program, "cColor"), 0.6f, 0.3f, 0.1f);
+	glUniform1f(glGetUniformLocation(particle_program, "cPointSize"), PARTICLE_SIZE * proj[1][1] * (float)height * 0.5f);
+	glUseProgram(0);
+
+	if (!validate_gl("Shader Uniforms Error"))
+	{
+		glDeleteProgram(particle_program);
+		glDeleteProgram(scene_program);
+		glDeleteVertexArrays(1, &vao);
+		glDeleteBuffers(1, &vbo);
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Framebuffer
+	// The scene is drawn into a depth texture for the particles to collide with
+	unsigned framebuffer, color_buffer, depth_texture;
+	glGenRenderbuffers(1, &color_buffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, color_buffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glGenTextures(1, &depth_texture);
+	glBindTexture(GL_TEXTURE_2D, depth_texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_buffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth_texture, 0);
+	const int complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (!complete)
+	{
+		error("OpenGL Error", "Scene framebuffer is incomplete.");
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteTextures(1, &depth_texture);
+		glDeleteRenderbuffers(1, &color_buffer);
+		glDeleteProgram(particle_program);
+		glDeleteProgram(scene_program);
+		glDeleteVertexArrays(1, &vao);
+		glDeleteBuffers(1, &vbo);
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// =====================================
+	// Scene
+	// =====================================
+	// Particles
+	// A fountain spraying up, emitting as fast as particles die on average.
+	// The benchmark starts full.
+	struct gpu_particles particles;
+	if (!create_gpu_particles(&particles, capacity, compute))
+	{
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteTextures(1, &depth_texture);
+		glDeleteRenderbuffers(1, &color_buffer);
+		glDeleteProgram(particle_program);
+		glDeleteProgram(scene_program);
+		glDeleteVertexArrays(1, &vao);
+		glDeleteBuffers(1, &vbo);
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+	const struct particle_emitter emitter =
+	{
+		{ 0.0f, -1.5f, -8.0f },
+		{ 0.0f, 0.008f, 0.0f },
+		{ 0.002f, 0.001f, 0.002f },
+		PARTICLE_LIFE,
+		PARTICLE_LIFE_SPREAD
+	};
+	vec3 gravity = { 0.0f, GRAVITY, 0.0f };
+	float emission = bench ? (float)capacity : 0.0f;
+	unsigned emit_count;
+
+	// Camera
+	vec3 camera_position = { 0.0f, 0.0f, 3.0f };
+	vec3 camera_direction;
+	vec3 camera_up;
+	versor camera_rotation = GLM_QUAT_IDENTITY_INIT;
+
+	// =====================================
+	// Rendering
+	// =====================================
+	// Matrices
+	mat4 view, viewproj;
+
+	// Statistics
+	char title[256];
+	const char* path = particles.compute ? "compute" : "transform feedback";
+	Uint64 stage_start;
+	Uint64 update_time = 0;
+	Uint64 draw_time = 0;
+	unsigned frame = 0;
+	unsigned frames = 0;
+	float title_time = 0.0f;
+
+	int run = 1;
+	float step;
+	float tick_delta;
+	float tick_curr;
+	float tick_prev = (float)SDL_GetTicks();
+	unsigned short controls = 0;
+	while (run)
+	{
+		tick_curr = (float)SDL_GetTicks();
+		tick_delta = tick_curr - tick_prev;
+		process_events(camera_position, camera_direction, camera_rotation, &controls, &run, tick_delta);
+		tick_prev = tick_curr;
+		step = bench ? BENCH_STEP : (tick_delta < MAX_STEP ? tick_delta : MAX_STEP);
+
+		// =================================
+		// Camera
+		// =================================
+		// Look
+		glm_quat_rotatev(camera_rotation, GLM_FORWARD, camera_direction);
+
+		// View Matrix
+		glm_quat_rotatev(camera_rotation, GLM_YUP, camera_up);
+		glm_look(camera_position, camera_direction, camera_up, view);
+
+		// View and Projection Matrix
+		glm_mat4_mul_sse2(proj, view, viewproj);
+
+		// =================================
+		// Rendering
+		// =================================
+		// Scene, its depth is what the particles bounce off
+		stage_start = SDL_GetPerformanceCounter();
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glUseProgram(scene_program);
+		glUniformMatrix4fv(uniform_scene_viewproj, 1, GL_FALSE, viewproj[0]);
+		glBindVertexArray(vao);
+		glDrawArrays(GL_TRIANGLES, 0, BOXES_COUNT * BOX_VERTICES);
+		glBindVertexArray(0);
+		glUseProgram(0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		// Simulation
+		emission += step * (float)capacity / PARTICLE_LIFE;
+		emit_count = (unsigned)emission;
+		emission -= (float)emit_count;
+		update_gpu_particles(&particles, &emitter, emit_count, gravity, DRAG, RESTITUTION, step, depth_texture, viewproj);
+		if (bench)
+		{
+			glFinish();
+			if (frame >= BENCH_WARMUP_FRAMES)
+				update_time += SDL_GetPerformanceCounter() - stage_start;
+			stage_start = SDL_GetPerformanceCounter();
+		}
+
+		// Particles glow: they add up in any order, so they are tested
+		// against the scene but neither write depth nor need sorting
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glEnable(GL_BLEND);
+		glDepthMask(GL_FALSE);
+		glUseProgram(particle_program);
+		glUniformMatrix4fv(uniform_particle_viewproj, 1, GL_FALSE, viewproj[0]);
+		draw_gpu_particles(&particles);
+		glUseProgram(0);
+		glDepthMask(GL_TRUE);
+		glDisable(GL_BLEND);
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		// Statistics
+		++frame;
+		if (bench)
+		{
+			glFinish();
+			if (frame > BENCH_WARMUP_FRAMES)
+				draw_time += SDL_GetPerformanceCounter() - stage_start;
+			if (frame == BENCH_WARMUP_FRAMES + BENCH_FRAMES)
+			{
+				printf("%s, %u particles at %dx%d: %.2f ms scene and update, %.2f ms draw per frame\n", path, capacity,
+					   width, height, (double)update_time * 1000.0 / (double)SDL_GetPerformanceFrequency() / BENCH_FRAMES,
+					   (double)draw_time * 1000.0 / (double)SDL_GetPerformanceFrequency() / BENCH_FRAMES);
+				run = 0;
+			}
+		}
+		else
+		{
+			++frames;
+			title_time += tick_delta;
+			if (title_time >= 1000.0f)
+			{
+				snprintf(title, sizeof(title), "OpenGL Tutorial 18: up to %u particles, %s, %.2f ms per frame", capacity, path,
+						 (double)title_time / frames);
+				SDL_SetWindowTitle(window, title);
+				frames = 0;
+				title_time = 0.0f;
+			}
+		}
+
+		if (validate_gl("Open GL Rendering Error"))
+			SDL_GL_SwapWindow(window);
+		else
+			run = 0;
+	}
+
+	// =====================================
+	// Destruction
+	// =====================================
+	// Scene
+	destroy_gpu_particles(&particles);
+
+	// Framebuffer
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteTextures(1, &depth_texture);
+	glDeleteRenderbuffers(1, &color_buffer);
+
+	// Shaders
+	glDeleteProgram(particle_program);
+	glDeleteProgram(scene_program);
+
+	// Vertex Buffers
+	glDeleteVertexArrays(1, &vao);
+	glDeleteBuffers(1, &vbo);
+
+	// SDL
+	SDL_GL_DeleteContext(context);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+
+	return 0;
+}
+
+__declspec(dllexport) unsigned NvOptimusEnablement = 1;
+__declspec(dllexport) int AmdPowerXpressRequestHighPerformance = 1;
@@ -0,0 +1,268 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <string.h>
+#include <GL/glew.h>
+#include "cglm/mat4.h"
+#include "common.h"
+#include "gpu_particles.h"
+
+#define PARTICLE_SIZE (2 * sizeof(vec4))
+#define DRAW_SIZE (4 * sizeof(unsigned))
+#define DISPATCH_OFFSET (2 * DRAW_SIZE)
+
+enum gpu_particles_uniform
+{
+	UNIFORM_SOURCE,
+	UNIFORM_PREPARE,
+	UNIFORM_EMIT_COUNT,
+	UNIFORM_EMITTING,
+	UNIFORM_SEED,
+	UNIFORM_EMITTER_POSITION,
+	UNIFORM_EMITTER_VELOCITY,
+	UNIFORM_EMITTER_SPREAD,
+	UNIFORM_EMITTER_LIFE,
+	UNIFORM_ACCELERATION,
+	UNIFORM_DRAG,
+	UNIFORM_RESTITUTION,
+	UNIFORM_TIME,
+	UNIFORM_VIEWPROJ,
+	UNIFORM_INV_VIEWPROJ
+};
+
+// Each path lacks a few of these, their locations stay -1
+static const char* UNIFORM_NAMES[GPU_PARTICLES_UNIFORMS] =
+{
+	"cSource",
+	"cPrepare",
+	"cEmitCount",
+	"cEmitting",
+	"cSeed",
+	"cEmitterPosition",
+	"cEmitterVelocity",
+	"cEmitterSpread",
+	"cEmitterLife",
+	"cAcceleration",
+	"cDrag",
+	"cRestitution",
+	"cTime",
+	"cViewProj",
+	"cInvViewProj"
+};
+
+static const char* const VARYINGS[] = { "fPosition", "fVelocity" };
+
+int create_gpu_particles(struct gpu_particles* particles, unsigned capacity, int compute)
+{
+	// Both draws start empty, the dispatch and emission are sized on the GPU
+	const unsigned counters[] = { 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 1, 0 };
+	unsigned i;
+
+	memset(particles, 0, sizeof(struct gpu_particles));
+	if (!capacity || capacity > GPU_PARTICLES_MAX)
+	{
+		error("GPU Particles Error", "Capacity of %u particles is out of range.", capacity);
+		return 0;
+	}
+	particles->capacity = capacity;
+	particles->compute = compute && GLEW_VERSION_4_3;
+	if (!particles->compute && !GLEW_VERSION_4_0 && !GLEW_ARB_transform_feedback2)
+	{
+		error("GPU Particles Error", "Neither compute shaders nor transform feedback objects are supported.");
+		return 0;
+	}
+
+	if (particles->compute)
+		particles->program = create_compute_program("data/shaders/gpu_particles", "data/shaders/gpu_particles.glsl");
+	else
+		particles->program = create_feedback_program("data/shaders/gpu_particles", "data/shaders/gpu_particles.glsl", VARYINGS, 2);
+	if (!particles->program)
+		return 0;
+	for (i = 0; i < GPU_PARTICLES_UNIFORMS; ++i)
+		particles->uniforms[i] = glGetUniformLocation(particles->program, UNIFORM_NAMES[i]);
+	glUseProgram(particles->program);
+	glUniform1i(glGetUniformLocation(particles->program, "sDepth"), GPU_PARTICLES_DEPTH_UNIT);
+	glUseProgram(0);
+
+	glGenBuffers(2, particles->buffers);
+	glGenVertexArrays(2, particles->vaos);
+	for (i = 0; i < 2; ++i)
+	{
+		glBindVertexArray(particles->vaos[i]);
+		glBindBuffer(GL_ARRAY_BUFFER, particles->buffers[i]);
+		glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)capacity * PARTICLE_SIZE, NULL, GL_DYNAMIC_COPY);
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, PARTICLE_SIZE, (void*)0);
+		glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, PARTICLE_SIZE, (void*)sizeof(vec4));
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+	}
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (particles->compute)
+	{
+		glGenBuffers(1, &particles->counters);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, particles->counters);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(counters), counters, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+	else
+	{
+		glGenTransformFeedbacks(2, particles->feedbacks);
+		for (i = 0; i < 2; ++i)
+		{
+			glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, particles->feedbacks[i]);
+			glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, particles->buffers[i]);
+		}
+		glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+	}
+
+	if (!validate_gl("GPU Particles Creation Error"))
+	{
+		destroy_gpu_particles(particles);
+		return 0;
+	}
+	return 1;
+}
+
+void destroy_gpu_particles(struct gpu_particles* particles)
+{
+	if (particles->feedbacks[0])
+		glDeleteTransformFeedbacks(2, particles->feedbacks);
+	if (particles->counters)
+		glDeleteBuffers(1, &particles->counters);
+	if (particles->vaos[0])
+		glDeleteVertexArrays(2, particles->vaos);
+	if (particles->buffers[0])
+		glDeleteBuffers(2, particles->buffers);
+	if (particles->program)
+		glDeleteProgram(particles->program);
+	memset(particles, 0, sizeof(struct gpu_particles));
+}
+
+// A single invocation first sizes the update to the survivors of the last
+// one plus the emitted that fit, then the update appends to the other buffer
+static void update_compute(struct gpu_particles* particles, unsigned count)
+{
+	const unsigned source = particles->current;
+	unsigned i;
+
+	glUniform1ui(particles->uniforms[UNIFORM_SOURCE], source);
+	glUniform1ui(particles->uniforms[UNIFORM_EMIT_COUNT], count);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particles->buffers[source]);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, particles->buffers[!source]);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, particles->counters);
+
+	glUniform1i(particles->uniforms[UNIFORM_PREPARE], 1);
+	glDispatchCompute(1, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+	glUniform1i(particles->uniforms[UNIFORM_PREPARE], 0);
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, particles->counters);
+	glDispatchComputeIndirect(DISPATCH_OFFSET);
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+
+	for (i = 0; i < 3; ++i)
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, 0);
+}
+
+// Survivors, then the emitted, are captured into the other buffer. The
+// emitting draw reads the source attributes only to have a vertex per
+// particle.
+static void update_feedback(struct gpu_particles* particles, unsigned count)
+{
+	const unsigned source = particles->current;
+
+	glEnable(GL_RASTERIZER_DISCARD);
+	glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, particles->feedbacks[!source]);
+	glBeginTransformFeedback(GL_POINTS);
+	glBindVertexArray(particles->vaos[source]);
+	if (particles->primed)
+	{
+		glUniform1i(particles->uniforms[UNIFORM_EMITTING], 0);
+		glDrawTransformFeedback(GL_POINTS, particles->feedbacks[source]);
+	}
+	if (count)
+	{
+		glUniform1i(particles->uniforms[UNIFORM_EMITTING], 1);
+		glDrawArrays(GL_POINTS, 0, count);
+	}
+	glBindVertexArray(0);
+	glEndTransformFeedback();
+	glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+	glDisable(GL_RASTERIZER_DISCARD);
+}
+
+void update_gpu_particles(struct gpu_particles* particles, const struct particle_emitter* emitter, unsigned count,
+						  vec3 acceleration, float drag, float restitution, float time, unsigned depth_texture, mat4 viewproj)
+{
+	const int* uniforms = particles->uniforms;
+	mat4 inv_viewproj;
+
+	if (count > particles->capacity)
+		count = particles->capacity;
+	glm_mat4_inv(viewproj, inv_viewproj);
+
+	glUseProgram(particles->program);
+	glUniform1ui(uniforms[UNIFORM_SEED], particles->seed++);
+	glUniform3fv(uniforms[UNIFORM_EMITTER_POSITION], 1, emitter->position);
+	glUniform3fv(uniforms[UNIFORM_EMITTER_VELOCITY], 1, emitter->velocity);
+	glUniform3fv(uniforms[UNIFORM_EMITTER_SPREAD], 1, emitter->spread);
+	glUniform2f(uniforms[UNIFORM_EMITTER_LIFE], emitter->life, emitter->life_spread);
+	glUniform3fv(uniforms[UNIFORM_ACCELERATION], 1, acceleration);
+	glUniform1f(uniforms[UNIFORM_DRAG], drag);
+	glUniform1f(uniforms[UNIFORM_RESTITUTION], restitution);
+	glUniform1f(uniforms[UNIFORM_TIME], time);
+	glUniformMatrix4fv(uniforms[UNIFORM_VIEWPROJ], 1, GL_FALSE, viewproj[0]);
+	glUniformMatrix4fv(uniforms[UNIFORM_INV_VIEWPROJ], 1, GL_FALSE, inv_viewproj[0]);
+	glActiveTexture(GL_TEXTURE0 + GPU_PARTICLES_DEPTH_UNIT);
+	glBindTexture(GL_TEXTURE_2D, depth_texture);
+
+	if (particles->compute)
+		update_compute(particles, count);
+	else
+		update_feedback(particles, count);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glUseProgram(0);
+	particles->current = !particles->current;
+	particles->primed = 1;
+}
+
+void draw_gpu_particles(struct gpu_particles* particles)
+{
+	if (!particles->primed)
+		return;
+	glBindVertexArray(particles->vaos[particles->current]);
+	if (particles->compute)
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, particles->counters);
+		glDrawArraysIndirect(GL_POINTS, (void*)(particles->current * DRAW_SIZE));
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+	else
+		glDrawTransformFeedback(GL_POINTS, particles->feedbacks[particles->current]);
+	glBindVertexArray(0);
+}
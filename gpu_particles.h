@@ -0,0 +1,82 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef GPU_PARTICLES_H
+#define GPU_PARTICLES_H
+
+#include "cglm/types.h"
+#include "particles.h"
+
+#define GPU_PARTICLES_DEPTH_UNIT 14
+#define GPU_PARTICLES_GROUP_SIZE 256
+#define GPU_PARTICLES_MAX (65535u * GPU_PARTICLES_GROUP_SIZE)
+#define GPU_PARTICLES_UNIFORMS 15
+
+// Particles that never leave the GPU: two buffers of a position with the
+// life left and a velocity with the life at birth, four floats each, taking
+// turns as source and destination. Every update reads the live particles
+// of one, ages, moves and collides them, emits new ones and writes the
+// survivors packed into the other, then draws read that one.
+//
+// Simulated by a compute shader on 4.3, appending with an atomic counter
+// that is also the count of an indirect draw. Otherwise by transform
+// feedback, with a geometry shader dropping the dead, drawn with
+// glDrawTransformFeedback, which needs 4.0 or ARB_transform_feedback2.
+// Either way the CPU never learns how many particles are alive. Emission
+// beyond capacity is dropped.
+//
+// Particles bounce off the depth buffer they are seen against, so only
+// surfaces on screen stop them.
+struct gpu_particles
+{
+	unsigned buffers[2];
+	unsigned vaos[2];
+	unsigned feedbacks[2];
+	unsigned counters; // Draw arrays command per buffer, then dispatch size and emitted count
+	unsigned program;
+	unsigned capacity;
+	unsigned current; // Buffer holding the live particles
+	unsigned seed;
+	int uniforms[GPU_PARTICLES_UNIFORMS];
+	int compute;
+	int primed;
+};
+
+// Compute shaders are used when requested and available. Capacity is at
+// most GPU_PARTICLES_MAX.
+int create_gpu_particles(struct gpu_particles* particles, unsigned capacity, int compute);
+void destroy_gpu_particles(struct gpu_particles* particles);
+
+// Advances the particles by time milliseconds under acceleration, per
+// square millisecond, with drag slowing them by that fraction per
+// millisecond, then emits count new ones. Collisions test the single level
+// depth_texture rendered with viewproj, bounces keep restitution of the
+// speed. Uses texture unit GPU_PARTICLES_DEPTH_UNIT and leaves the program
+// unbound and GL_TEXTURE0 active.
+void update_gpu_particles(struct gpu_particles* particles, const struct particle_emitter* emitter, unsigned count,
+						  vec3 acceleration, float drag, float restitution, float time, unsigned depth_texture, mat4 viewproj);
+// Draws the live particles as points with the bound program: attribute 0 is
+// the position and life left, attribute 1 the velocity and life at birth
+void draw_gpu_particles(struct gpu_particles* particles);
+
+#endif // GPU_PARTICLES_H
@@ -0,0 +1,509 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SDL_MAIN_HANDLED
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_main.h>
+#include "cglm/affine.h"
+#include "cglm/cam.h"
+#include "cglm/quat.h"
+#include "common.h"
+#include "draw_list.h"
+#include "mesh_buffer.h"
+#include "packed_instance.h"
+#include "texture_manager.h"
+
+#define OBJECTS_X 64
+#define OBJECTS_Z 64
+#define OBJECTS_COUNT (OBJECTS_X * OBJECTS_Z)
+#define PRISMS_COUNT 3
+#define MESHES_COUNT (PRISMS_COUNT + 1)
+#define MATERIALS_COUNT (sizeof(material_files) / sizeof(material_files[0]))
+#define GROUPS_COUNT (MESHES_COUNT * MATERIALS_COUNT)
+#define PRISM_MAX_SIDES 24
+#define PRISM_MAX_VERTICES (PRISM_MAX_SIDES * 6 + 2)
+#define PRISM_MAX_INDICES (PRISM_MAX_SIDES * 12)
+
+static const float cube_vertices[] =
+{
+	// Position				| Normal				| Tex Coord
+	// Front
+	 0.5f,  0.5f,  0.5f,	 0.0f,  0.0,  1.0,		1.0f, 1.0f,		//   0 RU
+	 0.5f, -0.5f,  0.5f,	 0.0f,  0.0,  1.0,		1.0f, 0.0f,		//   1 RD
+	-0.5f, -0.5f,  0.5f,	 0.0f,  0.0,  1.0,		0.0f, 0.0f,		//   2 LD
+	-0.5f,  0.5f,  0.5f,	 0.0f,  0.0,  1.0,		0.0f, 1.0f,		//   3 LU
+
+	// Back
+	-0.5f,  0.5f, -0.5f,	 0.0f,  0.0, -1.0,		1.0f, 1.0f,		//   4 RU
+	-0.5f, -0.5f, -0.5f,	 0.0f,  0.0, -1.0,		1.0f, 0.0f,		//   5 RD
+	 0.5f, -0.5f, -0.5f,	 0.0f,  0.0, -1.0,		0.0f, 0.0f,		//   6 LD
+	 0.5f,  0.5f, -0.5f,	 0.0f,  0.0, -1.0,		0.0f, 1.0f,		//   7 LU
+
+	// Top
+	 0.5f,  0.5f, -0.5f,	 0.0f,  1.0,  0.0,		1.0f, 1.0f,		//   8 RU
+	 0.5f,  0.5f,  0.5f,	 0.0f,  1.0,  0.0,		1.0f, 0.0f,		//   9 RD
+	-0.5f,  0.5f,  0.5f,	 0.0f,  1.0,  0.0,		0.0f, 0.0f,		//  10 LD
+	-0.5f,  0.5f, -0.5f,	 0.0f,  1.0,  0.0,		0.0f, 1.0f,		//  11 LU
+
+	// Bottom
+	 0.5f, -0.5f,  0.5f,	 0.0f, -1.0,  0.0,		1.0f, 1.0f,		//  12 RU
+	 0.5f, -0.5f, -0.5f,	 0.0f, -1.0,  0.0,		1.0f, 0.0f,		//  13 RD
+	-0.5f, -0.5f, -0.5f,	 0.0f, -1.0,  0.0,		0.0f, 0.0f,		//  14 LD
+	-0.5f, -0.5f,  0.5f,	 0.0f, -1.0,  0.0,		0.0f, 1.0f,		//  15 LU
+
+	// Left
+	-0.5f,  0.5f,  0.5f,	-1.0f,  0.0,  0.0,		1.0f, 1.0f,		//  16 LU
+	-0.5f, -0.5f,  0.5f,	-1.0f,  0.0,  0.0,		1.0f, 0.0f,		//  17 LD
+	-0.5f, -0.5f, -0.5f,	-1.0f,  0.0,  0.0,		0.0f, 0.0f,		//  18 RD
+	-0.5f,  0.5f, -0.5f,	-1.0f,  0.0,  0.0,		0.0f, 1.0f,		//  19 RU
+
+	// Right
+	 0.5f,  0.5f, -0.5f,	 1.0f,  0.0,  0.0,		1.0f, 1.0f,		//   4 RU
+	 0.5f, -0.5f, -0.5f,	 1.0f,  0.0,  0.0,		1.0f, 0.0f,		//   5 RD
+	 0.5f, -0.5f,  0.5f,	 1.0f,  0.0,  0.0,		0.0f, 0.0f,		//   1 RD
+	 0.5f,  0.5f,  0.5f,	 1.0f,  0.0,  0.0,		0.0f, 1.0f		//   0 RU
+};
+
+static const unsigned cube_indices[] =
+{
+	 0,  1,  2,  2,  3,  0,	// Front
+	 4,  5,  6,  6,  7,  4,	// Back
+	 8,  9, 10, 10, 11,  8,	// Top
+	12, 13, 14, 14, 15, 12,	// Bottom
+	16, 17, 18, 18, 19, 16,	// Left
+	20, 21, 22, 22, 23, 20	// Right
+};
+
+static const unsigned prism_sides[PRISMS_COUNT] = { 3, 6, PRISM_MAX_SIDES };
+
+static const char* material_files[][2] =
+{
+	{ "data/textures/crate_diffuse.tex", "data/textures/crate_specular.tex" },
+	{ "data/textures/crate_dark_diffuse.tex", "data/textures/crate_dark_specular.tex" },
+	{ "data/textures/crate_painted_diffuse.tex", "data/textures/crate_painted_specular.tex" }
+};
+
+int main(int argc, char** argv)
+{
+	// =====================================
+	// Initialisation
+	// =====================================
+	// SDL
+
+	if (SDL_Init(SDL_INIT_VIDEO) < 0)
+	{
+		error("SDL Error", SDL_GetError());
+		return 1;
+	}
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_Window* window = SDL_CreateWindow("OpenGL Tutorial 12",
+										  SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+										  1024, 768, SDL_WINDOW_OPENGL);
+	if (!window)
+	{
+		error("SDL Error", SDL_GetError());
+		SDL_Quit();
+		return 1;
+	}
+	SDL_GLContext context = SDL_GL_CreateContext(window);
+	if (!context)
+	{
+		// Multi draw indirect needs a 4.3 driver, the fallback loop works with 3.3
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+		context = SDL_GL_CreateContext(window);
+	}
+	if (!context)
+	{
+		error("SDL Error", SDL_GetError());
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	SDL_ShowCursor(SDL_DISABLE);
+	SDL_SetRelativeMouseMode(SDL_TRUE);
+
+	// GLEW
+	glewExperimental = GL_TRUE;
+	if (glewInit() != GLEW_OK)
+	{
+		error("GLEW Error", glewGetErrorString(glGetError()));
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// OpenGL
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_CULL_FACE);
+	glCullFace(GL_BACK);
+	glFrontFace(GL_CW);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+	// Meshes
+	unsigned i;
+	struct mesh_buffer meshes;
+	if (!create_mesh_buffer(&meshes, 24 + PRISMS_COUNT * PRISM_MAX_VERTICES, 36 + PRISMS_COUNT * PRISM_MAX_INDICES, MESHES_COUNT))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	float prism_vertices[PRISM_MAX_VERTICES * MESH_VERTEX_FLOATS];
+	unsigned prism_indices[PRISM_MAX_INDICES];
+	unsigned prism_vertices_count, prism_indices_count;
+	int success = add_mesh(&meshes, cube_vertices, sizeof(cube_vertices) / sizeof(float) / MESH_VERTEX_FLOATS,
+						   cube_indices, sizeof(cube_indices) / sizeof(unsigned)) >= 0;
+	for (i = 0; i < PRISMS_COUNT && success; ++i)
+	{
+		build_prism_mesh(prism_vertices, &prism_vertices_count, prism_indices, &prism_indices_count, prism_sides[i]);
+		success = add_mesh(&meshes, prism_vertices, prism_vertices_count, prism_indices, prism_indices_count) >= 0;
+	}
+	if (!success)
+	{
+		destroy_mesh_buffer(&meshes);
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Shader
+	char* vertex_shader = NULL;
+	char* fragment_shader = NULL;
+
+	if (!load_shaders_text(&vertex_shader, &fragment_shader, "data/shaders/12_indirect"))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	unsigned vertex = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(vertex, 1, (const char* const*)&vertex_shader, NULL);
+	glCompileShader(vertex);
+	glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		char message[ERROR_BUFFER_SIZE];
+		glGetShaderInfoLog(vertex, ERROR_BUFFER_SIZE, NULL, message);
+		error("Vertex Shader Error", message);
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	unsigned fragment = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(fragment, 1, (const char* const*)&fragment_shader, NULL);
+	glCompileShader(fragment);
+	glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		char message[ERROR_BUFFER_SIZE];
+		glGetShaderInfoLog(fragment, ERROR_BUFFER_SIZE, NULL, message);
+		error("Fragment Shader Error", message);
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	const unsigned program = glCreateProgram();
+	glAttachShader(program, vertex);
+	glAttachShader(program, fragment);
+	glLinkProgram(program);
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		char message[ERROR_BUFFER_SIZE];
+		glGetProgramInfoLog(program, ERROR_BUFFER_SIZE, NULL, message);
+		error("Fragment Shader Error", message);
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	glDeleteShader(vertex);
+	glDeleteShader(fragment);
+	free(vertex_shader);
+	free(fragment_shader);
+
+	// Textures
+	struct texture_array diffuse_array, specular_array;
+	create_texture_array(&diffuse_array, MATERIALS_COUNT);
+	create_texture_array(&specular_array, MATERIALS_COUNT);
+	for (i = 0; i < MATERIALS_COUNT; ++i)
+		if (add_texture_layer(&diffuse_array, material_files[i][0]) != (int)i ||
+			add_texture_layer(&specular_array, material_files[i][1]) != (int)i)
+		{
+			destroy_texture_array(&specular_array);
+			destroy_texture_array(&diffuse_array);
+			SDL_GL_DeleteContext(context);
+			SDL_DestroyWindow(window);
+			SDL_Quit();
+			return 1;
+		}
+
+	// Shader Uniforms
+	const int uniform_viewproj = glGetUniformLocation(program, "cViewProj");
+	const int uniform_view_pos = glGetUniformLocation(program, "cViewPos");
+	const int uniform_draw_offset = glGetUniformLocation(program, "cDrawOffset");
+
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "sDiffuse"), 0);
+	glUniform1i(glGetUniformLocation(program, "sSpecular"), 1);
+	glUniform1i(glGetUniformLocation(program, "sInstances"), 2);
+	glUniform1i(glGetUniformLocation(program, "sDraws"), 3);
+	glUniform1f(glGetUniformLocation(program, "cShininess"), 32.0f);
+	glUniform3f(glGetUniformLocation(program, "cAmbientColor"), 0.2f, 0.2f, 0.2f);
+	glUniform3f(glGetUniformLocation(program, "cLight.direction"), -0.2f, -1.0f, -0.3f);
+	glUniform3f(glGetUniformLocation(program, "cLight.diffuse"), 1.0f, 0.8f, 0.6f);
+	glUniform3f(glGetUniformLocation(program, "cLight.specular"), 0.5f, 0.5f, 0.5f);
+	glUseProgram(0);
+
+	if (!validate_gl("Shader Uniforms Error"))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// =====================================
+	// Scene
+	// =====================================
+	// Objects
+	// Every object is one mesh with one material. Objects are sorted into
+	// groups of the same mesh and material, each group is one instanced
+	// draw and the whole scene is one draw list.
+	unsigned object_groups[OBJECTS_COUNT];
+	unsigned group_sizes[GROUPS_COUNT];
+	unsigned group_first[GROUPS_COUNT];
+	unsigned draw_data[GROUPS_COUNT * 4];
+	struct packed_instance* instances = (struct packed_instance*)malloc(OBJECTS_COUNT * sizeof(struct packed_instance));
+	vec3 position, axis = { 0.0f, 1.0f, 0.0f };
+	float scale;
+
+	memset(group_sizes, 0, sizeof(group_sizes));
+	for (i = 0; i < OBJECTS_COUNT; ++i)
+	{
+		object_groups[i] = (unsigned)rand() % GROUPS_COUNT;
+		++group_sizes[object_groups[i]];
+	}
+	for (i = 0, group_first[0] = 0; i + 1 < GROUPS_COUNT; ++i)
+		group_first[i + 1] = group_first[i] + group_sizes[i];
+
+	memset(group_sizes, 0, sizeof(group_sizes));
+	for (i = 0; i < OBJECTS_COUNT; ++i)
+	{
+		const unsigned slot = group_first[object_groups[i]] + group_sizes[object_groups[i]]++;
+		position[0] = ((float)(i % OBJECTS_X) - OBJECTS_X * 0.5f) * 2.0f;
+		position[1] = (float)(rand() % 100) * 0.01f - 2.0f;
+		position[2] = -(float)(i / OBJECTS_X) * 2.0f - 2.0f;
+		scale = 0.5f + (float)(rand() % 100) * 0.005f;
+		glm_quatv(instances[slot].rotation, (float)(rand() % 360) * GLM_PIf / 180.0f, axis);
+		glm_vec3_copy(position, instances[slot].position);
+		instances[slot].scale = scale;
+	}
+
+	struct draw_list draws;
+	if (!create_draw_list(&draws, GROUPS_COUNT))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+	for (i = 0; i < GROUPS_COUNT; ++i)
+	{
+		if (!group_sizes[i])
+			continue;
+		const int draw = add_draw(&draws, &meshes.meshes[i / MATERIALS_COUNT], group_sizes[i], group_first[i]);
+		draw_data[draw * 4] = group_first[i];
+		draw_data[draw * 4 + 1] = i % MATERIALS_COUNT;
+		draw_data[draw * 4 + 2] = 0;
+		draw_data[draw * 4 + 3] = 0;
+	}
+
+	// Per instance and per draw data are read through buffer textures, which 3.3 has as well
+	unsigned instance_buffer, instance_texture;
+	glGenBuffers(1, &instance_buffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, instance_buffer);
+	glBufferData(GL_TEXTURE_BUFFER, OBJECTS_COUNT * sizeof(struct packed_instance), instances, GL_STATIC_DRAW);
+	glGenTextures(1, &instance_texture);
+	glBindTexture(GL_TEXTURE_BUFFER, instance_texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, instance_buffer);
+
+	unsigned draw_buffer, draw_texture;
+	glGenBuffers(1, &draw_buffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, draw_buffer);
+	glBufferData(GL_TEXTURE_BUFFER, draws.count * 4 * sizeof(unsigned), draw_data, GL_STATIC_DRAW);
+	glGenTextures(1, &draw_texture);
+	glBindTexture(GL_TEXTURE_BUFFER, draw_texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, draw_buffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	free(instances);
+	if (!validate_gl("Buffer Texture Creation Error"))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Camera
+	vec3 camera_position = { 0.0f, 0.0f, 3.0f };
+	vec3 camera_direction;
+	vec3 camera_up;
+	versor camera_rotation = GLM_QUAT_IDENTITY_INIT;
+
+	// =====================================
+	// Rendering
+	// =====================================
+	// Matrices
+	mat4 view, viewproj;
+
+	// Projection Matrix
+	mat4 proj;
+	glm_perspective(45.0f, 1024.0f / 720.0f, 0.01f, 200.0f, proj);
+
+	// Textures
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, diffuse_array.texture);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, specular_array.texture);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_BUFFER, instance_texture);
+	glActiveTexture(GL_TEXTURE3);
+	glBindTexture(GL_TEXTURE_BUFFER, draw_texture);
+	glActiveTexture(GL_TEXTURE0);
+
+	// Statistics
+	char title[256];
+	Uint64 submit_start;
+	Uint64 submit_time = 0;
+	unsigned frames = 0;
+	float title_time = 0.0f;
+
+	int run = 1;
+	float tick_delta;
+	float tick_curr;
+	float tick_prev = 0.0f;
+	unsigned short controls = 0;
+	while (run)
+	{
+		tick_curr = (float)SDL_GetTicks();
+		tick_delta = tick_curr - tick_prev;
+		process_events(camera_position, camera_direction, camera_rotation, &controls, &run, tick_delta);
+		tick_prev = tick_curr;
+
+		// =================================
+		// Camera
+		// =================================
+		// Look
+		glm_quat_rotatev(camera_rotation, GLM_FORWARD, camera_direction);
+
+		// View Matrix
+		glm_quat_rotatev(camera_rotation, GLM_YUP, camera_up);
+		glm_look(camera_position, camera_direction, camera_up, view);
+
+		// View and Projection Matrix
+		glm_mat4_mul_sse2(proj, view, viewproj);
+
+		// Rendering
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		submit_start = SDL_GetPerformanceCounter();
+		glUseProgram(program);
+		glUniformMatrix4fv(uniform_viewproj, 1, GL_FALSE, viewproj[0]);
+		glUniform3fv(uniform_view_pos, 1, camera_position);
+		glBindVertexArray(meshes.vao);
+		submit_draw_list(&draws, uniform_draw_offset);
+		glBindVertexArray(0);
+		glUseProgram(0);
+		submit_time += SDL_GetPerformanceCounter() - submit_start;
+
+		// Statistics
+		++frames;
+		title_time += tick_delta;
+		if (title_time >= 1000.0f)
+		{
+			snprintf(title, sizeof(title), "OpenGL Tutorial 12: %u objects, %u draws %s, %.1f us submit",
+					 OBJECTS_COUNT, draws.count, draws.indirect ? "in one indirect call" : "in a loop",
+					 (double)submit_time * 1000000.0 / (double)SDL_GetPerformanceFrequency() / frames);
+			SDL_SetWindowTitle(window, title);
+			submit_time = 0;
+			frames = 0;
+			title_time = 0.0f;
+		}
+
+		if (validate_gl("Open GL Rendering Error"))
+			SDL_GL_SwapWindow(window);
+		else
+			run = 0;
+	}
+
+	// =====================================
+	// Destruction
+	// =====================================
+	// Texture
+	glDeleteTextures(1, &draw_texture);
+	glDeleteTextures(1, &instance_texture);
+	destroy_texture_array(&specular_array);
+	destroy_texture_array(&diffuse_array);
+
+	// Shader
+	glDeleteProgram(program);
+
+	// Vertex Buffers
+	glDeleteBuffers(1, &draw_buffer);
+	glDeleteBuffers(1, &instance_buffer);
+	destroy_draw_list(&draws);
+	destroy_mesh_buffer(&meshes);
+
+	// SDL
+	SDL_GL_DeleteContext(context);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+
+	return 0;
+}
+
+__declspec(dllexport) unsigned NvOptimusEnablement = 1;
+__declspec(dllexport) int AmdPowerXpressRequestHighPerformance = 1;
@@ -23,7 +23,6 @@
 #include <stdio.h>
 #include <string.h>
 
-#define STB_IMAGE_IMPLEMENTATION
 #define SDL_MAIN_HANDLED
 #include <GL/glew.h>
 #include <SDL2/SDL.h>
@@ -32,7 +31,7 @@
 #include "cglm/cam.h"
 #include "cglm/quat.h"
 #include "common.h"
-#include "stb_image.h"
+#include "texture_manager.h"
 
 static const float vertices[] =
 {
@@ -125,9 +124,6 @@ int main(int argc, char** argv)
 	glFrontFace(GL_CW);
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
-	// STB Image
-	stbi_set_flip_vertically_on_load(1);
-
 	// Vertex Buffers
 	unsigned vao;
 	glGenVertexArrays(1, &vao);
@@ -231,30 +227,8 @@ int main(int argc, char** argv)
 	glDeleteShader(fragment);
 
 	// Texture
-	unsigned texture;
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	int width, height, channels;
-	unsigned char* texture_data = stbi_load("data/textures/crate_diffuse.png", &width, &height, &channels, 0);
-	if (!texture_data)
-	{
-		error("Texture Loading Error", "Could not found file data/textures/crate_diffuse.png.");
-		SDL_GL_DeleteContext(context);
-		SDL_DestroyWindow(window);
-		SDL_Quit();
-		return 1;
-	}
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, texture_data);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	stbi_image_free(texture_data);
-	if (!validate_gl("VAO Creation Error"))
+	const unsigned texture = load_texture("data/textures/crate_diffuse.tex");
+	if (!texture)
 	{
 		SDL_GL_DeleteContext(context);
 		SDL_DestroyWindow(window);
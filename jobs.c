@@ -0,0 +1,158 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <stdlib.h>
+#include <SDL_atomic.h>
+#include <SDL_cpuinfo.h>
+#include <SDL_mutex.h>
+#include <SDL_thread.h>
+#include "jobs.h"
+
+#define JOBS_MAX_THREADS 64
+
+// Workers sleep on a semaphore until a batch is published, then pull ranges
+// of the batch with an atomic counter. The calling thread works on the batch
+// too and waits for every worker to report back before returning, so a batch
+// never outlives the stack frame that owns its data.
+static struct
+{
+	SDL_Thread* threads[JOBS_MAX_THREADS];
+	unsigned threads_count;
+	SDL_atomic_t busy;
+	SDL_sem* start;
+	SDL_sem* done;
+	SDL_atomic_t next;
+	job_func func;
+	void* data;
+	unsigned count;
+	unsigned grain;
+	int quit;
+} jobs;
+
+static void run_batch(void)
+{
+	unsigned begin, end;
+	while ((begin = (unsigned)SDL_AtomicAdd(&jobs.next, (int)jobs.grain)) < jobs.count)
+	{
+		end = begin + jobs.grain < jobs.count ? begin + jobs.grain : jobs.count;
+		jobs.func(jobs.data, begin, end);
+	}
+}
+
+static int worker(void* data)
+{
+	(void)data;
+	for (;;)
+	{
+		SDL_SemWait(jobs.start);
+		if (jobs.quit)
+			break;
+		run_batch();
+		SDL_SemPost(jobs.done);
+	}
+	return 0;
+}
+
+int jobs_init(unsigned threads)
+{
+	unsigned i;
+
+	if (jobs.start)
+		return 1;
+	if (!threads)
+		threads = SDL_GetCPUCount() > 1 ? (unsigned)SDL_GetCPUCount() - 1 : 0;
+	if (threads > JOBS_MAX_THREADS)
+		threads = JOBS_MAX_THREADS;
+
+	jobs.start = SDL_CreateSemaphore(0);
+	jobs.done = SDL_CreateSemaphore(0);
+	if (!jobs.start || !jobs.done)
+	{
+		jobs_shutdown();
+		return 0;
+	}
+
+	jobs.quit = 0;
+	for (i = 0; i < threads; ++i)
+	{
+		jobs.threads[i] = SDL_CreateThread(worker, "Worker", NULL);
+		if (!jobs.threads[i])
+			break;
+		++jobs.threads_count;
+	}
+	return 1;
+}
+
+void jobs_shutdown(void)
+{
+	unsigned i;
+
+	jobs.quit = 1;
+	for (i = 0; i < jobs.threads_count; ++i)
+		SDL_SemPost(jobs.start);
+	for (i = 0; i < jobs.threads_count; ++i)
+		SDL_WaitThread(jobs.threads[i], NULL);
+	jobs.threads_count = 0;
+
+	if (jobs.done)
+		SDL_DestroySemaphore(jobs.done);
+	if (jobs.start)
+		SDL_DestroySemaphore(jobs.start);
+	jobs.done = NULL;
+	jobs.start = NULL;
+}
+
+unsigned jobs_thread_count(void)
+{
+	return jobs.threads_count + 1;
+}
+
+void jobs_parallel_for(job_func func, void* data, unsigned count, unsigned grain)
+{
+	unsigned i;
+
+	if (!grain)
+		grain = 1;
+
+	// Small batches, nested calls from inside a job and calls racing another
+	// batch all run inline on the calling thread
+	if (!jobs.threads_count || count <= grain || !SDL_AtomicCAS(&jobs.busy, 0, 1))
+	{
+		func(data, 0, count);
+		return;
+	}
+
+	jobs.func = func;
+	jobs.data = data;
+	jobs.count = count;
+	jobs.grain = grain;
+	SDL_AtomicSet(&jobs.next, 0);
+	for (i = 0; i < jobs.threads_count; ++i)
+		SDL_SemPost(jobs.start);
+
+	run_batch();
+	for (i = 0; i < jobs.threads_count; ++i)
+		SDL_SemWait(jobs.done);
+
+	SDL_AtomicSet(&jobs.busy, 0);
+}
@@ -24,7 +24,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define STB_IMAGE_IMPLEMENTATION
 #define SDL_MAIN_HANDLED
 #include <GL/glew.h>
 #include <SDL2/SDL.h>
@@ -33,7 +32,7 @@
 #include "cglm/cam.h"
 #include "cglm/quat.h"
 #include "common.h"
-#include "stb_image.h"
+#include "texture_manager.h"
 
 static const float cube_vertices[] =
 {
@@ -139,9 +138,6 @@ int main(int argc, char** argv)
 	glFrontFace(GL_CW);
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
-	// STB Image
-	stbi_set_flip_vertically_on_load(1);
-
 	// Vertex Buffers
 
 	unsigned vbo;
@@ -330,30 +326,8 @@ int main(int argc, char** argv)
 	glDeleteShader(fragment);
 
 	// Texture
-	unsigned texture;
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	int width, height, channels;
-	unsigned char* texture_data = stbi_load("data/textures/crate_diffuse.png", &width, &height, &channels, 0);
-	if (!texture_data)
-	{
-		error("Texture Loading Error", "Could not found file data/textures/crate_diffuse.png.");
-		SDL_GL_DeleteContext(context);
-		SDL_DestroyWindow(window);
-		SDL_Quit();
-		return 1;
-	}
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, texture_data);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	stbi_image_free(texture_data);
-	if (!validate_gl("VAO Creation Error"))
+	const unsigned texture = load_texture("data/textures/crate_diffuse.tex");
+	if (!texture)
 	{
 		SDL_GL_DeleteContext(context);
 		SDL_DestroyWindow(window);
@@ -370,8 +344,7 @@ int main(int argc, char** argv)
 	const int uniform_light_color = glGetUniformLocation(program_diffuse, "cLightColor");
 	const int uniform_view_pos = glGetUniformLocation(program_diffuse, "cViewPos");
 
-	const int uniform_model_dif = glGetUniformLocation(program_emissive, "cModel");
-	const int uniform_viewproj_dif = glGetUniformLocation(program_emissive, "cViewProj");
+	const int uniform_mvp_dif = glGetUniformLocation(program_emissive, "cModelViewProj");
 	const int uniform_color = glGetUniformLocation(program_emissive, "cColor");
 
 	glUseProgram(program_diffuse);
@@ -415,7 +388,7 @@ int main(int argc, char** argv)
 	// Rendering
 	// =====================================
 	// Matrices
-	mat4 model, model_inv, view, viewproj;
+	mat4 model, model_inv, view, viewproj, mvp;
 
 	// Projection Matrix
 	mat4 proj;
@@ -491,8 +464,8 @@ int main(int argc, char** argv)
 		glm_scale(model, light_scale);
 
 		glUseProgram(program_emissive);
-		glUniformMatrix4fv(uniform_viewproj_dif, 1, GL_FALSE, viewproj[0]);
-		glUniformMatrix4fv(uniform_model_dif, 1, GL_FALSE, model[0]);
+		glm_mat4_mul_sse2(viewproj, model, mvp);
+		glUniformMatrix4fv(uniform_mvp_dif, 1, GL_FALSE, mvp[0]);
 		glUniform3fv(uniform_color, 1, light_color);
 		glBindVertexArray(lamp_vao);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
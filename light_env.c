@@ -24,7 +24,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define STB_IMAGE_IMPLEMENTATION
 #define SDL_MAIN_HANDLED
 #include <GL/glew.h>
 #include <SDL2/SDL.h>
@@ -33,7 +32,7 @@
 #include "cglm/cam.h"
 #include "cglm/quat.h"
 #include "common.h"
-#include "stb_image.h"
+#include "texture_manager.h"
 
 static const float cube_vertices[] =
 {
@@ -153,9 +152,6 @@ int main(int argc, char** argv)
 	glFrontFace(GL_CW);
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
-	// STB Image
-	stbi_set_flip_vertically_on_load(1);
-
 	// Vertex Buffers
 	unsigned vbo;
 	glGenBuffers(1, &vbo);
@@ -268,58 +264,17 @@ int main(int argc, char** argv)
 	free(fragment_shader);
 
 	// Textures
-	unsigned texture_diffuse;
-	glGenTextures(1, &texture_diffuse);
-	glBindTexture(GL_TEXTURE_2D, texture_diffuse);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	int width, height, channels;
-	unsigned char* texture_data = stbi_load("data/textures/crate_diffuse.png", &width, &height, &channels, 0);
-	if (!texture_data)
-	{
-		error("Texture Loading Error", "Could not found file data/textures/crate_diffuse.png.");
-		SDL_GL_DeleteContext(context);
-		SDL_DestroyWindow(window);
-		SDL_Quit();
-		return 1;
-	}
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, texture_data);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	stbi_image_free(texture_data);
-	if (!validate_gl("Texture Creation Error"))
-	{
-		SDL_GL_DeleteContext(context);
-		SDL_DestroyWindow(window);
-		SDL_Quit();
-		return 1;
-	}
-
-	unsigned texture_specular;
-	glGenTextures(1, &texture_specular);
-	glBindTexture(GL_TEXTURE_2D, texture_specular);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	texture_data = stbi_load("data/textures/crate_specular.png", &width, &height, &channels, 0);
-	if (!texture_data)
+	const unsigned texture_diffuse = load_texture("data/textures/crate_diffuse.tex");
+	if (!texture_diffuse)
 	{
-		error("Texture Loading Error", "Could not found file data/textures/crate_specular.png.");
 		SDL_GL_DeleteContext(context);
 		SDL_DestroyWindow(window);
 		SDL_Quit();
 		return 1;
 	}
 
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, texture_data);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	stbi_image_free(texture_data);
-	if (!validate_gl("Texture Creation Error"))
+	const unsigned texture_specular = load_texture("data/textures/crate_specular.tex");
+	if (!texture_specular)
 	{
 		SDL_GL_DeleteContext(context);
 		SDL_DestroyWindow(window);
@@ -390,6 +345,14 @@ int main(int argc, char** argv)
 	versor rotation;
 	glm_quat_identity(rotation);
 
+	// Textures
+	// Nothing else samples textures, so they stay bound for the whole run
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture_diffuse);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, texture_specular);
+	glActiveTexture(GL_TEXTURE0);
+
 	SDL_Event event;
 	int i;
 	int run = 1;
@@ -428,10 +391,6 @@ int main(int argc, char** argv)
 		glUniform3fv(uniform_light_specular, 1, light_specular);
 		glUniform3fv(uniform_ambient_color, 1, ambient_color);
 		glUniform3fv(uniform_view_pos, 1, camera_position);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, texture_diffuse);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, texture_specular);
 		glBindVertexArray(cube_vao);
 		for (i = 0; i < cubes_count; ++i)
 		{
@@ -452,7 +411,6 @@ int main(int argc, char** argv)
 		}
 		glUseProgram(0);
 		glBindVertexArray(0);
-		glBindTexture(GL_TEXTURE_2D, 0);
 
 		if (validate_gl("Open GL Rendering Error"))
 			SDL_GL_SwapWindow(window);
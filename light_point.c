@@ -24,7 +24,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define STB_IMAGE_IMPLEMENTATION
 #define SDL_MAIN_HANDLED
 #include <GL/glew.h>
 #include <SDL2/SDL.h>
@@ -32,8 +31,14 @@
 #include "cglm/affine.h"
 #include "cglm/cam.h"
 #include "cglm/quat.h"
+#include "animation.h"
 #include "common.h"
-#include "stb_image.h"
+#include "ecs.h"
+#include "jobs.h"
+#include "scene_graph.h"
+#include "simd.h"
+#include "texture_manager.h"
+#include "transform_batch.h"
 
 static const float cube_vertices[] =
 {
@@ -85,7 +90,9 @@ static const unsigned cube_indices[] =
 	20, 21, 22, 22, 23, 20	// Right
 };
 
-static vec3 cube_positions[] =
+#define CUBES_COUNT 10
+
+static vec3 cube_positions[CUBES_COUNT] =
 {
 	{ 0.0f, 0.0f, 0.0f },
 	{ 2.0f, 5.0f, -15.0f },
@@ -99,6 +106,86 @@ static vec3 cube_positions[] =
 	{ -1.3f, 1.0f, -1.5f }
 };
 
+#define MAX_ENTITIES 1024
+
+enum component
+{
+	COMPONENT_POSITION,
+	COMPONENT_ROTATION,
+	COMPONENT_SPIN,
+	COMPONENT_MODEL,
+	COMPONENT_MVP,
+	COMPONENT_NORMAL,
+	COMPONENT_LIGHT
+};
+
+#define CUBE_COMPONENTS (ECS_MASK(COMPONENT_POSITION) | ECS_MASK(COMPONENT_ROTATION) | ECS_MASK(COMPONENT_SPIN) | \
+						 ECS_MASK(COMPONENT_MODEL) | ECS_MASK(COMPONENT_MVP) | ECS_MASK(COMPONENT_NORMAL))
+#define LIGHT_COMPONENTS (ECS_MASK(COMPONENT_POSITION) | ECS_MASK(COMPONENT_LIGHT))
+
+struct point_light
+{
+	vec3 diffuse;
+	vec3 specular;
+	float constant;
+	float linear;
+	float quadratic;
+};
+
+struct draw_cubes
+{
+	int uniform_mvp;
+	int uniform_model;
+	int uniform_normal;
+	unsigned ebo;
+};
+
+struct spin_step
+{
+	float time;
+	unsigned step;
+};
+
+// Spin is a unit rotation axis and a speed in radians per millisecond
+static void spin_system(void* data, struct ecs_view* view)
+{
+	const struct spin_step* spin = (const struct spin_step*)data;
+	animate_spins((versor*)view->columns[COMPONENT_ROTATION], (vec4*)view->columns[COMPONENT_SPIN], spin->time,
+				  spin->step, view->count);
+}
+
+static void transform_system(void* data, struct ecs_view* view)
+{
+	vec3* positions = (vec3*)view->columns[COMPONENT_POSITION];
+	versor* rotations = (versor*)view->columns[COMPONENT_ROTATION];
+	mat4* models = (mat4*)view->columns[COMPONENT_MODEL];
+	unsigned i;
+	for (i = 0; i < view->count; ++i)
+	{
+		glm_translate_make(models[i], positions[i]);
+		glm_quat_rotate(models[i], rotations[i], models[i]);
+	}
+	batch_transforms(*(mat4*)data, models, (mat4*)view->columns[COMPONENT_MVP], (mat3*)view->columns[COMPONENT_NORMAL], view->count);
+}
+
+static void draw_system(void* data, struct ecs_view* view)
+{
+	const struct draw_cubes* draw = (const struct draw_cubes*)data;
+	mat4* models = (mat4*)view->columns[COMPONENT_MODEL];
+	mat4* mvps = (mat4*)view->columns[COMPONENT_MVP];
+	mat3* normals = (mat3*)view->columns[COMPONENT_NORMAL];
+	unsigned i;
+	for (i = 0; i < view->count; ++i)
+	{
+		glUniformMatrix4fv(draw->uniform_mvp, 1, GL_FALSE, mvps[i][0]);
+		glUniformMatrix4fv(draw->uniform_model, 1, GL_FALSE, models[i][0]);
+		glUniformMatrix3fv(draw->uniform_normal, 1, GL_FALSE, normals[i][0]);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, draw->ebo);
+		glDrawElements(GL_TRIANGLES, sizeof(cube_vertices) / sizeof(float), GL_UNSIGNED_INT, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+}
+
 int main(int argc, char** argv)
 {
 	// =====================================
@@ -153,8 +240,8 @@ int main(int argc, char** argv)
 	glFrontFace(GL_CW);
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
-	// STB Image
-	stbi_set_flip_vertically_on_load(1);
+	// Math kernels of the widest instruction set the CPU has
+	simd_init();
 
 	// Vertex Buffers
 
@@ -344,29 +431,8 @@ int main(int argc, char** argv)
 	glDeleteShader(fragment);
 
 	// Textures
-	unsigned texture_diffuse;
-	glGenTextures(1, &texture_diffuse);
-	glBindTexture(GL_TEXTURE_2D, texture_diffuse);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	int width, height, channels;
-	unsigned char* texture_data = stbi_load("data/textures/crate_diffuse.png", &width, &height, &channels, 0);
-	if (!texture_data)
-	{
-		error("Texture Loading Error", "Could not found file data/textures/crate_diffuse.png.");
-		SDL_GL_DeleteContext(context);
-		SDL_DestroyWindow(window);
-		SDL_Quit();
-		return 1;
-	}
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, texture_data);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	stbi_image_free(texture_data);
-	if (!validate_gl("Texture Creation Error"))
+	const unsigned texture_diffuse = load_texture("data/textures/crate_diffuse.tex");
+	if (!texture_diffuse)
 	{
 		SDL_GL_DeleteContext(context);
 		SDL_DestroyWindow(window);
@@ -374,28 +440,8 @@ int main(int argc, char** argv)
 		return 1;
 	}
 
-	unsigned texture_specular;
-	glGenTextures(1, &texture_specular);
-	glBindTexture(GL_TEXTURE_2D, texture_specular);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	texture_data = stbi_load("data/textures/crate_specular.png", &width, &height, &channels, 0);
-	if (!texture_data)
-	{
-		error("Texture Loading Error", "Could not found file data/textures/crate_specular.png.");
-		SDL_GL_DeleteContext(context);
-		SDL_DestroyWindow(window);
-		SDL_Quit();
-		return 1;
-	}
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, texture_data);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	stbi_image_free(texture_data);
-	if (!validate_gl("Texture Creation Error"))
+	const unsigned texture_specular = load_texture("data/textures/crate_specular.tex");
+	if (!texture_specular)
 	{
 		SDL_GL_DeleteContext(context);
 		SDL_DestroyWindow(window);
@@ -404,9 +450,9 @@ int main(int argc, char** argv)
 	}
 
 	// Shader Uniforms
+	const int uniform_mvp = glGetUniformLocation(program_diffuse, "cModelViewProj");
 	const int uniform_model = glGetUniformLocation(program_diffuse, "cModel");
-	const int uniform_model_inv = glGetUniformLocation(program_diffuse, "cModelInv");
-	const int uniform_viewproj = glGetUniformLocation(program_diffuse, "cViewProj");
+	const int uniform_normal = glGetUniformLocation(program_diffuse, "cNormalMatrix");
 	const int uniform_view_pos = glGetUniformLocation(program_diffuse, "cViewPos");
 	const int uniform_ambient_color = glGetUniformLocation(program_diffuse, "cAmbientColor");
 	const int uniform_shininess = glGetUniformLocation(program_diffuse, "cMaterial.shininess");
@@ -418,8 +464,7 @@ int main(int argc, char** argv)
 	const int uniform_light_linear = glGetUniformLocation(program_diffuse, "cLight.linear");
 	const int uniform_light_quadratic = glGetUniformLocation(program_diffuse, "cLight.quadratic");
 
-	const int uniform_model_dif = glGetUniformLocation(program_emissive, "cModel");
-	const int uniform_viewproj_dif = glGetUniformLocation(program_emissive, "cViewProj");
+	const int uniform_mvp_dif = glGetUniformLocation(program_emissive, "cModelViewProj");
 	const int uniform_color = glGetUniformLocation(program_emissive, "cColor");
 
 	glUseProgram(program_diffuse);
@@ -438,21 +483,95 @@ int main(int argc, char** argv)
 	// =====================================
 	// Scene
 	// =====================================
-	// Cube
-	vec3 cube_axis = { 0.5, 0.5, 0.2 };
-	versor cube_rotation = GLM_QUAT_IDENTITY_INIT;
+	// Jobs
+	if (!jobs_init(0))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Entities
+	struct ecs_world world;
+	if (!create_ecs_world(&world, MAX_ENTITIES))
+	{
+		jobs_shutdown();
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+	ecs_register_component(&world, COMPONENT_POSITION, sizeof(vec3));
+	ecs_register_component(&world, COMPONENT_ROTATION, sizeof(versor));
+	ecs_register_component(&world, COMPONENT_SPIN, sizeof(vec4));
+	ecs_register_component(&world, COMPONENT_MODEL, sizeof(mat4));
+	ecs_register_component(&world, COMPONENT_MVP, sizeof(mat4));
+	ecs_register_component(&world, COMPONENT_NORMAL, sizeof(mat3));
+	ecs_register_component(&world, COMPONENT_LIGHT, sizeof(struct point_light));
+
+	// Cubes
+	// Every cube spins on its own, a bit faster than the one before
 	const float cube_shininess = 32.0f;
-	const unsigned cubes_count = sizeof(cube_positions) / sizeof(vec3);
+	versor cube_rotation = GLM_QUAT_IDENTITY_INIT;
+	vec4 cube_spin = { 0.5f, 0.5f, 0.2f, 0.0f };
+	glm_vec3_normalize(cube_spin);
+	ecs_entity entity;
+	int i;
+	for (i = 0; i < CUBES_COUNT; ++i)
+	{
+		entity = ecs_defer_create(&world, CUBE_COMPONENTS);
+		cube_spin[3] = -0.000025f * (float)(i + 1);
+		ecs_defer_add(&world, entity, COMPONENT_POSITION, cube_positions[i]);
+		ecs_defer_add(&world, entity, COMPONENT_ROTATION, cube_rotation);
+		ecs_defer_add(&world, entity, COMPONENT_SPIN, cube_spin);
+	}
 
 	// Light
 	vec3 ambient_color = { 0.1f, 0.1f, 0.1f };
 	vec3 light_position = { -0.5f, -0.5f, -2.5f };
-	vec3 light_diffuse = { 1.0f, 0.8f, 0.6f };
-	vec3 light_specular = { 0.5f, 0.5f, 0.5f };
 	vec3 light_scale = { 0.25f, 0.25f, 0.25f };
-	const float light_constant = 1.0f;
-	const float light_linear = 0.09f;
-	const float light_quadratic = 0.032f;
+	const struct point_light light_init =
+	{
+		{ 1.0f, 0.8f, 0.6f },
+		{ 0.5f, 0.5f, 0.5f },
+		1.0f,
+		0.09f,
+		0.032f
+	};
+	const ecs_entity light = ecs_defer_create(&world, LIGHT_COMPONENTS);
+	ecs_defer_add(&world, light, COMPONENT_POSITION, light_position);
+	ecs_defer_add(&world, light, COMPONENT_LIGHT, &light_init);
+
+	// The lamp hangs from a pivot at the origin, which holds still
+	struct scene_graph graph;
+	if (!create_scene_graph(&graph, 2))
+	{
+		error("Scene Graph Error", "Could not allocate scene graph.");
+		destroy_ecs_world(&world);
+		jobs_shutdown();
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+	mat4 light_local = GLM_MAT4_IDENTITY_INIT;
+	const unsigned light_pivot = add_scene_node(&graph, SCENE_ROOT, light_local);
+	glm_translate_make(light_local, light_position);
+	glm_scale(light_local, light_scale);
+	const unsigned light_node = add_scene_node(&graph, light_pivot, light_local);
+	update_scene_graph(&graph);
+
+	if (!ecs_flush(&world))
+	{
+		destroy_scene_graph(&graph);
+		destroy_ecs_world(&world);
+		jobs_shutdown();
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
 
 	// Camera
 	vec3 camera_position = { 0.0f, 0.0f, 3.0f };
@@ -466,19 +585,27 @@ int main(int argc, char** argv)
 	// Rendering
 	// =====================================
 	// Matrices
-	mat4 model, model_inv, view, viewproj;
+	// Shaders get the model-view-projection matrix of every object, built
+	// here once per object instead of once per vertex
+	mat4 view, viewproj, mvp;
 
 	// Projection Matrix
 	mat4 proj;
 	glm_perspective(45.0f, 1024.0f / 720.0f, 0.01f, 100.0f, proj);
 
-	// Rotation
-	vec3 rotation_axis = { 0.5f, 1.0f, 0.75f };
-	versor rotation;
-	glm_quat_identity(rotation);
+	// Textures
+	// Nothing else samples textures, so they stay bound for the whole run
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture_diffuse);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, texture_specular);
+	glActiveTexture(GL_TEXTURE0);
 
+	struct draw_cubes draw_cubes = { uniform_mvp, uniform_model, uniform_normal, ebo };
+	const struct point_light* light_data;
+	float* light_world_position;
+	struct spin_step spin_step = { 0.0f, 0 };
 	SDL_Event event;
-	int i;
 	int run = 1;
 	float tick_delta;
 	float tick_curr;
@@ -507,51 +634,36 @@ int main(int argc, char** argv)
 		// Rendering
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+		// Systems
+		spin_step.time = tick_delta;
+		++spin_step.step;
+		ecs_each_parallel(&world, ECS_MASK(COMPONENT_ROTATION) | ECS_MASK(COMPONENT_SPIN), spin_system, &spin_step);
+		ecs_each_parallel(&world, CUBE_COMPONENTS, transform_system, viewproj);
+		ecs_flush(&world);
+
+		light_world_position = (float*)ecs_get(&world, light, COMPONENT_POSITION);
+		glm_vec3_copy(scene_world(&graph, light_node) + 12, light_world_position);
+		light_data = (const struct point_light*)ecs_get(&world, light, COMPONENT_LIGHT);
+
 		glUseProgram(program_diffuse);
-		glUniformMatrix4fv(uniform_viewproj, 1, GL_FALSE, viewproj[0]);
 		glUniform1f(uniform_shininess, cube_shininess);
 		glUniform3fv(uniform_ambient_color, 1, ambient_color);
-		glUniform3fv(uniform_light_position, 1, light_position);
-		glUniform3fv(uniform_light_diffuse, 1, light_diffuse);
-		glUniform3fv(uniform_light_specular, 1, light_specular);
-		glUniform1f(uniform_light_constant, light_constant);
-		glUniform1f(uniform_light_linear, light_linear);
-		glUniform1f(uniform_light_quadratic, light_quadratic);
+		glUniform3fv(uniform_light_position, 1, light_world_position);
+		glUniform3fv(uniform_light_diffuse, 1, light_data->diffuse);
+		glUniform3fv(uniform_light_specular, 1, light_data->specular);
+		glUniform1f(uniform_light_constant, light_data->constant);
+		glUniform1f(uniform_light_linear, light_data->linear);
+		glUniform1f(uniform_light_quadratic, light_data->quadratic);
 		glUniform3fv(uniform_view_pos, 1, camera_position);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, texture_diffuse);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, texture_specular);
 		glBindVertexArray(cube_vao);
-		for (i = 0; i < cubes_count; ++i)
-		{
-			glm_translate_make(model, cube_positions[i]);
-			glm_quatv(rotation, tick_delta * -0.000025f, cube_axis);
-			glm_quat_mul_sse2(rotation, cube_rotation, cube_rotation);
-			glm_quat_rotate(model, cube_rotation, model);
-			glm_mat4_inv_sse2(model, model_inv);
-			glm_mat4_transp_sse2(model_inv, model_inv);
-
-			glUniformMatrix4fv(uniform_model, 1, GL_FALSE, model[0]);
-			glUniformMatrix4fv(uniform_model_inv, 1, GL_FALSE, model_inv[0]);
-			glUniformMatrix4fv(uniform_model_inv, 1, GL_FALSE, model_inv[0]);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-			glDrawElements(GL_TRIANGLES, sizeof(cube_vertices) / sizeof(float), GL_UNSIGNED_INT, 0);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-		}
+		ecs_each(&world, CUBE_COMPONENTS, draw_system, &draw_cubes);
 		glUseProgram(0);
 		glBindVertexArray(0);
-		glBindTexture(GL_TEXTURE_2D, 0);
-
-		glm_mat4_identity(model);
-		glm_quat_rotate(model, rotation, model);
-		glm_translate(model, light_position);
-		glm_scale(model, light_scale);
 
 		glUseProgram(program_emissive);
-		glUniformMatrix4fv(uniform_viewproj_dif, 1, GL_FALSE, viewproj[0]);
-		glUniformMatrix4fv(uniform_model_dif, 1, GL_FALSE, model[0]);
-		glUniform3fv(uniform_color, 1, light_diffuse);
+		glm_mat4_mul_sse2(viewproj, (vec4*)scene_world(&graph, light_node), mvp);
+		glUniformMatrix4fv(uniform_mvp_dif, 1, GL_FALSE, mvp[0]);
+		glUniform3fv(uniform_color, 1, light_data->diffuse);
 		glBindVertexArray(lamp_vao);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
 		glDrawElements(GL_TRIANGLES, sizeof(cube_vertices) / sizeof(float), GL_UNSIGNED_INT, 0);
@@ -567,6 +679,11 @@ int main(int argc, char** argv)
 	// =====================================
 	// Destruction
 	// =====================================
+	// Entities
+	destroy_scene_graph(&graph);
+	destroy_ecs_world(&world);
+	jobs_shutdown();
+
 	// Texture
 	glDeleteTextures(1, &texture_diffuse);
 	glDeleteTextures(1, &texture_specular);
@@ -0,0 +1,102 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <float.h>
+#include <string.h>
+#include "cglm/vec3.h"
+#include "lod.h"
+
+#define FADE_DONE 0xffffu
+#define LEVEL_UNSET 0xff
+
+void init_lod_instances(struct lod_instance* instances, unsigned count)
+{
+	memset(instances, 0xff, count * sizeof(struct lod_instance));
+}
+
+// proj[1][1] of glm_perspective is 1 / tan(fovy / 2), so a sphere of
+// radius r at distance d covers r * proj[1][1] / d of the screen height
+float lod_projected_size(mat4 proj, vec3 eye, vec4 sphere)
+{
+	const float distance = glm_vec3_distance(eye, sphere);
+	return distance > sphere[3] ? sphere[3] * proj[1][1] / distance : FLT_MAX;
+}
+
+void update_lod(const struct lod_levels* levels, struct lod_instance* instance, float size, float delta)
+{
+	unsigned level = instance->level;
+	float fade;
+
+	// New instances start at their level without a fade
+	if (level == LEVEL_UNSET)
+	{
+		for (level = 0; level + 1 < levels->count && size < levels->sizes[level]; ++level)
+			;
+		instance->level = (unsigned char)level;
+		instance->previous = (unsigned char)level;
+		instance->fade = FADE_DONE;
+		return;
+	}
+
+	while (level > 0 && size >= levels->sizes[level - 1] * (1.0f + levels->hysteresis))
+		--level;
+	while (level + 1 < levels->count && size < levels->sizes[level] * (1.0f - levels->hysteresis))
+		++level;
+
+	if (level != instance->level)
+	{
+		// Going back to the level still fading out turns the fade around
+		// instead of popping
+		if (level == instance->previous && instance->fade < FADE_DONE)
+			instance->fade = (unsigned short)(FADE_DONE - instance->fade);
+		else
+			instance->fade = 0;
+		instance->previous = instance->level;
+		instance->level = (unsigned char)level;
+	}
+	else if (instance->fade < FADE_DONE)
+	{
+		fade = levels->fade_time > 0.0f ? (float)instance->fade + delta / levels->fade_time * (float)FADE_DONE : (float)FADE_DONE;
+		instance->fade = fade < (float)FADE_DONE ? (unsigned short)fade : FADE_DONE;
+	}
+	if (instance->fade == FADE_DONE)
+		instance->previous = instance->level;
+}
+
+unsigned lod_entries(const struct lod_instance* instance, unsigned object, unsigned* levels, unsigned* entries)
+{
+	const unsigned fade = instance->fade * LOD_FADE_MAX / FADE_DONE;
+	unsigned count = 0;
+
+	if (fade)
+	{
+		levels[count] = instance->level;
+		entries[count++] = object | fade << LOD_FADE_SHIFT;
+	}
+	if (fade < LOD_FADE_MAX)
+	{
+		levels[count] = instance->previous;
+		entries[count++] = object | fade << LOD_FADE_SHIFT | LOD_FADE_OUT;
+	}
+	return count;
+}
@@ -0,0 +1,67 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef LOD_H
+#define LOD_H
+
+#include "cglm/types.h"
+
+#define LOD_MAX_LEVELS 8
+#define LOD_OBJECT_MASK 0xffffffu
+#define LOD_FADE_SHIFT 24
+#define LOD_FADE_MAX 127u
+#define LOD_FADE_OUT 0x80000000u
+
+// Detail levels of a mesh, finest first. Sizes are the smallest projected
+// diameter of each level as a fraction of the screen height, the last one
+// is zero. Hysteresis widens every threshold in the direction of the
+// change so objects near a threshold do not flip every frame.
+struct lod_levels
+{
+	float sizes[LOD_MAX_LEVELS];
+	unsigned count;
+	float hysteresis;
+	float fade_time;
+};
+
+// Level of one instance. Fade goes from zero to one after a switch, the
+// previous level stays drawn until it is done.
+struct lod_instance
+{
+	unsigned char level;
+	unsigned char previous;
+	unsigned short fade;
+};
+
+void init_lod_instances(struct lod_instance* instances, unsigned count);
+
+float lod_projected_size(mat4 proj, vec3 eye, vec4 sphere);
+void update_lod(const struct lod_levels* levels, struct lod_instance* instance, float size, float delta);
+
+// Writes the levels an instance is drawn with and the packed entries for
+// their visible lists: object in the low bits, fade of the level above
+// LOD_FADE_SHIFT, LOD_FADE_OUT for the level fading out. Returns one, or
+// two during a cross-fade.
+unsigned lod_entries(const struct lod_instance* instance, unsigned object, unsigned* levels, unsigned* entries);
+
+#endif // LOD_H
@@ -24,7 +24,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define STB_IMAGE_IMPLEMENTATION
 #define SDL_MAIN_HANDLED
 #include <GL/glew.h>
 #include <SDL2/SDL.h>
@@ -33,7 +32,7 @@
 #include "cglm/cam.h"
 #include "cglm/quat.h"
 #include "common.h"
-#include "stb_image.h"
+#include "texture_manager.h"
 
 static const float cube_vertices[] =
 {
@@ -139,9 +138,6 @@ int main(int argc, char** argv)
 	glFrontFace(GL_CW);
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
-	// STB Image
-	stbi_set_flip_vertically_on_load(1);
-
 	// Vertex Buffers
 
 	unsigned vbo;
@@ -330,29 +326,8 @@ int main(int argc, char** argv)
 	glDeleteShader(fragment);
 
 	// Textures
-	unsigned texture_diffuse;
-	glGenTextures(1, &texture_diffuse);
-	glBindTexture(GL_TEXTURE_2D, texture_diffuse);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	int width, height, channels;
-	unsigned char* texture_data = stbi_load("data/textures/crate_diffuse.png", &width, &height, &channels, 0);
-	if (!texture_data)
-	{
-		error("Texture Loading Error", "Could not found file data/textures/crate_diffuse.png.");
-		SDL_GL_DeleteContext(context);
-		SDL_DestroyWindow(window);
-		SDL_Quit();
-		return 1;
-	}
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, texture_data);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	stbi_image_free(texture_data);
-	if (!validate_gl("Texture Creation Error"))
+	const unsigned texture_diffuse = load_texture("data/textures/crate_diffuse.tex");
+	if (!texture_diffuse)
 	{
 		SDL_GL_DeleteContext(context);
 		SDL_DestroyWindow(window);
@@ -360,28 +335,8 @@ int main(int argc, char** argv)
 		return 1;
 	}
 
-	unsigned texture_specular;
-	glGenTextures(1, &texture_specular);
-	glBindTexture(GL_TEXTURE_2D, texture_specular);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	texture_data = stbi_load("data/textures/crate_specular.png", &width, &height, &channels, 0);
-	if (!texture_data)
-	{
-		error("Texture Loading Error", "Could not found file data/textures/crate_specular.png.");
-		SDL_GL_DeleteContext(context);
-		SDL_DestroyWindow(window);
-		SDL_Quit();
-		return 1;
-	}
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, texture_data);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	stbi_image_free(texture_data);
-	if (!validate_gl("Texture Creation Error"))
+	const unsigned texture_specular = load_texture("data/textures/crate_specular.tex");
+	if (!texture_specular)
 	{
 		SDL_GL_DeleteContext(context);
 		SDL_DestroyWindow(window);
@@ -401,8 +356,7 @@ int main(int argc, char** argv)
 	const int uniform_light_diffuse = glGetUniformLocation(program_diffuse, "cLight.diffuse");
 	const int uniform_light_specular = glGetUniformLocation(program_diffuse, "cLight.specular");
 
-	const int uniform_model_dif = glGetUniformLocation(program_emissive, "cModel");
-	const int uniform_viewproj_dif = glGetUniformLocation(program_emissive, "cViewProj");
+	const int uniform_mvp_dif = glGetUniformLocation(program_emissive, "cModelViewProj");
 	const int uniform_color = glGetUniformLocation(program_emissive, "cColor");
 
 	glUseProgram(program_diffuse);
@@ -449,7 +403,7 @@ int main(int argc, char** argv)
 	// Rendering
 	// =====================================
 	// Matrices
-	mat4 model, model_inv, view, viewproj;
+	mat4 model, model_inv, view, viewproj, mvp;
 
 	// Projection Matrix
 	mat4 proj;
@@ -460,6 +414,14 @@ int main(int argc, char** argv)
 	versor rotation;
 	glm_quat_identity(rotation);
 
+	// Textures
+	// Nothing else samples textures, so they stay bound for the whole run
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture_diffuse);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, texture_specular);
+	glActiveTexture(GL_TEXTURE0);
+
 	SDL_Event event;
 	int run = 1;
 	float tick_delta;
@@ -506,23 +468,17 @@ int main(int argc, char** argv)
 		glUniformMatrix4fv(uniform_viewproj, 1, GL_FALSE, viewproj[0]);
 		glUniformMatrix4fv(uniform_model, 1, GL_FALSE, model[0]);
 		glUniformMatrix4fv(uniform_model_inv, 1, GL_FALSE, model_inv[0]);
-		glUniformMatrix4fv(uniform_model_inv, 1, GL_FALSE, model_inv[0]);
 		glUniform1f(uniform_shininess, cube_shininess);
 		glUniform3fv(uniform_light_position, 1, light_position);
 		glUniform3fv(uniform_light_diffuse, 1, light_diffuse);
 		glUniform3fv(uniform_light_specular, 1, light_specular);
 		glUniform3fv(uniform_ambient_color, 1, ambient_color);
 		glUniform3fv(uniform_view_pos, 1, camera_position);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, texture_diffuse);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, texture_specular);
 		glBindVertexArray(cube_vao);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
 		glDrawElements(GL_TRIANGLES, sizeof(cube_vertices) / sizeof(float), GL_UNSIGNED_INT, 0);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 		glBindVertexArray(0);
-		glBindTexture(GL_TEXTURE_2D, 0);
 
 		glm_mat4_identity(model);
 		glm_quat_rotate(model, rotation, model);
@@ -530,8 +486,8 @@ int main(int argc, char** argv)
 		glm_scale(model, light_scale);
 
 		glUseProgram(program_emissive);
-		glUniformMatrix4fv(uniform_viewproj_dif, 1, GL_FALSE, viewproj[0]);
-		glUniformMatrix4fv(uniform_model_dif, 1, GL_FALSE, model[0]);
+		glm_mat4_mul_sse2(viewproj, model, mvp);
+		glUniformMatrix4fv(uniform_mvp_dif, 1, GL_FALSE, mvp[0]);
 		glUniform3fv(uniform_color, 1, light_diffuse);
 		glBindVertexArray(lamp_vao);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
@@ -0,0 +1,187 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <GL/glew.h>
+#include <SDL_events.h>
+#include "cglm/vec3.h"
+#include "common.h"
+#include "mesh_buffer.h"
+
+int create_mesh_buffer(struct mesh_buffer* buffer, unsigned vertices, unsigned indices, unsigned meshes)
+{
+	memset(buffer, 0, sizeof(struct mesh_buffer));
+	buffer->meshes = (struct mesh*)malloc(meshes * sizeof(struct mesh));
+	buffer->meshes_capacity = meshes;
+	buffer->vertices_capacity = vertices;
+	buffer->indices_capacity = indices;
+
+	glGenVertexArrays(1, &buffer->vao);
+	glGenBuffers(1, &buffer->vbo);
+	glGenBuffers(1, &buffer->ebo);
+
+	glBindVertexArray(buffer->vao);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer->vbo);
+	glBufferData(GL_ARRAY_BUFFER, vertices * MESH_VERTEX_FLOATS * sizeof(float), NULL, GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, MESH_VERTEX_FLOATS * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, MESH_VERTEX_FLOATS * sizeof(float), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, MESH_VERTEX_FLOATS * sizeof(float), (void*)(6 * sizeof(float)));
+	glEnableVertexAttribArray(2);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer->ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices * sizeof(unsigned), NULL, GL_STATIC_DRAW);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (!validate_gl("Mesh Buffer Creation Error"))
+	{
+		destroy_mesh_buffer(buffer);
+		return 0;
+	}
+	return 1;
+}
+
+// Returns the mesh index, or -1 when the buffer is out of room
+int add_mesh(struct mesh_buffer* buffer, const float* vertices, unsigned vertices_count, const unsigned* indices, unsigned indices_count)
+{
+	struct mesh* mesh;
+
+	if (buffer->meshes_count >= buffer->meshes_capacity || buffer->vertices_count + vertices_count > buffer->vertices_capacity ||
+		buffer->indices_count + indices_count > buffer->indices_capacity)
+	{
+		error("Mesh Buffer Error", "Mesh buffer is full (%u meshes, %u vertices, %u indices).", buffer->meshes_capacity,
+			  buffer->vertices_capacity, buffer->indices_capacity);
+		return -1;
+	}
+
+	mesh = &buffer->meshes[buffer->meshes_count];
+	mesh->index_count = indices_count;
+	mesh->first_index = buffer->indices_count;
+	mesh->base_vertex = (int)buffer->vertices_count;
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffer->vbo);
+	glBufferSubData(GL_ARRAY_BUFFER, buffer->vertices_count * MESH_VERTEX_FLOATS * sizeof(float), vertices_count * MESH_VERTEX_FLOATS * sizeof(float),
+					vertices);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer->ebo);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, buffer->indices_count * sizeof(unsigned), indices_count * sizeof(unsigned), indices);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	if (!validate_gl("Mesh Buffer Error"))
+		return -1;
+
+	buffer->vertices_count += vertices_count;
+	buffer->indices_count += indices_count;
+	return (int)buffer->meshes_count++;
+}
+
+void destroy_mesh_buffer(struct mesh_buffer* buffer)
+{
+	glDeleteVertexArrays(1, &buffer->vao);
+	glDeleteBuffers(1, &buffer->ebo);
+	glDeleteBuffers(1, &buffer->vbo);
+	free(buffer->meshes);
+	memset(buffer, 0, sizeof(struct mesh_buffer));
+}
+
+unsigned add_mesh_vertex(float* vertices, unsigned* count, float x, float y, float z, const vec3 normal, float u, float v)
+{
+	float* vertex = vertices + *count * MESH_VERTEX_FLOATS;
+	vertex[0] = x;
+	vertex[1] = y;
+	vertex[2] = z;
+	glm_vec3_copy((float*)normal, vertex + 3);
+	vertex[6] = u;
+	vertex[7] = v;
+	return (*count)++;
+}
+
+void add_mesh_triangle(unsigned* indices, unsigned* count, const float* vertices, unsigned a, unsigned b, unsigned c)
+{
+	vec3 ab, ac, cross;
+	glm_vec3_sub((float*)vertices + b * MESH_VERTEX_FLOATS, (float*)vertices + a * MESH_VERTEX_FLOATS, ab);
+	glm_vec3_sub((float*)vertices + c * MESH_VERTEX_FLOATS, (float*)vertices + a * MESH_VERTEX_FLOATS, ac);
+	glm_vec3_cross(ab, ac, cross);
+	indices[(*count)++] = a;
+	if (glm_vec3_dot(cross, (float*)vertices + a * MESH_VERTEX_FLOATS + 3) > 0.0f)
+	{
+		indices[(*count)++] = c;
+		indices[(*count)++] = b;
+	}
+	else
+	{
+		indices[(*count)++] = b;
+		indices[(*count)++] = c;
+	}
+}
+
+void build_prism_mesh(float* vertices, unsigned* vertices_count, unsigned* indices, unsigned* indices_count, unsigned sides)
+{
+	const vec3 up = { 0.0f, 1.0f, 0.0f };
+	const vec3 down = { 0.0f, -1.0f, 0.0f };
+	float angle0, angle1, x0, z0, x1, z1;
+	unsigned side, first, top, bottom;
+	vec3 normal;
+
+	*vertices_count = 0;
+	*indices_count = 0;
+	for (side = 0; side < sides; ++side)
+	{
+		angle0 = GLM_PIf * 2.0f * side / sides;
+		angle1 = GLM_PIf * 2.0f * (side + 1) / sides;
+		x0 = cosf(angle0) * 0.5f;
+		z0 = sinf(angle0) * 0.5f;
+		x1 = cosf(angle1) * 0.5f;
+		z1 = sinf(angle1) * 0.5f;
+		normal[0] = cosf((angle0 + angle1) * 0.5f);
+		normal[1] = 0.0f;
+		normal[2] = sinf((angle0 + angle1) * 0.5f);
+
+		first = add_mesh_vertex(vertices, vertices_count, x0, -0.5f, z0, normal, (float)side / sides, 0.0f);
+		add_mesh_vertex(vertices, vertices_count, x1, -0.5f, z1, normal, (float)(side + 1) / sides, 0.0f);
+		add_mesh_vertex(vertices, vertices_count, x1, 0.5f, z1, normal, (float)(side + 1) / sides, 1.0f);
+		add_mesh_vertex(vertices, vertices_count, x0, 0.5f, z0, normal, (float)side / sides, 1.0f);
+		add_mesh_triangle(indices, indices_count, vertices, first, first + 1, first + 2);
+		add_mesh_triangle(indices, indices_count, vertices, first + 2, first + 3, first);
+	}
+
+	top = add_mesh_vertex(vertices, vertices_count, 0.0f, 0.5f, 0.0f, up, 0.5f, 0.5f);
+	bottom = add_mesh_vertex(vertices, vertices_count, 0.0f, -0.5f, 0.0f, down, 0.5f, 0.5f);
+	first = *vertices_count;
+	for (side = 0; side < sides; ++side)
+	{
+		angle0 = GLM_PIf * 2.0f * side / sides;
+		x0 = cosf(angle0);
+		z0 = sinf(angle0);
+		add_mesh_vertex(vertices, vertices_count, x0 * 0.5f, 0.5f, z0 * 0.5f, up, 0.5f + x0 * 0.5f, 0.5f + z0 * 0.5f);
+		add_mesh_vertex(vertices, vertices_count, x0 * 0.5f, -0.5f, z0 * 0.5f, down, 0.5f + x0 * 0.5f, 0.5f + z0 * 0.5f);
+	}
+	for (side = 0; side < sides; ++side)
+	{
+		const unsigned next = (side + 1) % sides;
+		add_mesh_triangle(indices, indices_count, vertices, top, first + side * 2, first + next * 2);
+		add_mesh_triangle(indices, indices_count, vertices, bottom, first + side * 2 + 1, first + next * 2 + 1);
+	}
+}
@@ -0,0 +1,72 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef MESH_BUFFER_H
+#define MESH_BUFFER_H
+
+#include "cglm/types.h"
+
+// Vertices are position, normal and texture coordinates, as in the samples
+#define MESH_VERTEX_FLOATS 8
+
+// Where a mesh lives inside its mesh buffer
+struct mesh
+{
+	unsigned index_count;
+	unsigned first_index;
+	int base_vertex;
+};
+
+// One vertex and one index buffer shared by many meshes, so that every
+// mesh draws from the same VAO and indices stay relative to the mesh
+// (drawn with a base vertex).
+struct mesh_buffer
+{
+	struct mesh* meshes;
+	unsigned vao;
+	unsigned vbo;
+	unsigned ebo;
+	unsigned meshes_count;
+	unsigned meshes_capacity;
+	unsigned vertices_count;
+	unsigned vertices_capacity;
+	unsigned indices_count;
+	unsigned indices_capacity;
+};
+
+int create_mesh_buffer(struct mesh_buffer* buffer, unsigned vertices, unsigned indices, unsigned meshes);
+int add_mesh(struct mesh_buffer* buffer, const float* vertices, unsigned vertices_count, const unsigned* indices, unsigned indices_count);
+void destroy_mesh_buffer(struct mesh_buffer* buffer);
+
+// Mesh building on the CPU. Both append to their array and advance count,
+// add_mesh_vertex returns the index of the new vertex. Front faces are
+// clockwise (glFrontFace(GL_CW)), add_mesh_triangle fixes the winding from
+// the normal of vertex a.
+unsigned add_mesh_vertex(float* vertices, unsigned* count, float x, float y, float z, const vec3 normal, float u, float v);
+void add_mesh_triangle(unsigned* indices, unsigned* count, const float* vertices, unsigned a, unsigned b, unsigned c);
+
+// Unit high prism around the Y axis with flat shaded sides and caps, takes
+// sides * 6 + 2 vertices and sides * 12 indices
+void build_prism_mesh(float* vertices, unsigned* vertices_count, unsigned* indices, unsigned* indices_count, unsigned sides);
+
+#endif // MESH_BUFFER_H
@@ -0,0 +1,328 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cglm/util.h"
+#include "jobs.h"
+#include "mipmap.h"
+#include "simd.h"
+
+#define BOX_TAPS 2
+#define KAISER_TAPS 8
+#define KAISER_ALPHA 4.0
+#define SRGB_TABLE_SIZE 4096
+#define ROWS_PER_JOB 8
+#define COVERAGE_ITERATIONS 10
+#define COVERAGE_MAX_SCALE 4.0f
+
+// Images are filtered as four float channels per pixel so that one pixel is
+// one SSE register and two pixels are one AVX register, whatever the source
+// channel count is. Levels are produced from the previous float level, not
+// from quantised bytes.
+struct mip_job
+{
+	const float* src;
+	float* dest;
+	unsigned src_width;
+	unsigned src_height;
+	unsigned dest_width;
+	const float* weights;
+	unsigned taps;
+};
+
+struct convert_job
+{
+	unsigned char* bytes;
+	float* pixels;
+	unsigned width;
+	unsigned channels;
+	unsigned flags;
+	float alpha_scale;
+};
+
+static float srgb_to_linear[256];
+static unsigned char linear_to_srgb[SRGB_TABLE_SIZE + 1];
+static int tables_ready;
+
+static void init_tables(void)
+{
+	double value;
+	unsigned i;
+
+	if (tables_ready)
+		return;
+	for (i = 0; i < 256; ++i)
+	{
+		value = i / 255.0;
+		srgb_to_linear[i] = (float)(value <= 0.04045 ? value / 12.92 : pow((value + 0.055) / 1.055, 2.4));
+	}
+	for (i = 0; i <= SRGB_TABLE_SIZE; ++i)
+	{
+		value = (double)i / SRGB_TABLE_SIZE;
+		value = value <= 0.0031308 ? value * 12.92 : 1.055 * pow(value, 1.0 / 2.4) - 0.055;
+		linear_to_srgb[i] = (unsigned char)(value * 255.0 + 0.5);
+	}
+	tables_ready = 1;
+}
+
+// Weights for a 2:1 decimation, tap k sits (k - taps / 2 + 0.5) source
+// pixels away from the destination pixel centre
+static void init_weights(float* weights, unsigned taps, unsigned filter)
+{
+	const double radius = taps / 2;
+	double distance, x, window, bessel, term, total = 0.0;
+	unsigned k, n;
+
+	for (k = 0; k < taps; ++k)
+	{
+		if (filter == MIPMAP_FILTER_BOX)
+		{
+			weights[k] = 1.0f / taps;
+			continue;
+		}
+
+		distance = k - radius + 0.5;
+		x = distance / 2.0;
+		weights[k] = (float)(sin(GLM_PI * x) / (GLM_PI * x));
+
+		// Kaiser window, I0 by its power series
+		window = KAISER_ALPHA * sqrt(1.0 - (distance / radius) * (distance / radius));
+		bessel = 1.0;
+		term = 1.0;
+		for (n = 1; n < 16; ++n)
+		{
+			term *= (window / (2.0 * n)) * (window / (2.0 * n));
+			bessel += term;
+		}
+		window = bessel;
+		bessel = 1.0;
+		term = 1.0;
+		for (n = 1; n < 16; ++n)
+		{
+			term *= (KAISER_ALPHA / (2.0 * n)) * (KAISER_ALPHA / (2.0 * n));
+			bessel += term;
+		}
+		weights[k] *= (float)(window / bessel);
+		total += weights[k];
+	}
+	if (filter != MIPMAP_FILTER_BOX)
+		for (k = 0; k < taps; ++k)
+			weights[k] = (float)(weights[k] / total);
+}
+
+static void downsample_rows(void* data, unsigned begin, unsigned end)
+{
+	const struct mip_job* job = (const struct mip_job*)data;
+	const unsigned before = job->taps / 2 - 1;
+	const unsigned padded_width = job->src_width + job->taps + 1;
+	const float* rows[KAISER_TAPS];
+	float* padded = (float*)malloc(padded_width * 4 * sizeof(float));
+	float* row = padded + before * 4;
+	unsigned y, k, x;
+	int source;
+
+	for (y = begin; y < end; ++y)
+	{
+		for (k = 0; k < job->taps; ++k)
+		{
+			source = (int)(y * 2 + k) - (int)before;
+			source = source < 0 ? 0 : source >= (int)job->src_height ? (int)job->src_height - 1 : source;
+			rows[k] = job->src + (unsigned)source * job->src_width * 4;
+		}
+		simd_filter_rows(row, rows, job->weights, job->taps, job->src_width * 4);
+
+		for (x = 0; x < before; ++x)
+			memcpy(padded + x * 4, row, 4 * sizeof(float));
+		for (x = before + job->src_width; x < padded_width; ++x)
+			memcpy(padded + x * 4, row + (job->src_width - 1) * 4, 4 * sizeof(float));
+
+		simd_filter_columns(job->dest + y * job->dest_width * 4, padded, job->weights, job->taps, job->dest_width);
+	}
+	free(padded);
+}
+
+// =====================================
+// Conversion
+// =====================================
+
+static void expand_rows(void* data, unsigned begin, unsigned end)
+{
+	const struct convert_job* job = (const struct convert_job*)data;
+	const int srgb = job->flags & MIPMAP_SRGB;
+	const unsigned char* src;
+	float* dest;
+	unsigned i, c;
+
+	for (i = begin * job->width; i < end * job->width; ++i)
+	{
+		src = job->bytes + i * job->channels;
+		dest = job->pixels + i * 4;
+		for (c = 0; c < 3; ++c)
+		{
+			const unsigned char value = src[job->channels >= 3 ? c : 0];
+			dest[c] = srgb ? srgb_to_linear[value] : value * (1.0f / 255.0f);
+		}
+		dest[3] = job->channels == 2 || job->channels == 4 ? src[job->channels - 1] * (1.0f / 255.0f) : 1.0f;
+	}
+}
+
+static void pack_rows(void* data, unsigned begin, unsigned end)
+{
+	const struct convert_job* job = (const struct convert_job*)data;
+	const int srgb = job->flags & MIPMAP_SRGB;
+	const unsigned colors = job->channels >= 3 ? 3 : 1;
+	unsigned char* dest;
+	const float* src;
+	float value;
+	unsigned i, c;
+
+	for (i = begin * job->width; i < end * job->width; ++i)
+	{
+		src = job->pixels + i * 4;
+		dest = job->bytes + i * job->channels;
+		for (c = 0; c < colors; ++c)
+		{
+			value = glm_clamp(src[c], 0.0f, 1.0f);
+			dest[c] = srgb ? linear_to_srgb[(unsigned)(value * SRGB_TABLE_SIZE + 0.5f)] : (unsigned char)(value * 255.0f + 0.5f);
+		}
+		if (job->channels == 2 || job->channels == 4)
+			dest[job->channels - 1] = (unsigned char)(glm_clamp(src[3] * job->alpha_scale, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+}
+
+// =====================================
+// Alpha Coverage
+// =====================================
+
+static float alpha_coverage(const float* pixels, unsigned count, float scale, float reference)
+{
+	unsigned covered = 0, i;
+	for (i = 0; i < count; ++i)
+		if (pixels[i * 4 + 3] * scale > reference)
+			++covered;
+	return (float)covered / (float)count;
+}
+
+// Scale that keeps the fraction of pixels passing the alpha test the same
+// as in the top level, so alpha tested foliage does not thin out with distance
+static float alpha_coverage_scale(const float* pixels, unsigned count, float target, float reference)
+{
+	float low = 0.0f, high = COVERAGE_MAX_SCALE, scale = 1.0f;
+	unsigned i;
+
+	for (i = 0; i < COVERAGE_ITERATIONS; ++i)
+	{
+		scale = (low + high) * 0.5f;
+		if (alpha_coverage(pixels, count, scale, reference) < target)
+			low = scale;
+		else
+			high = scale;
+	}
+	return scale;
+}
+
+// =====================================
+// Mipmaps
+// =====================================
+
+unsigned mipmap_levels(unsigned width, unsigned height)
+{
+	unsigned levels = 1;
+	while ((width | height) >> levels)
+		++levels;
+	return levels;
+}
+
+unsigned mipmap_chain_size(unsigned width, unsigned height, unsigned channels)
+{
+	const unsigned levels = mipmap_levels(width, height);
+	unsigned size = 0, level;
+	for (level = 0; level < levels; ++level)
+		size += (width >> level ? width >> level : 1) * (height >> level ? height >> level : 1) * channels;
+	return size;
+}
+
+unsigned generate_mipmaps(unsigned char* chain, const unsigned char* image, unsigned width, unsigned height, unsigned channels,
+						  unsigned filter, unsigned flags, float alpha_reference)
+{
+	const unsigned levels = mipmap_levels(width, height);
+	const unsigned taps = filter == MIPMAP_FILTER_KAISER ? KAISER_TAPS : BOX_TAPS;
+	float weights[KAISER_TAPS];
+	struct convert_job convert;
+	struct mip_job job;
+	float *src, *dest, *swap;
+	float coverage = 0.0f;
+	unsigned level, dest_height;
+
+	init_tables();
+	init_weights(weights, taps, filter);
+	if (channels != 2 && channels != 4)
+		flags &= ~MIPMAP_ALPHA_COVERAGE;
+
+	memcpy(chain, image, width * height * channels);
+	src = (float*)malloc(width * height * 4 * sizeof(float));
+	dest = (float*)malloc((width / 2 + 1) * (height / 2 + 1) * 4 * sizeof(float));
+
+	convert.bytes = chain;
+	convert.pixels = src;
+	convert.width = width;
+	convert.channels = channels;
+	convert.flags = flags;
+	convert.alpha_scale = 1.0f;
+	jobs_parallel_for(expand_rows, &convert, height, ROWS_PER_JOB);
+	if (flags & MIPMAP_ALPHA_COVERAGE)
+		coverage = alpha_coverage(src, width * height, 1.0f, alpha_reference);
+
+	job.weights = weights;
+	job.taps = taps;
+	job.src_width = width;
+	job.src_height = height;
+	for (level = 1; level < levels; ++level)
+	{
+		chain += job.src_width * job.src_height * channels;
+		job.src = src;
+		job.dest = dest;
+		job.dest_width = job.src_width > 1 ? job.src_width / 2 : 1;
+		dest_height = job.src_height > 1 ? job.src_height / 2 : 1;
+		jobs_parallel_for(downsample_rows, &job, dest_height, ROWS_PER_JOB);
+
+		convert.bytes = chain;
+		convert.pixels = dest;
+		convert.width = job.dest_width;
+		if (flags & MIPMAP_ALPHA_COVERAGE)
+			convert.alpha_scale = alpha_coverage_scale(dest, job.dest_width * dest_height, coverage, alpha_reference);
+		jobs_parallel_for(pack_rows, &convert, dest_height, ROWS_PER_JOB);
+
+		swap = src;
+		src = dest;
+		dest = swap;
+		job.src_width = job.dest_width;
+		job.src_height = dest_height;
+	}
+
+	free(dest);
+	free(src);
+	return levels;
+}
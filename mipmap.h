@@ -0,0 +1,41 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef MIPMAP_H
+#define MIPMAP_H
+
+#define MIPMAP_FILTER_BOX 0
+#define MIPMAP_FILTER_KAISER 1
+
+#define MIPMAP_SRGB 0x0001
+#define MIPMAP_ALPHA_COVERAGE 0x0002
+
+unsigned mipmap_levels(unsigned width, unsigned height);
+unsigned mipmap_chain_size(unsigned width, unsigned height, unsigned channels);
+
+// Writes the whole chain, level 0 included, tightly packed largest first.
+// Returns the number of levels.
+unsigned generate_mipmaps(unsigned char* chain, const unsigned char* image, unsigned width, unsigned height, unsigned channels,
+						  unsigned filter, unsigned flags, float alpha_reference);
+
+#endif // MIPMAP_H
@@ -0,0 +1,375 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL_atomic.h>
+#include <SDL_events.h>
+#include "cglm/mat4.h"
+#include "common.h"
+#include "jobs.h"
+#include "occlusion.h"
+#include "simd.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define LANES 4
+#else
+#define LANES 1
+#endif
+
+#define NEAR_W 0.0001f
+#define OBJECTS_PER_JOB 256
+
+struct cull_job
+{
+	struct occlusion_buffer* buffer;
+	const vec4* spheres;
+	unsigned char* visible;
+	SDL_atomic_t culled;
+};
+
+int create_occlusion_buffer(struct occlusion_buffer* buffer, unsigned max_triangles)
+{
+	memset(buffer, 0, sizeof(struct occlusion_buffer));
+	buffer->depth = (float*)malloc(OCCLUSION_WIDTH * OCCLUSION_HEIGHT * sizeof(float));
+	buffer->triangles = (struct occluder_triangle*)malloc(max_triangles * sizeof(struct occluder_triangle));
+	buffer->bins = (unsigned*)malloc(OCCLUSION_TILES * max_triangles * sizeof(unsigned));
+	buffer->triangles_capacity = max_triangles;
+	if (!buffer->depth || !buffer->triangles || !buffer->bins)
+	{
+		error("Occlusion Error", "Could not allocate an occlusion buffer for %u triangles.", max_triangles);
+		destroy_occlusion_buffer(buffer);
+		return 0;
+	}
+	return 1;
+}
+
+void destroy_occlusion_buffer(struct occlusion_buffer* buffer)
+{
+	free(buffer->bins);
+	free(buffer->triangles);
+	free(buffer->depth);
+	memset(buffer, 0, sizeof(struct occlusion_buffer));
+}
+
+void begin_occlusion(struct occlusion_buffer* buffer, mat4 viewproj)
+{
+	glm_mat4_copy(viewproj, buffer->viewproj);
+	memset(buffer->bin_sizes, 0, sizeof(buffer->bin_sizes));
+	buffer->triangles_count = 0;
+}
+
+// Expects a counter clockwise triangle in buffer coordinates and its doubled area
+static int setup_triangle(struct occluder_triangle* triangle, const float* x, const float* y, const float* z, float area)
+{
+	unsigned i, next;
+
+	for (i = 0; i < 3; ++i)
+	{
+		next = (i + 1) % 3;
+		triangle->edges[i][0] = y[i] - y[next];
+		triangle->edges[i][1] = x[next] - x[i];
+		triangle->edges[i][2] = x[i] * y[next] - y[i] * x[next];
+	}
+	triangle->depth[0] = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+	triangle->depth[1] = ((x[1] - x[0]) * (z[2] - z[0]) - (x[2] - x[0]) * (z[1] - z[0])) / area;
+	triangle->depth[2] = z[0] - triangle->depth[0] * x[0] - triangle->depth[1] * y[0];
+
+	// Pixels whose centre may be inside
+	triangle->min_x = (int)ceilf(fminf(x[0], fminf(x[1], x[2])) - 0.5f);
+	triangle->min_y = (int)ceilf(fminf(y[0], fminf(y[1], y[2])) - 0.5f);
+	triangle->max_x = (int)floorf(fmaxf(x[0], fmaxf(x[1], x[2])) - 0.5f);
+	triangle->max_y = (int)floorf(fmaxf(y[0], fmaxf(y[1], y[2])) - 0.5f);
+	triangle->min_x = triangle->min_x > 0 ? triangle->min_x : 0;
+	triangle->min_y = triangle->min_y > 0 ? triangle->min_y : 0;
+	triangle->max_x = triangle->max_x < OCCLUSION_WIDTH - 1 ? triangle->max_x : OCCLUSION_WIDTH - 1;
+	triangle->max_y = triangle->max_y < OCCLUSION_HEIGHT - 1 ? triangle->max_y : OCCLUSION_HEIGHT - 1;
+	return triangle->min_x <= triangle->max_x && triangle->min_y <= triangle->max_y;
+}
+
+// Positions are the first three floats of every vertex, stride is in floats.
+// Returns 0 when the buffer is full, the rest of the occluder is dropped.
+int add_occluder(struct occlusion_buffer* buffer, const float* vertices, unsigned stride,
+				 const unsigned* indices, unsigned indices_count, mat4 model)
+{
+	struct occluder_triangle* triangle;
+	float x[3], y[3], z[3], area, swap;
+	vec4 position, clip;
+	unsigned i, j, tile_x, tile_y, tile;
+	mat4 mvp;
+
+	glm_mat4_mul(buffer->viewproj, model, mvp);
+	for (i = 0; i + 2 < indices_count; i += 3)
+	{
+		for (j = 0; j < 3; ++j)
+		{
+			glm_vec4((float*)vertices + indices[i + j] * stride, 1.0f, position);
+			glm_mat4_mulv(mvp, position, clip);
+			if (clip[3] < NEAR_W)
+				break;
+			x[j] = (clip[0] / clip[3] * 0.5f + 0.5f) * OCCLUSION_WIDTH;
+			y[j] = (clip[1] / clip[3] * 0.5f + 0.5f) * OCCLUSION_HEIGHT;
+			z[j] = clip[2] / clip[3] * 0.5f + 0.5f;
+		}
+		if (j < 3)
+			continue;
+
+		// Front faces are clockwise, which is a negative area with y pointing up
+		area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+		if (area >= 0.0f)
+			continue;
+		swap = x[1], x[1] = x[2], x[2] = swap;
+		swap = y[1], y[1] = y[2], y[2] = swap;
+		swap = z[1], z[1] = z[2], z[2] = swap;
+
+		if (buffer->triangles_count >= buffer->triangles_capacity)
+			return 0;
+		triangle = &buffer->triangles[buffer->triangles_count];
+		if (!setup_triangle(triangle, x, y, z, -area))
+			continue;
+
+		for (tile_y = (unsigned)triangle->min_y / OCCLUSION_TILE_SIZE; tile_y <= (unsigned)triangle->max_y / OCCLUSION_TILE_SIZE; ++tile_y)
+			for (tile_x = (unsigned)triangle->min_x / OCCLUSION_TILE_SIZE; tile_x <= (unsigned)triangle->max_x / OCCLUSION_TILE_SIZE; ++tile_x)
+			{
+				tile = tile_y * OCCLUSION_TILES_X + tile_x;
+				buffer->bins[tile * buffer->triangles_capacity + buffer->bin_sizes[tile]++] = buffer->triangles_count;
+			}
+		++buffer->triangles_count;
+	}
+	return 1;
+}
+
+static void rasterize_tiles(void* data, unsigned begin, unsigned end)
+{
+	struct occlusion_buffer* buffer = (struct occlusion_buffer*)data;
+	const unsigned* bin;
+	unsigned tile, i;
+	int tile_x, tile_y, x, y;
+	float* row;
+#if defined(__SSE2__)
+	const __m128 far = _mm_set1_ps(1.0f);
+	__m128 farthest;
+	float lanes[4];
+#else
+	float farthest;
+#endif
+
+	for (tile = begin; tile < end; ++tile)
+	{
+		tile_x = (int)(tile % OCCLUSION_TILES_X) * OCCLUSION_TILE_SIZE;
+		tile_y = (int)(tile / OCCLUSION_TILES_X) * OCCLUSION_TILE_SIZE;
+		for (y = tile_y; y < tile_y + OCCLUSION_TILE_SIZE; ++y)
+		{
+			row = buffer->depth + y * OCCLUSION_WIDTH;
+			for (x = tile_x; x < tile_x + OCCLUSION_TILE_SIZE; x += LANES)
+#if defined(__SSE2__)
+				_mm_storeu_ps(row + x, far);
+#else
+				row[x] = 1.0f;
+#endif
+		}
+
+		bin = buffer->bins + tile * buffer->triangles_capacity;
+		for (i = 0; i < buffer->bin_sizes[tile]; ++i)
+			simd_occlusion_rasterize(buffer->depth, &buffer->triangles[bin[i]], tile_x, tile_y);
+
+#if defined(__SSE2__)
+		farthest = _mm_setzero_ps();
+#else
+		farthest = 0.0f;
+#endif
+		for (y = tile_y; y < tile_y + OCCLUSION_TILE_SIZE; ++y)
+		{
+			row = buffer->depth + y * OCCLUSION_WIDTH;
+			for (x = tile_x; x < tile_x + OCCLUSION_TILE_SIZE; x += LANES)
+#if defined(__SSE2__)
+				farthest = _mm_max_ps(farthest, _mm_loadu_ps(row + x));
+#else
+				farthest = fmaxf(farthest, row[x]);
+#endif
+		}
+#if defined(__SSE2__)
+		_mm_storeu_ps(lanes, farthest);
+#endif
+#if LANES > 1
+		buffer->tile_depth[tile] = lanes[0];
+		for (i = 1; i < LANES; ++i)
+			buffer->tile_depth[tile] = fmaxf(buffer->tile_depth[tile], lanes[i]);
+#else
+		buffer->tile_depth[tile] = farthest;
+#endif
+	}
+}
+
+void rasterize_occluders(struct occlusion_buffer* buffer)
+{
+	jobs_parallel_for(rasterize_tiles, buffer, OCCLUSION_TILES, 1);
+}
+
+// Tests the pixels touched by the screen rectangle of the sphere's bounding
+// box against the nearest depth of the box. Corners are the clip position
+// of the centre plus or minus the clip space box axes.
+static int sphere_occluded(struct occlusion_buffer* buffer, const float* sphere)
+{
+	float min_x, min_y, max_x, max_y, min_z;
+	int first_x, first_y, last_x, last_y, tile_x, tile_y, from_x, to_x, from_y, to_y, x, y;
+	const float* row;
+	unsigned i, axis;
+	vec4 center, clip;
+#if defined(__SSE2__)
+	const __m128 offsets = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+	const __m128 radius = _mm_set1_ps(sphere[3]);
+	__m128 axes[3], corner, w, low, high, closest;
+	__m128 first, last, nearest, px, behind;
+	float bounds[8];
+#else
+	float corner[4];
+#endif
+
+	glm_vec4((float*)sphere, 1.0f, center);
+	glm_mat4_mulv(buffer->viewproj, center, clip);
+#if defined(__SSE2__)
+	for (axis = 0; axis < 3; ++axis)
+		axes[axis] = _mm_mul_ps(_mm_loadu_ps(buffer->viewproj[axis]), radius);
+	low = _mm_set1_ps(FLT_MAX);
+	high = _mm_set1_ps(-FLT_MAX);
+	closest = _mm_set1_ps(FLT_MAX);
+	for (i = 0; i < 8; ++i)
+	{
+		corner = _mm_loadu_ps(clip);
+		for (axis = 0; axis < 3; ++axis)
+			corner = i & (1 << axis) ? _mm_add_ps(corner, axes[axis]) : _mm_sub_ps(corner, axes[axis]);
+		w = _mm_shuffle_ps(corner, corner, _MM_SHUFFLE(3, 3, 3, 3));
+		closest = _mm_min_ps(closest, w);
+		corner = _mm_div_ps(corner, w);
+		low = _mm_min_ps(low, corner);
+		high = _mm_max_ps(high, corner);
+	}
+	if (_mm_movemask_ps(_mm_cmplt_ps(closest, _mm_set1_ps(NEAR_W))))
+		return 0;
+	_mm_storeu_ps(bounds, low);
+	_mm_storeu_ps(bounds + 4, high);
+	min_x = bounds[0];
+	min_y = bounds[1];
+	min_z = bounds[2] * 0.5f + 0.5f;
+	max_x = bounds[4];
+	max_y = bounds[5];
+#else
+	min_x = min_y = min_z = FLT_MAX;
+	max_x = max_y = -FLT_MAX;
+	for (i = 0; i < 8; ++i)
+	{
+		for (x = 0; x < 4; ++x)
+		{
+			corner[x] = clip[x];
+			for (axis = 0; axis < 3; ++axis)
+				corner[x] += i & (1 << axis) ? buffer->viewproj[axis][x] * sphere[3] : -buffer->viewproj[axis][x] * sphere[3];
+		}
+		if (corner[3] < NEAR_W)
+			return 0;
+		min_x = fminf(min_x, corner[0] / corner[3]);
+		min_y = fminf(min_y, corner[1] / corner[3]);
+		min_z = fminf(min_z, corner[2] / corner[3]);
+		max_x = fmaxf(max_x, corner[0] / corner[3]);
+		max_y = fmaxf(max_y, corner[1] / corner[3]);
+	}
+	min_z = min_z * 0.5f + 0.5f;
+#endif
+	if (max_x < -1.0f || min_x > 1.0f || max_y < -1.0f || min_y > 1.0f)
+		return 0;
+
+	first_x = (int)floorf((fmaxf(min_x, -1.0f) * 0.5f + 0.5f) * OCCLUSION_WIDTH);
+	first_y = (int)floorf((fmaxf(min_y, -1.0f) * 0.5f + 0.5f) * OCCLUSION_HEIGHT);
+	last_x = (int)floorf((fminf(max_x, 1.0f) * 0.5f + 0.5f) * OCCLUSION_WIDTH);
+	last_y = (int)floorf((fminf(max_y, 1.0f) * 0.5f + 0.5f) * OCCLUSION_HEIGHT);
+	last_x = last_x < OCCLUSION_WIDTH - 1 ? last_x : OCCLUSION_WIDTH - 1;
+	last_y = last_y < OCCLUSION_HEIGHT - 1 ? last_y : OCCLUSION_HEIGHT - 1;
+#if defined(__SSE2__)
+	nearest = _mm_set1_ps(min_z);
+#endif
+
+	for (tile_y = first_y / OCCLUSION_TILE_SIZE; tile_y <= last_y / OCCLUSION_TILE_SIZE; ++tile_y)
+		for (tile_x = first_x / OCCLUSION_TILE_SIZE; tile_x <= last_x / OCCLUSION_TILE_SIZE; ++tile_x)
+		{
+			// Every pixel of the tile is in front of the object
+			if (buffer->tile_depth[tile_y * OCCLUSION_TILES_X + tile_x] <= min_z)
+				continue;
+
+			from_x = first_x > tile_x * OCCLUSION_TILE_SIZE ? first_x : tile_x * OCCLUSION_TILE_SIZE;
+			to_x = last_x < (tile_x + 1) * OCCLUSION_TILE_SIZE - 1 ? last_x : (tile_x + 1) * OCCLUSION_TILE_SIZE - 1;
+			from_y = first_y > tile_y * OCCLUSION_TILE_SIZE ? first_y : tile_y * OCCLUSION_TILE_SIZE;
+			to_y = last_y < (tile_y + 1) * OCCLUSION_TILE_SIZE - 1 ? last_y : (tile_y + 1) * OCCLUSION_TILE_SIZE - 1;
+			for (y = from_y; y <= to_y; ++y)
+			{
+				row = buffer->depth + y * OCCLUSION_WIDTH;
+#if defined(__SSE2__)
+				first = _mm_set1_ps((float)from_x);
+				last = _mm_set1_ps((float)to_x);
+				for (x = from_x & ~3; x <= to_x; x += 4)
+				{
+					px = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+					behind = _mm_and_ps(_mm_cmpgt_ps(_mm_loadu_ps(row + x), nearest),
+										_mm_and_ps(_mm_cmpge_ps(px, first), _mm_cmple_ps(px, last)));
+					if (_mm_movemask_ps(behind))
+						return 0;
+				}
+#else
+				for (x = from_x; x <= to_x; ++x)
+					if (row[x] > min_z)
+						return 0;
+#endif
+			}
+		}
+	return 1;
+}
+
+static void cull_spheres(void* data, unsigned begin, unsigned end)
+{
+	struct cull_job* job = (struct cull_job*)data;
+	unsigned i, culled = 0;
+
+	for (i = begin; i < end; ++i)
+		if (job->visible[i] && sphere_occluded(job->buffer, job->spheres[i]))
+		{
+			job->visible[i] = 0;
+			++culled;
+		}
+	SDL_AtomicAdd(&job->culled, (int)culled);
+}
+
+// Clears visible[i] of every visible sphere hidden by the occluders and
+// returns how many were hidden. Spheres are centre and radius.
+unsigned cull_occluded(struct occlusion_buffer* buffer, const vec4* spheres, unsigned count, unsigned char* visible)
+{
+	struct cull_job job;
+
+	job.buffer = buffer;
+	job.spheres = spheres;
+	job.visible = visible;
+	SDL_AtomicSet(&job.culled, 0);
+	jobs_parallel_for(cull_spheres, &job, count, OBJECTS_PER_JOB);
+	return (unsigned)SDL_AtomicGet(&job.culled);
+}
@@ -0,0 +1,81 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+#include "cglm/types.h"
+
+#define OCCLUSION_WIDTH 256
+#define OCCLUSION_HEIGHT 128
+#define OCCLUSION_TILE_SIZE 32
+#define OCCLUSION_TILES_X (OCCLUSION_WIDTH / OCCLUSION_TILE_SIZE)
+#define OCCLUSION_TILES_Y (OCCLUSION_HEIGHT / OCCLUSION_TILE_SIZE)
+#define OCCLUSION_TILES (OCCLUSION_TILES_X * OCCLUSION_TILES_Y)
+
+// Edge functions and depth are planes over the buffer: a * x + b * y + c,
+// edges are positive inside. Bounds are inclusive pixel coordinates.
+// Rasterized by simd_occlusion_rasterize().
+struct occluder_triangle
+{
+	float edges[3][3];
+	float depth[3];
+	int min_x;
+	int min_y;
+	int max_x;
+	int max_y;
+};
+
+// Software occlusion culling for drivers without compute shaders. A few
+// large occluder meshes are rasterized on the CPU into a small depth
+// buffer, tile by tile on the job threads, then objects are tested against
+// it before anything is submitted.
+//
+// Per frame: begin_occlusion(), add_occluder() for every occluder,
+// rasterize_occluders(), then any number of cull_occluded().
+//
+// Triangles crossing the camera plane are dropped rather than clipped and
+// pixels count as covered only when their centre is inside, so occluders
+// come out slightly smaller than they are and never hide visible objects.
+struct occlusion_buffer
+{
+	mat4 viewproj;
+	float* depth;
+	float tile_depth[OCCLUSION_TILES];
+	struct occluder_triangle* triangles;
+	unsigned* bins;
+	unsigned bin_sizes[OCCLUSION_TILES];
+	unsigned triangles_count;
+	unsigned triangles_capacity;
+};
+
+int create_occlusion_buffer(struct occlusion_buffer* buffer, unsigned max_triangles);
+void destroy_occlusion_buffer(struct occlusion_buffer* buffer);
+
+void begin_occlusion(struct occlusion_buffer* buffer, mat4 viewproj);
+int add_occluder(struct occlusion_buffer* buffer, const float* vertices, unsigned stride,
+				 const unsigned* indices, unsigned indices_count, mat4 model);
+void rasterize_occluders(struct occlusion_buffer* buffer);
+unsigned cull_occluded(struct occlusion_buffer* buffer, const vec4* spheres, unsigned count, unsigned char* visible);
+
+#endif // OCCLUSION_H
@@ -0,0 +1,132 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <string.h>
+#include "cglm/affine.h"
+#include "cglm/mat4.h"
+#include "cglm/quat.h"
+#include "packed_instance.h"
+
+void pack_instance(struct packed_instance* instance, mat4 model)
+{
+	mat4 rotation;
+
+	instance->scale = glm_vec3_norm(model[0]);
+	glm_mat4_copy(model, rotation);
+	glm_vec3_scale(model[0], 1.0f / instance->scale, rotation[0]);
+	glm_vec3_scale(model[1], 1.0f / instance->scale, rotation[1]);
+	glm_vec3_scale(model[2], 1.0f / instance->scale, rotation[2]);
+	glm_mat4_quat(rotation, instance->rotation);
+	glm_vec3_copy(model[3], instance->position);
+}
+
+void pack_instances_half(struct packed_instance_half* packed, const struct packed_instance* instances, unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; ++i)
+	{
+		packed[i].rotation[0] = float_to_half(instances[i].rotation[0]);
+		packed[i].rotation[1] = float_to_half(instances[i].rotation[1]);
+		packed[i].rotation[2] = float_to_half(instances[i].rotation[2]);
+		packed[i].rotation[3] = float_to_half(instances[i].rotation[3]);
+		glm_vec3_copy((float*)instances[i].position, packed[i].position);
+		packed[i].scale = float_to_half(instances[i].scale);
+		packed[i].padding = 0;
+	}
+}
+
+void packed_instance_matrix(const struct packed_instance* instance, mat4 model)
+{
+	glm_quat_mat4((float*)instance->rotation, model);
+	glm_vec3_scale(model[0], instance->scale, model[0]);
+	glm_vec3_scale(model[1], instance->scale, model[1]);
+	glm_vec3_scale(model[2], instance->scale, model[2]);
+	glm_vec3_copy((float*)instance->position, model[3]);
+}
+
+// Rounds to nearest even like the hardware conversions, keeps infinities
+// and NaNs and flushes nothing: small values become half denormals
+unsigned short float_to_half(float value)
+{
+	unsigned bits, sign, mantissa, half, remainder, shift;
+	int exponent;
+
+	memcpy(&bits, &value, sizeof(bits));
+	sign = bits >> 16 & 0x8000u;
+	exponent = (int)(bits >> 23 & 0xffu);
+	mantissa = bits & 0x7fffffu;
+
+	if (exponent == 0xff)
+		return (unsigned short)(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+	exponent -= 127 - 15;
+	if (exponent >= 31)
+		return (unsigned short)(sign | 0x7c00u);
+	if (exponent <= 0)
+	{
+		if (exponent < -10)
+			return (unsigned short)sign;
+		mantissa |= 0x800000u;
+		shift = (unsigned)(14 - exponent);
+		half = mantissa >> shift;
+		remainder = mantissa & ((1u << shift) - 1u);
+		if (remainder > 1u << (shift - 1u) || (remainder == 1u << (shift - 1u) && (half & 1u)))
+			++half;
+		return (unsigned short)(sign | half);
+	}
+
+	// A carry out of the mantissa moves into the exponent, up to infinity
+	half = (unsigned)exponent << 10 | mantissa >> 13;
+	remainder = mantissa & 0x1fffu;
+	if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u)))
+		++half;
+	return (unsigned short)(sign | half);
+}
+
+float half_to_float(unsigned short value)
+{
+	unsigned sign = (unsigned)(value & 0x8000u) << 16;
+	unsigned exponent = value >> 10 & 0x1fu;
+	unsigned mantissa = value & 0x3ffu;
+	unsigned bits;
+	float result;
+
+	if (exponent == 0x1f)
+		bits = sign | 0x7f800000u | mantissa << 13;
+	else if (exponent)
+		bits = sign | (exponent + 127 - 15) << 23 | mantissa << 13;
+	else if (mantissa)
+	{
+		// Denormal: normalise the mantissa
+		exponent = 127 - 15 + 1;
+		while (!(mantissa & 0x400u))
+		{
+			mantissa <<= 1;
+			--exponent;
+		}
+		bits = sign | exponent << 23 | (mantissa & 0x3ffu) << 13;
+	}
+	else
+		bits = sign;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
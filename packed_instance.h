@@ -0,0 +1,59 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef PACKED_INSTANCE_H
+#define PACKED_INSTANCE_H
+
+#include "cglm/types.h"
+
+// Rotation, position and uniform scale of an instance in 32 bytes, where a
+// model matrix takes 64 (and 128 with its inverse transpose). Shaders
+// rotate by the quaternion directly; with a uniform scale the rotation
+// also turns the normals, so no normal matrix is needed.
+struct packed_instance
+{
+	versor rotation;
+	vec3 position;
+	float scale;
+};
+
+// Same instance in 24 bytes, for vertex attributes: rotation and scale are
+// half floats, the position stays a float because halves step by whole
+// units a few hundred units away from the origin.
+struct packed_instance_half
+{
+	unsigned short rotation[4];
+	vec3 position;
+	unsigned short scale;
+	unsigned short padding;
+};
+
+// The matrix must be a rotation, a uniform scale and a translation
+void pack_instance(struct packed_instance* instance, mat4 model);
+void pack_instances_half(struct packed_instance_half* packed, const struct packed_instance* instances, unsigned count);
+void packed_instance_matrix(const struct packed_instance* instance, mat4 model);
+
+unsigned short float_to_half(float value);
+float half_to_float(unsigned short value);
+
+#endif // PACKED_INSTANCE_H
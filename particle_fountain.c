@@ -0,0 +1,399 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SDL_MAIN_HANDLED
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_main.h>
+#include "cglm/affine.h"
+#include "cglm/cam.h"
+#include "cglm/quat.h"
+#include "common.h"
+#include "jobs.h"
+#include "particles.h"
+#include "simd.h"
+#include "stream_buffer.h"
+
+#define PARTICLES_CAPACITY (1 << 20)
+#define PARTICLE_LIFE 3000.0f
+#define PARTICLE_LIFE_SPREAD 1000.0f
+#define PARTICLE_SIZE 0.02f
+#define GRAVITY -0.00001f
+
+int main(int argc, char** argv)
+{
+	// =====================================
+	// Initialisation
+	// =====================================
+	// SDL
+
+	if (SDL_Init(SDL_INIT_VIDEO) < 0)
+	{
+		error("SDL Error", SDL_GetError());
+		return 1;
+	}
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_Window* window = SDL_CreateWindow("OpenGL Tutorial 17",
+										  SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+										  1024, 768, SDL_WINDOW_OPENGL);
+	if (!window)
+	{
+		error("SDL Error", SDL_GetError());
+		SDL_Quit();
+		return 1;
+	}
+	SDL_GLContext context = SDL_GL_CreateContext(window);
+	if (!context)
+	{
+		error("SDL Error", SDL_GetError());
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	SDL_ShowCursor(SDL_DISABLE);
+	SDL_SetRelativeMouseMode(SDL_TRUE);
+
+	// GLEW
+	glewExperimental = GL_TRUE;
+	if (glewInit() != GLEW_OK)
+	{
+		error("GLEW Error", glewGetErrorString(glGetError()));
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Jobs
+	if (!jobs_init(0))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// OpenGL
+	// Particles glow: they add up in any order, so neither depth nor
+	// sorting is needed
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+	// Math kernels of the widest instruction set the CPU has
+	simd_init();
+
+	// Vertex Buffers
+	// Corners of the billboard, the particles themselves are pointed to in
+	// the stream buffer every frame
+	const float corners[] =
+	{
+		-1.0f, -1.0f,
+		 1.0f, -1.0f,
+		-1.0f,  1.0f,
+		 1.0f,  1.0f
+	};
+	unsigned vbo;
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (!validate_gl("Vertex Buffer Error"))
+	{
+		jobs_shutdown();
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	unsigned vao;
+	unsigned i;
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	for (i = 1; i <= 4; ++i)
+	{
+		glEnableVertexAttribArray(i);
+		glVertexAttribDivisor(i, 1);
+	}
+	glBindVertexArray(0);
+
+	if (!validate_gl("Vertex Array Error"))
+	{
+		glDeleteVertexArrays(1, &vao);
+		glDeleteBuffers(1, &vbo);
+		jobs_shutdown();
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Shader
+	// Billboards of its own, coloured by the emissive fragment shader
+	const unsigned program = create_program_stages("data/shaders/17_particle_fountain", "data/shaders/7_emissive");
+	if (!program)
+	{
+		glDeleteVertexArrays(1, &vao);
+		glDeleteBuffers(1, &vbo);
+		jobs_shutdown();
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Shader Uniforms
+	const int uniform_viewproj = glGetUniformLocation(program, "cModelViewProj");
+	const int uniform_camera_right = glGetUniformLocation(program, "cCameraRight");
+	const int uniform_camera_up = glGetUniformLocation(program, "cCameraUp");
+
+	glUseProgram(program);
+	glUniform3f(glGetUniformLocation(program, "cColor"), 0.12f, 0.05f, 0.015f);
+	glUniform1f(glGetUniformLocation(program, "cSize"), PARTICLE_SIZE);
+	glUniform1f(glGetUniformLocation(program, "cLife"), PARTICLE_LIFE + PARTICLE_LIFE_SPREAD);
+	glUseProgram(0);
+
+	if (!validate_gl("Shader Uniforms Error"))
+	{
+		glDeleteProgram(program);
+		glDeleteVertexArrays(1, &vao);
+		glDeleteBuffers(1, &vbo);
+		jobs_shutdown();
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Stream Buffer
+	// Survivors of every frame, as four runs of floats: x, y, z and life
+	struct stream_buffer stream;
+	if (!create_stream_buffer(&stream, PARTICLES_CAPACITY * 4 * sizeof(float) + 16))
+	{
+		glDeleteProgram(program);
+		glDeleteVertexArrays(1, &vao);
+		glDeleteBuffers(1, &vbo);
+		jobs_shutdown();
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// =====================================
+	// Scene
+	// =====================================
+	// Particles
+	// A fountain spraying up, emitting as fast as particles die on average
+	struct particle_system particles;
+	if (!create_particle_system(&particles, PARTICLES_CAPACITY, 1))
+	{
+		destroy_stream_buffer(&stream);
+		glDeleteProgram(program);
+		glDeleteVertexArrays(1, &vao);
+		glDeleteBuffers(1, &vbo);
+		jobs_shutdown();
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+	const struct particle_emitter emitter =
+	{
+		{ 0.0f, -1.5f, -6.0f },
+		{ 0.0f, 0.008f, 0.0f },
+		{ 0.002f, 0.001f, 0.002f },
+		PARTICLE_LIFE,
+		PARTICLE_LIFE_SPREAD
+	};
+	vec3 gravity = { 0.0f, GRAVITY, 0.0f };
+	float emission = 0.0f;
+	unsigned emit_count;
+
+	// Camera
+	vec3 camera_position = { 0.0f, 0.0f, 3.0f };
+	vec3 camera_direction;
+	vec3 camera_up;
+	vec3 camera_right;
+	versor camera_rotation = GLM_QUAT_IDENTITY_INIT;
+
+	// =====================================
+	// Rendering
+	// =====================================
+	// Matrices
+	mat4 view, viewproj;
+
+	// Projection Matrix
+	mat4 proj;
+	glm_perspective(glm_rad(45.0f), 1024.0f / 768.0f, 0.01f, 100.0f, proj);
+
+	// Statistics
+	char title[256];
+	float* frame_data;
+	unsigned frame_offset;
+	Uint64 stage_start;
+	Uint64 update_time = 0;
+	Uint64 pack_time = 0;
+	unsigned frames = 0;
+	float title_time = 0.0f;
+
+	int run = 1;
+	float tick_delta;
+	float tick_curr;
+	float tick_prev = (float)SDL_GetTicks();
+	unsigned short controls = 0;
+	while (run)
+	{
+		tick_curr = (float)SDL_GetTicks();
+		tick_delta = tick_curr - tick_prev;
+		process_events(camera_position, camera_direction, camera_rotation, &controls, &run, tick_delta);
+		tick_prev = tick_curr;
+
+		// =================================
+		// Camera
+		// =================================
+		// Look
+		glm_quat_rotatev(camera_rotation, GLM_FORWARD, camera_direction);
+
+		// View Matrix
+		glm_quat_rotatev(camera_rotation, GLM_YUP, camera_up);
+		glm_look(camera_position, camera_direction, camera_up, view);
+
+		// View and Projection Matrix
+		glm_mat4_mul_sse2(proj, view, viewproj);
+
+		// Billboard axes, the first two rows of the view rotation
+		camera_right[0] = view[0][0];
+		camera_right[1] = view[1][0];
+		camera_right[2] = view[2][0];
+		camera_up[0] = view[0][1];
+		camera_up[1] = view[1][1];
+		camera_up[2] = view[2][1];
+
+		// =================================
+		// Simulation
+		// =================================
+		stage_start = SDL_GetPerformanceCounter();
+		update_particles(&particles, gravity, tick_delta);
+		emission += tick_delta * PARTICLES_CAPACITY / PARTICLE_LIFE;
+		emit_count = (unsigned)emission;
+		emission -= (float)emit_count;
+		emit_particles(&particles, &emitter, emit_count);
+		update_time += SDL_GetPerformanceCounter() - stage_start;
+
+		// =================================
+		// Frame Data
+		// =================================
+		if (!stream_begin_frame(&stream))
+			break;
+
+		stage_start = SDL_GetPerformanceCounter();
+		frame_data = (float*)stream_alloc(&stream, particles.count * 4 * sizeof(float), 16, &frame_offset);
+		if (!frame_data)
+		{
+			error("Stream Buffer Error", "Frame data does not fit the stream buffer.");
+			break;
+		}
+		pack_particles(&particles, frame_data);
+		pack_time += SDL_GetPerformanceCounter() - stage_start;
+		stream_flush(&stream);
+
+		// Rendering
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		glUseProgram(program);
+		glUniformMatrix4fv(uniform_viewproj, 1, GL_FALSE, viewproj[0]);
+		glUniform3fv(uniform_camera_right, 1, camera_right);
+		glUniform3fv(uniform_camera_up, 1, camera_up);
+		glBindVertexArray(vao);
+		glBindBuffer(GL_ARRAY_BUFFER, stream.buffer);
+		for (i = 0; i < 4; ++i)
+			glVertexAttribPointer(i + 1, 1, GL_FLOAT, GL_FALSE, sizeof(float),
+								  (void*)(frame_offset + i * particles.count * sizeof(float)));
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, particles.count);
+		glBindVertexArray(0);
+		glUseProgram(0);
+		stream_end_frame(&stream);
+
+		// Statistics
+		++frames;
+		title_time += tick_delta;
+		if (title_time >= 1000.0f)
+		{
+			snprintf(title, sizeof(title), "OpenGL Tutorial 17: %u particles, %s, %u threads, %.2f ms update, %.2f ms pack",
+					 particles.count, simd_isa_name(simd_current()), jobs_thread_count(),
+					 (double)update_time * 1000.0 / (double)SDL_GetPerformanceFrequency() / frames,
+					 (double)pack_time * 1000.0 / (double)SDL_GetPerformanceFrequency() / frames);
+			SDL_SetWindowTitle(window, title);
+			update_time = 0;
+			pack_time = 0;
+			frames = 0;
+			title_time = 0.0f;
+		}
+
+		if (validate_gl("Open GL Rendering Error"))
+			SDL_GL_SwapWindow(window);
+		else
+			run = 0;
+	}
+
+	// =====================================
+	// Destruction
+	// =====================================
+	// Scene
+	destroy_particle_system(&particles);
+
+	// Shader
+	glDeleteProgram(program);
+
+	// Vertex Buffers
+	destroy_stream_buffer(&stream);
+	glDeleteVertexArrays(1, &vao);
+	glDeleteBuffers(1, &vbo);
+
+	// Jobs
+	jobs_shutdown();
+
+	// SDL
+	SDL_GL_DeleteContext(context);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+
+	return 0;
+}
+
+__declspec(dllexport) unsigned NvOptimusEnablement = 1;
+__declspec(dllexport) int AmdPowerXpressRequestHighPerformance = 1;
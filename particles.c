@@ -0,0 +1,226 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "jobs.h"
+#include "particles.h"
+#include "simd.h"
+
+#define UPDATE_GRAIN 16384
+#define PACK_GRAIN 65536
+
+struct update_job
+{
+	struct particle_system* system;
+	float* acceleration;
+	float time;
+};
+
+struct pack_job
+{
+	const struct particle_system* system;
+	float* dest;
+};
+
+int create_particle_system(struct particle_system* system, unsigned capacity, unsigned seed)
+{
+	memset(system, 0, sizeof(struct particle_system));
+	system->positions = (float*)malloc(capacity * 7 * sizeof(float));
+	system->holes = (unsigned*)malloc(capacity * sizeof(unsigned));
+	system->lives_count = (unsigned*)malloc((capacity / UPDATE_GRAIN + 1) * sizeof(unsigned));
+	if (!system->positions || !system->holes || !system->lives_count || !capacity)
+	{
+		destroy_particle_system(system);
+		return 0;
+	}
+	system->velocities = system->positions + capacity * 3;
+	system->lives = system->velocities + capacity * 3;
+	system->capacity = capacity;
+	system->seed = seed;
+	return 1;
+}
+
+void destroy_particle_system(struct particle_system* system)
+{
+	free(system->positions);
+	free(system->holes);
+	free(system->lives_count);
+	memset(system, 0, sizeof(struct particle_system));
+}
+
+// Linear congruential generator, -1 to 1
+static float particle_random(unsigned* seed)
+{
+	*seed = *seed * 1664525u + 1013904223u;
+	return (float)(*seed >> 8) / 8388608.0f - 1.0f;
+}
+
+unsigned emit_particles(struct particle_system* system, const struct particle_emitter* emitter, unsigned count)
+{
+	const unsigned capacity = system->capacity;
+	unsigned i, e, end;
+
+	if (count > capacity - system->count)
+		count = capacity - system->count;
+	end = system->count + count;
+	for (i = system->count; i < end; ++i)
+	{
+		for (e = 0; e < 3; ++e)
+		{
+			system->positions[e * capacity + i] = emitter->position[e] + emitter->spread[e] * particle_random(&system->seed);
+			system->velocities[e * capacity + i] = emitter->velocity[e] + emitter->spread[e] * particle_random(&system->seed);
+		}
+		system->lives[i] = emitter->life + emitter->life_spread * particle_random(&system->seed);
+	}
+	system->count = end;
+	return count;
+}
+
+static void move_particles(struct particle_system* system, unsigned from, unsigned to, unsigned count)
+{
+	const unsigned capacity = system->capacity;
+	const unsigned size = count * sizeof(float);
+	unsigned e;
+
+	for (e = 0; e < 3; ++e)
+	{
+		memcpy(system->positions + e * capacity + to, system->positions + e * capacity + from, size);
+		memcpy(system->velocities + e * capacity + to, system->velocities + e * capacity + from, size);
+	}
+	memcpy(system->lives + to, system->lives + from, size);
+}
+
+// Fills the holes of a grain with its last live particles while they are
+// still in cache, live ones end up first
+static unsigned compact_grain(struct particle_system* system, unsigned begin, unsigned count, unsigned dead)
+{
+	unsigned i, hole, end = begin + count;
+
+	for (i = 0; i < dead; ++i)
+	{
+		hole = begin + system->holes[begin + i];
+		if (hole >= end)
+			break;
+		while (end - 1 > hole && system->lives[end - 1] <= 0.0f)
+			--end;
+		--end;
+		if (end > hole)
+			move_particles(system, end, hole, 1);
+	}
+	return end - begin;
+}
+
+// Ranges are split into grains so that every grain is compacted on its own,
+// even when the whole batch runs inline as one range
+static void update_job(void* data, unsigned begin, unsigned end)
+{
+	const struct update_job* job = (const struct update_job*)data;
+	struct particle_system* system = job->system;
+	unsigned count, dead;
+
+	for (; begin < end; begin += count)
+	{
+		count = end - begin;
+		if (count > UPDATE_GRAIN)
+			count = UPDATE_GRAIN;
+		dead = simd_particles_update(system->positions + begin, system->velocities + begin, system->lives + begin,
+									 system->capacity, job->acceleration, job->time, system->holes + begin, count);
+		system->lives_count[begin / UPDATE_GRAIN] = dead ? compact_grain(system, begin, count, dead) : count;
+	}
+}
+
+// Gaps left at the end of the first grains are filled with blocks from
+// the end of the last ones, so only as many particles as died move
+static void close_gaps(struct particle_system* system)
+{
+	const unsigned grains = (system->count + UPDATE_GRAIN - 1) / UPDATE_GRAIN;
+	unsigned first = 0, last, first_end, last_end, count;
+
+	if (!grains)
+		return;
+	last = grains - 1;
+	first_end = system->lives_count[first];
+	last_end = last * UPDATE_GRAIN + system->lives_count[last];
+	while (first < last)
+	{
+		if (first_end == (first + 1) * UPDATE_GRAIN)
+		{
+			if (++first == last)
+			{
+				first_end = last_end;
+				break;
+			}
+			first_end = first * UPDATE_GRAIN + system->lives_count[first];
+		}
+		else if (last_end == last * UPDATE_GRAIN)
+		{
+			if (--last == first)
+				break;
+			last_end = last * UPDATE_GRAIN + system->lives_count[last];
+		}
+		else
+		{
+			count = (first + 1) * UPDATE_GRAIN - first_end;
+			if (count > last_end - last * UPDATE_GRAIN)
+				count = last_end - last * UPDATE_GRAIN;
+			last_end -= count;
+			move_particles(system, last_end, first_end, count);
+			first_end += count;
+		}
+	}
+	system->count = first_end;
+}
+
+void update_particles(struct particle_system* system, vec3 acceleration, float time)
+{
+	struct update_job job;
+
+	job.system = system;
+	job.acceleration = acceleration;
+	job.time = time;
+	jobs_parallel_for(update_job, &job, system->count, UPDATE_GRAIN);
+	close_gaps(system);
+}
+
+static void pack_job(void* data, unsigned begin, unsigned end)
+{
+	const struct pack_job* job = (const struct pack_job*)data;
+	const struct particle_system* system = job->system;
+	const unsigned count = system->count;
+	const unsigned size = (end - begin) * sizeof(float);
+	unsigned e;
+
+	for (e = 0; e < 3; ++e)
+		memcpy(job->dest + e * count + begin, system->positions + e * system->capacity + begin, size);
+	memcpy(job->dest + 3 * count + begin, system->lives + begin, size);
+}
+
+void pack_particles(const struct particle_system* system, float* dest)
+{
+	struct pack_job job;
+
+	job.system = system;
+	job.dest = dest;
+	jobs_parallel_for(pack_job, &job, system->count, PACK_GRAIN);
+}
@@ -0,0 +1,69 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include "cglm/types.h"
+
+// Particles kept as structure of arrays: x, y and z runs of capacity
+// floats for positions and for velocities, then one run of lives. Live
+// particles are the first count of every run; dead ones are replaced in
+// place, first within each update range, then by moving the last ranges
+// into the gaps, so storage never moves.
+struct particle_system
+{
+	float* positions;
+	float* velocities;
+	float* lives; // Milliseconds left
+	unsigned* holes; // Dead particles of each update range, scratch
+	unsigned* lives_count; // Survivors of each update range, scratch
+	unsigned count;
+	unsigned capacity;
+	unsigned seed;
+};
+
+// New particles start at position with velocity, both offset by up to
+// spread along each axis, and live life give or take life_spread
+// milliseconds.
+struct particle_emitter
+{
+	vec3 position;
+	vec3 velocity;
+	vec3 spread;
+	float life;
+	float life_spread;
+};
+
+int create_particle_system(struct particle_system* system, unsigned capacity, unsigned seed);
+void destroy_particle_system(struct particle_system* system);
+
+// Returns how many particles were emitted, fewer than count when full
+unsigned emit_particles(struct particle_system* system, const struct particle_emitter* emitter, unsigned count);
+// Advances particles by time milliseconds under acceleration, per square
+// millisecond, over the job threads, then drops the ones that died
+void update_particles(struct particle_system* system, vec3 acceleration, float time);
+// Copies live particles for drawing: count x, then y, then z, then lives
+void pack_particles(const struct particle_system* system, float* dest);
+
+#endif // PARTICLES_H
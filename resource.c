@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL_events.h>
+#include "common.h"
+#include "resource.h"
+
+const struct resource* find_resource(const char* name)
+{
+	unsigned first = 0;
+	unsigned last = resources_count;
+	unsigned middle;
+	int order;
+	while (first < last)
+	{
+		middle = (first + last) / 2;
+		order = strcmp(name, resources[middle].name);
+		if (order == 0)
+			return &resources[middle];
+		else if (order < 0)
+			last = middle;
+		else
+			first = middle + 1;
+	}
+	return NULL;
+}
+
+int load_resource(struct resource* resource, const char* name)
+{
+	const struct resource* embedded = find_resource(name);
+	if (embedded)
+	{
+		*resource = *embedded;
+		return 1;
+	}
+
+	FILE* file = fopen(name, "rb");
+	if (!file)
+	{
+		error("Resource Loading Error", "Failed to open file %s.", name);
+		return 0;
+	}
+	fseek(file, 0, SEEK_END);
+	const unsigned size = ftell(file);
+	if (!size)
+	{
+		error("Resource Loading Error", "File %s is empty.", name);
+		fclose(file);
+		return 0;
+	}
+	rewind(file);
+
+	// Loose files get the same trailing zero as embedded ones so text can be used in-place
+	unsigned char* data = (unsigned char*)malloc(size + 1);
+	if (fread(data, 1, size, file) != size)
+	{
+		error("Resource Loading Error", "Failed to read file %s.", name);
+		free(data);
+		fclose(file);
+		return 0;
+	}
+	data[size] = '\0';
+	fclose(file);
+
+	resource->name = name;
+	resource->data = data;
+	resource->size = size;
+	resource->flags = 0;
+	return 1;
+}
+
+void free_resource(struct resource* resource)
+{
+	if (!(resource->flags & RESOURCE_EMBEDDED))
+		free((void*)resource->data);
+	resource->data = NULL;
+	resource->size = 0;
+}
@@ -0,0 +1,55 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef RESOURCE_H
+#define RESOURCE_H
+
+#define RESOURCE_EMBEDDED 0x0001
+#define RESOURCE_ALIGNMENT 64
+#define RESOURCE_PAGE_SIZE 4096
+
+#if defined(_MSC_VER)
+#define RESOURCE_SECTION __declspec(allocate(".lglres")) __declspec(align(RESOURCE_PAGE_SIZE))
+#elif defined(__APPLE__)
+#define RESOURCE_SECTION __attribute__((section("__TEXT,__lglres"), aligned(RESOURCE_PAGE_SIZE)))
+#else
+#define RESOURCE_SECTION __attribute__((section(".lglres"), aligned(RESOURCE_PAGE_SIZE)))
+#endif
+
+struct resource
+{
+	const char* name;
+	const unsigned char* data;
+	unsigned size;
+	unsigned flags;
+};
+
+// Generated by rescomp at build time, sorted by name
+extern const struct resource resources[];
+extern const unsigned resources_count;
+
+const struct resource* find_resource(const char* name);
+int load_resource(struct resource* resource, const char* name);
+void free_resource(struct resource* resource);
+
+#endif // RESOURCE_H
@@ -0,0 +1,196 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "cglm/mat4.h"
+#include "jobs.h"
+#include "scene_graph.h"
+
+#define LEVEL_GRAIN 1024
+
+struct level_job
+{
+	struct scene_graph* graph;
+	unsigned first;
+};
+
+int create_scene_graph(struct scene_graph* graph, unsigned capacity)
+{
+	memset(graph, 0, sizeof(struct scene_graph));
+	graph->locals = (mat4*)malloc(capacity * sizeof(mat4));
+	graph->worlds = (mat4*)malloc(capacity * sizeof(mat4));
+	graph->parents = (unsigned*)malloc(capacity * sizeof(unsigned));
+	graph->dirty = (unsigned char*)malloc(capacity);
+	graph->slots = (unsigned*)malloc(capacity * sizeof(unsigned));
+	graph->handles = (unsigned*)malloc(capacity * sizeof(unsigned));
+	graph->parent_handles = (unsigned*)malloc(capacity * sizeof(unsigned));
+	graph->depths = (unsigned char*)malloc(capacity);
+	if (!graph->locals || !graph->worlds || !graph->parents || !graph->dirty || !graph->slots || !graph->handles ||
+		!graph->parent_handles || !graph->depths)
+	{
+		destroy_scene_graph(graph);
+		return 0;
+	}
+	graph->capacity = capacity;
+	return 1;
+}
+
+void destroy_scene_graph(struct scene_graph* graph)
+{
+	free(graph->depths);
+	free(graph->parent_handles);
+	free(graph->handles);
+	free(graph->slots);
+	free(graph->dirty);
+	free(graph->parents);
+	free(graph->worlds);
+	free(graph->locals);
+	memset(graph, 0, sizeof(struct scene_graph));
+}
+
+// New nodes go to the end and stay there until the next update puts them
+// in their level
+unsigned add_scene_node(struct scene_graph* graph, unsigned parent, mat4 local)
+{
+	unsigned node = graph->count, depth = 0;
+	if (node == graph->capacity)
+		return SCENE_ROOT;
+	if (parent != SCENE_ROOT)
+	{
+		depth = graph->depths[parent] + 1u;
+		if (depth >= SCENE_MAX_DEPTH)
+			return SCENE_ROOT;
+	}
+
+	graph->slots[node] = node;
+	graph->handles[node] = node;
+	graph->parent_handles[node] = parent;
+	graph->depths[node] = (unsigned char)depth;
+	glm_mat4_copy(local, graph->locals[node]);
+	++graph->count;
+	graph->reorder = 1;
+	return node;
+}
+
+void set_scene_local(struct scene_graph* graph, unsigned node, mat4 local)
+{
+	unsigned slot = graph->slots[node];
+	unsigned level = graph->depths[node];
+	glm_mat4_copy(local, graph->locals[slot]);
+	graph->dirty[slot] = 1;
+	if (level < graph->first_dirty_level)
+		graph->first_dirty_level = level;
+}
+
+float* scene_world(struct scene_graph* graph, unsigned node)
+{
+	return graph->worlds[graph->slots[node]][0];
+}
+
+// Counting sort of the handles by depth, stable, so parents keep coming
+// before their children inside a level as well
+static void reorder_scene_graph(struct scene_graph* graph)
+{
+	mat4* locals = (mat4*)malloc(graph->count * sizeof(mat4));
+	unsigned next[SCENE_MAX_DEPTH + 1];
+	unsigned node, slot, depth;
+
+	if (!locals)
+		return;
+	for (node = 0; node < graph->count; ++node)
+		glm_mat4_copy(graph->locals[graph->slots[node]], locals[node]);
+
+	memset(graph->levels, 0, sizeof(graph->levels));
+	graph->levels_count = 0;
+	for (node = 0; node < graph->count; ++node)
+	{
+		++graph->levels[graph->depths[node] + 1];
+		if (graph->depths[node] + 1u > graph->levels_count)
+			graph->levels_count = graph->depths[node] + 1u;
+	}
+	for (depth = 0; depth < graph->levels_count; ++depth)
+		graph->levels[depth + 1] += graph->levels[depth];
+	memcpy(next, graph->levels, sizeof(next));
+
+	for (node = 0; node < graph->count; ++node)
+	{
+		slot = next[graph->depths[node]]++;
+		graph->slots[node] = slot;
+		graph->handles[slot] = node;
+		glm_mat4_copy(locals[node], graph->locals[slot]);
+	}
+	for (slot = 0; slot < graph->count; ++slot)
+	{
+		node = graph->parent_handles[graph->handles[slot]];
+		graph->parents[slot] = node == SCENE_ROOT ? SCENE_ROOT : graph->slots[node];
+	}
+	free(locals);
+
+	memset(graph->dirty, 1, graph->count);
+	graph->first_dirty_level = 0;
+	graph->reorder = 0;
+}
+
+static void level_job(void* data, unsigned begin, unsigned end)
+{
+	struct level_job* job = (struct level_job*)data;
+	struct scene_graph* graph = job->graph;
+	unsigned slot, parent;
+
+	for (slot = job->first + begin; slot < job->first + end; ++slot)
+	{
+		parent = graph->parents[slot];
+		if (parent == SCENE_ROOT)
+		{
+			if (graph->dirty[slot])
+				glm_mat4_copy(graph->locals[slot], graph->worlds[slot]);
+		}
+		else if (graph->dirty[slot] || graph->dirty[parent])
+		{
+			graph->dirty[slot] = 1;
+			glm_mat4_mul(graph->worlds[parent], graph->locals[slot], graph->worlds[slot]);
+		}
+	}
+}
+
+void update_scene_graph(struct scene_graph* graph)
+{
+	struct level_job job;
+	unsigned level;
+
+	if (graph->reorder)
+		reorder_scene_graph(graph);
+	if (graph->first_dirty_level >= graph->levels_count)
+		return;
+
+	job.graph = graph;
+	for (level = graph->first_dirty_level; level < graph->levels_count; ++level)
+	{
+		job.first = graph->levels[level];
+		jobs_parallel_for(level_job, &job, graph->levels[level + 1] - job.first, LEVEL_GRAIN);
+	}
+
+	memset(graph->dirty + graph->levels[graph->first_dirty_level], 0, graph->count - graph->levels[graph->first_dirty_level]);
+	graph->first_dirty_level = SCENE_MAX_DEPTH;
+}
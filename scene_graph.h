@@ -0,0 +1,72 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef SCENE_GRAPH_H
+#define SCENE_GRAPH_H
+
+#include "cglm/types.h"
+
+#define SCENE_ROOT 0xFFFFFFFFu
+#define SCENE_MAX_DEPTH 64
+
+// Transform hierarchy kept in breadth-first order: every level of the tree
+// is a contiguous run of slots that only points back at the level before
+// it, so world matrices are computed level after level, each level split
+// over the job threads. Nodes whose local matrix changed are flagged
+// dirty; the flag spreads to children on the way down and only flagged
+// nodes are multiplied. A frame without changes returns at once.
+//
+// Nodes are referred to by the handle add_scene_node returns, which stays
+// the same while slots move. New nodes are placed in their level on the
+// next update, which recomputes the whole tree once.
+struct scene_graph
+{
+	mat4* locals;
+	mat4* worlds;
+	unsigned* parents; // Slot of the parent, SCENE_ROOT for roots
+	unsigned char* dirty;
+	unsigned* slots; // Handle to slot
+	unsigned* handles; // Slot to handle
+	unsigned* parent_handles;
+	unsigned char* depths;
+	unsigned levels[SCENE_MAX_DEPTH + 1]; // First slot of every level and the end
+	unsigned levels_count;
+	unsigned count;
+	unsigned capacity;
+	unsigned first_dirty_level;
+	int reorder;
+};
+
+int create_scene_graph(struct scene_graph* graph, unsigned capacity);
+void destroy_scene_graph(struct scene_graph* graph);
+
+// Parents have to exist already. Returns SCENE_ROOT when the graph is full
+// or too deep.
+unsigned add_scene_node(struct scene_graph* graph, unsigned parent, mat4 local);
+void set_scene_local(struct scene_graph* graph, unsigned node, mat4 local);
+// Valid after update_scene_graph
+float* scene_world(struct scene_graph* graph, unsigned node);
+
+void update_scene_graph(struct scene_graph* graph);
+
+#endif // SCENE_GRAPH_H
@@ -0,0 +1,278 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+#include <SDL_cpuinfo.h>
+#include "simd.h"
+#include "simd_loops.h"
+
+// Baseline kernels until simd_init picks wider ones
+static struct simd_kernels kernels =
+{
+	loop_mat4_mul,
+	loop_mat4_mul_left,
+	loop_mat4_inv,
+	loop_mat4_inv_affine,
+	loop_mat4_transpose,
+	loop_mat4_mulv,
+	loop_mat4_mul_soa,
+	loop_mat4_inv_soa,
+	loop_mat4_inv_soa,
+	loop_mat4_transpose_soa,
+	loop_mat4_mulv_soa,
+	loop_quat_mul,
+	loop_quat_rotatev,
+	loop_quat_integrate,
+	loop_quat_normalize,
+	loop_quat_nlerp,
+	loop_quat_slerp,
+	loop_ease,
+	loop_bezier,
+	loop_skin,
+	loop_particles_update,
+	loop_filter_rows,
+	loop_filter_columns,
+	loop_occlusion_rasterize
+};
+static enum simd_isa current = SIMD_BASELINE;
+
+// SDL has no FMA check, which the AVX2 and AVX-512 kernels are built with
+static int has_fma(void)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 12)) != 0;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	return __builtin_cpu_supports("fma");
+#else
+	return 0;
+#endif
+}
+
+// SDL checks that the OS saves the wide registers too
+static int cpu_supports(enum simd_isa isa)
+{
+	switch (isa)
+	{
+	case SIMD_AVX:
+		return SDL_HasAVX();
+	case SIMD_AVX2:
+		return SDL_HasAVX2() && has_fma();
+	case SIMD_AVX512:
+		return SDL_HasAVX512F() && has_fma();
+	default:
+		return 1;
+	}
+}
+
+enum simd_isa simd_init(void)
+{
+	enum simd_isa isa = SIMD_AVX512;
+	while (isa > SIMD_BASELINE && !simd_select(isa))
+		isa = (enum simd_isa)(isa - 1);
+	if (isa == SIMD_BASELINE)
+		simd_select(SIMD_BASELINE);
+	return current;
+}
+
+int simd_select(enum simd_isa isa)
+{
+	struct simd_kernels selected;
+	int built;
+
+	if (isa >= SIMD_ISA_COUNT || !cpu_supports(isa))
+		return 0;
+	switch (isa)
+	{
+	case SIMD_AVX:
+		built = simd_kernels_avx(&selected);
+		break;
+	case SIMD_AVX2:
+		built = simd_kernels_avx2(&selected);
+		break;
+	case SIMD_AVX512:
+		built = simd_kernels_avx512(&selected);
+		break;
+	default:
+		simd_loops(&selected);
+		built = 1;
+		break;
+	}
+	if (!built)
+		return 0;
+	kernels = selected;
+	current = isa;
+	return 1;
+}
+
+enum simd_isa simd_current(void)
+{
+	return current;
+}
+
+const char* simd_isa_name(enum simd_isa isa)
+{
+	switch (isa)
+	{
+	case SIMD_BASELINE:
+#if defined(CGLM_SSE_FP)
+		return "sse2";
+#elif defined(CGLM_NEON_FP)
+		return "neon";
+#else
+		return "scalar";
+#endif
+	case SIMD_AVX:
+		return "avx";
+	case SIMD_AVX2:
+		return "avx2";
+	case SIMD_AVX512:
+		return "avx512";
+	default:
+		return "unknown";
+	}
+}
+
+void simd_mat4_mul(mat4* a, mat4* b, mat4* dest, unsigned count)
+{
+	kernels.mat4_mul(a, b, dest, count);
+}
+
+void simd_mat4_mul_left(mat4 left, mat4* right, mat4* dest, unsigned count)
+{
+	kernels.mat4_mul_left(left, right, dest, count);
+}
+
+void simd_mat4_inv(mat4* m, mat4* dest, unsigned count)
+{
+	kernels.mat4_inv(m, dest, count);
+}
+
+void simd_mat4_inv_affine(mat4* m, mat4* dest, unsigned count)
+{
+	kernels.mat4_inv_affine(m, dest, count);
+}
+
+void simd_mat4_transpose(mat4* m, mat4* dest, unsigned count)
+{
+	kernels.mat4_transpose(m, dest, count);
+}
+
+void simd_mat4_mulv(mat4 m, vec4* v, vec4* dest, unsigned count)
+{
+	kernels.mat4_mulv(m, v, dest, count);
+}
+
+void simd_mat4_mul_soa(float* a, float* b, float* dest, unsigned stride, unsigned count)
+{
+	kernels.mat4_mul_soa(a, b, dest, stride, count);
+}
+
+void simd_mat4_inv_soa(float* m, float* dest, unsigned stride, unsigned count)
+{
+	kernels.mat4_inv_soa(m, dest, stride, count);
+}
+
+void simd_mat4_inv_affine_soa(float* m, float* dest, unsigned stride, unsigned count)
+{
+	kernels.mat4_inv_affine_soa(m, dest, stride, count);
+}
+
+void simd_mat4_transpose_soa(float* m, float* dest, unsigned stride, unsigned count)
+{
+	kernels.mat4_transpose_soa(m, dest, stride, count);
+}
+
+void simd_mat4_mulv_soa(float* m, float* v, float* dest, unsigned stride, unsigned count)
+{
+	kernels.mat4_mulv_soa(m, v, dest, stride, count);
+}
+
+void simd_quat_mul(versor* a, versor* b, versor* dest, unsigned count)
+{
+	kernels.quat_mul(a, b, dest, count);
+}
+
+void simd_quat_rotatev(versor* q, vec3* v, vec3* dest, unsigned count)
+{
+	kernels.quat_rotatev(q, v, dest, count);
+}
+
+void simd_quat_integrate(versor* q, vec4* spins, float time, unsigned count)
+{
+	kernels.quat_integrate(q, spins, time, count);
+}
+
+void simd_quat_normalize(versor* q, unsigned count)
+{
+	kernels.quat_normalize(q, count);
+}
+
+void simd_quat_nlerp(versor* from, versor* to, float* t, versor* dest, unsigned count)
+{
+	kernels.quat_nlerp(from, to, t, dest, count);
+}
+
+void simd_quat_slerp(versor* from, versor* to, float* t, versor* dest, unsigned count)
+{
+	kernels.quat_slerp(from, to, t, dest, count);
+}
+
+void simd_ease(enum simd_ease_curve curve, const float* t, float* dest, unsigned count)
+{
+	kernels.ease(curve, t, dest, count);
+}
+
+void simd_bezier(float c0, float c1, const float* t, float* dest, unsigned count)
+{
+	kernels.bezier(c0, c1, t, dest, count);
+}
+
+void simd_skin(mat4* palette, struct skin_vertex* vertices, struct skinned_vertex* dest, unsigned count)
+{
+	kernels.skin(palette, vertices, dest, count);
+}
+
+unsigned simd_particles_update(float* positions, float* velocities, float* lives, unsigned stride, vec3 acceleration,
+							   float time, unsigned* dead, unsigned count)
+{
+	return kernels.particles_update(positions, velocities, lives, stride, acceleration, time, dead, count);
+}
+
+void simd_filter_rows(float* dest, const float** rows, const float* weights, unsigned taps, unsigned count)
+{
+	kernels.filter_rows(dest, rows, weights, taps, count);
+}
+
+void simd_filter_columns(float* dest, const float* padded, const float* weights, unsigned taps, unsigned width)
+{
+	kernels.filter_columns(dest, padded, weights, taps, width);
+}
+
+void simd_occlusion_rasterize(float* depth, const struct occluder_triangle* triangle, int tile_x, int tile_y)
+{
+	kernels.occlusion_rasterize(depth, triangle, tile_x, tile_y);
+}
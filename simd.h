@@ -0,0 +1,147 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#include "cglm/types.h"
+
+struct occluder_triangle;
+struct skin_vertex;
+struct skinned_vertex;
+
+// Instruction sets of the batch math kernels. The baseline is whatever
+// cglm was compiled with: SSE2 on x86-64, NEON on ARM and plain C
+// elsewhere. Wider sets are built separately and only used when the CPU
+// running the binary has them.
+enum simd_isa
+{
+	SIMD_BASELINE,
+	SIMD_AVX,
+	SIMD_AVX2,
+	SIMD_AVX512,
+	SIMD_ISA_COUNT
+};
+
+// Easing curves of cglm/ease.h, in its order
+enum simd_ease_curve
+{
+	SIMD_EASE_LINEAR,
+	SIMD_EASE_SINE_IN,
+	SIMD_EASE_SINE_OUT,
+	SIMD_EASE_SINE_INOUT,
+	SIMD_EASE_QUAD_IN,
+	SIMD_EASE_QUAD_OUT,
+	SIMD_EASE_QUAD_INOUT,
+	SIMD_EASE_CUBIC_IN,
+	SIMD_EASE_CUBIC_OUT,
+	SIMD_EASE_CUBIC_INOUT,
+	SIMD_EASE_QUART_IN,
+	SIMD_EASE_QUART_OUT,
+	SIMD_EASE_QUART_INOUT,
+	SIMD_EASE_QUINT_IN,
+	SIMD_EASE_QUINT_OUT,
+	SIMD_EASE_QUINT_INOUT,
+	SIMD_EASE_EXP_IN,
+	SIMD_EASE_EXP_OUT,
+	SIMD_EASE_EXP_INOUT,
+	SIMD_EASE_CIRC_IN,
+	SIMD_EASE_CIRC_OUT,
+	SIMD_EASE_CIRC_INOUT,
+	SIMD_EASE_BACK_IN,
+	SIMD_EASE_BACK_OUT,
+	SIMD_EASE_BACK_INOUT,
+	SIMD_EASE_ELASTIC_IN,
+	SIMD_EASE_ELASTIC_OUT,
+	SIMD_EASE_ELASTIC_INOUT,
+	SIMD_EASE_BOUNCE_IN,
+	SIMD_EASE_BOUNCE_OUT,
+	SIMD_EASE_BOUNCE_INOUT,
+	SIMD_EASE_COUNT
+};
+
+// Picks the widest kernels that both the CPU and the build support, once
+// at startup. Until then every entry point runs the baseline kernels.
+enum simd_isa simd_init(void);
+// Forces the kernels of one instruction set, for benchmarks. Fails when
+// the CPU or the build lacks it.
+int simd_select(enum simd_isa isa);
+enum simd_isa simd_current(void);
+const char* simd_isa_name(enum simd_isa isa);
+
+// Batch math over arrays of count elements, destinations may be sources
+void simd_mat4_mul(mat4* a, mat4* b, mat4* dest, unsigned count);
+void simd_mat4_mul_left(mat4 left, mat4* right, mat4* dest, unsigned count);
+void simd_mat4_inv(mat4* m, mat4* dest, unsigned count);
+// Matrices with a last row of 0 0 0 1 only
+void simd_mat4_inv_affine(mat4* m, mat4* dest, unsigned count);
+void simd_mat4_transpose(mat4* m, mat4* dest, unsigned count);
+void simd_mat4_mulv(mat4 m, vec4* v, vec4* dest, unsigned count);
+// The same over SoA arrays: element e of matrix or vector i lives at
+// soa[e * stride + i], sixteen runs of stride floats per matrix array and
+// four per vector array
+void simd_mat4_mul_soa(float* a, float* b, float* dest, unsigned stride, unsigned count);
+void simd_mat4_inv_soa(float* m, float* dest, unsigned stride, unsigned count);
+void simd_mat4_inv_affine_soa(float* m, float* dest, unsigned stride, unsigned count);
+void simd_mat4_transpose_soa(float* m, float* dest, unsigned stride, unsigned count);
+void simd_mat4_mulv_soa(float* m, float* v, float* dest, unsigned stride, unsigned count);
+
+void simd_quat_mul(versor* a, versor* b, versor* dest, unsigned count);
+void simd_quat_rotatev(versor* q, vec3* v, vec3* dest, unsigned count);
+// Turns every rotation by its spin over time: a unit axis and a speed in
+// radians per unit of time. Rounding slowly pulls the results off unit
+// length, so callers renormalize every now and then.
+void simd_quat_integrate(versor* q, vec4* spins, float time, unsigned count);
+void simd_quat_normalize(versor* q, unsigned count);
+// Shortest path interpolation of unit quaternions, one amount in 0..1 per
+// pair
+void simd_quat_nlerp(versor* from, versor* to, float* t, versor* dest, unsigned count);
+void simd_quat_slerp(versor* from, versor* to, float* t, versor* dest, unsigned count);
+// Eases amounts in 0..1 along a curve of cglm/ease.h, or along the cubic
+// bezier of glm_bezier from 0 to 1 with control points c0 and c1
+void simd_ease(enum simd_ease_curve curve, const float* t, float* dest, unsigned count);
+void simd_bezier(float c0, float c1, const float* t, float* dest, unsigned count);
+
+// Linear blend skinning with the joint matrices of one palette, see
+// skeleton.h. Palettes are affine, normals are renormalized.
+void simd_skin(mat4* palette, struct skin_vertex* vertices, struct skinned_vertex* dest, unsigned count);
+
+// Particle motion over SoA runs as in the SoA matrix kernels, three runs
+// of stride floats for positions and for velocities: velocities gain
+// acceleration * time, positions move by the new velocities and lives
+// lose time. Indices of the lives that ended at or below zero go to dead,
+// returns how many.
+unsigned simd_particles_update(float* positions, float* velocities, float* lives, unsigned stride, vec3 acceleration,
+							   float time, unsigned* dead, unsigned count);
+
+// Mipmap filter taps, see mipmap.c. Rows: dest[i] is the sum of
+// rows[k][i] * weights[k] over the taps. Columns: RGBA pixel x of dest is
+// the sum of padded pixels x * 2 + k weighted the same way.
+void simd_filter_rows(float* dest, const float** rows, const float* weights, unsigned taps, unsigned count);
+void simd_filter_columns(float* dest, const float* padded, const float* weights, unsigned taps, unsigned width);
+
+// Keeps the nearest depth of every pixel centre of one occlusion tile
+// covered by the triangle, see occlusion.h
+void simd_occlusion_rasterize(float* depth, const struct occluder_triangle* triangle, int tile_x, int tile_y);
+
+#endif // SIMD_H
@@ -0,0 +1,55 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Callers only align matrices for the baseline build, wider loads must not
+// assume more
+#define CGLM_ALL_UNALIGNED
+#include "simd_kernels.h"
+
+#ifdef __AVX__
+#include "simd_ease.h"
+#include "simd_filter.h"
+#include "simd_loops.h"
+#include "simd_occlusion.h"
+#include "simd_particles.h"
+#include "simd_skin.h"
+
+int simd_kernels_avx(struct simd_kernels* kernels)
+{
+	simd_loops(kernels);
+	kernels->ease = avx_ease;
+	kernels->bezier = avx_bezier;
+	kernels->skin = avx_skin;
+	kernels->particles_update = avx_particles_update;
+	kernels->filter_rows = avx_filter_rows;
+	kernels->filter_columns = avx_filter_columns;
+	kernels->occlusion_rasterize = avx_occlusion_rasterize;
+	return 1;
+}
+#else
+int simd_kernels_avx(struct simd_kernels* kernels)
+{
+	(void)kernels;
+	return 0;
+}
+#endif // __AVX__
@@ -0,0 +1,153 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Callers only align matrices for the baseline build, wider loads must not
+// assume more
+#define CGLM_ALL_UNALIGNED
+#include "simd_kernels.h"
+
+#ifdef __AVX512F__
+#include "simd_ease.h"
+#include "simd_filter.h"
+#include "simd_loops.h"
+#include "simd_occlusion.h"
+#include "simd_particles.h"
+#include "simd_skin.h"
+#include "cglm/simd/avx512/mat4_batch.h"
+#include "cglm/simd/avx512/quat_batch.h"
+
+static void batch_mat4_mul(mat4* a, mat4* b, mat4* dest, unsigned count)
+{
+	glm_mat4_mul_batch_avx512(a, b, dest, count);
+}
+
+static void batch_mat4_mul_left(mat4 left, mat4* right, mat4* dest, unsigned count)
+{
+	glm_mat4_mul_left_batch_avx512(left, right, dest, count);
+}
+
+static void batch_mat4_inv(mat4* m, mat4* dest, unsigned count)
+{
+	glm_mat4_inv_batch_avx512(m, dest, count);
+}
+
+static void batch_mat4_inv_affine(mat4* m, mat4* dest, unsigned count)
+{
+	glm_mat4_inv_affine_batch_avx512(m, dest, count);
+}
+
+static void batch_mat4_transpose(mat4* m, mat4* dest, unsigned count)
+{
+	glm_mat4_transpose_batch_avx512(m, dest, count);
+}
+
+static void batch_mat4_mulv(mat4 m, vec4* v, vec4* dest, unsigned count)
+{
+	glm_mat4_mulv_shared_batch_avx512(m, v, dest, count);
+}
+
+static void batch_mat4_mul_soa(float* a, float* b, float* dest, unsigned stride, unsigned count)
+{
+	glm_mat4_mul_soa_avx512(a, b, dest, stride, count);
+}
+
+static void batch_mat4_inv_soa(float* m, float* dest, unsigned stride, unsigned count)
+{
+	glm_mat4_inv_soa_avx512(m, dest, stride, count);
+}
+
+static void batch_mat4_inv_affine_soa(float* m, float* dest, unsigned stride, unsigned count)
+{
+	glm_mat4_inv_affine_soa_avx512(m, dest, stride, count);
+}
+
+static void batch_mat4_transpose_soa(float* m, float* dest, unsigned stride, unsigned count)
+{
+	glm_mat4_transpose_soa_avx512(m, dest, stride, count);
+}
+
+static void batch_mat4_mulv_soa(float* m, float* v, float* dest, unsigned stride, unsigned count)
+{
+	glm_mat4_mulv_soa_avx512(m, v, dest, stride, count);
+}
+
+static void batch_quat_mul(versor* a, versor* b, versor* dest, unsigned count)
+{
+	glm_quat_mul_batch_avx512(a, b, dest, count);
+}
+
+static void batch_quat_integrate(versor* q, vec4* spins, float time, unsigned count)
+{
+	glm_quat_integrate_batch_avx512(q, spins, time, count);
+}
+
+static void batch_quat_normalize(versor* q, unsigned count)
+{
+	glm_quat_normalize_batch_avx512(q, count);
+}
+
+static void batch_quat_nlerp(versor* from, versor* to, float* t, versor* dest, unsigned count)
+{
+	glm_quat_nlerp_batch_avx512(from, to, t, dest, count);
+}
+
+static void batch_quat_slerp(versor* from, versor* to, float* t, versor* dest, unsigned count)
+{
+	glm_quat_slerp_batch_avx512(from, to, t, dest, count);
+}
+
+int simd_kernels_avx512(struct simd_kernels* kernels)
+{
+	simd_loops(kernels);
+	kernels->mat4_mul = batch_mat4_mul;
+	kernels->mat4_mul_left = batch_mat4_mul_left;
+	kernels->mat4_inv = batch_mat4_inv;
+	kernels->mat4_inv_affine = batch_mat4_inv_affine;
+	kernels->mat4_transpose = batch_mat4_transpose;
+	kernels->mat4_mulv = batch_mat4_mulv;
+	kernels->mat4_mul_soa = batch_mat4_mul_soa;
+	kernels->mat4_inv_soa = batch_mat4_inv_soa;
+	kernels->mat4_inv_affine_soa = batch_mat4_inv_affine_soa;
+	kernels->mat4_transpose_soa = batch_mat4_transpose_soa;
+	kernels->mat4_mulv_soa = batch_mat4_mulv_soa;
+	kernels->quat_mul = batch_quat_mul;
+	kernels->quat_integrate = batch_quat_integrate;
+	kernels->quat_normalize = batch_quat_normalize;
+	kernels->quat_nlerp = batch_quat_nlerp;
+	kernels->quat_slerp = batch_quat_slerp;
+	kernels->ease = avx_ease;
+	kernels->bezier = avx_bezier;
+	kernels->skin = avx_skin;
+	kernels->particles_update = avx_particles_update;
+	kernels->filter_rows = avx_filter_rows;
+	kernels->filter_columns = avx_filter_columns;
+	kernels->occlusion_rasterize = avx_occlusion_rasterize;
+	return 1;
+}
+#else
+int simd_kernels_avx512(struct simd_kernels* kernels)
+{
+	(void)kernels;
+	return 0;
+}
+#endif // __AVX512F__
@@ -0,0 +1,355 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef SIMD_EASE_H
+#define SIMD_EASE_H
+
+// Easing curves of cglm/ease.h and the cubic bezier of glm_bezier for AVX
+// and wider, included by the simd_avx*.c files. Sine and powers of two are
+// polynomials, piecewise curves evaluate every piece and blend, a full
+// register of amounts at a time, AVX-512 builds at their full width.
+
+#include <string.h>
+#include <immintrin.h>
+#include "simd_kernels.h"
+
+#if defined(__AVX512F__)
+#define EASE_LANES 16
+#define ease_vec __m512
+#define ease_mask __mmask16
+#define EASE_SET1(x) _mm512_set1_ps(x)
+#define EASE_LOAD(p) _mm512_loadu_ps(p)
+#define EASE_STORE(p, a) _mm512_storeu_ps(p, a)
+#define EASE_ADD(a, b) _mm512_add_ps(a, b)
+#define EASE_SUB(a, b) _mm512_sub_ps(a, b)
+#define EASE_MUL(a, b) _mm512_mul_ps(a, b)
+#define EASE_MULADD(a, b, c) _mm512_fmadd_ps(a, b, c)
+#define EASE_SQRT(a) _mm512_sqrt_ps(a)
+#define EASE_MIN(a, b) _mm512_min_ps(a, b)
+#define EASE_MAX(a, b) _mm512_max_ps(a, b)
+#define EASE_ROUND(a) _mm512_roundscale_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+#define EASE_LT(a, b) _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ)
+#define EASE_EQ(a, b) _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ)
+#define EASE_OR(m, n) ((m) | (n))
+#define EASE_SELECT(m, a, b) _mm512_mask_blend_ps(m, b, a)
+#define EASE_POW2I(k) \
+	_mm512_castsi512_ps(_mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(k), _mm512_set1_epi32(127)), 23))
+#else
+#define EASE_LANES 8
+#define ease_vec __m256
+#define ease_mask __m256
+#define EASE_SET1(x) _mm256_set1_ps(x)
+#define EASE_LOAD(p) _mm256_loadu_ps(p)
+#define EASE_STORE(p, a) _mm256_storeu_ps(p, a)
+#define EASE_ADD(a, b) _mm256_add_ps(a, b)
+#define EASE_SUB(a, b) _mm256_sub_ps(a, b)
+#define EASE_MUL(a, b) _mm256_mul_ps(a, b)
+#ifdef __FMA__
+#define EASE_MULADD(a, b, c) _mm256_fmadd_ps(a, b, c)
+#else
+#define EASE_MULADD(a, b, c) _mm256_add_ps(_mm256_mul_ps(a, b), c)
+#endif
+#define EASE_SQRT(a) _mm256_sqrt_ps(a)
+#define EASE_MIN(a, b) _mm256_min_ps(a, b)
+#define EASE_MAX(a, b) _mm256_max_ps(a, b)
+#define EASE_ROUND(a) _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+#define EASE_LT(a, b) _mm256_cmp_ps(a, b, _CMP_LT_OQ)
+#define EASE_EQ(a, b) _mm256_cmp_ps(a, b, _CMP_EQ_OQ)
+#define EASE_OR(m, n) _mm256_or_ps(m, n)
+#define EASE_SELECT(m, a, b) _mm256_blendv_ps(b, a, m)
+#ifdef __AVX2__
+#define EASE_POW2I(k) \
+	_mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(k), _mm256_set1_epi32(127)), 23))
+#else
+#define EASE_POW2I(k) ease_pow2i(k)
+
+// AVX has no wide integer math, the halves take SSE2
+static __m256 ease_pow2i(__m256 k)
+{
+	const __m256i i = _mm256_cvtps_epi32(k);
+	const __m128i bias = _mm_set1_epi32(127);
+	const __m128i low = _mm_slli_epi32(_mm_add_epi32(_mm256_castsi256_si128(i), bias), 23);
+	const __m128i high = _mm_slli_epi32(_mm_add_epi32(_mm256_extractf128_si256(i, 1), bias), 23);
+	return _mm256_castsi256_ps(_mm256_insertf128_si256(_mm256_castsi128_si256(low), high, 1));
+}
+#endif
+#endif
+
+#define EASE_HALF_PI 1.5707963f
+#define EASE_ELASTIC 20.420352f // 13 pi / 2
+#define EASE_BACK 1.70158f
+#define EASE_BACK_INOUT 2.5949095f // EASE_BACK * 1.525
+
+// Any angle: reduced to -pi..pi, halved into the range of the series and
+// doubled back
+static ease_vec ease_sin(ease_vec x)
+{
+	ease_vec k, xx, s, c;
+
+	k = EASE_ROUND(EASE_MUL(x, EASE_SET1(0.15915494f)));
+	x = EASE_SUB(x, EASE_MUL(k, EASE_SET1(6.28125f)));
+	x = EASE_SUB(x, EASE_MUL(k, EASE_SET1(1.9353072e-3f)));
+	x = EASE_MUL(x, EASE_SET1(0.5f));
+	xx = EASE_MUL(x, x);
+
+	s = EASE_MULADD(xx, EASE_SET1(-2.5052108e-8f), EASE_SET1(2.7557319e-6f));
+	s = EASE_MULADD(xx, s, EASE_SET1(-1.9841270e-4f));
+	s = EASE_MULADD(xx, s, EASE_SET1(8.3333333e-3f));
+	s = EASE_MULADD(xx, s, EASE_SET1(-1.6666667e-1f));
+	s = EASE_MULADD(EASE_MUL(xx, x), s, x);
+
+	c = EASE_MULADD(xx, EASE_SET1(2.0876757e-9f), EASE_SET1(-2.7557319e-7f));
+	c = EASE_MULADD(xx, c, EASE_SET1(2.4801587e-5f));
+	c = EASE_MULADD(xx, c, EASE_SET1(-1.3888889e-3f));
+	c = EASE_MULADD(xx, c, EASE_SET1(4.1666667e-2f));
+	c = EASE_MULADD(xx, c, EASE_SET1(-0.5f));
+	c = EASE_MULADD(xx, c, EASE_SET1(1.0f));
+	return EASE_MUL(EASE_ADD(s, s), c);
+}
+
+// 2 to the nearest integer power from the exponent bits, times a Taylor
+// series of 2 to the rest
+static ease_vec ease_exp2(ease_vec x)
+{
+	ease_vec k, f, p;
+
+	x = EASE_MAX(EASE_MIN(x, EASE_SET1(126.0f)), EASE_SET1(-126.0f));
+	k = EASE_ROUND(x);
+	f = EASE_SUB(x, k);
+	p = EASE_MULADD(f, EASE_SET1(1.5403530e-4f), EASE_SET1(1.3333558e-3f));
+	p = EASE_MULADD(f, p, EASE_SET1(9.6181291e-3f));
+	p = EASE_MULADD(f, p, EASE_SET1(5.5504109e-2f));
+	p = EASE_MULADD(f, p, EASE_SET1(2.4022651e-1f));
+	p = EASE_MULADD(f, p, EASE_SET1(6.9314718e-1f));
+	p = EASE_MULADD(f, p, EASE_SET1(1.0f));
+	return EASE_MUL(p, EASE_POW2I(k));
+}
+
+static ease_vec ease_bounce_out(ease_vec t)
+{
+	const ease_vec tt = EASE_MUL(t, t);
+	ease_vec a, b, c, d;
+
+	a = EASE_MUL(tt, EASE_SET1(121.0f / 16.0f));
+	b = EASE_MULADD(EASE_SET1(363.0f / 40.0f), tt, EASE_MULADD(EASE_SET1(-99.0f / 10.0f), t, EASE_SET1(17.0f / 5.0f)));
+	c = EASE_MULADD(EASE_SET1(4356.0f / 361.0f), tt,
+					EASE_MULADD(EASE_SET1(-35442.0f / 1805.0f), t, EASE_SET1(16061.0f / 1805.0f)));
+	d = EASE_MULADD(EASE_SET1(54.0f / 5.0f), tt, EASE_MULADD(EASE_SET1(-513.0f / 25.0f), t, EASE_SET1(268.0f / 25.0f)));
+	d = EASE_SELECT(EASE_LT(t, EASE_SET1(9.0f / 10.0f)), c, d);
+	d = EASE_SELECT(EASE_LT(t, EASE_SET1(8.0f / 11.0f)), b, d);
+	return EASE_SELECT(EASE_LT(t, EASE_SET1(4.0f / 11.0f)), a, d);
+}
+
+static ease_vec ease_curve(enum simd_ease_curve curve, ease_vec t)
+{
+	const ease_vec one = EASE_SET1(1.0f);
+	const ease_vec half = EASE_SET1(0.5f);
+	const ease_mask first = EASE_LT(t, half);
+	ease_vec f, g, a, b;
+
+	switch (curve)
+	{
+	case SIMD_EASE_SINE_IN:
+		return EASE_ADD(ease_sin(EASE_MUL(EASE_SUB(t, one), EASE_SET1(EASE_HALF_PI))), one);
+	case SIMD_EASE_SINE_OUT:
+		return ease_sin(EASE_MUL(t, EASE_SET1(EASE_HALF_PI)));
+	case SIMD_EASE_SINE_INOUT:
+		// (1 - cos 2x) / 2 is sin x squared
+		f = ease_sin(EASE_MUL(t, EASE_SET1(EASE_HALF_PI)));
+		return EASE_MUL(f, f);
+	case SIMD_EASE_QUAD_IN:
+		return EASE_MUL(t, t);
+	case SIMD_EASE_QUAD_OUT:
+		return EASE_MUL(t, EASE_SUB(EASE_SET1(2.0f), t));
+	case SIMD_EASE_QUAD_INOUT:
+		f = EASE_MUL(t, t);
+		a = EASE_MUL(f, EASE_SET1(2.0f));
+		b = EASE_MULADD(f, EASE_SET1(-2.0f), EASE_MULADD(t, EASE_SET1(4.0f), EASE_SET1(-1.0f)));
+		return EASE_SELECT(first, a, b);
+	case SIMD_EASE_CUBIC_IN:
+		return EASE_MUL(EASE_MUL(t, t), t);
+	case SIMD_EASE_CUBIC_OUT:
+		f = EASE_SUB(t, one);
+		return EASE_MULADD(EASE_MUL(f, f), f, one);
+	case SIMD_EASE_CUBIC_INOUT:
+		a = EASE_MUL(EASE_MUL(EASE_MUL(t, t), t), EASE_SET1(4.0f));
+		f = EASE_MULADD(t, EASE_SET1(2.0f), EASE_SET1(-2.0f));
+		b = EASE_MULADD(EASE_MUL(EASE_MUL(f, f), f), half, one);
+		return EASE_SELECT(first, a, b);
+	case SIMD_EASE_QUART_IN:
+		f = EASE_MUL(t, t);
+		return EASE_MUL(f, f);
+	case SIMD_EASE_QUART_OUT:
+		f = EASE_SUB(t, one);
+		return EASE_MULADD(EASE_MUL(EASE_MUL(f, f), f), EASE_SUB(one, t), one);
+	case SIMD_EASE_QUART_INOUT:
+		f = EASE_MUL(t, t);
+		a = EASE_MUL(EASE_MUL(f, f), EASE_SET1(8.0f));
+		g = EASE_SUB(t, one);
+		g = EASE_MUL(g, g);
+		b = EASE_MULADD(EASE_MUL(g, g), EASE_SET1(-8.0f), one);
+		return EASE_SELECT(first, a, b);
+	case SIMD_EASE_QUINT_IN:
+		f = EASE_MUL(t, t);
+		return EASE_MUL(EASE_MUL(f, f), t);
+	case SIMD_EASE_QUINT_OUT:
+		f = EASE_SUB(t, one);
+		g = EASE_MUL(f, f);
+		return EASE_MULADD(EASE_MUL(g, g), f, one);
+	case SIMD_EASE_QUINT_INOUT:
+		f = EASE_MUL(t, t);
+		a = EASE_MUL(EASE_MUL(EASE_MUL(f, f), t), EASE_SET1(16.0f));
+		f = EASE_MULADD(t, EASE_SET1(2.0f), EASE_SET1(-2.0f));
+		g = EASE_MUL(f, f);
+		b = EASE_MULADD(EASE_MUL(EASE_MUL(g, g), f), half, one);
+		return EASE_SELECT(first, a, b);
+	case SIMD_EASE_EXP_IN:
+		f = ease_exp2(EASE_MUL(EASE_SUB(t, one), EASE_SET1(10.0f)));
+		return EASE_SELECT(EASE_EQ(t, EASE_SET1(0.0f)), t, f);
+	case SIMD_EASE_EXP_OUT:
+		f = EASE_SUB(one, ease_exp2(EASE_MUL(t, EASE_SET1(-10.0f))));
+		return EASE_SELECT(EASE_EQ(t, one), t, f);
+	case SIMD_EASE_EXP_INOUT:
+		f = EASE_MULADD(t, EASE_SET1(20.0f), EASE_SET1(-10.0f));
+		f = EASE_MUL(ease_exp2(EASE_SELECT(first, f, EASE_SUB(EASE_SET1(0.0f), f))), half);
+		f = EASE_SELECT(first, f, EASE_SUB(one, f));
+		return EASE_SELECT(EASE_OR(EASE_EQ(t, EASE_SET1(0.0f)), EASE_EQ(t, one)), t, f);
+	case SIMD_EASE_CIRC_IN:
+		return EASE_SUB(one, EASE_SQRT(EASE_SUB(one, EASE_MUL(t, t))));
+	case SIMD_EASE_CIRC_OUT:
+		return EASE_SQRT(EASE_MUL(EASE_SUB(EASE_SET1(2.0f), t), t));
+	case SIMD_EASE_CIRC_INOUT:
+		a = EASE_MUL(EASE_SUB(one, EASE_SQRT(EASE_SUB(one, EASE_MUL(EASE_MUL(t, t), EASE_SET1(4.0f))))), half);
+		f = EASE_MULADD(t, EASE_SET1(2.0f), EASE_SET1(-3.0f));
+		g = EASE_MULADD(t, EASE_SET1(2.0f), EASE_SET1(-1.0f));
+		b = EASE_MUL(EASE_ADD(EASE_SQRT(EASE_SUB(EASE_SET1(0.0f), EASE_MUL(f, g))), one), half);
+		return EASE_SELECT(first, a, b);
+	case SIMD_EASE_BACK_IN:
+		f = EASE_MULADD(t, EASE_SET1(EASE_BACK + 1.0f), EASE_SET1(-EASE_BACK));
+		return EASE_MUL(EASE_MUL(t, t), f);
+	case SIMD_EASE_BACK_OUT:
+		f = EASE_SUB(t, one);
+		g = EASE_MULADD(f, EASE_SET1(EASE_BACK + 1.0f), EASE_SET1(EASE_BACK));
+		return EASE_MULADD(EASE_MUL(f, f), g, one);
+	case SIMD_EASE_BACK_INOUT:
+		f = EASE_ADD(t, t);
+		g = EASE_MULADD(f, EASE_SET1(EASE_BACK_INOUT + 1.0f), EASE_SET1(-EASE_BACK_INOUT));
+		a = EASE_MUL(EASE_MUL(EASE_MUL(f, f), g), half);
+		f = EASE_SUB(f, EASE_SET1(2.0f));
+		g = EASE_MULADD(f, EASE_SET1(EASE_BACK_INOUT + 1.0f), EASE_SET1(EASE_BACK_INOUT));
+		b = EASE_MUL(EASE_MULADD(EASE_MUL(f, f), g, EASE_SET1(2.0f)), half);
+		return EASE_SELECT(first, a, b);
+	case SIMD_EASE_ELASTIC_IN:
+		f = ease_sin(EASE_MUL(t, EASE_SET1(EASE_ELASTIC)));
+		return EASE_MUL(f, ease_exp2(EASE_MUL(EASE_SUB(t, one), EASE_SET1(10.0f))));
+	case SIMD_EASE_ELASTIC_OUT:
+		f = ease_sin(EASE_MUL(EASE_ADD(t, one), EASE_SET1(-EASE_ELASTIC)));
+		return EASE_MULADD(f, ease_exp2(EASE_MUL(t, EASE_SET1(-10.0f))), one);
+	case SIMD_EASE_ELASTIC_INOUT:
+		// The second half is the first mirrored: sine and exponent negated
+		f = EASE_ADD(t, t);
+		a = EASE_MUL(ease_sin(EASE_MUL(f, EASE_SET1(EASE_ELASTIC))), half);
+		g = EASE_MUL(EASE_SUB(f, one), EASE_SET1(10.0f));
+		f = EASE_MUL(a, ease_exp2(EASE_SELECT(first, g, EASE_SUB(EASE_SET1(0.0f), g))));
+		return EASE_SELECT(first, f, EASE_SUB(one, f));
+	case SIMD_EASE_BOUNCE_IN:
+		return EASE_SUB(one, ease_bounce_out(EASE_SUB(one, t)));
+	case SIMD_EASE_BOUNCE_OUT:
+		return ease_bounce_out(t);
+	case SIMD_EASE_BOUNCE_INOUT:
+		f = EASE_ADD(t, t);
+		f = ease_bounce_out(EASE_SELECT(first, f, EASE_SUB(f, one)));
+		return EASE_SELECT(first, EASE_MUL(EASE_SUB(one, f), half), EASE_MULADD(f, half, half));
+	default:
+		return t;
+	}
+}
+
+static void avx_ease(enum simd_ease_curve curve, const float* t, float* dest, unsigned count)
+{
+	float tail[EASE_LANES];
+	unsigned i;
+
+	for (i = 0; i + EASE_LANES <= count; i += EASE_LANES)
+		EASE_STORE(dest + i, ease_curve(curve, EASE_LOAD(t + i)));
+	if (i < count)
+	{
+		memset(tail, 0, sizeof(tail));
+		memcpy(tail, t + i, (count - i) * sizeof(float));
+		EASE_STORE(tail, ease_curve(curve, EASE_LOAD(tail)));
+		memcpy(dest + i, tail, (count - i) * sizeof(float));
+	}
+}
+
+// glm_bezier from 0 to 1, where the end terms drop out
+static ease_vec ease_bezier(ease_vec c0, ease_vec c1, ease_vec s)
+{
+	const ease_vec ss = EASE_MUL(s, s);
+	const ease_vec xs3 = EASE_MUL(EASE_SUB(s, ss), EASE_SET1(3.0f));
+	const ease_vec a = EASE_MUL(c0, xs3);
+	return EASE_MULADD(s, EASE_SUB(EASE_MULADD(c1, xs3, ss), a), a);
+}
+
+static void avx_bezier(float c0, float c1, const float* t, float* dest, unsigned count)
+{
+	const ease_vec first = EASE_SET1(c0);
+	const ease_vec second = EASE_SET1(c1);
+	float tail[EASE_LANES];
+	unsigned i;
+
+	for (i = 0; i + EASE_LANES <= count; i += EASE_LANES)
+		EASE_STORE(dest + i, ease_bezier(first, second, EASE_LOAD(t + i)));
+	if (i < count)
+	{
+		memset(tail, 0, sizeof(tail));
+		memcpy(tail, t + i, (count - i) * sizeof(float));
+		EASE_STORE(tail, ease_bezier(first, second, EASE_LOAD(tail)));
+		memcpy(dest + i, tail, (count - i) * sizeof(float));
+	}
+}
+
+#undef EASE_LANES
+#undef ease_vec
+#undef ease_mask
+#undef EASE_SET1
+#undef EASE_LOAD
+#undef EASE_STORE
+#undef EASE_ADD
+#undef EASE_SUB
+#undef EASE_MUL
+#undef EASE_MULADD
+#undef EASE_SQRT
+#undef EASE_MIN
+#undef EASE_MAX
+#undef EASE_ROUND
+#undef EASE_LT
+#undef EASE_EQ
+#undef EASE_OR
+#undef EASE_SELECT
+#undef EASE_POW2I
+#undef EASE_HALF_PI
+#undef EASE_ELASTIC
+#undef EASE_BACK
+#undef EASE_BACK_INOUT
+
+#endif // SIMD_EASE_H
@@ -0,0 +1,89 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef SIMD_FILTER_H
+#define SIMD_FILTER_H
+
+// Mipmap filter taps for AVX and wider, included by the simd_avx*.c files.
+// Rows are filtered eight floats at a time, columns two RGBA pixels at a
+// time, see mipmap.c.
+
+#include <immintrin.h>
+#include "simd_kernels.h"
+
+#ifdef __FMA__
+#define FILTER_MULADD(a, b, c) _mm256_fmadd_ps(a, b, c)
+#else
+#define FILTER_MULADD(a, b, c) _mm256_add_ps(_mm256_mul_ps(a, b), c)
+#endif
+
+static void avx_filter_rows(float* dest, const float** rows, const float* weights, unsigned taps, unsigned count)
+{
+	unsigned i = 0, k;
+	__m256 sum;
+	float tail;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		sum = _mm256_mul_ps(_mm256_loadu_ps(rows[0] + i), _mm256_set1_ps(weights[0]));
+		for (k = 1; k < taps; ++k)
+			sum = FILTER_MULADD(_mm256_loadu_ps(rows[k] + i), _mm256_set1_ps(weights[k]), sum);
+		_mm256_storeu_ps(dest + i, sum);
+	}
+	for (; i < count; ++i)
+	{
+		tail = 0.0f;
+		for (k = 0; k < taps; ++k)
+			tail += rows[k][i] * weights[k];
+		dest[i] = tail;
+	}
+}
+
+static void avx_filter_columns(float* dest, const float* padded, const float* weights, unsigned taps, unsigned width)
+{
+	const float* pixel;
+	unsigned x = 0, k;
+	__m256 sum, pair;
+	__m128 single;
+
+	for (; x + 2 <= width; x += 2)
+	{
+		sum = _mm256_setzero_ps();
+		for (k = 0; k < taps; ++k)
+		{
+			pixel = padded + (x * 2 + k) * 4;
+			pair = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pixel)), _mm_loadu_ps(pixel + 8), 1);
+			sum = FILTER_MULADD(pair, _mm256_set1_ps(weights[k]), sum);
+		}
+		_mm256_storeu_ps(dest + x * 4, sum);
+	}
+	for (; x < width; ++x)
+	{
+		single = _mm_setzero_ps();
+		for (k = 0; k < taps; ++k)
+			single = _mm_add_ps(single, _mm_mul_ps(_mm_loadu_ps(padded + (x * 2 + k) * 4), _mm_set1_ps(weights[k])));
+		_mm_storeu_ps(dest + x * 4, single);
+	}
+}
+
+#endif // SIMD_FILTER_H
@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include "cglm/types.h"
+#include "simd.h"
+
+struct occluder_triangle;
+struct skin_vertex;
+struct skinned_vertex;
+
+// Entry points of one instruction set, see simd.h
+struct simd_kernels
+{
+	void (*mat4_mul)(mat4* a, mat4* b, mat4* dest, unsigned count);
+	void (*mat4_mul_left)(mat4 left, mat4* right, mat4* dest, unsigned count);
+	void (*mat4_inv)(mat4* m, mat4* dest, unsigned count);
+	void (*mat4_inv_affine)(mat4* m, mat4* dest, unsigned count);
+	void (*mat4_transpose)(mat4* m, mat4* dest, unsigned count);
+	void (*mat4_mulv)(mat4 m, vec4* v, vec4* dest, unsigned count);
+	void (*mat4_mul_soa)(float* a, float* b, float* dest, unsigned stride, unsigned count);
+	void (*mat4_inv_soa)(float* m, float* dest, unsigned stride, unsigned count);
+	void (*mat4_inv_affine_soa)(float* m, float* dest, unsigned stride, unsigned count);
+	void (*mat4_transpose_soa)(float* m, float* dest, unsigned stride, unsigned count);
+	void (*mat4_mulv_soa)(float* m, float* v, float* dest, unsigned stride, unsigned count);
+	void (*quat_mul)(versor* a, versor* b, versor* dest, unsigned count);
+	void (*quat_rotatev)(versor* q, vec3* v, vec3* dest, unsigned count);
+	void (*quat_integrate)(versor* q, vec4* spins, float time, unsigned count);
+	void (*quat_normalize)(versor* q, unsigned count);
+	void (*quat_nlerp)(versor* from, versor* to, float* t, versor* dest, unsigned count);
+	void (*quat_slerp)(versor* from, versor* to, float* t, versor* dest, unsigned count);
+	void (*ease)(enum simd_ease_curve curve, const float* t, float* dest, unsigned count);
+	void (*bezier)(float c0, float c1, const float* t, float* dest, unsigned count);
+	void (*skin)(mat4* palette, struct skin_vertex* vertices, struct skinned_vertex* dest, unsigned count);
+	unsigned (*particles_update)(float* positions, float* velocities, float* lives, unsigned stride, vec3 acceleration,
+								 float time, unsigned* dead, unsigned count);
+	void (*filter_rows)(float* dest, const float** rows, const float* weights, unsigned taps, unsigned count);
+	void (*filter_columns)(float* dest, const float* padded, const float* weights, unsigned taps, unsigned width);
+	void (*occlusion_rasterize)(float* depth, const struct occluder_triangle* triangle, int tile_x, int tile_y);
+};
+
+// Each fills the table with the kernels of its translation unit and fails
+// when the unit was built without its instruction set
+int simd_kernels_avx(struct simd_kernels* kernels);
+int simd_kernels_avx2(struct simd_kernels* kernels);
+int simd_kernels_avx512(struct simd_kernels* kernels);
+
+#endif // SIMD_KERNELS_H
@@ -0,0 +1,480 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef SIMD_LOOPS_H
+#define SIMD_LOOPS_H
+
+// Batch kernels written as loops over cglm, included by every simd_*.c
+// file. Each of them is compiled for its own instruction set, so the same
+// loops pick up the cglm routines and code generation of that set.
+
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "cglm/affine.h"
+#include "cglm/bezier.h"
+#include "cglm/ease.h"
+#include "cglm/mat4.h"
+#include "cglm/quat.h"
+#include "occlusion.h"
+#include "simd_kernels.h"
+#include "skeleton.h"
+
+static void loop_mat4_mul(mat4* a, mat4* b, mat4* dest, unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; ++i)
+		glm_mat4_mul(a[i], b[i], dest[i]);
+}
+
+static void loop_mat4_mul_left(mat4 left, mat4* right, mat4* dest, unsigned count)
+{
+	mat4 l;
+	unsigned i;
+	// A copy, so that the compiler may keep it in registers even though
+	// the destination could overlap it
+	glm_mat4_copy(left, l);
+	for (i = 0; i < count; ++i)
+		glm_mat4_mul(l, right[i], dest[i]);
+}
+
+static void loop_mat4_inv(mat4* m, mat4* dest, unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; ++i)
+		glm_mat4_inv(m[i], dest[i]);
+}
+
+// The general inverse is exact for affine matrices too, the wider sets
+// replace it with a cheaper 3x3 one
+static void loop_mat4_inv_affine(mat4* m, mat4* dest, unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; ++i)
+		glm_mat4_inv(m[i], dest[i]);
+}
+
+static void loop_mat4_transpose(mat4* m, mat4* dest, unsigned count)
+{
+	mat4 t;
+	unsigned i;
+	for (i = 0; i < count; ++i)
+	{
+		glm_mat4_transpose_to(m[i], t);
+		glm_mat4_copy(t, dest[i]);
+	}
+}
+
+static void loop_mat4_mulv(mat4 m, vec4* v, vec4* dest, unsigned count)
+{
+	mat4 l;
+	unsigned i;
+	glm_mat4_copy(m, l);
+	for (i = 0; i < count; ++i)
+		glm_mat4_mulv(l, v[i], dest[i]);
+}
+
+static void soa_get(float* soa, unsigned stride, unsigned i, float* x, unsigned elements)
+{
+	unsigned e;
+	for (e = 0; e < elements; ++e)
+		x[e] = soa[e * stride + i];
+}
+
+static void soa_set(float* soa, unsigned stride, unsigned i, float* x, unsigned elements)
+{
+	unsigned e;
+	for (e = 0; e < elements; ++e)
+		soa[e * stride + i] = x[e];
+}
+
+static void loop_mat4_mul_soa(float* a, float* b, float* dest, unsigned stride, unsigned count)
+{
+	mat4 l, r;
+	unsigned i;
+	for (i = 0; i < count; ++i)
+	{
+		soa_get(a, stride, i, l[0], 16);
+		soa_get(b, stride, i, r[0], 16);
+		glm_mat4_mul(l, r, l);
+		soa_set(dest, stride, i, l[0], 16);
+	}
+}
+
+static void loop_mat4_inv_soa(float* m, float* dest, unsigned stride, unsigned count)
+{
+	mat4 s, t;
+	unsigned i;
+	for (i = 0; i < count; ++i)
+	{
+		soa_get(m, stride, i, s[0], 16);
+		glm_mat4_inv(s, t);
+		soa_set(dest, stride, i, t[0], 16);
+	}
+}
+
+static void loop_mat4_transpose_soa(float* m, float* dest, unsigned stride, unsigned count)
+{
+	mat4 s;
+	unsigned i;
+	for (i = 0; i < count; ++i)
+	{
+		soa_get(m, stride, i, s[0], 16);
+		glm_mat4_transpose(s);
+		soa_set(dest, stride, i, s[0], 16);
+	}
+}
+
+static void loop_mat4_mulv_soa(float* m, float* v, float* dest, unsigned stride, unsigned count)
+{
+	mat4 s;
+	vec4 t;
+	unsigned i;
+	for (i = 0; i < count; ++i)
+	{
+		soa_get(m, stride, i, s[0], 16);
+		soa_get(v, stride, i, t, 4);
+		glm_mat4_mulv(s, t, t);
+		soa_set(dest, stride, i, t, 4);
+	}
+}
+
+// Scalar quaternion routines write the destination while reading sources
+static void loop_quat_mul(versor* a, versor* b, versor* dest, unsigned count)
+{
+	versor q;
+	unsigned i;
+	for (i = 0; i < count; ++i)
+	{
+		glm_quat_mul(a[i], b[i], q);
+		glm_quat_copy(q, dest[i]);
+	}
+}
+
+static void loop_quat_rotatev(versor* q, vec3* v, vec3* dest, unsigned count)
+{
+	vec3 r;
+	unsigned i;
+	for (i = 0; i < count; ++i)
+	{
+		glm_quat_rotatev(q[i], v[i], r);
+		glm_vec3_copy(r, dest[i]);
+	}
+}
+
+// Spin axes are unit length already, glm_quatv would normalize them again
+static void loop_quat_integrate(versor* q, vec4* spins, float time, unsigned count)
+{
+	versor step, r;
+	float angle;
+	unsigned i;
+	for (i = 0; i < count; ++i)
+	{
+		angle = time * spins[i][3] * 0.5f;
+		glm_vec3_scale(spins[i], sinf(angle), step);
+		step[3] = cosf(angle);
+		glm_quat_mul(step, q[i], r);
+		glm_quat_copy(r, q[i]);
+	}
+}
+
+static void loop_quat_normalize(versor* q, unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; ++i)
+		glm_quat_normalize(q[i]);
+}
+
+// Turns to towards the hemisphere of from, returns the cosine between them
+static float quat_shortest(versor from, versor to, versor dest)
+{
+	float dot = glm_quat_dot(from, to);
+	if (dot < 0.0f)
+	{
+		glm_vec4_negate_to(to, dest);
+		return -dot;
+	}
+	glm_quat_copy(to, dest);
+	return dot;
+}
+
+static void loop_quat_nlerp(versor* from, versor* to, float* t, versor* dest, unsigned count)
+{
+	versor r;
+	unsigned i;
+	for (i = 0; i < count; ++i)
+	{
+		quat_shortest(from[i], to[i], r);
+		glm_vec4_lerp(from[i], r, t[i], dest[i]);
+		glm_quat_normalize(dest[i]);
+	}
+}
+
+// glm_quat_slerp lerps towards the unflipped quaternion when they are
+// nearly equal and otherwise does not normalize, so this one is spelled out
+static void loop_quat_slerp(versor* from, versor* to, float* t, versor* dest, unsigned count)
+{
+	versor r;
+	float cosine, angle, sine, wa, wb;
+	unsigned i;
+	for (i = 0; i < count; ++i)
+	{
+		cosine = quat_shortest(from[i], to[i], r);
+		angle = acosf(glm_min(cosine, 1.0f));
+		sine = sinf(angle);
+		if (sine < 0.001f)
+		{
+			wa = 1.0f - t[i];
+			wb = t[i];
+		}
+		else
+		{
+			wa = sinf((1.0f - t[i]) * angle) / sine;
+			wb = sinf(t[i] * angle) / sine;
+		}
+		glm_vec4_scale(from[i], wa, dest[i]);
+		glm_vec4_muladds(r, wb, dest[i]);
+	}
+}
+
+#define EASE_LOOP(curve, func) \
+	case curve: \
+		for (i = 0; i < count; ++i) \
+			dest[i] = func(t[i]); \
+		break;
+
+static void loop_ease(enum simd_ease_curve curve, const float* t, float* dest, unsigned count)
+{
+	unsigned i;
+	switch (curve)
+	{
+		EASE_LOOP(SIMD_EASE_SINE_IN, glm_ease_sine_in)
+		EASE_LOOP(SIMD_EASE_SINE_OUT, glm_ease_sine_out)
+		EASE_LOOP(SIMD_EASE_SINE_INOUT, glm_ease_sine_inout)
+		EASE_LOOP(SIMD_EASE_QUAD_IN, glm_ease_quad_in)
+		EASE_LOOP(SIMD_EASE_QUAD_OUT, glm_ease_quad_out)
+		EASE_LOOP(SIMD_EASE_QUAD_INOUT, glm_ease_quad_inout)
+		EASE_LOOP(SIMD_EASE_CUBIC_IN, glm_ease_cubic_in)
+		EASE_LOOP(SIMD_EASE_CUBIC_OUT, glm_ease_cubic_out)
+		EASE_LOOP(SIMD_EASE_CUBIC_INOUT, glm_ease_cubic_inout)
+		EASE_LOOP(SIMD_EASE_QUART_IN, glm_ease_quart_in)
+		EASE_LOOP(SIMD_EASE_QUART_OUT, glm_ease_quart_out)
+		EASE_LOOP(SIMD_EASE_QUART_INOUT, glm_ease_quart_inout)
+		EASE_LOOP(SIMD_EASE_QUINT_IN, glm_ease_quint_in)
+		EASE_LOOP(SIMD_EASE_QUINT_OUT, glm_ease_quint_out)
+		EASE_LOOP(SIMD_EASE_QUINT_INOUT, glm_ease_quint_inout)
+		EASE_LOOP(SIMD_EASE_EXP_IN, glm_ease_exp_in)
+		EASE_LOOP(SIMD_EASE_EXP_OUT, glm_ease_exp_out)
+		EASE_LOOP(SIMD_EASE_EXP_INOUT, glm_ease_exp_inout)
+		EASE_LOOP(SIMD_EASE_CIRC_IN, glm_ease_circ_in)
+		EASE_LOOP(SIMD_EASE_CIRC_OUT, glm_ease_circ_out)
+		EASE_LOOP(SIMD_EASE_CIRC_INOUT, glm_ease_circ_inout)
+		EASE_LOOP(SIMD_EASE_BACK_IN, glm_ease_back_in)
+		EASE_LOOP(SIMD_EASE_BACK_OUT, glm_ease_back_out)
+		EASE_LOOP(SIMD_EASE_BACK_INOUT, glm_ease_back_inout)
+		EASE_LOOP(SIMD_EASE_ELASTIC_IN, glm_ease_elast_in)
+		EASE_LOOP(SIMD_EASE_ELASTIC_OUT, glm_ease_elast_out)
+		EASE_LOOP(SIMD_EASE_ELASTIC_INOUT, glm_ease_elast_inout)
+		EASE_LOOP(SIMD_EASE_BOUNCE_IN, glm_ease_bounce_in)
+		EASE_LOOP(SIMD_EASE_BOUNCE_OUT, glm_ease_bounce_out)
+		EASE_LOOP(SIMD_EASE_BOUNCE_INOUT, glm_ease_bounce_inout)
+	default:
+		if (dest != t)
+			memmove(dest, t, count * sizeof(float));
+		break;
+	}
+}
+
+#undef EASE_LOOP
+
+static void loop_bezier(float c0, float c1, const float* t, float* dest, unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; ++i)
+		dest[i] = glm_bezier(t[i], 0.0f, c0, c1, 1.0f);
+}
+
+// Blends the affine part of the four joint matrices, the last rows add up
+// to 0 0 0 1 with the weights anyway
+static void loop_skin(mat4* palette, struct skin_vertex* vertices, struct skinned_vertex* dest, unsigned count)
+{
+	mat4 m;
+	vec3 normal;
+	unsigned i, c, k;
+	for (i = 0; i < count; ++i)
+	{
+		for (c = 0; c < 4; ++c)
+		{
+			glm_vec4_scale(palette[vertices[i].joints[0]][c], vertices[i].weights[0], m[c]);
+			for (k = 1; k < 4; ++k)
+				glm_vec4_muladds(palette[vertices[i].joints[k]][c], vertices[i].weights[k], m[c]);
+		}
+		glm_mat4_mulv3(m, vertices[i].position, 1.0f, dest[i].position);
+		glm_mat4_mulv3(m, vertices[i].normal, 0.0f, normal);
+		glm_vec3_normalize_to(normal, dest[i].normal);
+	}
+}
+
+static unsigned loop_particles_update(float* positions, float* velocities, float* lives, unsigned stride, vec3 acceleration,
+									  float time, unsigned* dead, unsigned count)
+{
+	float step;
+	unsigned i, e, found = 0;
+	for (e = 0; e < 3; ++e)
+	{
+		step = acceleration[e] * time;
+		for (i = 0; i < count; ++i)
+		{
+			velocities[e * stride + i] += step;
+			positions[e * stride + i] += velocities[e * stride + i] * time;
+		}
+	}
+	for (i = 0; i < count; ++i)
+	{
+		lives[i] -= time;
+		if (lives[i] <= 0.0f)
+			dead[found++] = i;
+	}
+	return found;
+}
+
+static void loop_filter_rows(float* dest, const float** rows, const float* weights, unsigned taps, unsigned count)
+{
+	unsigned i, k;
+	float sum;
+	for (i = 0; i < count; ++i)
+	{
+		sum = 0.0f;
+		for (k = 0; k < taps; ++k)
+			sum += rows[k][i] * weights[k];
+		dest[i] = sum;
+	}
+}
+
+// One RGBA pixel is one vec4, copied out since the rows are only float aligned
+static void loop_filter_columns(float* dest, const float* padded, const float* weights, unsigned taps, unsigned width)
+{
+	vec4 sum, pixel;
+	unsigned x, k;
+	for (x = 0; x < width; ++x)
+	{
+		glm_vec4_zero(sum);
+		for (k = 0; k < taps; ++k)
+		{
+			glm_vec4_ucopy((float*)padded + (x * 2 + k) * 4, pixel);
+			glm_vec4_muladds(pixel, weights[k], sum);
+		}
+		glm_vec4_ucopy(sum, dest + x * 4);
+	}
+}
+
+// SSE2 takes groups of four pixels starting on a group boundary; tile
+// widths are a multiple of four, so groups never leave the tile
+static void loop_occlusion_rasterize(float* depth, const struct occluder_triangle* triangle, int tile_x, int tile_y)
+{
+	const int last_x = triangle->max_x < tile_x + OCCLUSION_TILE_SIZE - 1 ? triangle->max_x : tile_x + OCCLUSION_TILE_SIZE - 1;
+	const int first_y = triangle->min_y > tile_y ? triangle->min_y : tile_y;
+	const int last_y = triangle->max_y < tile_y + OCCLUSION_TILE_SIZE - 1 ? triangle->max_y : tile_y + OCCLUSION_TILE_SIZE - 1;
+	float py;
+	float* row;
+	int x, y;
+
+#if defined(__SSE2__)
+	const int first_x = (triangle->min_x > tile_x ? triangle->min_x : tile_x) & ~3;
+	const __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 edge0 = _mm_set1_ps(triangle->edges[0][0]);
+	const __m128 edge1 = _mm_set1_ps(triangle->edges[1][0]);
+	const __m128 edge2 = _mm_set1_ps(triangle->edges[2][0]);
+	const __m128 slope = _mm_set1_ps(triangle->depth[0]);
+	__m128 px, row0, row1, row2, row_depth, inside, current, nearest;
+
+	for (y = first_y; y <= last_y; ++y)
+	{
+		py = (float)y + 0.5f;
+		row = depth + y * OCCLUSION_WIDTH;
+		row0 = _mm_set1_ps(triangle->edges[0][1] * py + triangle->edges[0][2]);
+		row1 = _mm_set1_ps(triangle->edges[1][1] * py + triangle->edges[1][2]);
+		row2 = _mm_set1_ps(triangle->edges[2][1] * py + triangle->edges[2][2]);
+		row_depth = _mm_set1_ps(triangle->depth[1] * py + triangle->depth[2]);
+		for (x = first_x; x <= last_x; x += 4)
+		{
+			px = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+			inside = _mm_and_ps(_mm_cmpgt_ps(_mm_add_ps(_mm_mul_ps(edge0, px), row0), zero),
+								_mm_cmpgt_ps(_mm_add_ps(_mm_mul_ps(edge1, px), row1), zero));
+			inside = _mm_and_ps(inside, _mm_cmpgt_ps(_mm_add_ps(_mm_mul_ps(edge2, px), row2), zero));
+			current = _mm_loadu_ps(row + x);
+			nearest = _mm_min_ps(current, _mm_add_ps(_mm_mul_ps(slope, px), row_depth));
+			_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+		}
+	}
+#else
+	const int first_x = triangle->min_x > tile_x ? triangle->min_x : tile_x;
+	float px;
+
+	for (y = first_y; y <= last_y; ++y)
+	{
+		py = (float)y + 0.5f;
+		row = depth + y * OCCLUSION_WIDTH;
+		for (x = first_x; x <= last_x; ++x)
+		{
+			px = (float)x + 0.5f;
+			if (triangle->edges[0][0] * px + triangle->edges[0][1] * py + triangle->edges[0][2] > 0.0f &&
+				triangle->edges[1][0] * px + triangle->edges[1][1] * py + triangle->edges[1][2] > 0.0f &&
+				triangle->edges[2][0] * px + triangle->edges[2][1] * py + triangle->edges[2][2] > 0.0f)
+				row[x] = fminf(row[x], triangle->depth[0] * px + triangle->depth[1] * py + triangle->depth[2]);
+		}
+	}
+#endif
+}
+
+static void simd_loops(struct simd_kernels* kernels)
+{
+	kernels->mat4_mul = loop_mat4_mul;
+	kernels->mat4_mul_left = loop_mat4_mul_left;
+	kernels->mat4_inv = loop_mat4_inv;
+	kernels->mat4_inv_affine = loop_mat4_inv_affine;
+	kernels->mat4_transpose = loop_mat4_transpose;
+	kernels->mat4_mulv = loop_mat4_mulv;
+	kernels->mat4_mul_soa = loop_mat4_mul_soa;
+	kernels->mat4_inv_soa = loop_mat4_inv_soa;
+	kernels->mat4_inv_affine_soa = loop_mat4_inv_soa;
+	kernels->mat4_transpose_soa = loop_mat4_transpose_soa;
+	kernels->mat4_mulv_soa = loop_mat4_mulv_soa;
+	kernels->quat_mul = loop_quat_mul;
+	kernels->quat_rotatev = loop_quat_rotatev;
+	kernels->quat_integrate = loop_quat_integrate;
+	kernels->quat_normalize = loop_quat_normalize;
+	kernels->quat_nlerp = loop_quat_nlerp;
+	kernels->quat_slerp = loop_quat_slerp;
+	kernels->ease = loop_ease;
+	kernels->bezier = loop_bezier;
+	kernels->skin = loop_skin;
+	kernels->particles_update = loop_particles_update;
+	kernels->filter_rows = loop_filter_rows;
+	kernels->filter_columns = loop_filter_columns;
+	kernels->occlusion_rasterize = loop_occlusion_rasterize;
+}
+
+#endif // SIMD_LOOPS_H
@@ -0,0 +1,73 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef SIMD_OCCLUSION_H
+#define SIMD_OCCLUSION_H
+
+// Occluder rasterization for AVX and wider, included by the simd_avx*.c
+// files. Rows are walked in groups of eight pixels starting on a group
+// boundary; tile widths are a multiple of eight, so groups never leave the
+// tile.
+
+#include <immintrin.h>
+#include "occlusion.h"
+#include "simd_kernels.h"
+
+static void avx_occlusion_rasterize(float* depth, const struct occluder_triangle* triangle, int tile_x, int tile_y)
+{
+	const int first_x = (triangle->min_x > tile_x ? triangle->min_x : tile_x) & ~7;
+	const int last_x = triangle->max_x < tile_x + OCCLUSION_TILE_SIZE - 1 ? triangle->max_x : tile_x + OCCLUSION_TILE_SIZE - 1;
+	const int first_y = triangle->min_y > tile_y ? triangle->min_y : tile_y;
+	const int last_y = triangle->max_y < tile_y + OCCLUSION_TILE_SIZE - 1 ? triangle->max_y : tile_y + OCCLUSION_TILE_SIZE - 1;
+	const __m256 offsets = _mm256_set_ps(7.5f, 6.5f, 5.5f, 4.5f, 3.5f, 2.5f, 1.5f, 0.5f);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 edge0 = _mm256_set1_ps(triangle->edges[0][0]);
+	const __m256 edge1 = _mm256_set1_ps(triangle->edges[1][0]);
+	const __m256 edge2 = _mm256_set1_ps(triangle->edges[2][0]);
+	const __m256 slope = _mm256_set1_ps(triangle->depth[0]);
+	__m256 px, row0, row1, row2, row_depth, inside, current;
+	float py;
+	float* row;
+	int x, y;
+
+	for (y = first_y; y <= last_y; ++y)
+	{
+		py = (float)y + 0.5f;
+		row = depth + y * OCCLUSION_WIDTH;
+		row0 = _mm256_set1_ps(triangle->edges[0][1] * py + triangle->edges[0][2]);
+		row1 = _mm256_set1_ps(triangle->edges[1][1] * py + triangle->edges[1][2]);
+		row2 = _mm256_set1_ps(triangle->edges[2][1] * py + triangle->edges[2][2]);
+		row_depth = _mm256_set1_ps(triangle->depth[1] * py + triangle->depth[2]);
+		for (x = first_x; x <= last_x; x += 8)
+		{
+			px = _mm256_add_ps(_mm256_set1_ps((float)x), offsets);
+			inside = _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edge0, px), row0), zero, _CMP_GT_OQ),
+								   _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edge1, px), row1), zero, _CMP_GT_OQ));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edge2, px), row2), zero, _CMP_GT_OQ));
+			current = _mm256_loadu_ps(row + x);
+			_mm256_storeu_ps(row + x, _mm256_blendv_ps(current, _mm256_min_ps(current, _mm256_add_ps(_mm256_mul_ps(slope, px), row_depth)), inside));
+		}
+	}
+}
+
+#endif // SIMD_OCCLUSION_H
@@ -0,0 +1,118 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef SIMD_PARTICLES_H
+#define SIMD_PARTICLES_H
+
+// Particle integration for AVX and wider, included by the simd_avx*.c
+// files. Each attribute run is streamed through once, a full register of
+// particles at a time, AVX-512 builds at their full width.
+
+#include <immintrin.h>
+#include "simd_kernels.h"
+
+#if defined(__AVX512F__)
+#define PARTICLE_LANES 16
+#define particle_vec __m512
+#define PARTICLE_SET1(x) _mm512_set1_ps(x)
+#define PARTICLE_LOAD(p) _mm512_loadu_ps(p)
+#define PARTICLE_STORE(p, a) _mm512_storeu_ps(p, a)
+#define PARTICLE_ADD(a, b) _mm512_add_ps(a, b)
+#define PARTICLE_SUB(a, b) _mm512_sub_ps(a, b)
+#define PARTICLE_MULADD(a, b, c) _mm512_fmadd_ps(a, b, c)
+#define PARTICLE_DEAD(a) (unsigned)_mm512_cmp_ps_mask(a, _mm512_setzero_ps(), _CMP_LE_OQ)
+#else
+#define PARTICLE_LANES 8
+#define particle_vec __m256
+#define PARTICLE_SET1(x) _mm256_set1_ps(x)
+#define PARTICLE_LOAD(p) _mm256_loadu_ps(p)
+#define PARTICLE_STORE(p, a) _mm256_storeu_ps(p, a)
+#define PARTICLE_ADD(a, b) _mm256_add_ps(a, b)
+#define PARTICLE_SUB(a, b) _mm256_sub_ps(a, b)
+#ifdef __FMA__
+#define PARTICLE_MULADD(a, b, c) _mm256_fmadd_ps(a, b, c)
+#else
+#define PARTICLE_MULADD(a, b, c) _mm256_add_ps(_mm256_mul_ps(a, b), c)
+#endif
+#define PARTICLE_DEAD(a) (unsigned)_mm256_movemask_ps(_mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_LE_OQ))
+#endif
+
+static unsigned avx_particles_update(float* positions, float* velocities, float* lives, unsigned stride, vec3 acceleration,
+									 float time, unsigned* dead, unsigned count)
+{
+	const unsigned body = count / PARTICLE_LANES * PARTICLE_LANES;
+	const particle_vec t = PARTICLE_SET1(time);
+	particle_vec step, v, l;
+	float* p;
+	float* pv;
+	float s;
+	unsigned i, e, lane, mask, found = 0;
+
+	for (e = 0; e < 3; ++e)
+	{
+		p = positions + e * stride;
+		pv = velocities + e * stride;
+		s = acceleration[e] * time;
+		step = PARTICLE_SET1(s);
+		for (i = 0; i < body; i += PARTICLE_LANES)
+		{
+			v = PARTICLE_ADD(PARTICLE_LOAD(pv + i), step);
+			PARTICLE_STORE(pv + i, v);
+			PARTICLE_STORE(p + i, PARTICLE_MULADD(v, t, PARTICLE_LOAD(p + i)));
+		}
+		for (; i < count; ++i)
+		{
+			pv[i] += s;
+			p[i] += pv[i] * time;
+		}
+	}
+
+	for (i = 0; i < body; i += PARTICLE_LANES)
+	{
+		l = PARTICLE_SUB(PARTICLE_LOAD(lives + i), t);
+		PARTICLE_STORE(lives + i, l);
+		// Deaths are rare enough to walk the mask bit by bit
+		for (mask = PARTICLE_DEAD(l), lane = 0; mask; mask >>= 1, ++lane)
+			if (mask & 1)
+				dead[found++] = i + lane;
+	}
+	for (; i < count; ++i)
+	{
+		lives[i] -= time;
+		if (lives[i] <= 0.0f)
+			dead[found++] = i;
+	}
+	return found;
+}
+
+#undef PARTICLE_LANES
+#undef particle_vec
+#undef PARTICLE_SET1
+#undef PARTICLE_LOAD
+#undef PARTICLE_STORE
+#undef PARTICLE_ADD
+#undef PARTICLE_SUB
+#undef PARTICLE_MULADD
+#undef PARTICLE_DEAD
+
+#endif // SIMD_PARTICLES_H
@@ -0,0 +1,89 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef SIMD_SKIN_H
+#define SIMD_SKIN_H
+
+// Skinning kernel for AVX and wider, included by the simd_avx*.c files.
+// A vertex blends its four joint matrices as two registers of two
+// columns each, then transforms position and normal with the blend.
+// Fetching the joints of eight vertices at once would take gathers that
+// AVX lacks and that are slower than these loads on AVX2 as well.
+
+#include <immintrin.h>
+#include "simd_kernels.h"
+#include "skeleton.h"
+
+#ifdef __FMA__
+#define SKIN_MULADD(a, b, c) _mm256_fmadd_ps(a, b, c)
+#else
+#define SKIN_MULADD(a, b, c) _mm256_add_ps(_mm256_mul_ps(a, b), c)
+#endif
+
+// lo in the low four lanes, hi in the high four
+static inline __m256 skin_pair(float lo, float hi)
+{
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(lo)), _mm_set1_ps(hi), 1);
+}
+
+static void avx_skin(mat4* palette, struct skin_vertex* vertices, struct skinned_vertex* dest, unsigned count)
+{
+	const struct skin_vertex* v;
+	const float* m;
+	__m256 c01, c23, w, p, n;
+	__m128 position, normal, length;
+	unsigned i, k;
+
+	for (i = 0; i < count; ++i)
+	{
+		v = vertices + i;
+		m = palette[v->joints[0]][0];
+		w = _mm256_set1_ps(v->weights[0]);
+		c01 = _mm256_mul_ps(_mm256_loadu_ps(m), w);
+		c23 = _mm256_mul_ps(_mm256_loadu_ps(m + 8), w);
+		for (k = 1; k < 4; ++k)
+		{
+			m = palette[v->joints[k]][0];
+			w = _mm256_set1_ps(v->weights[k]);
+			c01 = SKIN_MULADD(_mm256_loadu_ps(m), w, c01);
+			c23 = SKIN_MULADD(_mm256_loadu_ps(m + 8), w, c23);
+		}
+
+		// c0 * x + c1 * y and c2 * z + c3 side by side, then the halves summed
+		p = SKIN_MULADD(c01, skin_pair(v->position[0], v->position[1]), _mm256_mul_ps(c23, skin_pair(v->position[2], 1.0f)));
+		n = SKIN_MULADD(c01, skin_pair(v->normal[0], v->normal[1]), _mm256_mul_ps(c23, skin_pair(v->normal[2], 0.0f)));
+		position = _mm_add_ps(_mm256_castps256_ps128(p), _mm256_extractf128_ps(p, 1));
+		normal = _mm_add_ps(_mm256_castps256_ps128(n), _mm256_extractf128_ps(n, 1));
+		length = _mm_sqrt_ps(_mm_dp_ps(normal, normal, 0x7F));
+		normal = _mm_div_ps(normal, length);
+
+		// Six floats in two stores, the destination may be write combined
+		// memory that should not be written twice
+		_mm_storeu_ps(dest[i].position, _mm_blend_ps(position, _mm_shuffle_ps(normal, normal, _MM_SHUFFLE(0, 0, 0, 0)), 0x8));
+		_mm_storel_pi((__m64*)(dest[i].normal + 1), _mm_shuffle_ps(normal, normal, _MM_SHUFFLE(3, 3, 2, 1)));
+	}
+}
+
+#undef SKIN_MULADD
+
+#endif // SIMD_SKIN_H
@@ -0,0 +1,197 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cglm/affine.h"
+#include "cglm/quat.h"
+#include "jobs.h"
+#include "simd.h"
+#include "skeleton.h"
+
+#define CHARACTER_GRAIN 16
+#define VERTEX_GRAIN 4096
+
+struct animate_job
+{
+	const struct skeleton* skeleton;
+	const struct animation_clip* clip;
+	float* times;
+	mat4* worlds;
+	mat4* palettes;
+};
+
+struct skin_job
+{
+	struct skin_vertex* vertices;
+	mat4* palettes;
+	struct skinned_vertex* dest;
+	unsigned vertices_count;
+	unsigned joints_count;
+};
+
+int create_skeleton(struct skeleton* skeleton, const unsigned char* parents, mat4* binds, unsigned count)
+{
+	unsigned i;
+
+	if (count > SKELETON_MAX_JOINTS)
+		return 0;
+	for (i = 0; i < count; ++i)
+		if (parents[i] != SKELETON_ROOT && parents[i] >= i)
+			return 0;
+	memcpy(skeleton->parents, parents, count);
+	simd_mat4_inv(binds, skeleton->inverse_binds, count);
+	skeleton->count = count;
+	return 1;
+}
+
+int create_animation_clip(struct animation_clip* clip, unsigned joints_count, unsigned frames_count, float frame_time)
+{
+	memset(clip, 0, sizeof(struct animation_clip));
+	clip->rotations = (versor*)malloc(frames_count * joints_count * sizeof(versor));
+	clip->translations = (vec4*)malloc(frames_count * joints_count * sizeof(vec4));
+	if (!clip->rotations || !clip->translations || joints_count > SKELETON_MAX_JOINTS || !frames_count)
+	{
+		destroy_animation_clip(clip);
+		return 0;
+	}
+	clip->frames_count = frames_count;
+	clip->joints_count = joints_count;
+	clip->frame_time = frame_time;
+	return 1;
+}
+
+void destroy_animation_clip(struct animation_clip* clip)
+{
+	free(clip->translations);
+	free(clip->rotations);
+	memset(clip, 0, sizeof(struct animation_clip));
+}
+
+void sample_animation_clip(const struct animation_clip* clip, float time, versor* rotations, vec4* translations)
+{
+	float t[SKELETON_MAX_JOINTS];
+	const float duration = clip->frames_count * clip->frame_time;
+	float position, alpha;
+	unsigned frame, next, i;
+
+	position = fmodf(time, duration);
+	if (position < 0.0f)
+		position += duration;
+	position /= clip->frame_time;
+	frame = (unsigned)position;
+	if (frame >= clip->frames_count)
+		frame = clip->frames_count - 1;
+	next = (frame + 1) % clip->frames_count;
+	alpha = position - (float)frame;
+
+	// Every joint blends by the same amount, the batch kernel wants one per pair
+	for (i = 0; i < clip->joints_count; ++i)
+		t[i] = alpha;
+	simd_quat_nlerp(clip->rotations + frame * clip->joints_count, clip->rotations + next * clip->joints_count, t,
+					rotations, clip->joints_count);
+	for (i = 0; i < clip->joints_count; ++i)
+		glm_vec4_lerp(clip->translations[frame * clip->joints_count + i], clip->translations[next * clip->joints_count + i],
+					  alpha, translations[i]);
+}
+
+void skeleton_palette(const struct skeleton* skeleton, versor* rotations, vec4* translations, mat4 world, mat4* palette)
+{
+	mat4 models[SKELETON_MAX_JOINTS];
+	mat4 local;
+	unsigned i;
+
+	// Parents are resolved first, so the world transform only enters at the roots
+	for (i = 0; i < skeleton->count; ++i)
+	{
+		glm_quat_mat4(rotations[i], local);
+		glm_vec3_copy(translations[i], local[3]);
+		if (skeleton->parents[i] == SKELETON_ROOT)
+			glm_mul(world, local, models[i]);
+		else
+			glm_mul(models[skeleton->parents[i]], local, models[i]);
+	}
+	simd_mat4_mul(models, (mat4*)skeleton->inverse_binds, palette, skeleton->count);
+}
+
+static void animate_job(void* data, unsigned begin, unsigned end)
+{
+	const struct animate_job* job = (const struct animate_job*)data;
+	versor rotations[SKELETON_MAX_JOINTS];
+	vec4 translations[SKELETON_MAX_JOINTS];
+	unsigned i;
+
+	for (i = begin; i < end; ++i)
+	{
+		sample_animation_clip(job->clip, job->times[i], rotations, translations);
+		skeleton_palette(job->skeleton, rotations, translations, job->worlds[i], job->palettes + i * job->skeleton->count);
+	}
+}
+
+void animate_characters(const struct skeleton* skeleton, const struct animation_clip* clip,
+						float* times, mat4* worlds, mat4* palettes, unsigned count)
+{
+	struct animate_job job;
+	job.skeleton = skeleton;
+	job.clip = clip;
+	job.times = times;
+	job.worlds = worlds;
+	job.palettes = palettes;
+	jobs_parallel_for(animate_job, &job, count, CHARACTER_GRAIN);
+}
+
+// Ranges run over the vertices of all characters, so a few characters with
+// large meshes split as well as many small ones
+static void skin_job(void* data, unsigned begin, unsigned end)
+{
+	const struct skin_job* job = (const struct skin_job*)data;
+	unsigned character = begin / job->vertices_count;
+	unsigned first = begin % job->vertices_count;
+	unsigned count;
+
+	while (begin < end)
+	{
+		count = job->vertices_count - first;
+		if (count > end - begin)
+			count = end - begin;
+		simd_skin(job->palettes + character * job->joints_count, job->vertices + first, job->dest + begin, count);
+		begin += count;
+		first = 0;
+		++character;
+	}
+}
+
+void skin_characters(struct skin_vertex* vertices, unsigned vertices_count, mat4* palettes, unsigned joints_count,
+					 struct skinned_vertex* dest, unsigned count)
+{
+	struct skin_job job;
+	if (!vertices_count)
+		return;
+	job.vertices = vertices;
+	job.palettes = palettes;
+	job.dest = dest;
+	job.vertices_count = vertices_count;
+	job.joints_count = joints_count;
+	jobs_parallel_for(skin_job, &job, vertices_count * count, VERTEX_GRAIN);
+}
@@ -0,0 +1,93 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef SKELETON_H
+#define SKELETON_H
+
+#include "cglm/types.h"
+
+#define SKELETON_MAX_JOINTS 64
+#define SKELETON_ROOT 0xFF
+
+// Vertex of a skinned mesh in bind pose, bound to up to four joints whose
+// weights add up to one. Unused influences have a weight of zero.
+struct skin_vertex
+{
+	vec3 position;
+	vec3 normal;
+	unsigned char joints[4];
+	float weights[4];
+};
+
+// Vertex after CPU skinning, in world space
+struct skinned_vertex
+{
+	vec3 position;
+	vec3 normal;
+};
+
+// Joints are ordered so that every parent comes before its children, so a
+// pose is resolved in one pass from the first joint to the last.
+struct skeleton
+{
+	mat4 inverse_binds[SKELETON_MAX_JOINTS];
+	unsigned char parents[SKELETON_MAX_JOINTS]; // SKELETON_ROOT for roots
+	unsigned count;
+};
+
+// Keyframes sampled at a fixed rate, frame after frame with joints_count
+// local rotations and translations in each. Clips loop, the last frame
+// blends back into the first.
+struct animation_clip
+{
+	versor* rotations;
+	vec4* translations;
+	unsigned frames_count;
+	unsigned joints_count;
+	float frame_time; // Milliseconds between keyframes
+};
+
+// Binds are the model space transforms of the joints in bind pose. Fails
+// when there are too many joints or a parent does not come first.
+int create_skeleton(struct skeleton* skeleton, const unsigned char* parents, mat4* binds, unsigned count);
+
+int create_animation_clip(struct animation_clip* clip, unsigned joints_count, unsigned frames_count, float frame_time);
+void destroy_animation_clip(struct animation_clip* clip);
+
+// Local pose at time milliseconds, rotations interpolated between the two
+// nearest keyframes with the batch nlerp of simd.h
+void sample_animation_clip(const struct animation_clip* clip, float time, versor* rotations, vec4* translations);
+// Skinning matrices of a pose: world * joint model transform * inverse bind
+void skeleton_palette(const struct skeleton* skeleton, versor* rotations, vec4* translations, mat4 world, mat4* palette);
+
+// Characters sharing a skeleton, a clip and a mesh, split over the job
+// threads. Each character has its clip time and world transform; palettes
+// hold skeleton->count matrices per character.
+void animate_characters(const struct skeleton* skeleton, const struct animation_clip* clip,
+						float* times, mat4* worlds, mat4* palettes, unsigned count);
+// CPU skinning: dest receives vertices_count vertices per character, one
+// character after another
+void skin_characters(struct skin_vertex* vertices, unsigned vertices_count, mat4* palettes, unsigned joints_count,
+					 struct skinned_vertex* dest, unsigned count);
+
+#endif // SKELETON_H
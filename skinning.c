@@ -0,0 +1,618 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SDL_MAIN_HANDLED
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_main.h>
+#include "cglm/affine.h"
+#include "cglm/cam.h"
+#include "cglm/quat.h"
+#include "common.h"
+#include "jobs.h"
+#include "simd.h"
+#include "skeleton.h"
+#include "stream_buffer.h"
+
+#define TENTACLES_X 32
+#define TENTACLES_Z 32
+#define TENTACLES_COUNT (TENTACLES_X * TENTACLES_Z)
+#define JOINTS_COUNT 8
+#define SEGMENT_LENGTH 0.4f
+#define SEGMENT_RINGS 4
+#define RINGS_COUNT (JOINTS_COUNT * SEGMENT_RINGS + 1)
+#define RING_SIDES 12
+#define TENTACLE_RADIUS 0.15f
+#define TENTACLE_VERTICES (RINGS_COUNT * RING_SIDES + 1)
+#define TENTACLE_INDICES ((RINGS_COUNT - 1) * RING_SIDES * 6 + RING_SIDES * 3)
+#define CLIP_FRAMES 30
+#define CLIP_FRAME_TIME 50.0f
+#define PALETTE_UNIFORM_BINDING 0
+
+enum skinning_mode
+{
+	SKINNING_CPU,
+	SKINNING_UBO,
+	SKINNING_TBO
+};
+
+static const char* mode_names[] = { "CPU", "GPU uniform buffer", "GPU texture buffer" };
+static const char* mode_shaders[] = { "data/shaders/16_skinning", "data/shaders/16_skinning_ubo", "data/shaders/16_skinning_tbo" };
+
+// Tapered tube around the Y axis with a joint every SEGMENT_LENGTH. Rings
+// between two joints blend from the lower one to the upper one, the last
+// segment and the cap follow the last joint only.
+static void build_tentacle(struct skin_vertex* vertices, unsigned* indices)
+{
+	const float height = JOINTS_COUNT * SEGMENT_LENGTH;
+	struct skin_vertex* vertex;
+	unsigned ring, side, segment, first, next, index = 0;
+	float angle, y, radius, blend;
+
+	for (ring = 0; ring < RINGS_COUNT; ++ring)
+	{
+		segment = ring / SEGMENT_RINGS;
+		blend = (float)(ring % SEGMENT_RINGS) / SEGMENT_RINGS;
+		if (segment >= JOINTS_COUNT - 1)
+		{
+			segment = JOINTS_COUNT - 1;
+			blend = 0.0f;
+		}
+		y = (float)ring * SEGMENT_LENGTH / SEGMENT_RINGS;
+		radius = TENTACLE_RADIUS * (1.0f - 0.7f * y / height);
+		for (side = 0; side < RING_SIDES; ++side)
+		{
+			angle = GLM_PIf * 2.0f * side / RING_SIDES;
+			vertex = &vertices[ring * RING_SIDES + side];
+			vertex->position[0] = cosf(angle) * radius;
+			vertex->position[1] = y;
+			vertex->position[2] = sinf(angle) * radius;
+			vertex->normal[0] = cosf(angle);
+			vertex->normal[1] = 0.0f;
+			vertex->normal[2] = sinf(angle);
+			vertex->joints[0] = (unsigned char)segment;
+			vertex->joints[1] = (unsigned char)(blend > 0.0f ? segment + 1 : segment);
+			vertex->joints[2] = 0;
+			vertex->joints[3] = 0;
+			vertex->weights[0] = 1.0f - blend;
+			vertex->weights[1] = blend;
+			vertex->weights[2] = 0.0f;
+			vertex->weights[3] = 0.0f;
+		}
+	}
+
+	vertex = &vertices[RINGS_COUNT * RING_SIDES];
+	memset(vertex, 0, sizeof(struct skin_vertex));
+	vertex->position[1] = height;
+	vertex->normal[1] = 1.0f;
+	vertex->joints[0] = JOINTS_COUNT - 1;
+	vertex->weights[0] = 1.0f;
+
+	// Front faces are clockwise (glFrontFace(GL_CW)) seen from outside
+	for (ring = 0; ring < RINGS_COUNT - 1; ++ring)
+		for (side = 0; side < RING_SIDES; ++side)
+		{
+			first = ring * RING_SIDES + side;
+			next = ring * RING_SIDES + (side + 1) % RING_SIDES;
+			indices[index++] = first;
+			indices[index++] = next;
+			indices[index++] = next + RING_SIDES;
+			indices[index++] = next + RING_SIDES;
+			indices[index++] = first + RING_SIDES;
+			indices[index++] = first;
+		}
+	for (side = 0; side < RING_SIDES; ++side)
+	{
+		indices[index++] = RINGS_COUNT * RING_SIDES;
+		indices[index++] = (RINGS_COUNT - 1) * RING_SIDES + side;
+		indices[index++] = (RINGS_COUNT - 1) * RING_SIDES + (side + 1) % RING_SIDES;
+	}
+}
+
+// A wave running up the tentacle: every joint sways around two axes, a
+// little later than the one below it
+static void build_sway_clip(struct animation_clip* clip)
+{
+	versor sway, bend;
+	float phase;
+	unsigned frame, joint;
+	vec4* translation;
+
+	for (frame = 0; frame < CLIP_FRAMES; ++frame)
+		for (joint = 0; joint < JOINTS_COUNT; ++joint)
+		{
+			phase = GLM_PIf * 2.0f * frame / CLIP_FRAMES;
+			glm_quatv(sway, 0.3f * sinf(phase + joint * 0.7f), GLM_ZUP);
+			glm_quatv(bend, 0.2f * cosf(phase + joint * 0.5f), GLM_XUP);
+			glm_quat_mul(sway, bend, clip->rotations[frame * JOINTS_COUNT + joint]);
+			translation = &clip->translations[frame * JOINTS_COUNT + joint];
+			glm_vec4_zero(*translation);
+			if (joint)
+				(*translation)[1] = SEGMENT_LENGTH;
+		}
+}
+
+int main(int argc, char** argv)
+{
+	// =====================================
+	// Initialisation
+	// =====================================
+	// SDL
+
+	if (SDL_Init(SDL_INIT_VIDEO) < 0)
+	{
+		error("SDL Error", SDL_GetError());
+		return 1;
+	}
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_Window* window = SDL_CreateWindow("OpenGL Tutorial 16",
+										  SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+										  1024, 768, SDL_WINDOW_OPENGL);
+	if (!window)
+	{
+		error("SDL Error", SDL_GetError());
+		SDL_Quit();
+		return 1;
+	}
+	SDL_GLContext context = SDL_GL_CreateContext(window);
+	if (!context)
+	{
+		error("SDL Error", SDL_GetError());
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	SDL_ShowCursor(SDL_DISABLE);
+	SDL_SetRelativeMouseMode(SDL_TRUE);
+
+	// GLEW
+	glewExperimental = GL_TRUE;
+	if (glewInit() != GLEW_OK)
+	{
+		error("GLEW Error", glewGetErrorString(glGetError()));
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Jobs
+	if (!jobs_init(0))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// OpenGL
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_CULL_FACE);
+	glCullFace(GL_BACK);
+	glFrontFace(GL_CW);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+	// Math kernels of the widest instruction set the CPU has
+	simd_init();
+
+	// Pass -ubo or -tbo to skin on the GPU with palettes in uniform or
+	// texture buffers, the CPU skins into the stream buffer otherwise
+	enum skinning_mode mode = SKINNING_CPU;
+	if (argc > 1 && !strcmp(argv[1], "-ubo"))
+		mode = SKINNING_UBO;
+	else if (argc > 1 && !strcmp(argv[1], "-tbo"))
+		mode = SKINNING_TBO;
+
+	// Mesh
+	struct skin_vertex* vertices = (struct skin_vertex*)malloc(TENTACLE_VERTICES * sizeof(struct skin_vertex));
+	unsigned* indices = (unsigned*)malloc(TENTACLE_INDICES * sizeof(unsigned));
+	build_tentacle(vertices, indices);
+
+	// Vertex Buffers
+	// Bind pose vertices with their joints feed the GPU skinning shaders,
+	// the CPU skinned ones are pointed to in the stream buffer every frame
+	unsigned vbo;
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, TENTACLE_VERTICES * sizeof(struct skin_vertex), vertices, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	unsigned ebo;
+	glGenBuffers(1, &ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, TENTACLE_INDICES * sizeof(unsigned), indices, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	if (!validate_gl("Vertex Buffer Error"))
+	{
+		jobs_shutdown();
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	unsigned vao;
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	if (mode != SKINNING_CPU)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(struct skin_vertex), (void*)offsetof(struct skin_vertex, position));
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(struct skin_vertex), (void*)offsetof(struct skin_vertex, normal));
+		glVertexAttribIPointer(2, 4, GL_UNSIGNED_BYTE, sizeof(struct skin_vertex), (void*)offsetof(struct skin_vertex, joints));
+		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(struct skin_vertex), (void*)offsetof(struct skin_vertex, weights));
+		glEnableVertexAttribArray(2);
+		glEnableVertexAttribArray(3);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	glBindVertexArray(0);
+
+	if (!validate_gl("Vertex Array Error"))
+	{
+		jobs_shutdown();
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Shader
+	// The modes differ in where the vertex stage finds the joints only
+	const unsigned program = create_program_stages(mode_shaders[mode], "data/shaders/16_skinning");
+	if (!program)
+	{
+		jobs_shutdown();
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Shader Uniforms
+	const int uniform_viewproj = glGetUniformLocation(program, "cViewProj");
+	const int uniform_view_pos = glGetUniformLocation(program, "cViewPos");
+	const int uniform_palette_offset = glGetUniformLocation(program, "cPaletteOffset");
+
+	glUseProgram(program);
+	glUniform3f(glGetUniformLocation(program, "cColor"), 0.8f, 0.35f, 0.45f);
+	glUniform1f(glGetUniformLocation(program, "cShininess"), 16.0f);
+	glUniform3f(glGetUniformLocation(program, "cAmbientColor"), 0.2f, 0.2f, 0.2f);
+	glUniform3f(glGetUniformLocation(program, "cLight.direction"), -0.2f, -1.0f, -0.3f);
+	glUniform3f(glGetUniformLocation(program, "cLight.diffuse"), 1.0f, 0.9f, 0.8f);
+	glUniform3f(glGetUniformLocation(program, "cLight.specular"), 0.4f, 0.4f, 0.4f);
+	if (mode == SKINNING_UBO)
+		glUniformBlockBinding(program, glGetUniformBlockIndex(program, "Palette"), PALETTE_UNIFORM_BINDING);
+	else if (mode == SKINNING_TBO)
+	{
+		glUniform1i(glGetUniformLocation(program, "sPalettes"), 0);
+		glUniform1i(glGetUniformLocation(program, "cJointsCount"), JOINTS_COUNT);
+	}
+	glUseProgram(0);
+
+	if (!validate_gl("Shader Uniforms Error"))
+	{
+		glDeleteProgram(program);
+		jobs_shutdown();
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Stream Buffer
+	// Holds what changes every frame: skinned vertices, or the palettes.
+	// Uniform blocks are bound at the uniform alignment and always span
+	// SKELETON_MAX_JOINTS matrices, as declared in the shader.
+	unsigned frame_size;
+	if (mode == SKINNING_CPU)
+		frame_size = TENTACLES_COUNT * TENTACLE_VERTICES * sizeof(struct skinned_vertex) + 16;
+	else if (mode == SKINNING_UBO)
+	{
+		int alignment;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		frame_size = TENTACLES_COUNT * (SKELETON_MAX_JOINTS * sizeof(mat4) + (unsigned)alignment);
+	}
+	else
+		frame_size = TENTACLES_COUNT * JOINTS_COUNT * sizeof(mat4) + sizeof(mat4);
+	struct stream_buffer stream;
+	if (!create_stream_buffer(&stream, frame_size))
+	{
+		glDeleteProgram(program);
+		jobs_shutdown();
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// The texture views the whole stream buffer, orphaning included
+	unsigned palette_texture = 0;
+	if (mode == SKINNING_TBO)
+	{
+		glGenTextures(1, &palette_texture);
+		glBindTexture(GL_TEXTURE_BUFFER, palette_texture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, stream.buffer);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+	}
+
+	// =====================================
+	// Scene
+	// =====================================
+	// Skeleton
+	// A chain of joints straight up the tentacle
+	struct skeleton skeleton;
+	unsigned char parents[JOINTS_COUNT];
+	mat4 binds[JOINTS_COUNT];
+	unsigned i;
+	for (i = 0; i < JOINTS_COUNT; ++i)
+	{
+		parents[i] = i ? (unsigned char)(i - 1) : SKELETON_ROOT;
+		glm_translate_make(binds[i], (vec3){ 0.0f, i * SEGMENT_LENGTH, 0.0f });
+	}
+	create_skeleton(&skeleton, parents, binds, JOINTS_COUNT);
+
+	struct animation_clip clip;
+	if (!create_animation_clip(&clip, JOINTS_COUNT, CLIP_FRAMES, CLIP_FRAME_TIME))
+	{
+		glDeleteTextures(1, &palette_texture);
+		destroy_stream_buffer(&stream);
+		glDeleteProgram(program);
+		jobs_shutdown();
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+	build_sway_clip(&clip);
+
+	// Characters
+	// Every tentacle plays the clip from its own start and at its own speed
+	float* times = (float*)malloc(TENTACLES_COUNT * sizeof(float));
+	float* speeds = (float*)malloc(TENTACLES_COUNT * sizeof(float));
+	mat4* worlds = (mat4*)malloc(TENTACLES_COUNT * sizeof(mat4));
+	mat4* palettes = (mat4*)malloc(TENTACLES_COUNT * JOINTS_COUNT * sizeof(mat4));
+	unsigned* palette_offsets = (unsigned*)malloc(TENTACLES_COUNT * sizeof(unsigned));
+	vec3 position;
+
+	for (i = 0; i < TENTACLES_COUNT; ++i)
+	{
+		times[i] = (float)(rand() % 1500);
+		speeds[i] = 0.7f + (float)(rand() % 100) * 0.006f;
+		position[0] = ((float)(i % TENTACLES_X) - TENTACLES_X * 0.5f) * 1.5f;
+		position[1] = -2.0f;
+		position[2] = -(float)(i / TENTACLES_X) * 1.5f - 2.0f;
+		glm_translate_make(worlds[i], position);
+		glm_rotate(worlds[i], (float)(rand() % 360) * GLM_PIf / 180.0f, GLM_YUP);
+	}
+
+	// Camera
+	vec3 camera_position = { 0.0f, 0.0f, 3.0f };
+	vec3 camera_direction;
+	vec3 camera_up;
+	versor camera_rotation = GLM_QUAT_IDENTITY_INIT;
+
+	// =====================================
+	// Rendering
+	// =====================================
+	// Matrices
+	mat4 view, viewproj;
+
+	// Projection Matrix
+	mat4 proj;
+	glm_perspective(glm_rad(45.0f), 1024.0f / 768.0f, 0.01f, 100.0f, proj);
+
+	// Statistics
+	char title[256];
+	unsigned char* frame_data;
+	unsigned frame_offset;
+	Uint64 stage_start;
+	Uint64 animate_time = 0;
+	Uint64 skin_time = 0;
+	unsigned frames = 0;
+	float title_time = 0.0f;
+
+	int run = 1;
+	float tick_delta;
+	float tick_curr;
+	float tick_prev = 0.0f;
+	unsigned short controls = 0;
+	while (run)
+	{
+		tick_curr = (float)SDL_GetTicks();
+		tick_delta = tick_curr - tick_prev;
+		process_events(camera_position, camera_direction, camera_rotation, &controls, &run, tick_delta);
+		tick_prev = tick_curr;
+
+		// =================================
+		// Camera
+		// =================================
+		// Look
+		glm_quat_rotatev(camera_rotation, GLM_FORWARD, camera_direction);
+
+		// View Matrix
+		glm_quat_rotatev(camera_rotation, GLM_YUP, camera_up);
+		glm_look(camera_position, camera_direction, camera_up, view);
+
+		// View and Projection Matrix
+		glm_mat4_mul_sse2(proj, view, viewproj);
+
+		// =================================
+		// Animation
+		// =================================
+		stage_start = SDL_GetPerformanceCounter();
+		for (i = 0; i < TENTACLES_COUNT; ++i)
+			times[i] += tick_delta * speeds[i];
+		animate_characters(&skeleton, &clip, times, worlds, palettes, TENTACLES_COUNT);
+		animate_time += SDL_GetPerformanceCounter() - stage_start;
+
+		// =================================
+		// Frame Data
+		// =================================
+		if (!stream_begin_frame(&stream))
+			break;
+
+		// Palettes of the uniform buffer path are placed at draw time
+		stage_start = SDL_GetPerformanceCounter();
+		frame_data = NULL;
+		if (mode == SKINNING_CPU)
+		{
+			frame_data = (unsigned char*)stream_alloc(&stream, TENTACLES_COUNT * TENTACLE_VERTICES * sizeof(struct skinned_vertex),
+													  16, &frame_offset);
+			if (frame_data)
+				skin_characters(vertices, TENTACLE_VERTICES, palettes, JOINTS_COUNT, (struct skinned_vertex*)frame_data, TENTACLES_COUNT);
+		}
+		else if (mode == SKINNING_TBO)
+		{
+			frame_data = (unsigned char*)stream_alloc(&stream, TENTACLES_COUNT * JOINTS_COUNT * sizeof(mat4), sizeof(mat4), &frame_offset);
+			if (frame_data)
+				memcpy(frame_data, palettes, TENTACLES_COUNT * JOINTS_COUNT * sizeof(mat4));
+		}
+		else
+		{
+			for (i = 0; i < TENTACLES_COUNT; ++i)
+			{
+				frame_data = (unsigned char*)stream_alloc(&stream, SKELETON_MAX_JOINTS * sizeof(mat4), stream.uniform_alignment,
+														  &palette_offsets[i]);
+				if (!frame_data)
+					break;
+				memcpy(frame_data, palettes + i * JOINTS_COUNT, JOINTS_COUNT * sizeof(mat4));
+			}
+		}
+		skin_time += SDL_GetPerformanceCounter() - stage_start;
+
+		if (!frame_data)
+		{
+			error("Stream Buffer Error", "Frame data does not fit the stream buffer.");
+			break;
+		}
+		stream_flush(&stream);
+
+		// Rendering
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		glUseProgram(program);
+		glUniformMatrix4fv(uniform_viewproj, 1, GL_FALSE, viewproj[0]);
+		glUniform3fv(uniform_view_pos, 1, camera_position);
+		glBindVertexArray(vao);
+		if (mode == SKINNING_CPU)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, stream.buffer);
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(struct skinned_vertex),
+								  (void*)(frame_offset + offsetof(struct skinned_vertex, position)));
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(struct skinned_vertex),
+								  (void*)(frame_offset + offsetof(struct skinned_vertex, normal)));
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			for (i = 0; i < TENTACLES_COUNT; ++i)
+				glDrawElementsBaseVertex(GL_TRIANGLES, TENTACLE_INDICES, GL_UNSIGNED_INT, 0, (int)(i * TENTACLE_VERTICES));
+		}
+		else if (mode == SKINNING_UBO)
+		{
+			for (i = 0; i < TENTACLES_COUNT; ++i)
+			{
+				glBindBufferRange(GL_UNIFORM_BUFFER, PALETTE_UNIFORM_BINDING, stream.buffer, palette_offsets[i], SKELETON_MAX_JOINTS * sizeof(mat4));
+				glDrawElements(GL_TRIANGLES, TENTACLE_INDICES, GL_UNSIGNED_INT, 0);
+			}
+		}
+		else
+		{
+			glBindTexture(GL_TEXTURE_BUFFER, palette_texture);
+			glUniform1i(uniform_palette_offset, (int)(frame_offset / sizeof(vec4)));
+			glDrawElementsInstanced(GL_TRIANGLES, TENTACLE_INDICES, GL_UNSIGNED_INT, 0, TENTACLES_COUNT);
+			glBindTexture(GL_TEXTURE_BUFFER, 0);
+		}
+		glBindVertexArray(0);
+		glUseProgram(0);
+		stream_end_frame(&stream);
+
+		// Statistics
+		++frames;
+		title_time += tick_delta;
+		if (title_time >= 1000.0f)
+		{
+			snprintf(title, sizeof(title), "OpenGL Tutorial 16: %u tentacles, %s skinning, %u threads, %.2f ms animate, %.2f ms %s",
+					 TENTACLES_COUNT, mode_names[mode], jobs_thread_count(),
+					 (double)animate_time * 1000.0 / (double)SDL_GetPerformanceFrequency() / frames,
+					 (double)skin_time * 1000.0 / (double)SDL_GetPerformanceFrequency() / frames,
+					 mode == SKINNING_CPU ? "skin" : "upload");
+			SDL_SetWindowTitle(window, title);
+			animate_time = 0;
+			skin_time = 0;
+			frames = 0;
+			title_time = 0.0f;
+		}
+
+		if (validate_gl("Open GL Rendering Error"))
+			SDL_GL_SwapWindow(window);
+		else
+			run = 0;
+	}
+
+	// =====================================
+	// Destruction
+	// =====================================
+	// Scene
+	free(palette_offsets);
+	free(palettes);
+	free(worlds);
+	free(speeds);
+	free(times);
+	destroy_animation_clip(&clip);
+
+	// Shader
+	glDeleteProgram(program);
+
+	// Vertex Buffers
+	glDeleteTextures(1, &palette_texture);
+	destroy_stream_buffer(&stream);
+	glDeleteVertexArrays(1, &vao);
+	glDeleteBuffers(1, &ebo);
+	glDeleteBuffers(1, &vbo);
+	free(indices);
+	free(vertices);
+
+	// Jobs
+	jobs_shutdown();
+
+	// SDL
+	SDL_GL_DeleteContext(context);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+
+	return 0;
+}
+
+__declspec(dllexport) unsigned NvOptimusEnablement = 1;
+__declspec(dllexport) int AmdPowerXpressRequestHighPerformance = 1;
@@ -0,0 +1,209 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <GL/glew.h>
+#include <SDL_events.h>
+#include "cglm/box.h"
+#include "cglm/mat3.h"
+#include "cglm/mat4.h"
+#include "common.h"
+#include "static_batch.h"
+
+struct chunk_key
+{
+	unsigned material;
+	int cell[3];
+	unsigned instance;
+};
+
+static int compare_keys(const void* left, const void* right)
+{
+	const struct chunk_key* a = (const struct chunk_key*)left;
+	const struct chunk_key* b = (const struct chunk_key*)right;
+	int i;
+
+	if (a->material != b->material)
+		return a->material < b->material ? -1 : 1;
+	for (i = 0; i < 3; ++i)
+		if (a->cell[i] != b->cell[i])
+			return a->cell[i] < b->cell[i] ? -1 : 1;
+	return a->instance < b->instance ? -1 : a->instance > b->instance;
+}
+
+static int same_chunk(const struct chunk_key* a, const struct chunk_key* b)
+{
+	return a->material == b->material && a->cell[0] == b->cell[0] && a->cell[1] == b->cell[1] && a->cell[2] == b->cell[2];
+}
+
+// Appends an instance in world space to the chunk being built. Normals go
+// through the inverse transpose, and mirroring transforms have their
+// winding swapped back so front faces stay front faces.
+static void append_instance(const struct static_instance* instance, float* vertices, unsigned* vertices_count,
+							unsigned* indices, unsigned* indices_count, vec3 bounds[2])
+{
+	const unsigned first = *vertices_count;
+	const float* source;
+	float* vertex;
+	mat3 normal_matrix;
+	unsigned i;
+	int mirror;
+
+	glm_mat4_pick3((vec4*)instance->transform, normal_matrix);
+	mirror = glm_mat3_det(normal_matrix) < 0.0f;
+	glm_mat3_inv(normal_matrix, normal_matrix);
+	glm_mat3_transpose(normal_matrix);
+
+	for (i = 0; i < instance->vertices_count; ++i)
+	{
+		source = instance->vertices + i * MESH_VERTEX_FLOATS;
+		vertex = vertices + (first + i) * MESH_VERTEX_FLOATS;
+		glm_mat4_mulv3((vec4*)instance->transform, (float*)source, 1.0f, vertex);
+		glm_mat3_mulv(normal_matrix, (float*)source + 3, vertex + 3);
+		glm_vec3_normalize(vertex + 3);
+		vertex[6] = source[6];
+		vertex[7] = source[7];
+		glm_vec3_minv(bounds[0], vertex, bounds[0]);
+		glm_vec3_maxv(bounds[1], vertex, bounds[1]);
+	}
+	for (i = 0; i < instance->indices_count; i += 3)
+	{
+		indices[*indices_count + i] = first + instance->indices[i];
+		indices[*indices_count + i + 1] = first + instance->indices[i + (mirror ? 2 : 1)];
+		indices[*indices_count + i + 2] = first + instance->indices[i + (mirror ? 1 : 2)];
+	}
+	*vertices_count += instance->vertices_count;
+	*indices_count += instance->indices_count;
+}
+
+int build_static_batch(struct static_batch* batch, const struct static_instance* instances, unsigned count, float chunk_size)
+{
+	struct chunk_key* keys;
+	float* vertices;
+	unsigned* indices;
+	unsigned i, begin, chunk, total_vertices = 0, total_indices = 0, chunk_vertices = 0, chunk_indices = 0;
+	unsigned max_vertices = 0, max_indices = 0, vertices_count, indices_count;
+	int success = 1;
+
+	memset(batch, 0, sizeof(struct static_batch));
+	keys = (struct chunk_key*)malloc(count * sizeof(struct chunk_key));
+	if (!keys)
+	{
+		error("Static Batch Error", "Could not allocate %u static instances.", count);
+		return 0;
+	}
+	for (i = 0; i < count; ++i)
+	{
+		keys[i].material = instances[i].material;
+		keys[i].cell[0] = (int)floorf(instances[i].transform[3][0] / chunk_size);
+		keys[i].cell[1] = (int)floorf(instances[i].transform[3][1] / chunk_size);
+		keys[i].cell[2] = (int)floorf(instances[i].transform[3][2] / chunk_size);
+		keys[i].instance = i;
+		total_vertices += instances[i].vertices_count;
+		total_indices += instances[i].indices_count;
+	}
+	qsort(keys, count, sizeof(struct chunk_key), compare_keys);
+
+	// Count chunks and find the largest one for the staging arrays
+	for (i = 0; i < count; ++i)
+	{
+		if (i && !same_chunk(&keys[i - 1], &keys[i]))
+		{
+			max_vertices = chunk_vertices > max_vertices ? chunk_vertices : max_vertices;
+			max_indices = chunk_indices > max_indices ? chunk_indices : max_indices;
+			chunk_vertices = 0;
+			chunk_indices = 0;
+		}
+		batch->chunks_count += !i || !same_chunk(&keys[i - 1], &keys[i]);
+		chunk_vertices += instances[keys[i].instance].vertices_count;
+		chunk_indices += instances[keys[i].instance].indices_count;
+	}
+	max_vertices = chunk_vertices > max_vertices ? chunk_vertices : max_vertices;
+	max_indices = chunk_indices > max_indices ? chunk_indices : max_indices;
+
+	vertices = (float*)malloc(max_vertices * MESH_VERTEX_FLOATS * sizeof(float));
+	indices = (unsigned*)malloc(max_indices * sizeof(unsigned));
+	batch->bounds = (vec3(*)[2])malloc(batch->chunks_count * sizeof(vec3[2]));
+	batch->materials = (unsigned*)malloc(batch->chunks_count * sizeof(unsigned));
+	if ((max_vertices && !vertices) || (max_indices && !indices) || (batch->chunks_count && (!batch->bounds || !batch->materials)))
+	{
+		error("Static Batch Error", "Could not allocate %u chunks of %u vertices.", batch->chunks_count, max_vertices);
+		success = 0;
+	}
+	else if (!create_mesh_buffer(&batch->meshes, total_vertices, total_indices, batch->chunks_count))
+		success = 0;
+
+	for (begin = 0, chunk = 0; success && begin < count; ++chunk)
+	{
+		vertices_count = 0;
+		indices_count = 0;
+		glm_vec3_broadcast(FLT_MAX, batch->bounds[chunk][0]);
+		glm_vec3_broadcast(-FLT_MAX, batch->bounds[chunk][1]);
+		for (i = begin; i < count && same_chunk(&keys[begin], &keys[i]); ++i)
+			append_instance(&instances[keys[i].instance], vertices, &vertices_count, indices, &indices_count, batch->bounds[chunk]);
+		batch->materials[chunk] = keys[begin].material;
+		success = add_mesh(&batch->meshes, vertices, vertices_count, indices, indices_count) >= 0;
+		begin = i;
+	}
+
+	free(indices);
+	free(vertices);
+	free(keys);
+	if (!success)
+		destroy_static_batch(batch);
+	return success;
+}
+
+void destroy_static_batch(struct static_batch* batch)
+{
+	if (batch->meshes.vao)
+		destroy_mesh_buffer(&batch->meshes);
+	free(batch->materials);
+	free(batch->bounds);
+	memset(batch, 0, sizeof(struct static_batch));
+}
+
+unsigned draw_static_batch(const struct static_batch* batch, vec4 planes[6], int material_location)
+{
+	const struct mesh* mesh;
+	unsigned chunk, material = ~0u, draws = 0;
+
+	for (chunk = 0; chunk < batch->chunks_count; ++chunk)
+	{
+		if (!glm_aabb_frustum(batch->bounds[chunk], planes))
+			continue;
+		if (batch->materials[chunk] != material)
+		{
+			material = batch->materials[chunk];
+			glUniform1ui(material_location, material);
+		}
+		mesh = &batch->meshes.meshes[chunk];
+		glDrawElementsBaseVertex(GL_TRIANGLES, (int)mesh->index_count, GL_UNSIGNED_INT, (void*)(mesh->first_index * sizeof(unsigned)),
+								 mesh->base_vertex);
+		++draws;
+	}
+	return draws;
+}
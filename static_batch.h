@@ -0,0 +1,61 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef STATIC_BATCH_H
+#define STATIC_BATCH_H
+
+#include "cglm/types.h"
+#include "mesh_buffer.h"
+
+// One placement of a mesh that never moves, as given to build_static_batch.
+// Vertices are in the mesh buffer layout (MESH_VERTEX_FLOATS per vertex).
+struct static_instance
+{
+	mat4 transform;
+	const float* vertices;
+	const unsigned* indices;
+	unsigned vertices_count;
+	unsigned indices_count;
+	unsigned material;
+};
+
+// Static instances moved into world space at load time and merged into
+// chunks: every chunk holds the instances of one material whose origins
+// fall into the same cell of a regular grid, and is one mesh of a shared
+// mesh buffer with its own bounding box. Chunks are sorted by material.
+struct static_batch
+{
+	struct mesh_buffer meshes;
+	vec3 (*bounds)[2];
+	unsigned* materials;
+	unsigned chunks_count;
+};
+
+int build_static_batch(struct static_batch* batch, const struct static_instance* instances, unsigned count, float chunk_size);
+void destroy_static_batch(struct static_batch* batch);
+
+// Draws the chunks inside the frustum and returns the number of draw calls.
+// Expects the program and the VAO of the batch meshes to be bound.
+unsigned draw_static_batch(const struct static_batch* batch, vec4 planes[6], int material_location);
+
+#endif // STATIC_BATCH_H
@@ -0,0 +1,156 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <string.h>
+#include <GL/glew.h>
+#include <SDL_events.h>
+#include "common.h"
+#include "stream_buffer.h"
+
+#define FENCE_TIMEOUT 1000000000
+
+// Buffers are managed on the copy target so that array and uniform bindings of the caller are left alone
+#define STREAM_TARGET GL_COPY_WRITE_BUFFER
+
+int create_stream_buffer(struct stream_buffer* stream, unsigned frame_size)
+{
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	int alignment;
+
+	memset(stream, 0, sizeof(struct stream_buffer));
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	stream->uniform_alignment = (unsigned)alignment;
+	stream->frame_size = (frame_size + stream->uniform_alignment - 1) / stream->uniform_alignment * stream->uniform_alignment;
+	stream->persistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+
+	glGenBuffers(1, &stream->buffer);
+	glBindBuffer(STREAM_TARGET, stream->buffer);
+	if (stream->persistent)
+	{
+		glBufferStorage(STREAM_TARGET, stream->frame_size * STREAM_BUFFER_FRAMES, NULL, flags);
+		stream->mapped = (unsigned char*)glMapBufferRange(STREAM_TARGET, 0, stream->frame_size * STREAM_BUFFER_FRAMES, flags);
+	}
+	else
+		glBufferData(STREAM_TARGET, stream->frame_size, NULL, GL_STREAM_DRAW);
+	glBindBuffer(STREAM_TARGET, 0);
+
+	if (!validate_gl("Stream Buffer Error") || (stream->persistent && !stream->mapped))
+	{
+		error("Stream Buffer Error", "Could not create a %u byte stream buffer.", stream->frame_size);
+		glDeleteBuffers(1, &stream->buffer);
+		return 0;
+	}
+	return 1;
+}
+
+void destroy_stream_buffer(struct stream_buffer* stream)
+{
+	unsigned i;
+
+	for (i = 0; i < STREAM_BUFFER_FRAMES; ++i)
+		if (stream->fences[i])
+			glDeleteSync((GLsync)stream->fences[i]);
+	if (stream->mapped)
+	{
+		glBindBuffer(STREAM_TARGET, stream->buffer);
+		glUnmapBuffer(STREAM_TARGET);
+		glBindBuffer(STREAM_TARGET, 0);
+	}
+	glDeleteBuffers(1, &stream->buffer);
+	memset(stream, 0, sizeof(struct stream_buffer));
+}
+
+int stream_begin_frame(struct stream_buffer* stream)
+{
+	GLenum status;
+
+	stream->offset = 0;
+	if (stream->persistent)
+	{
+		stream->frame = (stream->frame + 1) % STREAM_BUFFER_FRAMES;
+		if (!stream->fences[stream->frame])
+			return 1;
+
+		// Only blocks when the GPU is more than STREAM_BUFFER_FRAMES - 1 frames behind
+		status = glClientWaitSync((GLsync)stream->fences[stream->frame], 0, 0);
+		if (status == GL_TIMEOUT_EXPIRED)
+		{
+			++stream->stalls;
+			do
+				status = glClientWaitSync((GLsync)stream->fences[stream->frame], GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+			while (status == GL_TIMEOUT_EXPIRED);
+		}
+		glDeleteSync((GLsync)stream->fences[stream->frame]);
+		stream->fences[stream->frame] = NULL;
+		if (status == GL_WAIT_FAILED)
+		{
+			error("Stream Buffer Error", "Waiting for the frame fence failed.");
+			return 0;
+		}
+		return 1;
+	}
+
+	// Orphaning gives the driver a fresh block while the GPU still reads the old one
+	glBindBuffer(STREAM_TARGET, stream->buffer);
+	glBufferData(STREAM_TARGET, stream->frame_size, NULL, GL_STREAM_DRAW);
+	stream->mapped = (unsigned char*)glMapBufferRange(STREAM_TARGET, 0, stream->frame_size,
+													  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	glBindBuffer(STREAM_TARGET, 0);
+	if (!stream->mapped)
+	{
+		error("Stream Buffer Error", "Could not map stream buffer.");
+		return 0;
+	}
+	return 1;
+}
+
+// Returns where to write size bytes and their buffer offset, or NULL when the frame region is full
+void* stream_alloc(struct stream_buffer* stream, unsigned size, unsigned alignment, unsigned* offset)
+{
+	const unsigned begin = (stream->offset + alignment - 1) / alignment * alignment;
+	const unsigned region = stream->persistent ? stream->frame * stream->frame_size : 0;
+
+	if (!stream->mapped || begin + size > stream->frame_size)
+		return NULL;
+	stream->offset = begin + size;
+	*offset = region + begin;
+	return stream->mapped + region + begin;
+}
+
+void stream_flush(struct stream_buffer* stream)
+{
+	if (stream->persistent || !stream->mapped)
+		return;
+	glBindBuffer(STREAM_TARGET, stream->buffer);
+	glUnmapBuffer(STREAM_TARGET);
+	glBindBuffer(STREAM_TARGET, 0);
+	stream->mapped = NULL;
+}
+
+void stream_end_frame(struct stream_buffer* stream)
+{
+	if (stream->persistent)
+		stream->fences[stream->frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	else
+		stream_flush(stream);
+}
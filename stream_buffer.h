@@ -0,0 +1,59 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#define STREAM_BUFFER_FRAMES 3
+
+// Ring of per-frame regions for data rewritten every frame (instances,
+// uniform blocks). With ARB_buffer_storage the buffer is mapped once,
+// persistently and coherently, and a fence per region keeps the CPU from
+// overwriting a region the GPU still reads. Older drivers orphan the
+// buffer every frame and map it unsynchronised instead.
+//
+// Per frame: stream_begin_frame(), any number of stream_alloc(), then
+// stream_flush() before the draws that read the data, stream_end_frame()
+// after them.
+struct stream_buffer
+{
+	unsigned buffer;
+	unsigned char* mapped;
+	void* fences[STREAM_BUFFER_FRAMES];
+	unsigned frame_size;
+	unsigned frame;
+	unsigned offset;
+	unsigned uniform_alignment;
+	unsigned stalls;
+	int persistent;
+};
+
+int create_stream_buffer(struct stream_buffer* stream, unsigned frame_size);
+void destroy_stream_buffer(struct stream_buffer* stream);
+
+int stream_begin_frame(struct stream_buffer* stream);
+void* stream_alloc(struct stream_buffer* stream, unsigned size, unsigned alignment, unsigned* offset);
+void stream_flush(struct stream_buffer* stream);
+void stream_end_frame(struct stream_buffer* stream);
+
+#endif // STREAM_BUFFER_H
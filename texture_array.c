@@ -0,0 +1,575 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SDL_MAIN_HANDLED
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_main.h>
+#include "cglm/affine.h"
+#include "cglm/cam.h"
+#include "cglm/quat.h"
+#include "common.h"
+#include "packed_instance.h"
+#include "stream_buffer.h"
+#include "texture_manager.h"
+
+#define CRATES_X 16
+#define CRATES_Z 16
+#define CRATES_COUNT (CRATES_X * CRATES_Z)
+#define FRAME_UNIFORM_BINDING 0
+#define MATERIALS_COUNT (sizeof(material_files) / sizeof(material_files[0]))
+
+static const float cube_vertices[] =
+{
+	// Position				| Normal				| Tex Coord
+	// Front
+	 0.5f,  0.5f,  0.5f,	 0.0f,  0.0,  1.0,		1.0f, 1.0f,		//   0 RU
+	 0.5f, -0.5f,  0.5f,	 0.0f,  0.0,  1.0,		1.0f, 0.0f,		//   1 RD
+	-0.5f, -0.5f,  0.5f,	 0.0f,  0.0,  1.0,		0.0f, 0.0f,		//   2 LD
+	-0.5f,  0.5f,  0.5f,	 0.0f,  0.0,  1.0,		0.0f, 1.0f,		//   3 LU
+
+	// Back
+	-0.5f,  0.5f, -0.5f,	 0.0f,  0.0, -1.0,		1.0f, 1.0f,		//   4 RU
+	-0.5f, -0.5f, -0.5f,	 0.0f,  0.0, -1.0,		1.0f, 0.0f,		//   5 RD
+	 0.5f, -0.5f, -0.5f,	 0.0f,  0.0, -1.0,		0.0f, 0.0f,		//   6 LD
+	 0.5f,  0.5f, -0.5f,	 0.0f,  0.0, -1.0,		0.0f, 1.0f,		//   7 LU
+
+	// Top
+	 0.5f,  0.5f, -0.5f,	 0.0f,  1.0,  0.0,		1.0f, 1.0f,		//   8 RU
+	 0.5f,  0.5f,  0.5f,	 0.0f,  1.0,  0.0,		1.0f, 0.0f,		//   9 RD
+	-0.5f,  0.5f,  0.5f,	 0.0f,  1.0,  0.0,		0.0f, 0.0f,		//  10 LD
+	-0.5f,  0.5f, -0.5f,	 0.0f,  1.0,  0.0,		0.0f, 1.0f,		//  11 LU
+
+	// Bottom
+	 0.5f, -0.5f,  0.5f,	 0.0f, -1.0,  0.0,		1.0f, 1.0f,		//  12 RU
+	 0.5f, -0.5f, -0.5f,	 0.0f, -1.0,  0.0,		1.0f, 0.0f,		//  13 RD
+	-0.5f, -0.5f, -0.5f,	 0.0f, -1.0,  0.0,		0.0f, 0.0f,		//  14 LD
+	-0.5f, -0.5f,  0.5f,	 0.0f, -1.0,  0.0,		0.0f, 1.0f,		//  15 LU
+
+	// Left
+	-0.5f,  0.5f,  0.5f,	-1.0f,  0.0,  0.0,		1.0f, 1.0f,		//  16 LU
+	-0.5f, -0.5f,  0.5f,	-1.0f,  0.0,  0.0,		1.0f, 0.0f,		//  17 LD
+	-0.5f, -0.5f, -0.5f,	-1.0f,  0.0,  0.0,		0.0f, 0.0f,		//  18 RD
+	-0.5f,  0.5f, -0.5f,	-1.0f,  0.0,  0.0,		0.0f, 1.0f,		//  19 RU
+
+	// Right
+	 0.5f,  0.5f, -0.5f,	 1.0f,  0.0,  0.0,		1.0f, 1.0f,		//   4 RU
+	 0.5f, -0.5f, -0.5f,	 1.0f,  0.0,  0.0,		1.0f, 0.0f,		//   5 RD
+	 0.5f, -0.5f,  0.5f,	 1.0f,  0.0,  0.0,		0.0f, 0.0f,		//   1 RD
+	 0.5f,  0.5f,  0.5f,	 1.0f,  0.0,  0.0,		0.0f, 1.0f		//   0 RU
+};
+
+static const unsigned cube_indices[] =
+{
+	 0,  1,  2,  2,  3,  0,	// Front
+	 4,  5,  6,  6,  7,  4,	// Back
+	 8,  9, 10, 10, 11,  8,	// Top
+	12, 13, 14, 14, 15, 12,	// Bottom
+	16, 17, 18, 18, 19, 16,	// Left
+	20, 21, 22, 22, 23, 20	// Right
+};
+
+// One index per instance selects the diffuse and specular texture of its
+// material, whether the material table is bindless or made of arrays
+static const char* material_files[][MATERIAL_TEXTURES] =
+{
+	{ "data/textures/crate_diffuse.tex", "data/textures/crate_specular.tex" },
+	{ "data/textures/crate_dark_diffuse.tex", "data/textures/crate_dark_specular.tex" },
+	{ "data/textures/crate_painted_diffuse.tex", "data/textures/crate_painted_specular.tex" }
+};
+
+// Frame uniform block, std140 layout
+struct frame_uniforms
+{
+	mat4 viewproj;
+	vec4 view_pos;
+	vec4 ambient_color;
+	vec4 light_position;
+	vec4 light_diffuse;
+	vec4 light_specular;
+	vec4 light_attenuation;
+};
+
+int main(int argc, char** argv)
+{
+	// =====================================
+	// Initialisation
+	// =====================================
+	// SDL
+
+	if (SDL_Init(SDL_INIT_VIDEO) < 0)
+	{
+		error("SDL Error", SDL_GetError());
+		return 1;
+	}
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_Window* window = SDL_CreateWindow("OpenGL Tutorial 01",
+										  SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+										  1024, 768, SDL_WINDOW_OPENGL);
+	if (!window)
+	{
+		error("SDL Error", SDL_GetError());
+		SDL_Quit();
+		return 1;
+	}
+	SDL_GLContext context = SDL_GL_CreateContext(window);
+	if (!context)
+	{
+		// Bindless textures need a 4.x driver, texture arrays work with 3.3
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+		context = SDL_GL_CreateContext(window);
+	}
+	if (!context)
+	{
+		error("SDL Error", SDL_GetError());
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	SDL_ShowCursor(SDL_DISABLE);
+	SDL_SetRelativeMouseMode(SDL_TRUE);
+
+	// GLEW
+	glewExperimental = GL_TRUE;
+	if (glewInit() != GLEW_OK)
+	{
+		error("GLEW Error", glewGetErrorString(glGetError()));
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// OpenGL
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_CULL_FACE);
+	glCullFace(GL_BACK);
+	glFrontFace(GL_CW);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+	// Materials
+	unsigned i;
+	struct material_table materials;
+	if (!create_material_table(&materials, MATERIALS_COUNT))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+	for (i = 0; i < MATERIALS_COUNT; ++i)
+		if (add_material(&materials, material_files[i]) < 0)
+		{
+			destroy_material_table(&materials);
+			SDL_GL_DeleteContext(context);
+			SDL_DestroyWindow(window);
+			SDL_Quit();
+			return 1;
+		}
+
+	// Vertex Buffers
+
+	unsigned vbo;
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices, GL_STATIC_DRAW);
+	if (!validate_gl("VBO Creation Error"))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	unsigned ebo;
+	glGenBuffers(1, &ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cube_indices), cube_indices, GL_STATIC_DRAW);
+	if (!validate_gl("EBO Creation Error"))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	// Instances and frame uniforms are rewritten every frame. Transforms go
+	// out as a quaternion, position and scale, in half floats with -half.
+	const int half = argc > 1 && !strcmp(argv[1], "-half");
+	const unsigned instance_size = half ? sizeof(struct packed_instance_half) : sizeof(struct packed_instance);
+	struct stream_buffer stream;
+	if (!create_stream_buffer(&stream, CRATES_COUNT * instance_size + sizeof(struct frame_uniforms) + 1024))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	unsigned cube_vao;
+	glGenVertexArrays(1, &cube_vao);
+	glBindVertexArray(cube_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+	glEnableVertexAttribArray(2);
+	for (i = 3; i < 6; ++i)
+	{
+		glEnableVertexAttribArray(i);
+		glVertexAttribDivisor(i, 1);
+	}
+	glEnableVertexAttribArray(7);
+	glVertexAttribDivisor(7, 1);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glBindVertexArray(0);
+	if (!validate_gl("VBO Creation Error"))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	unsigned lamp_vao;
+	glGenVertexArrays(1, &lamp_vao);
+	glBindVertexArray(lamp_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	if (!validate_gl("VBO Creation Error"))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// Shader
+	// Both material tables share the vertex stage
+	const unsigned program_diffuse = create_program_stages("data/shaders/11_texture_array",
+														   materials.bindless ? "data/shaders/11_texture_array_bindless"
+																			  : "data/shaders/11_texture_array");
+	if (!program_diffuse)
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	int success;
+	char* vertex_shader = NULL;
+	char* fragment_shader = NULL;
+
+	if (!load_shaders_text(&vertex_shader, &fragment_shader, "data/shaders/7_emissive"))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	unsigned vertex = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(vertex, 1, (const char* const*)&vertex_shader, NULL);
+	glCompileShader(vertex);
+	glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		char message[ERROR_BUFFER_SIZE];
+		glGetShaderInfoLog(vertex, ERROR_BUFFER_SIZE, NULL, message);
+		error("Vertex Shader Error", message);
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	unsigned fragment = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(fragment, 1, (const char* const*)&fragment_shader, NULL);
+	glCompileShader(fragment);
+	glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		char message[ERROR_BUFFER_SIZE];
+		glGetShaderInfoLog(fragment, ERROR_BUFFER_SIZE, NULL, message);
+		error("Fragment Shader Error", message);
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	const unsigned program_emissive = glCreateProgram();
+	glAttachShader(program_emissive, vertex);
+	glAttachShader(program_emissive, fragment);
+	glLinkProgram(program_emissive);
+	glGetProgramiv(program_emissive, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		char message[ERROR_BUFFER_SIZE];
+		glGetProgramInfoLog(program_emissive, ERROR_BUFFER_SIZE, NULL, message);
+		error("Fragment Shader Error", message);
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	free(vertex_shader);
+	free(fragment_shader);
+	glDeleteShader(vertex);
+	glDeleteShader(fragment);
+
+	// Shader Uniforms
+	glUniformBlockBinding(program_diffuse, glGetUniformBlockIndex(program_diffuse, "Frame"), FRAME_UNIFORM_BINDING);
+
+	const int uniform_mvp_dif = glGetUniformLocation(program_emissive, "cModelViewProj");
+	const int uniform_color = glGetUniformLocation(program_emissive, "cColor");
+
+	glUseProgram(program_diffuse);
+	glUniform1i(glGetUniformLocation(program_diffuse, "sDiffuse"), 0);
+	glUniform1i(glGetUniformLocation(program_diffuse, "sSpecular"), 1);
+	glUseProgram(0);
+
+	if (!validate_gl("Shader Uniforms Error"))
+	{
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+
+	// =====================================
+	// Scene
+	// =====================================
+	// Crates
+	unsigned cube_materials[CRATES_COUNT];
+	vec3 cube_positions[CRATES_COUNT];
+	vec3 cube_axes[CRATES_COUNT];
+	versor cube_rotations[CRATES_COUNT];
+	struct packed_instance instance;
+	void* instances;
+	struct frame_uniforms* uniforms;
+	unsigned instances_offset, uniforms_offset;
+	for (i = 0; i < CRATES_COUNT; ++i)
+	{
+		cube_positions[i][0] = ((float)(i % CRATES_X) - CRATES_X * 0.5f) * 2.0f;
+		cube_positions[i][1] = (float)(rand() % 100) * 0.02f - 1.0f;
+		cube_positions[i][2] = -(float)(i / CRATES_X) * 2.0f - 2.0f;
+		cube_axes[i][0] = (float)(rand() % 100) * 0.01f;
+		cube_axes[i][1] = 1.0f;
+		cube_axes[i][2] = (float)(rand() % 100) * 0.01f;
+		glm_vec3_normalize(cube_axes[i]);
+		glm_quat_identity(cube_rotations[i]);
+		cube_materials[i] = (unsigned)rand() % MATERIALS_COUNT;
+	}
+
+	// Materials never change, so they stay in their own buffer
+	unsigned material_buffer;
+	glGenBuffers(1, &material_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, material_buffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(cube_materials), cube_materials, GL_STATIC_DRAW);
+	glBindVertexArray(cube_vao);
+	glVertexAttribIPointer(7, 1, GL_UNSIGNED_INT, sizeof(unsigned), (void*)0);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// Light
+	vec4 ambient_color = { 0.1f, 0.1f, 0.1f, 0.0f };
+	vec4 light_position = { 0.0f, 2.0f, -CRATES_Z, 1.0f };
+	vec4 light_diffuse = { 1.0f, 0.8f, 0.6f, 1.0f };
+	vec4 light_specular = { 0.5f, 0.5f, 0.5f, 1.0f };
+	vec3 light_scale = { 0.25f, 0.25f, 0.25f };
+	vec4 light_attenuation = { 1.0f, 0.045f, 0.0075f, 32.0f }; // Constant, linear, quadratic, crate shininess
+
+	// Camera
+	vec3 camera_position = { 0.0f, 0.0f, 3.0f };
+	vec3 camera_direction;
+	vec3 camera_up;
+	versor camera_rotation = GLM_QUAT_IDENTITY_INIT;
+
+	// =====================================
+	// Rendering
+	// =====================================
+	// Matrices
+	mat4 model, view, viewproj, mvp;
+
+	// Projection Matrix
+	mat4 proj;
+	glm_perspective(45.0f, 1024.0f / 720.0f, 0.01f, 100.0f, proj);
+
+	// Rotation
+	versor rotation;
+
+	// Textures of every material stay bound for the whole run
+	bind_material_table(&materials, 0);
+
+	int run = 1;
+	float tick_delta;
+	float tick_curr;
+	float tick_prev = 0.0f;
+	unsigned short controls = 0;
+	while (run)
+	{
+		tick_curr = (float)SDL_GetTicks();
+		tick_delta = tick_curr - tick_prev;
+		process_events(camera_position, camera_direction, camera_rotation, &controls, &run, tick_delta);
+		tick_prev = tick_curr;
+
+		// =================================
+		// Camera
+		// =================================
+		// Look
+		glm_quat_rotatev(camera_rotation, GLM_FORWARD, camera_direction);
+
+		// View Matrix
+		glm_quat_rotatev(camera_rotation, GLM_YUP, camera_up);
+		glm_look(camera_position, camera_direction, camera_up, view);
+
+		// =================================
+		// Frame Data
+		// =================================
+		if (!stream_begin_frame(&stream))
+			break;
+		uniforms = (struct frame_uniforms*)stream_alloc(&stream, sizeof(struct frame_uniforms), stream.uniform_alignment, &uniforms_offset);
+		instances = stream_alloc(&stream, CRATES_COUNT * instance_size, 16, &instances_offset);
+
+		if (!uniforms || !instances)
+		{
+			error("Stream Buffer Error", "Frame data does not fit the stream buffer.");
+			break;
+		}
+
+		// Matrices are built on the stack and copied, mapped memory is write only
+		glm_mat4_mul_sse2(proj, view, viewproj);
+		glm_mat4_copy(viewproj, uniforms->viewproj);
+		glm_vec4(camera_position, 1.0f, uniforms->view_pos);
+		glm_vec4_copy(ambient_color, uniforms->ambient_color);
+		glm_vec4_copy(light_position, uniforms->light_position);
+		glm_vec4_copy(light_diffuse, uniforms->light_diffuse);
+		glm_vec4_copy(light_specular, uniforms->light_specular);
+		glm_vec4_copy(light_attenuation, uniforms->light_attenuation);
+
+		for (i = 0; i < CRATES_COUNT; ++i)
+		{
+			glm_quatv(rotation, tick_delta * -0.000025f, cube_axes[i]);
+			glm_quat_mul_sse2(rotation, cube_rotations[i], cube_rotations[i]);
+			glm_quat_copy(cube_rotations[i], instance.rotation);
+			glm_vec3_copy(cube_positions[i], instance.position);
+			instance.scale = 1.0f;
+			if (half)
+				pack_instances_half((struct packed_instance_half*)instances + i, &instance, 1);
+			else
+				memcpy((struct packed_instance*)instances + i, &instance, sizeof(instance));
+		}
+		stream_flush(&stream);
+
+		// Rendering
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		glUseProgram(program_diffuse);
+		glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, stream.buffer, uniforms_offset, sizeof(struct frame_uniforms));
+		glBindVertexArray(cube_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, stream.buffer);
+		if (half)
+		{
+			glVertexAttribPointer(3, 4, GL_HALF_FLOAT, GL_FALSE, instance_size, (void*)(instances_offset + offsetof(struct packed_instance_half, rotation)));
+			glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, instance_size, (void*)(instances_offset + offsetof(struct packed_instance_half, position)));
+			glVertexAttribPointer(5, 1, GL_HALF_FLOAT, GL_FALSE, instance_size, (void*)(instances_offset + offsetof(struct packed_instance_half, scale)));
+		}
+		else
+		{
+			glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, instance_size, (void*)(instances_offset + offsetof(struct packed_instance, rotation)));
+			glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, instance_size, (void*)(instances_offset + offsetof(struct packed_instance, position)));
+			glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, instance_size, (void*)(instances_offset + offsetof(struct packed_instance, scale)));
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glDrawElementsInstanced(GL_TRIANGLES, sizeof(cube_indices) / sizeof(unsigned), GL_UNSIGNED_INT, 0, CRATES_COUNT);
+		glUseProgram(0);
+		glBindVertexArray(0);
+
+		glm_mat4_identity(model);
+		glm_translate(model, light_position);
+		glm_scale(model, light_scale);
+
+		glUseProgram(program_emissive);
+		glm_mat4_mul_sse2(viewproj, model, mvp);
+		glUniformMatrix4fv(uniform_mvp_dif, 1, GL_FALSE, mvp[0]);
+		glUniform3fv(uniform_color, 1, light_diffuse);
+		glBindVertexArray(lamp_vao);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+		glDrawElements(GL_TRIANGLES, sizeof(cube_indices) / sizeof(unsigned), GL_UNSIGNED_INT, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+		stream_end_frame(&stream);
+
+		if (validate_gl("Open GL Rendering Error"))
+			SDL_GL_SwapWindow(window);
+		else
+			run = 0;
+	}
+
+	// =====================================
+	// Destruction
+	// =====================================
+	// Texture
+	destroy_material_table(&materials);
+
+	// Shader
+	glDeleteProgram(program_emissive);
+	glDeleteProgram(program_diffuse);
+
+	// Vertex Buffers
+	glDeleteVertexArrays(1, &lamp_vao);
+	glDeleteVertexArrays(1, &cube_vao);
+	destroy_stream_buffer(&stream);
+	glDeleteBuffers(1, &material_buffer);
+	glDeleteBuffers(1, &ebo);
+	glDeleteBuffers(1, &vbo);
+
+	// SDL
+	SDL_GL_DeleteContext(context);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+
+	return 0;
+}
+
+__declspec(dllexport) unsigned NvOptimusEnablement = 1;
+__declspec(dllexport) int AmdPowerXpressRequestHighPerformance = 1;
@@ -0,0 +1,620 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include "cglm/util.h"
+#include "cglm/vec3.h"
+#include "jobs.h"
+#include "texture_compress.h"
+
+#define BLOCK_PIXELS 16
+#define BLOCK_ROWS_PER_JOB 4
+#define REFINE_ITERATIONS 2
+#define POWER_ITERATIONS 4
+
+struct compress_job
+{
+	unsigned char* dest;
+	const unsigned char* src;
+	unsigned width;
+	unsigned height;
+	unsigned channels;
+	unsigned format;
+};
+
+unsigned texture_format_channels(unsigned format)
+{
+	switch (format)
+	{
+	case TEXTURE_FORMAT_R8:
+	case TEXTURE_FORMAT_BC4:
+		return 1;
+	case TEXTURE_FORMAT_RGB8:
+	case TEXTURE_FORMAT_BC1:
+		return 3;
+	default:
+		return 4;
+	}
+}
+
+int texture_format_compressed(unsigned format)
+{
+	return format == TEXTURE_FORMAT_BC1 || format == TEXTURE_FORMAT_BC3 || format == TEXTURE_FORMAT_BC4;
+}
+
+unsigned texture_level_size(unsigned format, unsigned width, unsigned height)
+{
+	const unsigned blocks = ((width + 3) / 4) * ((height + 3) / 4);
+	switch (format)
+	{
+	case TEXTURE_FORMAT_BC1:
+	case TEXTURE_FORMAT_BC4:
+		return blocks * 8;
+	case TEXTURE_FORMAT_BC3:
+		return blocks * 16;
+	default:
+		return width * height * texture_format_channels(format);
+	}
+}
+
+// =====================================
+// Block Gathering
+// =====================================
+
+static void load_block(unsigned char* rgba, const unsigned char* src, unsigned width, unsigned height, unsigned channels, unsigned x, unsigned y)
+{
+	const unsigned char* pixel;
+	unsigned px, py, i;
+	for (i = 0; i < BLOCK_PIXELS; ++i)
+	{
+		// Blocks hanging over the edge repeat the last row and column
+		px = x + (i & 3) < width ? x + (i & 3) : width - 1;
+		py = y + (i >> 2) < height ? y + (i >> 2) : height - 1;
+		pixel = src + (py * width + px) * channels;
+		switch (channels)
+		{
+		case 1:
+			rgba[i * 4 + 0] = rgba[i * 4 + 1] = rgba[i * 4 + 2] = pixel[0];
+			rgba[i * 4 + 3] = 255;
+			break;
+		case 2:
+			rgba[i * 4 + 0] = rgba[i * 4 + 1] = rgba[i * 4 + 2] = pixel[0];
+			rgba[i * 4 + 3] = pixel[1];
+			break;
+		case 3:
+			rgba[i * 4 + 0] = pixel[0];
+			rgba[i * 4 + 1] = pixel[1];
+			rgba[i * 4 + 2] = pixel[2];
+			rgba[i * 4 + 3] = 255;
+			break;
+		default:
+			memcpy(rgba + i * 4, pixel, 4);
+			break;
+		}
+	}
+}
+
+static void store_block(unsigned char* dest, const unsigned char* rgba, unsigned width, unsigned height, unsigned channels, unsigned x, unsigned y)
+{
+	unsigned i, c;
+	for (i = 0; i < BLOCK_PIXELS; ++i)
+		if (x + (i & 3) < width && y + (i >> 2) < height)
+			for (c = 0; c < channels; ++c)
+				dest[((y + (i >> 2)) * width + x + (i & 3)) * channels + c] = rgba[i * 4 + c];
+}
+
+// =====================================
+// BC1 Colour Block
+// =====================================
+
+static unsigned pack_565(const float* color)
+{
+	const unsigned r = (unsigned)(glm_clamp(color[0], 0.0f, 255.0f) * (31.0f / 255.0f) + 0.5f);
+	const unsigned g = (unsigned)(glm_clamp(color[1], 0.0f, 255.0f) * (63.0f / 255.0f) + 0.5f);
+	const unsigned b = (unsigned)(glm_clamp(color[2], 0.0f, 255.0f) * (31.0f / 255.0f) + 0.5f);
+	return r << 11 | g << 5 | b;
+}
+
+static void unpack_565(unsigned color, int* rgb)
+{
+	const int r = (color >> 11) & 31;
+	const int g = (color >> 5) & 63;
+	const int b = color & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+static void bc1_palette(unsigned color0, unsigned color1, int palette[4][3])
+{
+	int c;
+	unpack_565(color0, palette[0]);
+	unpack_565(color1, palette[1]);
+	for (c = 0; c < 3; ++c)
+	{
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+}
+
+// Picks the nearest palette entry for each pixel, returns the total squared error
+static float bc1_select(const float* r, const float* g, const float* b, int palette[4][3], unsigned char* indices)
+{
+	float total = 0.0f;
+	unsigned i, k;
+#if defined(__SSE2__)
+	CGLM_ALIGN(16) int selected[BLOCK_PIXELS];
+	CGLM_ALIGN(16) float errors[4];
+	__m128 dr, dg, db, distance, best, mask, sum = _mm_setzero_ps();
+	__m128i index, closer;
+	for (i = 0; i < BLOCK_PIXELS; i += 4)
+	{
+		best = _mm_set1_ps(FLT_MAX);
+		index = _mm_setzero_si128();
+		for (k = 0; k < 4; ++k)
+		{
+			dr = _mm_sub_ps(_mm_load_ps(r + i), _mm_set1_ps((float)palette[k][0]));
+			dg = _mm_sub_ps(_mm_load_ps(g + i), _mm_set1_ps((float)palette[k][1]));
+			db = _mm_sub_ps(_mm_load_ps(b + i), _mm_set1_ps((float)palette[k][2]));
+			distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+			mask = _mm_cmplt_ps(distance, best);
+			closer = _mm_castps_si128(mask);
+			index = _mm_or_si128(_mm_andnot_si128(closer, index), _mm_and_si128(closer, _mm_set1_epi32((int)k)));
+			best = _mm_min_ps(distance, best);
+		}
+		_mm_store_si128((__m128i*)(selected + i), index);
+		sum = _mm_add_ps(sum, best);
+	}
+	_mm_store_ps(errors, sum);
+	total = errors[0] + errors[1] + errors[2] + errors[3];
+	for (i = 0; i < BLOCK_PIXELS; ++i)
+		indices[i] = (unsigned char)selected[i];
+#else
+	float distance, best, dr, dg, db;
+	for (i = 0; i < BLOCK_PIXELS; ++i)
+	{
+		best = FLT_MAX;
+		for (k = 0; k < 4; ++k)
+		{
+			dr = r[i] - (float)palette[k][0];
+			dg = g[i] - (float)palette[k][1];
+			db = b[i] - (float)palette[k][2];
+			distance = dr * dr + dg * dg + db * db;
+			if (distance < best)
+			{
+				best = distance;
+				indices[i] = (unsigned char)k;
+			}
+		}
+		total += best;
+	}
+#endif
+	return total;
+}
+
+// Principal axis of the block colours by power iteration, endpoints are the
+// pixels lying furthest along it
+static void bc1_principal_endpoints(const float* r, const float* g, const float* b, float* color0, float* color1)
+{
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+	float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+	float axis[3], next[3], dr, dg, db, scale, projection, low = FLT_MAX, high = -FLT_MAX;
+	unsigned i, low_index = 0, high_index = 0;
+
+	for (i = 0; i < BLOCK_PIXELS; ++i)
+	{
+		mean[0] += r[i];
+		mean[1] += g[i];
+		mean[2] += b[i];
+	}
+	glm_vec3_scale(mean, 1.0f / BLOCK_PIXELS, mean);
+
+	for (i = 0; i < BLOCK_PIXELS; ++i)
+	{
+		dr = r[i] - mean[0];
+		dg = g[i] - mean[1];
+		db = b[i] - mean[2];
+		cov[0] += dr * dr;
+		cov[1] += dr * dg;
+		cov[2] += dr * db;
+		cov[3] += dg * dg;
+		cov[4] += dg * db;
+		cov[5] += db * db;
+	}
+
+	axis[0] = axis[1] = axis[2] = 1.0f;
+	for (i = 0; i < POWER_ITERATIONS; ++i)
+	{
+		next[0] = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+		next[1] = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+		next[2] = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+		scale = glm_max(glm_max(fabsf(next[0]), fabsf(next[1])), fabsf(next[2]));
+		if (scale < FLT_EPSILON)
+			break;
+		glm_vec3_scale(next, 1.0f / scale, axis);
+	}
+
+	for (i = 0; i < BLOCK_PIXELS; ++i)
+	{
+		projection = r[i] * axis[0] + g[i] * axis[1] + b[i] * axis[2];
+		if (projection < low)
+		{
+			low = projection;
+			low_index = i;
+		}
+		if (projection > high)
+		{
+			high = projection;
+			high_index = i;
+		}
+	}
+
+	color0[0] = r[high_index];
+	color0[1] = g[high_index];
+	color0[2] = b[high_index];
+	color1[0] = r[low_index];
+	color1[1] = g[low_index];
+	color1[2] = b[low_index];
+}
+
+// Least squares endpoints for a fixed index assignment
+static int bc1_refine_endpoints(const float* r, const float* g, const float* b, const unsigned char* indices, float* color0, float* color1)
+{
+	static const float WEIGHTS[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[3] = { 0.0f, 0.0f, 0.0f };
+	float bx[3] = { 0.0f, 0.0f, 0.0f };
+	float alpha, beta, det;
+	unsigned i, c;
+
+	for (i = 0; i < BLOCK_PIXELS; ++i)
+	{
+		alpha = WEIGHTS[indices[i]];
+		beta = 1.0f - alpha;
+		aa += alpha * alpha;
+		ab += alpha * beta;
+		bb += beta * beta;
+		ax[0] += alpha * r[i];
+		ax[1] += alpha * g[i];
+		ax[2] += alpha * b[i];
+		bx[0] += beta * r[i];
+		bx[1] += beta * g[i];
+		bx[2] += beta * b[i];
+	}
+
+	det = aa * bb - ab * ab;
+	if (fabsf(det) < FLT_EPSILON)
+		return 0;
+	det = 1.0f / det;
+	for (c = 0; c < 3; ++c)
+	{
+		color0[c] = glm_clamp((ax[c] * bb - bx[c] * ab) * det, 0.0f, 255.0f);
+		color1[c] = glm_clamp((bx[c] * aa - ax[c] * ab) * det, 0.0f, 255.0f);
+	}
+	return 1;
+}
+
+static float bc1_try_endpoints(const float* r, const float* g, const float* b, const float* color0, const float* color1, unsigned* packed0, unsigned* packed1, unsigned char* indices)
+{
+	int palette[4][3];
+	unsigned swap;
+	unsigned i;
+
+	*packed0 = pack_565(color0);
+	*packed1 = pack_565(color1);
+
+	// Four colour mode requires color0 > color1
+	if (*packed0 < *packed1)
+	{
+		swap = *packed0;
+		*packed0 = *packed1;
+		*packed1 = swap;
+	}
+	else if (*packed0 == *packed1)
+	{
+		// Single colour: every pixel takes color0, the mode bit is irrelevant
+		bc1_palette(*packed0, *packed1, palette);
+		for (i = 0; i < BLOCK_PIXELS; ++i)
+			indices[i] = 0;
+		palette[1][0] = palette[2][0] = palette[3][0] = palette[0][0];
+		palette[1][1] = palette[2][1] = palette[3][1] = palette[0][1];
+		palette[1][2] = palette[2][2] = palette[3][2] = palette[0][2];
+		return bc1_select(r, g, b, palette, indices);
+	}
+
+	bc1_palette(*packed0, *packed1, palette);
+	return bc1_select(r, g, b, palette, indices);
+}
+
+static void compress_bc1_block(unsigned char* block, const unsigned char* rgba)
+{
+	CGLM_ALIGN(16) float r[BLOCK_PIXELS];
+	CGLM_ALIGN(16) float g[BLOCK_PIXELS];
+	CGLM_ALIGN(16) float b[BLOCK_PIXELS];
+	float color0[3], color1[3];
+	unsigned char indices[BLOCK_PIXELS], best_indices[BLOCK_PIXELS];
+	unsigned packed0, packed1, best0, best1, bits = 0;
+	float error, best_error;
+	unsigned i;
+
+	for (i = 0; i < BLOCK_PIXELS; ++i)
+	{
+		r[i] = (float)rgba[i * 4 + 0];
+		g[i] = (float)rgba[i * 4 + 1];
+		b[i] = (float)rgba[i * 4 + 2];
+	}
+
+	bc1_principal_endpoints(r, g, b, color0, color1);
+	best_error = bc1_try_endpoints(r, g, b, color0, color1, &best0, &best1, best_indices);
+	memcpy(indices, best_indices, BLOCK_PIXELS);
+
+	for (i = 0; i < REFINE_ITERATIONS && best_error > 0.0f; ++i)
+	{
+		if (!bc1_refine_endpoints(r, g, b, indices, color0, color1))
+			break;
+		error = bc1_try_endpoints(r, g, b, color0, color1, &packed0, &packed1, indices);
+		if (error >= best_error)
+			break;
+		best_error = error;
+		best0 = packed0;
+		best1 = packed1;
+		memcpy(best_indices, indices, BLOCK_PIXELS);
+	}
+
+	for (i = 0; i < BLOCK_PIXELS; ++i)
+		bits |= (unsigned)best_indices[i] << (i * 2);
+	block[0] = (unsigned char)(best0 & 0xFF);
+	block[1] = (unsigned char)(best0 >> 8);
+	block[2] = (unsigned char)(best1 & 0xFF);
+	block[3] = (unsigned char)(best1 >> 8);
+	block[4] = (unsigned char)(bits & 0xFF);
+	block[5] = (unsigned char)((bits >> 8) & 0xFF);
+	block[6] = (unsigned char)((bits >> 16) & 0xFF);
+	block[7] = (unsigned char)(bits >> 24);
+}
+
+static void decompress_bc1_block(unsigned char* rgba, const unsigned char* block)
+{
+	const unsigned color0 = block[0] | block[1] << 8;
+	const unsigned color1 = block[2] | block[3] << 8;
+	const unsigned bits = block[4] | block[5] << 8 | block[6] << 16 | (unsigned)block[7] << 24;
+	int palette[4][3];
+	unsigned index, i;
+	int c;
+
+	bc1_palette(color0, color1, palette);
+	if (color0 <= color1)
+		for (c = 0; c < 3; ++c)
+		{
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+
+	for (i = 0; i < BLOCK_PIXELS; ++i)
+	{
+		index = (bits >> (i * 2)) & 3;
+		rgba[i * 4 + 0] = (unsigned char)palette[index][0];
+		rgba[i * 4 + 1] = (unsigned char)palette[index][1];
+		rgba[i * 4 + 2] = (unsigned char)palette[index][2];
+		rgba[i * 4 + 3] = color0 <= color1 && index == 3 ? 0 : 255;
+	}
+}
+
+// =====================================
+// BC4 Single Channel Block
+// =====================================
+
+static void bc4_palette(unsigned value0, unsigned value1, unsigned char* palette)
+{
+	unsigned i;
+	palette[0] = (unsigned char)value0;
+	palette[1] = (unsigned char)value1;
+	if (value0 > value1)
+		for (i = 1; i < 7; ++i)
+			palette[i + 1] = (unsigned char)(((7 - i) * value0 + i * value1) / 7);
+	else
+	{
+		for (i = 1; i < 5; ++i)
+			palette[i + 1] = (unsigned char)(((5 - i) * value0 + i * value1) / 5);
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+// values is 16 bytes of one channel
+static void compress_bc4_block(unsigned char* block, const unsigned char* values)
+{
+	unsigned char palette[8];
+	unsigned char indices[BLOCK_PIXELS];
+	unsigned low = 255, high = 0, i;
+	unsigned long long bits = 0;
+
+	for (i = 0; i < BLOCK_PIXELS; ++i)
+	{
+		low = values[i] < low ? values[i] : low;
+		high = values[i] > high ? values[i] : high;
+	}
+
+	if (low == high)
+		memset(indices, 0, BLOCK_PIXELS);
+	else
+	{
+		bc4_palette(high, low, palette);
+#if defined(__SSE2__)
+		const __m128i v = _mm_loadu_si128((const __m128i*)values);
+		__m128i best = _mm_set1_epi8((char)0xFF);
+		__m128i index = _mm_setzero_si128();
+		__m128i p, distance, closer;
+		for (i = 0; i < 8; ++i)
+		{
+			p = _mm_set1_epi8((char)palette[i]);
+			distance = _mm_or_si128(_mm_subs_epu8(v, p), _mm_subs_epu8(p, v));
+			// Strictly closer: min(distance, best) == distance and distance != best
+			closer = _mm_andnot_si128(_mm_cmpeq_epi8(distance, best), _mm_cmpeq_epi8(_mm_min_epu8(distance, best), distance));
+			index = _mm_or_si128(_mm_andnot_si128(closer, index), _mm_and_si128(closer, _mm_set1_epi8((char)i)));
+			best = _mm_min_epu8(distance, best);
+		}
+		_mm_storeu_si128((__m128i*)indices, index);
+#else
+		unsigned k, distance, best;
+		for (i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			best = 256;
+			for (k = 0; k < 8; ++k)
+			{
+				distance = values[i] > palette[k] ? values[i] - palette[k] : palette[k] - values[i];
+				if (distance < best)
+				{
+					best = distance;
+					indices[i] = (unsigned char)k;
+				}
+			}
+		}
+#endif
+	}
+
+	for (i = 0; i < BLOCK_PIXELS; ++i)
+		bits |= (unsigned long long)indices[i] << (i * 3);
+	block[0] = (unsigned char)high;
+	block[1] = (unsigned char)low;
+	for (i = 0; i < 6; ++i)
+		block[2 + i] = (unsigned char)(bits >> (i * 8));
+}
+
+static void decompress_bc4_block(unsigned char* values, unsigned stride, const unsigned char* block)
+{
+	unsigned char palette[8];
+	unsigned long long bits = 0;
+	unsigned i;
+
+	bc4_palette(block[0], block[1], palette);
+	for (i = 0; i < 6; ++i)
+		bits |= (unsigned long long)block[2 + i] << (i * 8);
+	for (i = 0; i < BLOCK_PIXELS; ++i)
+		values[i * stride] = palette[(bits >> (i * 3)) & 7];
+}
+
+// =====================================
+// Textures
+// =====================================
+
+static void compress_rows(void* data, unsigned begin, unsigned end)
+{
+	const struct compress_job* job = (const struct compress_job*)data;
+	const unsigned blocks_x = (job->width + 3) / 4;
+	const unsigned block_size = job->format == TEXTURE_FORMAT_BC3 ? 16 : 8;
+	unsigned char rgba[BLOCK_PIXELS * 4];
+	unsigned char alpha[BLOCK_PIXELS];
+	unsigned char* block;
+	unsigned x, y, i;
+
+	for (y = begin; y < end; ++y)
+		for (x = 0; x < blocks_x; ++x)
+		{
+			block = job->dest + (y * blocks_x + x) * block_size;
+			load_block(rgba, job->src, job->width, job->height, job->channels, x * 4, y * 4);
+			switch (job->format)
+			{
+			case TEXTURE_FORMAT_BC1:
+				compress_bc1_block(block, rgba);
+				break;
+			case TEXTURE_FORMAT_BC3:
+				for (i = 0; i < BLOCK_PIXELS; ++i)
+					alpha[i] = rgba[i * 4 + 3];
+				compress_bc4_block(block, alpha);
+				compress_bc1_block(block + 8, rgba);
+				break;
+			case TEXTURE_FORMAT_BC4:
+				for (i = 0; i < BLOCK_PIXELS; ++i)
+					alpha[i] = rgba[i * 4];
+				compress_bc4_block(block, alpha);
+				break;
+			}
+		}
+}
+
+void compress_texture(unsigned char* dest, const unsigned char* src, unsigned width, unsigned height, unsigned channels, unsigned format)
+{
+	struct compress_job job;
+	job.dest = dest;
+	job.src = src;
+	job.width = width;
+	job.height = height;
+	job.channels = channels;
+	job.format = format;
+	jobs_parallel_for(compress_rows, &job, (height + 3) / 4, BLOCK_ROWS_PER_JOB);
+}
+
+void decompress_texture(unsigned char* dest, const unsigned char* src, unsigned width, unsigned height, unsigned format)
+{
+	const unsigned channels = texture_format_channels(format);
+	const unsigned blocks_x = (width + 3) / 4;
+	const unsigned blocks_y = (height + 3) / 4;
+	unsigned char rgba[BLOCK_PIXELS * 4];
+	unsigned x, y;
+
+	for (y = 0; y < blocks_y; ++y)
+		for (x = 0; x < blocks_x; ++x)
+		{
+			switch (format)
+			{
+			case TEXTURE_FORMAT_BC1:
+				decompress_bc1_block(rgba, src);
+				src += 8;
+				break;
+			case TEXTURE_FORMAT_BC3:
+				decompress_bc1_block(rgba, src + 8);
+				decompress_bc4_block(rgba + 3, 4, src);
+				src += 16;
+				break;
+			case TEXTURE_FORMAT_BC4:
+				decompress_bc4_block(rgba, 4, src);
+				src += 8;
+				break;
+			default:
+				return;
+			}
+			store_block(dest, rgba, width, height, channels, x * 4, y * 4);
+		}
+}
+
+double texture_psnr(const unsigned char* image, unsigned channels, const unsigned char* reference, unsigned reference_channels, unsigned width, unsigned height)
+{
+	const unsigned pixels = width * height;
+	const unsigned compared = channels < reference_channels ? channels : reference_channels;
+	double error = 0.0, difference;
+	unsigned i, c;
+
+	for (i = 0; i < pixels; ++i)
+		for (c = 0; c < compared; ++c)
+		{
+			difference = (double)image[i * channels + c] - (double)reference[i * reference_channels + c];
+			error += difference * difference;
+		}
+	error /= (double)pixels * compared;
+	if (error <= 0.0)
+		return 99.0;
+	return 10.0 * log10(255.0 * 255.0 / error);
+}
@@ -0,0 +1,57 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef TEXTURE_COMPRESS_H
+#define TEXTURE_COMPRESS_H
+
+#define TEXTURE_FORMAT_R8 0
+#define TEXTURE_FORMAT_RGB8 1
+#define TEXTURE_FORMAT_RGBA8 2
+#define TEXTURE_FORMAT_BC1 3
+#define TEXTURE_FORMAT_BC3 4
+#define TEXTURE_FORMAT_BC4 5
+
+#define TEXTURE_MAGIC 0x5845544C // LTEX
+#define TEXTURE_MAX_LEVELS 16
+
+// Cooked texture file: header followed by the data of every mip level,
+// largest first, each level sizes[level] bytes long
+struct texture_header
+{
+	unsigned magic;
+	unsigned format;
+	unsigned width;
+	unsigned height;
+	unsigned levels;
+	unsigned sizes[TEXTURE_MAX_LEVELS];
+};
+
+unsigned texture_format_channels(unsigned format);
+int texture_format_compressed(unsigned format);
+unsigned texture_level_size(unsigned format, unsigned width, unsigned height);
+
+void compress_texture(unsigned char* dest, const unsigned char* src, unsigned width, unsigned height, unsigned channels, unsigned format);
+void decompress_texture(unsigned char* dest, const unsigned char* src, unsigned width, unsigned height, unsigned format);
+double texture_psnr(const unsigned char* image, unsigned channels, const unsigned char* reference, unsigned reference_channels, unsigned width, unsigned height);
+
+#endif // TEXTURE_COMPRESS_H
@@ -0,0 +1,437 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <GL/glew.h>
+#include <SDL_events.h>
+#include "common.h"
+#include "mipmap.h"
+#include "resource.h"
+#include "stb_image.h"
+#include "texture_compress.h"
+#include "texture_manager.h"
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+static int format_supported(unsigned format)
+{
+	switch (format)
+	{
+	case TEXTURE_FORMAT_BC1:
+	case TEXTURE_FORMAT_BC3:
+		return GLEW_EXT_texture_compression_s3tc;
+	case TEXTURE_FORMAT_BC4:
+		return GLEW_VERSION_3_0 || GLEW_ARB_texture_compression_rgtc;
+	default:
+		return 1;
+	}
+}
+
+static GLenum internal_format(unsigned format)
+{
+	switch (format)
+	{
+	case TEXTURE_FORMAT_R8:
+		return GL_R8;
+	case TEXTURE_FORMAT_RGB8:
+		return GL_RGB8;
+	case TEXTURE_FORMAT_BC1:
+		return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case TEXTURE_FORMAT_BC3:
+		return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case TEXTURE_FORMAT_BC4:
+		return GL_COMPRESSED_RED_RGTC1;
+	default:
+		return GL_RGBA8;
+	}
+}
+
+static GLenum channels_format(unsigned channels)
+{
+	switch (channels)
+	{
+	case 1:
+		return GL_RED;
+	case 2:
+		return GL_RG;
+	case 3:
+		return GL_RGB;
+	default:
+		return GL_RGBA;
+	}
+}
+
+static GLenum pixel_format(unsigned format)
+{
+	return channels_format(texture_format_channels(format));
+}
+
+static const struct texture_header* read_header(const unsigned char* data, unsigned size, const char* filename)
+{
+	const struct texture_header* header = (const struct texture_header*)data;
+	if (size < sizeof(struct texture_header) || header->magic != TEXTURE_MAGIC || !header->levels || header->levels > TEXTURE_MAX_LEVELS)
+	{
+		error("Texture Loading Error", "File %s is not a cooked texture.", filename);
+		return NULL;
+	}
+	return header;
+}
+
+// Drivers without the block compression extensions get the texture decoded on the CPU
+static unsigned upload_format(unsigned format)
+{
+	if (format_supported(format))
+		return format;
+	return texture_format_channels(format) == 1 ? TEXTURE_FORMAT_R8 : texture_format_channels(format) == 3 ? TEXTURE_FORMAT_RGB8 : TEXTURE_FORMAT_RGBA8;
+}
+
+// Single channel textures are sampled as grey instead of red
+static void set_swizzle(GLenum target, unsigned format)
+{
+	if (texture_format_channels(format) == 1)
+	{
+		const GLint swizzle[] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+		glTexParameteriv(target, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+	}
+}
+
+// Uploads every level to the bound 2D texture, or to one layer of the bound array when layer is not negative
+static void upload_levels(const struct texture_header* header, int layer)
+{
+	const unsigned char* data = (const unsigned char*)header + sizeof(struct texture_header);
+	const unsigned format = upload_format(header->format);
+	unsigned char* decompressed = NULL;
+	const unsigned char* pixels;
+	unsigned width, height, level;
+
+	if (format != header->format)
+		decompressed = (unsigned char*)malloc(texture_level_size(format, header->width, header->height));
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (level = 0; level < header->levels; ++level)
+	{
+		width = header->width >> level ? header->width >> level : 1;
+		height = header->height >> level ? header->height >> level : 1;
+		pixels = data;
+		if (decompressed)
+		{
+			decompress_texture(decompressed, data, width, height, header->format);
+			pixels = decompressed;
+		}
+
+		if (layer < 0 && texture_format_compressed(format))
+			glCompressedTexImage2D(GL_TEXTURE_2D, level, internal_format(format), width, height, 0, header->sizes[level], pixels);
+		else if (layer < 0)
+			glTexImage2D(GL_TEXTURE_2D, level, internal_format(format), width, height, 0, pixel_format(format), GL_UNSIGNED_BYTE, pixels);
+		else if (texture_format_compressed(format))
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, internal_format(format), header->sizes[level], pixels);
+		else
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, pixel_format(format), GL_UNSIGNED_BYTE, pixels);
+		data += header->sizes[level];
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	free(decompressed);
+}
+
+static int upload_cooked(const unsigned char* data, unsigned size, const char* filename)
+{
+	const struct texture_header* header = read_header(data, size, filename);
+	if (!header)
+		return 0;
+
+	set_swizzle(GL_TEXTURE_2D, upload_format(header->format));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, header->levels - 1);
+	upload_levels(header, -1);
+	return 1;
+}
+
+// Loose images get their mipmaps from generate_mipmaps() rather than
+// glGenerateMipmap(), which filters in gamma space with a box on most drivers
+static int upload_image(const char* filename)
+{
+	int width, height, channels;
+	unsigned char *chain, *mip;
+	unsigned levels, level, level_width, level_height;
+	GLenum format;
+	unsigned char* texture_data = load_image(filename, &width, &height, &channels);
+	if (!texture_data)
+	{
+		error("Texture Loading Error", "Could not found file %s.", filename);
+		return 0;
+	}
+
+	chain = (unsigned char*)malloc(mipmap_chain_size(width, height, channels));
+	if (!chain)
+	{
+		stbi_image_free(texture_data);
+		error("Texture Loading Error", "Could not allocate the mipmaps of %s.", filename);
+		return 0;
+	}
+	levels = generate_mipmaps(chain, texture_data, width, height, channels, MIPMAP_FILTER_KAISER, MIPMAP_SRGB, 0.0f);
+	stbi_image_free(texture_data);
+	format = channels_format((unsigned)channels);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (level = 0, mip = chain; level < levels; ++level)
+	{
+		level_width = width >> level ? width >> level : 1;
+		level_height = height >> level ? height >> level : 1;
+		glTexImage2D(GL_TEXTURE_2D, level, format, level_width, level_height, 0, format, GL_UNSIGNED_BYTE, mip);
+		mip += level_width * level_height * channels;
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	free(chain);
+	return 1;
+}
+
+unsigned load_texture(const char* filename)
+{
+	const size_t length = strlen(filename);
+	struct resource resource;
+	unsigned texture;
+	int success;
+
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	if (length > 4 && !strcmp(filename + length - 4, ".tex"))
+	{
+		success = load_resource(&resource, filename);
+		if (success)
+		{
+			success = upload_cooked(resource.data, resource.size, filename);
+			free_resource(&resource);
+		}
+	}
+	else
+		success = upload_image(filename);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	if (!success || !validate_gl("Texture Creation Error"))
+	{
+		glDeleteTextures(1, &texture);
+		return 0;
+	}
+	return texture;
+}
+
+// =====================================
+// Texture Arrays
+// =====================================
+
+void create_texture_array(struct texture_array* array, unsigned capacity)
+{
+	int max_layers;
+
+	memset(array, 0, sizeof(struct texture_array));
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+	array->capacity = capacity < (unsigned)max_layers ? capacity : (unsigned)max_layers;
+	glGenTextures(1, &array->texture);
+}
+
+// Storage for all layers is allocated when the first texture fixes format and size
+static void allocate_array(struct texture_array* array, const struct texture_header* header)
+{
+	const unsigned format = upload_format(header->format);
+	unsigned width, height, level;
+
+	array->format = header->format;
+	array->width = header->width;
+	array->height = header->height;
+	array->levels = header->levels;
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, header->levels - 1);
+	set_swizzle(GL_TEXTURE_2D_ARRAY, format);
+
+	for (level = 0; level < header->levels; ++level)
+	{
+		width = header->width >> level ? header->width >> level : 1;
+		height = header->height >> level ? header->height >> level : 1;
+		if (texture_format_compressed(format))
+			glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, internal_format(format), width, height, array->capacity, 0,
+								   texture_level_size(format, width, height) * array->capacity, NULL);
+		else
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, level, internal_format(format), width, height, array->capacity, 0, pixel_format(format),
+						 GL_UNSIGNED_BYTE, NULL);
+	}
+}
+
+int add_texture_layer(struct texture_array* array, const char* filename)
+{
+	const struct texture_header* header;
+	struct resource resource;
+	int layer = -1;
+
+	if (!load_resource(&resource, filename))
+		return -1;
+
+	header = read_header(resource.data, resource.size, filename);
+	if (header)
+	{
+		glBindTexture(GL_TEXTURE_2D_ARRAY, array->texture);
+		if (!array->layers)
+			allocate_array(array, header);
+
+		if (header->format != array->format || header->width != array->width || header->height != array->height || header->levels != array->levels)
+			error("Texture Array Error", "Texture %s differs in format or size from the other layers of its array.", filename);
+		else if (array->layers >= array->capacity)
+			error("Texture Array Error", "Could not add texture %s: array is full (%u layers).", filename, array->capacity);
+		else
+		{
+			upload_levels(header, array->layers);
+			layer = (int)array->layers++;
+		}
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+	free_resource(&resource);
+
+	if (layer >= 0 && !validate_gl("Texture Array Error"))
+		return -1;
+	return layer;
+}
+
+void destroy_texture_array(struct texture_array* array)
+{
+	glDeleteTextures(1, &array->texture);
+	memset(array, 0, sizeof(struct texture_array));
+}
+
+// =====================================
+// Material Tables
+// =====================================
+
+int create_material_table(struct material_table* table, unsigned capacity)
+{
+	unsigned i;
+
+	memset(table, 0, sizeof(struct material_table));
+	table->capacity = capacity;
+	table->bindless = GLEW_ARB_bindless_texture && (GLEW_VERSION_4_3 || GLEW_ARB_shader_storage_buffer_object);
+	if (!table->bindless)
+	{
+		for (i = 0; i < MATERIAL_TEXTURES; ++i)
+			create_texture_array(&table->arrays[i], capacity);
+		return 1;
+	}
+
+	table->textures = (unsigned*)calloc(capacity * MATERIAL_TEXTURES, sizeof(unsigned));
+	table->handles = (uint64_t*)calloc(capacity * MATERIAL_TEXTURES, sizeof(uint64_t));
+	glGenBuffers(1, &table->buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, table->buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * MATERIAL_TEXTURES * sizeof(uint64_t), NULL, GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	return validate_gl("Material Table Error");
+}
+
+int add_material(struct material_table* table, const char* const* filenames)
+{
+	uint64_t* handles;
+	unsigned* textures;
+	unsigned i;
+
+	if (table->count >= table->capacity)
+	{
+		error("Material Table Error", "Could not add material %s: table is full (%u materials).", filenames[0], table->capacity);
+		return -1;
+	}
+
+	if (!table->bindless)
+	{
+		for (i = 0; i < MATERIAL_TEXTURES; ++i)
+			if (add_texture_layer(&table->arrays[i], filenames[i]) != (int)table->count)
+				return -1;
+		return (int)table->count++;
+	}
+
+	handles = table->handles + table->count * MATERIAL_TEXTURES;
+	textures = table->textures + table->count * MATERIAL_TEXTURES;
+	for (i = 0; i < MATERIAL_TEXTURES; ++i)
+	{
+		textures[i] = load_texture(filenames[i]);
+		if (!textures[i])
+			return -1;
+		handles[i] = glGetTextureHandleARB(textures[i]);
+		glMakeTextureHandleResidentARB(handles[i]);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, table->buffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, table->count * MATERIAL_TEXTURES * sizeof(uint64_t), MATERIAL_TEXTURES * sizeof(uint64_t), handles);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	if (!validate_gl("Material Table Error"))
+		return -1;
+	return (int)table->count++;
+}
+
+// Bindless tables go to storage buffer binding point, arrays to texture units 0..MATERIAL_TEXTURES-1
+void bind_material_table(const struct material_table* table, unsigned binding)
+{
+	unsigned i;
+
+	if (table->bindless)
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, table->buffer);
+	else
+	{
+		for (i = 0; i < MATERIAL_TEXTURES; ++i)
+		{
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, table->arrays[i].texture);
+		}
+		glActiveTexture(GL_TEXTURE0);
+	}
+}
+
+void destroy_material_table(struct material_table* table)
+{
+	unsigned i;
+
+	if (table->bindless)
+	{
+		for (i = 0; i < table->capacity * MATERIAL_TEXTURES; ++i)
+			if (table->textures[i])
+			{
+				if (table->handles[i])
+					glMakeTextureHandleNonResidentARB(table->handles[i]);
+				glDeleteTextures(1, &table->textures[i]);
+			}
+		glDeleteBuffers(1, &table->buffer);
+		free(table->handles);
+		free(table->textures);
+	}
+	else
+		for (i = 0; i < MATERIAL_TEXTURES; ++i)
+			destroy_texture_array(&table->arrays[i]);
+	memset(table, 0, sizeof(struct material_table));
+}
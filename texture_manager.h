@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef TEXTURE_MANAGER_H
+#define TEXTURE_MANAGER_H
+
+#include <stdint.h>
+
+#define MATERIAL_TEXTURES 2
+
+// Layers of one GL_TEXTURE_2D_ARRAY: every layer shares the cooked format,
+// size and mip count of the first texture added, so a whole set of
+// materials is bound once and picked by layer index in the shader.
+struct texture_array
+{
+	unsigned texture;
+	unsigned format;
+	unsigned width;
+	unsigned height;
+	unsigned levels;
+	unsigned layers;
+	unsigned capacity;
+};
+
+// Textures of every material, reachable from shaders by material index.
+// With ARB_bindless_texture the handles of resident textures are stored in
+// a shader storage buffer; otherwise texture i of each material is a layer
+// of arrays[i]. Either way it is bound once per frame, not per draw.
+struct material_table
+{
+	struct texture_array arrays[MATERIAL_TEXTURES];
+	unsigned* textures;
+	uint64_t* handles;
+	unsigned buffer;
+	unsigned count;
+	unsigned capacity;
+	int bindless;
+};
+
+unsigned load_texture(const char* filename);
+
+void create_texture_array(struct texture_array* array, unsigned capacity);
+int add_texture_layer(struct texture_array* array, const char* filename);
+void destroy_texture_array(struct texture_array* array);
+
+int create_material_table(struct material_table* table, unsigned capacity);
+int add_material(struct material_table* table, const char* const* filenames);
+void bind_material_table(const struct material_table* table, unsigned binding);
+void destroy_material_table(struct material_table* table);
+
+#endif // TEXTURE_MANAGER_H
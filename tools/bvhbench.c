@@ -0,0 +1,410 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// BVH benchmark: builds a hierarchy over a field of rotated cubes and
+// measures build, refit and query throughput. Every query kind is checked
+// against a brute force pass over all objects on a few samples.
+//
+// Usage: bvhbench [objects]
+// One million objects by default.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL_timer.h>
+#include "../bvh.h"
+#include "../cglm/affine.h"
+#include "../cglm/box.h"
+#include "../cglm/cam.h"
+#include "../cglm/frustum.h"
+#include "../cglm/ray.h"
+#include "../jobs.h"
+
+#define FIELD_SIZE 1000.0f
+#define BUILD_RUNS 3
+#define REFIT_RUNS 10
+#define FRUSTUM_QUERIES 200
+#define RAY_QUERIES 100000
+#define OVERLAP_QUERIES 100000
+#define CHECKED_QUERIES 20
+#define RAYS_PER_JOB 256
+
+struct scene
+{
+	vec4* cubes; // Position and scale
+	float* angles;
+	vec3 (*boxes)[2];
+	unsigned count;
+};
+
+struct ray_job
+{
+	const struct bvh* bvh;
+	vec3* origins;
+	vec3* directions;
+	unsigned hits[RAY_QUERIES];
+};
+
+static const vec3 CUBE_AXIS = { 0.267f, 0.535f, 0.802f };
+
+static unsigned seed = 1;
+
+static float random_float(float min, float max)
+{
+	seed = seed * 1664525u + 1013904223u;
+	return min + (max - min) * (float)(seed >> 8) / 16777216.0f;
+}
+
+static void random_direction(vec3 direction)
+{
+	direction[0] = random_float(-1.0f, 1.0f);
+	direction[1] = random_float(-1.0f, 1.0f);
+	direction[2] = random_float(-1.0f, 1.0f);
+	glm_vec3_normalize(direction);
+}
+
+static double seconds_since(Uint64 start)
+{
+	return (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+static void cube_transform(const struct scene* scene, unsigned cube, mat4 transform)
+{
+	glm_translate_make(transform, scene->cubes[cube]);
+	glm_rotate(transform, scene->angles[cube], (float*)CUBE_AXIS);
+	glm_scale_uni(transform, scene->cubes[cube][3]);
+}
+
+static void update_box(struct scene* scene, unsigned cube)
+{
+	vec3 unit[2] = { { -0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, 0.5f } };
+	mat4 transform;
+	cube_transform(scene, cube, transform);
+	glm_aabb_transform(unit, transform, scene->boxes[cube]);
+}
+
+// Exact hit against the twelve triangles of the rotated cube
+static int ray_cube(void* data, unsigned object, vec3 origin, vec3 direction, float* distance)
+{
+	static const unsigned FACES[6][4] =
+	{
+		{ 0, 1, 3, 2 }, { 4, 6, 7, 5 }, { 0, 4, 5, 1 }, { 2, 3, 7, 6 }, { 0, 2, 6, 4 }, { 1, 5, 7, 3 }
+	};
+	vec3 corners[8];
+	mat4 transform;
+	float face_distance;
+	unsigned i;
+	int hit = 0;
+
+	cube_transform((const struct scene*)data, object, transform);
+	for (i = 0; i < 8; ++i)
+	{
+		corners[i][0] = i & 1 ? 0.5f : -0.5f;
+		corners[i][1] = i & 2 ? 0.5f : -0.5f;
+		corners[i][2] = i & 4 ? 0.5f : -0.5f;
+		glm_mat4_mulv3(transform, corners[i], 1.0f, corners[i]);
+	}
+	for (i = 0; i < 6; ++i)
+		if ((glm_ray_triangle(origin, direction, corners[FACES[i][0]], corners[FACES[i][1]], corners[FACES[i][2]], &face_distance) ||
+			 glm_ray_triangle(origin, direction, corners[FACES[i][0]], corners[FACES[i][2]], corners[FACES[i][3]], &face_distance)) &&
+			(!hit || face_distance < *distance))
+		{
+			*distance = face_distance;
+			hit = 1;
+		}
+	return hit;
+}
+
+static void rays_job(void* data, unsigned begin, unsigned end)
+{
+	struct ray_job* job = (struct ray_job*)data;
+	unsigned i, object;
+	float distance;
+	for (i = begin; i < end; ++i)
+		job->hits[i] = raycast_bvh(job->bvh, job->origins[i], job->directions[i], FIELD_SIZE, NULL, NULL, &object, &distance) ? object : ~0u;
+}
+
+static unsigned brute_frustum(const struct scene* scene, vec4 planes[6])
+{
+	unsigned i, found = 0;
+	for (i = 0; i < scene->count; ++i)
+		found += glm_aabb_frustum(scene->boxes[i], planes);
+	return found;
+}
+
+static unsigned brute_ray(const struct scene* scene, vec3 origin, vec3 direction)
+{
+	float t0, t1, near, far, best = FIELD_SIZE;
+	unsigned i, axis, hit = ~0u;
+
+	for (i = 0; i < scene->count; ++i)
+	{
+		near = 0.0f;
+		far = best;
+		for (axis = 0; axis < 3; ++axis)
+		{
+			t0 = (scene->boxes[i][0][axis] - origin[axis]) / direction[axis];
+			t1 = (scene->boxes[i][1][axis] - origin[axis]) / direction[axis];
+			near = glm_max(near, glm_min(t0, t1));
+			far = glm_min(far, glm_max(t0, t1));
+		}
+		if (near <= far && near <= best)
+		{
+			best = near;
+			hit = i;
+		}
+	}
+	return hit;
+}
+
+static unsigned brute_sphere(const struct scene* scene, vec4 sphere)
+{
+	unsigned i, found = 0;
+	vec3 closest;
+	for (i = 0; i < scene->count; ++i)
+	{
+		closest[0] = glm_clamp(sphere[0], scene->boxes[i][0][0], scene->boxes[i][1][0]);
+		closest[1] = glm_clamp(sphere[1], scene->boxes[i][0][1], scene->boxes[i][1][1]);
+		closest[2] = glm_clamp(sphere[2], scene->boxes[i][0][2], scene->boxes[i][1][2]);
+		found += glm_vec3_distance2(closest, sphere) <= sphere[3] * sphere[3];
+	}
+	return found;
+}
+
+static unsigned brute_box(const struct scene* scene, vec3 box[2])
+{
+	unsigned i, found = 0;
+	for (i = 0; i < scene->count; ++i)
+		found += glm_aabb_aabb(scene->boxes[i], box);
+	return found;
+}
+
+int main(int argc, char** argv)
+{
+	struct scene scene;
+	struct bvh bvh;
+	struct ray_job* rays;
+	unsigned* results;
+	vec4 planes[6];
+	vec4 sphere;
+	vec3 box[2], eye, direction;
+	mat4 proj, view, viewproj;
+	double seconds, best;
+	Uint64 start;
+	unsigned i, run, found, object, mismatches;
+	float distance;
+
+	scene.count = argc > 1 ? (unsigned)atoi(argv[1]) : 1000000;
+	if (!scene.count)
+	{
+		fprintf(stderr, "Usage: bvhbench [objects]\n");
+		return 1;
+	}
+
+	scene.cubes = (vec4*)malloc(scene.count * sizeof(vec4));
+	scene.angles = (float*)malloc(scene.count * sizeof(float));
+	scene.boxes = (vec3(*)[2])malloc(scene.count * sizeof(vec3[2]));
+	results = (unsigned*)malloc(scene.count * sizeof(unsigned));
+	rays = (struct ray_job*)malloc(sizeof(struct ray_job));
+	rays->origins = (vec3*)malloc(RAY_QUERIES * sizeof(vec3));
+	rays->directions = (vec3*)malloc(RAY_QUERIES * sizeof(vec3));
+	for (i = 0; i < scene.count; ++i)
+	{
+		scene.cubes[i][0] = random_float(0.0f, FIELD_SIZE);
+		scene.cubes[i][1] = random_float(0.0f, FIELD_SIZE * 0.1f);
+		scene.cubes[i][2] = random_float(0.0f, FIELD_SIZE);
+		scene.cubes[i][3] = random_float(0.5f, 2.0f);
+		scene.angles[i] = random_float(0.0f, GLM_PIf * 2.0f);
+		update_box(&scene, i);
+	}
+
+	jobs_init(0);
+	printf("%u objects, %u threads\n", scene.count, jobs_thread_count());
+
+	// =====================================
+	// Build
+	// =====================================
+	best = 1e9;
+	for (run = 0; run < BUILD_RUNS; ++run)
+	{
+		if (run)
+			destroy_bvh(&bvh);
+		start = SDL_GetPerformanceCounter();
+		if (!build_bvh(&bvh, scene.boxes, scene.count))
+		{
+			fprintf(stderr, "bvhbench: out of memory.\n");
+			return 1;
+		}
+		seconds = seconds_since(start);
+		best = glm_min(best, seconds);
+	}
+	printf("build:           %8.2f ms, %.1f M objects/s, %u subtrees\n",
+		   best * 1000.0, scene.count / best / 1e6, bvh.subtrees_count);
+
+	// =====================================
+	// Refit
+	// =====================================
+	best = 1e9;
+	for (run = 0; run < REFIT_RUNS; ++run)
+	{
+		for (i = 0; i < scene.count; ++i)
+		{
+			scene.angles[i] += 0.02f;
+			update_box(&scene, i);
+		}
+		start = SDL_GetPerformanceCounter();
+		refit_bvh(&bvh, scene.boxes);
+		best = glm_min(best, seconds_since(start));
+	}
+	printf("refit:           %8.2f ms\n", best * 1000.0);
+
+	found = scene.count / 100 ? scene.count / 100 : 1;
+	for (i = 0; i < found; ++i)
+	{
+		object = (i * 7919u) % scene.count;
+		scene.angles[object] += 0.02f;
+		update_box(&scene, object);
+	}
+	start = SDL_GetPerformanceCounter();
+	for (i = 0; i < found; ++i)
+	{
+		object = (i * 7919u) % scene.count;
+		update_bvh_object(&bvh, object, scene.boxes[object]);
+	}
+	seconds = seconds_since(start);
+	printf("object update:   %8.2f ns, %u objects\n", seconds / found * 1e9, found);
+
+	// =====================================
+	// Frustum
+	// =====================================
+	glm_perspective(glm_rad(60.0f), 16.0f / 9.0f, 0.1f, 100.0f, proj);
+	mismatches = 0;
+	found = 0;
+	seconds = 0.0;
+	for (run = 0; run < FRUSTUM_QUERIES; ++run)
+	{
+		glm_vec3_copy((vec3){ random_float(0.0f, FIELD_SIZE), FIELD_SIZE * 0.05f, random_float(0.0f, FIELD_SIZE) }, eye);
+		random_direction(direction);
+		glm_look(eye, direction, GLM_YUP, view);
+		glm_mat4_mul(proj, view, viewproj);
+		glm_frustum_planes(viewproj, planes);
+
+		start = SDL_GetPerformanceCounter();
+		i = query_bvh_frustum(&bvh, planes, results);
+		seconds += seconds_since(start);
+		found += i;
+		if (run < CHECKED_QUERIES && i != brute_frustum(&scene, planes))
+			++mismatches;
+	}
+	printf("frustum:         %8.0f queries/s, %u objects each, %u mismatches\n",
+		   FRUSTUM_QUERIES / seconds, found / FRUSTUM_QUERIES, mismatches);
+
+	// =====================================
+	// Rays
+	// =====================================
+	for (i = 0; i < RAY_QUERIES; ++i)
+	{
+		rays->origins[i][0] = random_float(0.0f, FIELD_SIZE);
+		rays->origins[i][1] = random_float(0.0f, FIELD_SIZE * 0.1f);
+		rays->origins[i][2] = random_float(0.0f, FIELD_SIZE);
+		random_direction(rays->directions[i]);
+	}
+
+	mismatches = 0;
+	found = 0;
+	start = SDL_GetPerformanceCounter();
+	for (i = 0; i < RAY_QUERIES; ++i)
+		found += raycast_bvh(&bvh, rays->origins[i], rays->directions[i], FIELD_SIZE, NULL, NULL, &object, &distance);
+	seconds = seconds_since(start);
+	for (i = 0; i < CHECKED_QUERIES; ++i)
+	{
+		if (!raycast_bvh(&bvh, rays->origins[i], rays->directions[i], FIELD_SIZE, NULL, NULL, &object, &distance))
+			object = ~0u;
+		if (object != brute_ray(&scene, rays->origins[i], rays->directions[i]))
+			++mismatches;
+	}
+	printf("rays (boxes):    %8.0f queries/s, %.1f%% hit, %u mismatches\n",
+		   RAY_QUERIES / seconds, found * 100.0 / RAY_QUERIES, mismatches);
+
+	found = 0;
+	start = SDL_GetPerformanceCounter();
+	for (i = 0; i < RAY_QUERIES; ++i)
+		found += raycast_bvh(&bvh, rays->origins[i], rays->directions[i], FIELD_SIZE, ray_cube, &scene, &object, &distance);
+	seconds = seconds_since(start);
+	printf("rays (meshes):   %8.0f queries/s, %.1f%% hit\n", RAY_QUERIES / seconds, found * 100.0 / RAY_QUERIES);
+
+	rays->bvh = &bvh;
+	start = SDL_GetPerformanceCounter();
+	jobs_parallel_for(rays_job, rays, RAY_QUERIES, RAYS_PER_JOB);
+	seconds = seconds_since(start);
+	printf("rays (threads):  %8.0f queries/s\n", RAY_QUERIES / seconds);
+
+	// =====================================
+	// Overlap
+	// =====================================
+	mismatches = 0;
+	found = 0;
+	seconds = 0.0;
+	for (run = 0; run < OVERLAP_QUERIES; ++run)
+	{
+		glm_vec4_copy((vec4){ random_float(0.0f, FIELD_SIZE), random_float(0.0f, FIELD_SIZE * 0.1f), random_float(0.0f, FIELD_SIZE), 5.0f }, sphere);
+		start = SDL_GetPerformanceCounter();
+		i = query_bvh_sphere(&bvh, sphere, results);
+		seconds += seconds_since(start);
+		found += i;
+		if (run < CHECKED_QUERIES && i != brute_sphere(&scene, sphere))
+			++mismatches;
+	}
+	printf("spheres:         %8.0f queries/s, %.1f objects each, %u mismatches\n",
+		   OVERLAP_QUERIES / seconds, (double)found / OVERLAP_QUERIES, mismatches);
+
+	mismatches = 0;
+	found = 0;
+	seconds = 0.0;
+	for (run = 0; run < OVERLAP_QUERIES; ++run)
+	{
+		glm_vec3_copy((vec3){ random_float(0.0f, FIELD_SIZE), random_float(0.0f, FIELD_SIZE * 0.1f), random_float(0.0f, FIELD_SIZE) }, box[0]);
+		glm_vec3_adds(box[0], 8.0f, box[1]);
+		start = SDL_GetPerformanceCounter();
+		i = query_bvh_box(&bvh, box, results);
+		seconds += seconds_since(start);
+		found += i;
+		if (run < CHECKED_QUERIES && i != brute_box(&scene, box))
+			++mismatches;
+	}
+	printf("boxes:           %8.0f queries/s, %.1f objects each, %u mismatches\n",
+		   OVERLAP_QUERIES / seconds, (double)found / OVERLAP_QUERIES, mismatches);
+
+	jobs_shutdown();
+	destroy_bvh(&bvh);
+	free(rays->directions);
+	free(rays->origins);
+	free(rays);
+	free(results);
+	free(scene.boxes);
+	free(scene.angles);
+	free(scene.cubes);
+	return 0;
+}
@@ -0,0 +1,370 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Impostor baker: renders a textured crate from the directions of an
+// octahedral grid into an atlas of frames drawn by the impostor shaders.
+//
+// Usage: impostorbake [-f <frames>] [-s <frame size>] [-n <normals.tga>]
+//                     <diffuse image> <albedo.tga>
+// Frame (x, y) of the frames x frames grid is the crate seen from the
+// direction with octahedral coordinates (x, y) / (frames - 1) * 2 - 1,
+// orthographic and framed by its bounding sphere. Albedo keeps coverage in
+// alpha; -n also writes object space normals so impostors are lit like the
+// meshes. Outputs are TGA images for texcook.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../stb_image.h"
+
+#define SUPERSAMPLE 2
+#define RADIUS 0.8660254f
+
+// Normal, tangent and bitangent of every face of the unit crate
+static const float face_axes[6][3][3] =
+{
+	{ {  0.0f,  0.0f,  1.0f }, {  1.0f,  0.0f,  0.0f }, { 0.0f, 1.0f,  0.0f } },
+	{ {  0.0f,  0.0f, -1.0f }, { -1.0f,  0.0f,  0.0f }, { 0.0f, 1.0f,  0.0f } },
+	{ {  0.0f,  1.0f,  0.0f }, {  1.0f,  0.0f,  0.0f }, { 0.0f, 0.0f, -1.0f } },
+	{ {  0.0f, -1.0f,  0.0f }, {  1.0f,  0.0f,  0.0f }, { 0.0f, 0.0f,  1.0f } },
+	{ { -1.0f,  0.0f,  0.0f }, {  0.0f,  0.0f,  1.0f }, { 0.0f, 1.0f,  0.0f } },
+	{ {  1.0f,  0.0f,  0.0f }, {  0.0f,  0.0f, -1.0f }, { 0.0f, 1.0f,  0.0f } }
+};
+
+struct image
+{
+	const unsigned char* pixels;
+	int width;
+	int height;
+	int channels;
+};
+
+static float dot(const float* a, const float* b)
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static void cross(const float* a, const float* b, float* out)
+{
+	out[0] = a[1] * b[2] - a[2] * b[1];
+	out[1] = a[2] * b[0] - a[0] * b[2];
+	out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static void normalize(float* v)
+{
+	const float length = sqrtf(dot(v, v));
+	v[0] /= length;
+	v[1] /= length;
+	v[2] /= length;
+}
+
+static float sign(float x)
+{
+	return x < 0.0f ? -1.0f : 1.0f;
+}
+
+// Same decoding and frame basis as data/shaders/14_impostor.vs.glsl
+static void frame_basis(unsigned x, unsigned y, unsigned frames, float* direction, float* right, float* up)
+{
+	const float px = (float)x / (float)(frames - 1) * 2.0f - 1.0f;
+	const float py = (float)y / (float)(frames - 1) * 2.0f - 1.0f;
+	const float axis_y[3] = { 0.0f, 1.0f, 0.0f };
+	const float axis_z[3] = { 0.0f, 0.0f, 1.0f };
+
+	direction[0] = px;
+	direction[1] = 1.0f - fabsf(px) - fabsf(py);
+	direction[2] = py;
+	if (direction[1] < 0.0f)
+	{
+		direction[0] = (1.0f - fabsf(py)) * sign(px);
+		direction[2] = (1.0f - fabsf(px)) * sign(py);
+	}
+	normalize(direction);
+	cross(fabsf(direction[1]) > 0.999f ? axis_z : axis_y, direction, right);
+	normalize(right);
+	cross(direction, right, up);
+}
+
+static void sample_image(const struct image* image, float u, float v, float* color)
+{
+	int x = (int)(u * (float)image->width);
+	int y = (int)(v * (float)image->height);
+	int i;
+
+	x = x < 0 ? 0 : x >= image->width ? image->width - 1 : x;
+	y = y < 0 ? 0 : y >= image->height ? image->height - 1 : y;
+	for (i = 0; i < 3; ++i)
+		color[i] = (float)image->pixels[(y * image->width + x) * image->channels + (image->channels < 3 ? 0 : i)];
+}
+
+// Rasterises one face of the crate into the supersampled frame, keeping
+// the samples nearest to the viewer. Faces are quads, split in two
+// triangles; the crate is convex, so no face needs clipping.
+static void draw_face(const struct image* diffuse, unsigned face, const float* direction, const float* right, const float* up,
+					  unsigned size, float* depth, float* color, float* normal)
+{
+	static const float corners[4][2] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+	static const unsigned triangles[2][3] = { { 0, 1, 2 }, { 2, 3, 0 } };
+	const float* axes = face_axes[face][0];
+	float screen[4][3], position[3], e0, e1, e2, area, z, u, v;
+	unsigned corner, triangle, i;
+	int x, y, min_x, max_x, min_y, max_y;
+
+	if (dot(axes, direction) <= 0.0f)
+		return;
+
+	for (corner = 0; corner < 4; ++corner)
+	{
+		for (i = 0; i < 3; ++i)
+			position[i] = face_axes[face][0][i] * 0.5f +
+						  face_axes[face][1][i] * (corners[corner][0] - 0.5f) +
+						  face_axes[face][2][i] * (corners[corner][1] - 0.5f);
+		screen[corner][0] = (dot(position, right) / RADIUS * 0.5f + 0.5f) * (float)size;
+		screen[corner][1] = (dot(position, up) / RADIUS * 0.5f + 0.5f) * (float)size;
+		screen[corner][2] = dot(position, direction);
+	}
+
+	for (triangle = 0; triangle < 2; ++triangle)
+	{
+		const float* a = screen[triangles[triangle][0]];
+		const float* b = screen[triangles[triangle][1]];
+		const float* c = screen[triangles[triangle][2]];
+		const float* ta = corners[triangles[triangle][0]];
+		const float* tb = corners[triangles[triangle][1]];
+		const float* tc = corners[triangles[triangle][2]];
+
+		area = (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+		if (fabsf(area) < 1e-6f)
+			continue;
+		min_x = (int)floorf(fminf(a[0], fminf(b[0], c[0])));
+		max_x = (int)ceilf(fmaxf(a[0], fmaxf(b[0], c[0])));
+		min_y = (int)floorf(fminf(a[1], fminf(b[1], c[1])));
+		max_y = (int)ceilf(fmaxf(a[1], fmaxf(b[1], c[1])));
+		min_x = min_x < 0 ? 0 : min_x;
+		min_y = min_y < 0 ? 0 : min_y;
+		max_x = max_x > (int)size ? (int)size : max_x;
+		max_y = max_y > (int)size ? (int)size : max_y;
+
+		for (y = min_y; y < max_y; ++y)
+			for (x = min_x; x < max_x; ++x)
+			{
+				const float sx = (float)x + 0.5f;
+				const float sy = (float)y + 0.5f;
+				const unsigned sample = (unsigned)y * size + (unsigned)x;
+				e0 = ((c[0] - b[0]) * (sy - b[1]) - (c[1] - b[1]) * (sx - b[0])) / area;
+				e1 = ((a[0] - c[0]) * (sy - c[1]) - (a[1] - c[1]) * (sx - c[0])) / area;
+				e2 = 1.0f - e0 - e1;
+				if (e0 < 0.0f || e1 < 0.0f || e2 < 0.0f)
+					continue;
+				z = e0 * a[2] + e1 * b[2] + e2 * c[2];
+				if (z <= depth[sample])
+					continue;
+				depth[sample] = z;
+				u = e0 * ta[0] + e1 * tb[0] + e2 * tc[0];
+				v = e0 * ta[1] + e1 * tb[1] + e2 * tc[1];
+				sample_image(diffuse, u, v, color + sample * 3);
+				for (i = 0; i < 3; ++i)
+					normal[sample * 3 + i] = face_axes[face][0][i];
+			}
+	}
+}
+
+// Averages the covered samples of every texel and puts the coverage in
+// alpha. Empty texels take the average colour of the frame and the view
+// direction as normal, so mipmaps do not bleed black into the silhouette.
+static void resolve_frame(unsigned char* albedo, unsigned char* normals, unsigned atlas_width, unsigned frame_x, unsigned frame_y, unsigned size,
+						  const float* depth, const float* color, const float* normal, const float* direction)
+{
+	const unsigned samples = size * SUPERSAMPLE;
+	float average[3] = { 0.0f, 0.0f, 0.0f }, texel_color[3], texel_normal[3];
+	unsigned x, y, sx, sy, i, covered, total = 0;
+	unsigned char* albedo_texel;
+	unsigned char* normal_texel;
+
+	for (i = 0; i < samples * samples; ++i)
+		if (depth[i] > -RADIUS * 2.0f)
+		{
+			average[0] += color[i * 3];
+			average[1] += color[i * 3 + 1];
+			average[2] += color[i * 3 + 2];
+			++total;
+		}
+	for (i = 0; i < 3; ++i)
+		average[i] = total ? average[i] / (float)total : 0.0f;
+
+	for (y = 0; y < size; ++y)
+		for (x = 0; x < size; ++x)
+		{
+			memset(texel_color, 0, sizeof(texel_color));
+			memset(texel_normal, 0, sizeof(texel_normal));
+			covered = 0;
+			for (sy = 0; sy < SUPERSAMPLE; ++sy)
+				for (sx = 0; sx < SUPERSAMPLE; ++sx)
+				{
+					const unsigned sample = (y * SUPERSAMPLE + sy) * samples + x * SUPERSAMPLE + sx;
+					if (depth[sample] <= -RADIUS * 2.0f)
+						continue;
+					for (i = 0; i < 3; ++i)
+					{
+						texel_color[i] += color[sample * 3 + i];
+						texel_normal[i] += normal[sample * 3 + i];
+					}
+					++covered;
+				}
+			if (covered)
+			{
+				for (i = 0; i < 3; ++i)
+					texel_color[i] /= (float)covered;
+				normalize(texel_normal);
+			}
+			else
+			{
+				memcpy(texel_color, average, sizeof(texel_color));
+				memcpy(texel_normal, direction, sizeof(texel_normal));
+			}
+
+			i = ((frame_y * size + y) * atlas_width + frame_x * size + x) * 4;
+			albedo_texel = albedo + i;
+			normal_texel = normals + i;
+			albedo_texel[0] = (unsigned char)(texel_color[0] + 0.5f);
+			albedo_texel[1] = (unsigned char)(texel_color[1] + 0.5f);
+			albedo_texel[2] = (unsigned char)(texel_color[2] + 0.5f);
+			albedo_texel[3] = (unsigned char)(covered * 255 / (SUPERSAMPLE * SUPERSAMPLE));
+			normal_texel[0] = (unsigned char)((texel_normal[0] * 0.5f + 0.5f) * 255.0f + 0.5f);
+			normal_texel[1] = (unsigned char)((texel_normal[1] * 0.5f + 0.5f) * 255.0f + 0.5f);
+			normal_texel[2] = (unsigned char)((texel_normal[2] * 0.5f + 0.5f) * 255.0f + 0.5f);
+			normal_texel[3] = albedo_texel[3];
+		}
+}
+
+// Uncompressed 32 bit TGA with the first row at the bottom, which is the
+// row order texcook uploads (it flips images on load)
+static int write_tga(const char* filename, const unsigned char* pixels, unsigned width, unsigned height)
+{
+	unsigned char header[18];
+	unsigned char* bgra;
+	unsigned i;
+	int success;
+
+	memset(header, 0, sizeof(header));
+	header[2] = 2;
+	header[12] = (unsigned char)(width & 0xff);
+	header[13] = (unsigned char)(width >> 8);
+	header[14] = (unsigned char)(height & 0xff);
+	header[15] = (unsigned char)(height >> 8);
+	header[16] = 32;
+	header[17] = 8;
+
+	bgra = (unsigned char*)malloc(width * height * 4);
+	for (i = 0; i < width * height; ++i)
+	{
+		bgra[i * 4] = pixels[i * 4 + 2];
+		bgra[i * 4 + 1] = pixels[i * 4 + 1];
+		bgra[i * 4 + 2] = pixels[i * 4];
+		bgra[i * 4 + 3] = pixels[i * 4 + 3];
+	}
+
+	FILE* file = fopen(filename, "wb");
+	success = file && fwrite(header, sizeof(header), 1, file) == 1 && fwrite(bgra, 4, width * height, file) == width * height;
+	if (file)
+		fclose(file);
+	free(bgra);
+	if (!success)
+		fprintf(stderr, "impostorbake: failed to write file %s.\n", filename);
+	return success;
+}
+
+int main(int argc, char** argv)
+{
+	struct image diffuse;
+	unsigned frames = 16, size = 64, samples, atlas_width, x, y, face, i;
+	unsigned char *pixels, *albedo, *normals;
+	float *depth, *color, *normal;
+	float direction[3], right[3], up[3];
+	const char* normals_file = NULL;
+	int arg = 1, success;
+
+	while (arg + 1 < argc && argv[arg][0] == '-')
+	{
+		if (!strcmp(argv[arg], "-f"))
+			frames = (unsigned)atoi(argv[arg + 1]);
+		else if (!strcmp(argv[arg], "-s"))
+			size = (unsigned)atoi(argv[arg + 1]);
+		else if (!strcmp(argv[arg], "-n"))
+			normals_file = argv[arg + 1];
+		else
+			break;
+		arg += 2;
+	}
+	if (argc - arg != 2 || frames < 2 || !size)
+	{
+		fprintf(stderr, "Usage: impostorbake [-f <frames>] [-s <frame size>] [-n <normals.tga>] <diffuse image> <albedo.tga>\n");
+		return 1;
+	}
+
+	stbi_set_flip_vertically_on_load(1);
+	pixels = stbi_load(argv[arg], &diffuse.width, &diffuse.height, &diffuse.channels, 0);
+	if (!pixels)
+	{
+		fprintf(stderr, "impostorbake: failed to load image %s: %s.\n", argv[arg], stbi_failure_reason());
+		return 1;
+	}
+	diffuse.pixels = pixels;
+
+	samples = size * SUPERSAMPLE;
+	atlas_width = frames * size;
+	albedo = (unsigned char*)malloc(atlas_width * atlas_width * 4);
+	normals = (unsigned char*)malloc(atlas_width * atlas_width * 4);
+	depth = (float*)malloc(samples * samples * sizeof(float));
+	color = (float*)malloc(samples * samples * 3 * sizeof(float));
+	normal = (float*)malloc(samples * samples * 3 * sizeof(float));
+
+	for (y = 0; y < frames; ++y)
+		for (x = 0; x < frames; ++x)
+		{
+			frame_basis(x, y, frames, direction, right, up);
+			for (i = 0; i < samples * samples; ++i)
+				depth[i] = -RADIUS * 2.0f;
+			for (face = 0; face < 6; ++face)
+				draw_face(&diffuse, face, direction, right, up, samples, depth, color, normal);
+			resolve_frame(albedo, normals, atlas_width, x, y, size, depth, color, normal, direction);
+		}
+
+	success = write_tga(argv[arg + 1], albedo, atlas_width, atlas_width);
+	if (success && normals_file)
+		success = write_tga(normals_file, normals, atlas_width, atlas_width);
+	if (success)
+		printf("%s: %u x %u frames of %ux%u\n", argv[arg], frames, frames, size, size);
+
+	free(normal);
+	free(color);
+	free(depth);
+	free(normals);
+	free(albedo);
+	stbi_image_free(pixels);
+	return success ? 0 : 1;
+}
@@ -0,0 +1,377 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Instance format benchmark: draws a field of instanced cubes with model
+// matrices, packed quaternion transforms and their half float variant, and
+// reports what an instance costs in bytes and what a frame that packs,
+// uploads and draws all of them costs in time.
+//
+// Usage: instancebench [instances] [frames]
+// One million instances and 100 frames by default.
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+#include "../cglm/affine.h"
+#include "../cglm/cam.h"
+#include "../cglm/quat.h"
+#include "../packed_instance.h"
+
+#define WARMUP_FRAMES 3
+#define FIELD_SPACING 2.0f
+
+struct format
+{
+	const char* name;
+	const char* vertex_source;
+	unsigned size;
+	void (*pack)(void* packed, const struct packed_instance* instances, unsigned count);
+	void (*attributes)(void);
+	unsigned attributes_count;
+};
+
+static const char VERTEX_MATRIX[] =
+	"#version 330 core\n"
+	"layout (location = 0) in vec3 aPos;\n"
+	"layout (location = 1) in vec3 aNormal;\n"
+	"layout (location = 2) in mat4 aModel;\n"
+	"uniform mat4 cViewProj;\n"
+	"out vec3 vNormal;\n"
+	"void main()\n"
+	"{\n"
+	"	vNormal = mat3(aModel) * aNormal;\n"
+	"	gl_Position = cViewProj * aModel * vec4(aPos, 1.0);\n"
+	"}\n";
+
+static const char VERTEX_PACKED[] =
+	"#version 330 core\n"
+	"layout (location = 0) in vec3 aPos;\n"
+	"layout (location = 1) in vec3 aNormal;\n"
+	"layout (location = 2) in vec4 aRotation;\n"
+	"layout (location = 3) in vec3 aPosition;\n"
+	"layout (location = 4) in float aScale;\n"
+	"uniform mat4 cViewProj;\n"
+	"out vec3 vNormal;\n"
+	"vec3 rotate(vec4 q, vec3 v)\n"
+	"{\n"
+	"	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);\n"
+	"}\n"
+	"void main()\n"
+	"{\n"
+	"	vNormal = rotate(aRotation, aNormal);\n"
+	"	gl_Position = cViewProj * vec4(aPosition + rotate(aRotation, aPos * aScale), 1.0);\n"
+	"}\n";
+
+static const char FRAGMENT[] =
+	"#version 330 core\n"
+	"in vec3 vNormal;\n"
+	"out vec4 fColor;\n"
+	"void main()\n"
+	"{\n"
+	"	fColor = vec4(vec3(max(dot(normalize(vNormal), vec3(0.267, 0.802, 0.535)), 0.1)), 1.0);\n"
+	"}\n";
+
+static void pack_matrices(void* packed, const struct packed_instance* instances, unsigned count)
+{
+	mat4* models = (mat4*)packed;
+	unsigned i;
+	for (i = 0; i < count; ++i)
+		packed_instance_matrix(&instances[i], models[i]);
+}
+
+static void pack_floats(void* packed, const struct packed_instance* instances, unsigned count)
+{
+	memcpy(packed, instances, count * sizeof(struct packed_instance));
+}
+
+static void pack_halves(void* packed, const struct packed_instance* instances, unsigned count)
+{
+	pack_instances_half((struct packed_instance_half*)packed, instances, count);
+}
+
+static void matrix_attributes(void)
+{
+	unsigned i;
+	for (i = 0; i < 4; ++i)
+		glVertexAttribPointer(2 + i, 4, GL_FLOAT, GL_FALSE, sizeof(mat4), (void*)(i * sizeof(vec4)));
+}
+
+static void float_attributes(void)
+{
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(struct packed_instance), (void*)offsetof(struct packed_instance, rotation));
+	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(struct packed_instance), (void*)offsetof(struct packed_instance, position));
+	glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(struct packed_instance), (void*)offsetof(struct packed_instance, scale));
+}
+
+static void half_attributes(void)
+{
+	glVertexAttribPointer(2, 4, GL_HALF_FLOAT, GL_FALSE, sizeof(struct packed_instance_half), (void*)offsetof(struct packed_instance_half, rotation));
+	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(struct packed_instance_half), (void*)offsetof(struct packed_instance_half, position));
+	glVertexAttribPointer(4, 1, GL_HALF_FLOAT, GL_FALSE, sizeof(struct packed_instance_half), (void*)offsetof(struct packed_instance_half, scale));
+}
+
+static const struct format FORMATS[] =
+{
+	{ "mat4", VERTEX_MATRIX, sizeof(mat4), pack_matrices, matrix_attributes, 4 },
+	{ "packed", VERTEX_PACKED, sizeof(struct packed_instance), pack_floats, float_attributes, 3 },
+	{ "half", VERTEX_PACKED, sizeof(struct packed_instance_half), pack_halves, half_attributes, 3 }
+};
+
+static unsigned compile_shader(GLenum type, const char* source)
+{
+	char log[1024];
+	int status;
+	unsigned shader = glCreateShader(type);
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (!status)
+	{
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		fprintf(stderr, "instancebench: %s\n", log);
+		glDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+static unsigned create_benchmark_program(const char* vertex_source)
+{
+	char log[1024];
+	int status;
+	unsigned program, vertex, fragment;
+
+	vertex = compile_shader(GL_VERTEX_SHADER, vertex_source);
+	fragment = compile_shader(GL_FRAGMENT_SHADER, FRAGMENT);
+	if (!vertex || !fragment)
+	{
+		glDeleteShader(vertex);
+		glDeleteShader(fragment);
+		return 0;
+	}
+	program = glCreateProgram();
+	glAttachShader(program, vertex);
+	glAttachShader(program, fragment);
+	glLinkProgram(program);
+	glDeleteShader(vertex);
+	glDeleteShader(fragment);
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (!status)
+	{
+		glGetProgramInfoLog(program, sizeof(log), NULL, log);
+		fprintf(stderr, "instancebench: %s\n", log);
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+// Four vertices with a shared normal per face, triangles are not culled
+static void build_cube(float vertices[24][6], unsigned indices[36])
+{
+	unsigned face, corner, axis, u, v;
+	float sign;
+	for (face = 0; face < 6; ++face)
+	{
+		axis = face >> 1;
+		sign = face & 1 ? 0.5f : -0.5f;
+		u = (axis + 1) % 3;
+		v = (axis + 2) % 3;
+		for (corner = 0; corner < 4; ++corner)
+		{
+			float* vertex = vertices[face * 4 + corner];
+			memset(vertex, 0, 6 * sizeof(float));
+			vertex[axis] = sign;
+			vertex[u] = corner & 1 ? 0.5f : -0.5f;
+			vertex[v] = corner & 2 ? 0.5f : -0.5f;
+			vertex[3 + axis] = sign * 2.0f;
+		}
+		indices[face * 6 + 0] = face * 4 + 0;
+		indices[face * 6 + 1] = face * 4 + 1;
+		indices[face * 6 + 2] = face * 4 + 3;
+		indices[face * 6 + 3] = face * 4 + 3;
+		indices[face * 6 + 4] = face * 4 + 2;
+		indices[face * 6 + 5] = face * 4 + 0;
+	}
+}
+
+static double seconds_since(Uint64 start)
+{
+	return (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+int main(int argc, char** argv)
+{
+	struct packed_instance* instances;
+	void* packed;
+	float vertices[24][6];
+	unsigned indices[36];
+	unsigned vbo, ebo, instance_buffer, vao, program;
+	unsigned i, count, frames, frame, format, side;
+	int viewproj_location;
+	mat4 proj, view, viewproj;
+	versor spin;
+	double pack_seconds, frame_seconds;
+	Uint64 start, pack_start;
+
+	count = argc > 1 ? (unsigned)atoi(argv[1]) : 1000000;
+	frames = argc > 2 ? (unsigned)atoi(argv[2]) : 100;
+	if (!count || !frames)
+	{
+		fprintf(stderr, "Usage: instancebench [instances] [frames]\n");
+		return 1;
+	}
+
+	if (SDL_Init(SDL_INIT_VIDEO) < 0)
+	{
+		fprintf(stderr, "instancebench: %s\n", SDL_GetError());
+		return 1;
+	}
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_Window* window = SDL_CreateWindow("instancebench", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+										  512, 512, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+	SDL_GLContext context = window ? SDL_GL_CreateContext(window) : NULL;
+	glewExperimental = GL_TRUE;
+	if (!context || glewInit() != GLEW_OK)
+	{
+		fprintf(stderr, "instancebench: %s\n", SDL_GetError());
+		if (context)
+			SDL_GL_DeleteContext(context);
+		if (window)
+			SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+	SDL_GL_SetSwapInterval(0);
+
+	instances = (struct packed_instance*)malloc(count * sizeof(struct packed_instance));
+	packed = malloc(count * sizeof(mat4));
+	if (!instances || !packed)
+	{
+		fprintf(stderr, "instancebench: out of memory.\n");
+		return 1;
+	}
+
+	// Square field of cubes seen from above, every instance on screen
+	for (side = 1; side * side < count; ++side)
+		;
+	for (i = 0; i < count; ++i)
+	{
+		glm_quatv(instances[i].rotation, (float)i * 0.001f, (vec3){ 0.267f, 0.535f, 0.802f });
+		instances[i].position[0] = ((float)(i % side) - side * 0.5f) * FIELD_SPACING;
+		instances[i].position[1] = 0.0f;
+		instances[i].position[2] = ((float)(i / side) - side * 0.5f) * FIELD_SPACING;
+		instances[i].scale = 1.0f + (float)(i % 7) * 0.1f;
+	}
+	glm_perspective(glm_rad(60.0f), 1.0f, 1.0f, side * FIELD_SPACING * 2.0f, proj);
+	glm_lookat((vec3){ 0.0f, side * FIELD_SPACING, side * FIELD_SPACING * 0.25f }, GLM_VEC3_ZERO, GLM_YUP, view);
+	glm_mat4_mul(proj, view, viewproj);
+	glm_quatv(spin, 0.01f, GLM_YUP);
+
+	build_cube(vertices, indices);
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	glGenBuffers(1, &ebo);
+	glGenBuffers(1, &instance_buffer);
+	glEnable(GL_DEPTH_TEST);
+	glViewport(0, 0, 512, 512);
+
+	printf("%u instances, %u frames\n", count, frames);
+	for (format = 0; format < sizeof(FORMATS) / sizeof(FORMATS[0]); ++format)
+	{
+		program = create_benchmark_program(FORMATS[format].vertex_source);
+		if (!program)
+			break;
+		viewproj_location = glGetUniformLocation(program, "cViewProj");
+
+		glGenVertexArrays(1, &vao);
+		glBindVertexArray(vao);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+		glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+		glBufferData(GL_ARRAY_BUFFER, count * FORMATS[format].size, NULL, GL_STREAM_DRAW);
+		FORMATS[format].attributes();
+		for (i = 2; i < 2 + FORMATS[format].attributes_count; ++i)
+		{
+			glEnableVertexAttribArray(i);
+			glVertexAttribDivisor(i, 1);
+		}
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+		glUseProgram(program);
+		glUniformMatrix4fv(viewproj_location, 1, GL_FALSE, viewproj[0]);
+
+		// Every frame turns the instances, packs them, orphans and refills
+		// the buffer and waits for the draw to finish
+		pack_seconds = 0.0;
+		frame_seconds = 0.0;
+		for (frame = 0; frame < WARMUP_FRAMES + frames; ++frame)
+		{
+			start = SDL_GetPerformanceCounter();
+			for (i = 0; i < count; ++i)
+				glm_quat_mul(spin, instances[i].rotation, instances[i].rotation);
+			pack_start = SDL_GetPerformanceCounter();
+			FORMATS[format].pack(packed, instances, count);
+			if (frame >= WARMUP_FRAMES)
+				pack_seconds += seconds_since(pack_start);
+
+			glBufferData(GL_ARRAY_BUFFER, count * FORMATS[format].size, NULL, GL_STREAM_DRAW);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, count * FORMATS[format].size, packed);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0, count);
+			glFinish();
+			if (frame >= WARMUP_FRAMES)
+				frame_seconds += seconds_since(start);
+		}
+
+		printf("%-8s %3u bytes/instance, %8.2f MB/frame, pack %8.2f ms, frame %8.2f ms\n",
+			   FORMATS[format].name, FORMATS[format].size, count * FORMATS[format].size / 1048576.0,
+			   pack_seconds * 1000.0 / frames, frame_seconds * 1000.0 / frames);
+
+		glUseProgram(0);
+		glBindVertexArray(0);
+		glDeleteVertexArrays(1, &vao);
+		glDeleteProgram(program);
+	}
+
+	glDeleteBuffers(1, &instance_buffer);
+	glDeleteBuffers(1, &ebo);
+	glDeleteBuffers(1, &vbo);
+	free(packed);
+	free(instances);
+	SDL_GL_DeleteContext(context);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+	return 0;
+}
@@ -0,0 +1,281 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Batched mat4 benchmark: times every matrix kernel of simd.h over AoS
+// and SoA arrays with each instruction set the CPU supports, and checks
+// the results against the scalar cglm routines.
+//
+// Usage: mat4bench [matrices]
+// 262144 matrices by default.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL_timer.h>
+#include "../cglm/affine.h"
+#include "../cglm/mat4.h"
+#include "../simd.h"
+
+#define RUNS 10
+// Relative error allowed against the scalar routines
+#define TOLERANCE 1e-4f
+
+struct data
+{
+	mat4* affine; // Rotation, scale and translation
+	mat4* general; // Diagonally dominant, so safe to invert
+	vec4* vectors;
+	mat4* dest;
+	vec4* dest_vectors;
+	float* soa_affine;
+	float* soa_general;
+	float* soa_vectors;
+	float* soa_dest;
+	unsigned count;
+};
+
+struct kernel
+{
+	const char* name;
+	void (*run)(struct data* data);
+	float* reference; // Scalar result, AoS order
+	unsigned elements; // 16 for matrices, 4 for vectors
+	int soa;
+};
+
+static unsigned seed = 1;
+
+static float random_float(float min, float max)
+{
+	seed = seed * 1664525u + 1013904223u;
+	return min + (max - min) * (float)(seed >> 8) / 16777216.0f;
+}
+
+static double seconds_since(Uint64 start)
+{
+	return (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+static void to_soa(float* aos, float* soa, unsigned elements, unsigned count)
+{
+	unsigned i, e;
+	for (i = 0; i < count; ++i)
+		for (e = 0; e < elements; ++e)
+			soa[e * count + i] = aos[i * elements + e];
+}
+
+static void from_soa(float* soa, float* aos, unsigned elements, unsigned count)
+{
+	unsigned i, e;
+	for (i = 0; i < count; ++i)
+		for (e = 0; e < elements; ++e)
+			aos[i * elements + e] = soa[e * count + i];
+}
+
+static void run_mul(struct data* d)
+{
+	simd_mat4_mul(d->affine, d->general, d->dest, d->count);
+}
+
+static void run_inv(struct data* d)
+{
+	simd_mat4_inv(d->general, d->dest, d->count);
+}
+
+static void run_inv_affine(struct data* d)
+{
+	simd_mat4_inv_affine(d->affine, d->dest, d->count);
+}
+
+static void run_transpose(struct data* d)
+{
+	simd_mat4_transpose(d->general, d->dest, d->count);
+}
+
+static void run_mulv(struct data* d)
+{
+	simd_mat4_mulv(d->affine[0], d->vectors, d->dest_vectors, d->count);
+}
+
+static void run_mul_soa(struct data* d)
+{
+	simd_mat4_mul_soa(d->soa_affine, d->soa_general, d->soa_dest, d->count, d->count);
+}
+
+static void run_inv_soa(struct data* d)
+{
+	simd_mat4_inv_soa(d->soa_general, d->soa_dest, d->count, d->count);
+}
+
+static void run_inv_affine_soa(struct data* d)
+{
+	simd_mat4_inv_affine_soa(d->soa_affine, d->soa_dest, d->count, d->count);
+}
+
+static void run_transpose_soa(struct data* d)
+{
+	simd_mat4_transpose_soa(d->soa_general, d->soa_dest, d->count, d->count);
+}
+
+static void run_mulv_soa(struct data* d)
+{
+	simd_mat4_mulv_soa(d->soa_affine, d->soa_vectors, d->soa_dest, d->count, d->count);
+}
+
+static float max_error(float* result, float* reference, unsigned floats)
+{
+	float error, worst = 0.0f;
+	unsigned i;
+	for (i = 0; i < floats; ++i)
+	{
+		error = fabsf(result[i] - reference[i]) / (1.0f + fabsf(reference[i]));
+		if (!(error <= worst)) // Catches NaN too
+			worst = error;
+	}
+	return worst;
+}
+
+int main(int argc, char** argv)
+{
+	struct data data;
+	struct kernel kernels[10];
+	float* result;
+	mat4* reference;
+	vec4* reference_vectors;
+	vec3 axis;
+	double seconds, best;
+	Uint64 start;
+	unsigned i, k, run, kernel_count, failures = 0;
+	int isa;
+	float error;
+
+	data.count = argc > 1 ? (unsigned)atoi(argv[1]) : 262144;
+	if (!data.count)
+	{
+		fprintf(stderr, "Usage: mat4bench [matrices]\n");
+		return 1;
+	}
+
+	data.affine = (mat4*)malloc(data.count * sizeof(mat4));
+	data.general = (mat4*)malloc(data.count * sizeof(mat4));
+	data.vectors = (vec4*)malloc(data.count * sizeof(vec4));
+	data.dest = (mat4*)malloc(data.count * sizeof(mat4));
+	data.dest_vectors = (vec4*)malloc(data.count * sizeof(vec4));
+	data.soa_affine = (float*)malloc(data.count * sizeof(mat4));
+	data.soa_general = (float*)malloc(data.count * sizeof(mat4));
+	data.soa_vectors = (float*)malloc(data.count * sizeof(vec4));
+	data.soa_dest = (float*)malloc(data.count * sizeof(mat4));
+	result = (float*)malloc(data.count * sizeof(mat4));
+	reference = (mat4*)malloc(data.count * sizeof(mat4) * 5);
+	reference_vectors = (vec4*)malloc(data.count * sizeof(vec4) * 2);
+
+	for (i = 0; i < data.count; ++i)
+	{
+		axis[0] = random_float(-1.0f, 1.0f);
+		axis[1] = random_float(-1.0f, 1.0f);
+		axis[2] = random_float(0.1f, 1.0f);
+		glm_vec3_normalize(axis);
+		glm_translate_make(data.affine[i], (vec3){ random_float(-100.0f, 100.0f), random_float(-100.0f, 100.0f), random_float(-100.0f, 100.0f) });
+		glm_rotate(data.affine[i], random_float(0.0f, GLM_PIf * 2.0f), axis);
+		glm_scale(data.affine[i], (vec3){ random_float(0.5f, 2.0f), random_float(0.5f, 2.0f), random_float(0.5f, 2.0f) });
+		for (k = 0; k < 16; ++k)
+			data.general[i][k / 4][k % 4] = random_float(-1.0f, 1.0f) + (k % 5 ? 0.0f : 4.0f);
+		for (k = 0; k < 4; ++k)
+			data.vectors[i][k] = random_float(-10.0f, 10.0f);
+	}
+	to_soa(data.affine[0][0], data.soa_affine, 16, data.count);
+	to_soa(data.general[0][0], data.soa_general, 16, data.count);
+	to_soa(data.vectors[0], data.soa_vectors, 4, data.count);
+
+	// Plain cglm, one matrix at a time
+	for (i = 0; i < data.count; ++i)
+	{
+		glm_mat4_mul(data.affine[i], data.general[i], reference[i]);
+		glm_mat4_inv(data.general[i], reference[data.count + i]);
+		glm_mat4_inv(data.affine[i], reference[data.count * 2 + i]);
+		glm_mat4_transpose_to(data.general[i], reference[data.count * 3 + i]);
+		glm_mat4_mulv(data.affine[0], data.vectors[i], reference_vectors[i]);
+		glm_mat4_mulv(data.affine[i], data.vectors[i], reference_vectors[data.count + i]);
+	}
+
+	kernel_count = 0;
+	kernels[kernel_count++] = (struct kernel){ "mul", run_mul, reference[0][0], 16, 0 };
+	kernels[kernel_count++] = (struct kernel){ "inv", run_inv, reference[data.count][0], 16, 0 };
+	kernels[kernel_count++] = (struct kernel){ "inv_affine", run_inv_affine, reference[data.count * 2][0], 16, 0 };
+	kernels[kernel_count++] = (struct kernel){ "transpose", run_transpose, reference[data.count * 3][0], 16, 0 };
+	kernels[kernel_count++] = (struct kernel){ "mulv", run_mulv, reference_vectors[0], 4, 0 };
+	kernels[kernel_count++] = (struct kernel){ "mul", run_mul_soa, reference[0][0], 16, 1 };
+	kernels[kernel_count++] = (struct kernel){ "inv", run_inv_soa, reference[data.count][0], 16, 1 };
+	kernels[kernel_count++] = (struct kernel){ "inv_affine", run_inv_affine_soa, reference[data.count * 2][0], 16, 1 };
+	kernels[kernel_count++] = (struct kernel){ "transpose", run_transpose_soa, reference[data.count * 3][0], 16, 1 };
+	kernels[kernel_count++] = (struct kernel){ "mulv", run_mulv_soa, reference_vectors[data.count], 4, 1 };
+
+	printf("%u matrices, best of %u runs\n", data.count, RUNS);
+	printf("%-10s %-6s %-12s %12s %12s\n", "isa", "layout", "kernel", "M/s", "max error");
+	for (isa = SIMD_BASELINE; isa < SIMD_ISA_COUNT; ++isa)
+	{
+		if (!simd_select((enum simd_isa)isa))
+			continue;
+		for (k = 0; k < kernel_count; ++k)
+		{
+			best = 0.0;
+			for (run = 0; run < RUNS; ++run)
+			{
+				start = SDL_GetPerformanceCounter();
+				kernels[k].run(&data);
+				seconds = seconds_since(start);
+				if (!run || seconds < best)
+					best = seconds;
+			}
+
+			if (kernels[k].soa)
+				from_soa(data.soa_dest, result, kernels[k].elements, data.count);
+			else if (kernels[k].elements == 16)
+				memcpy(result, data.dest, data.count * sizeof(mat4));
+			else
+				memcpy(result, data.dest_vectors, data.count * sizeof(vec4));
+			error = max_error(result, kernels[k].reference, data.count * kernels[k].elements);
+			if (!(error <= TOLERANCE))
+				++failures;
+
+			printf("%-10s %-6s %-12s %12.1f %12.3g%s\n", simd_isa_name((enum simd_isa)isa), kernels[k].soa ? "soa" : "aos",
+				   kernels[k].name, (double)data.count / best * 1e-6, (double)error, error <= TOLERANCE ? "" : "  MISMATCH");
+		}
+	}
+
+	free(reference_vectors);
+	free(reference);
+	free(result);
+	free(data.soa_dest);
+	free(data.soa_vectors);
+	free(data.soa_general);
+	free(data.soa_affine);
+	free(data.dest_vectors);
+	free(data.dest);
+	free(data.vectors);
+	free(data.general);
+	free(data.affine);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,638 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Math microbenchmarks: times the cglm routines the frame loop runs and
+// their batch versions from simd.h over 1 to 1M elements. Every case gets
+// warmup samples and then a series of timed ones, each covering about a
+// million elements, and reports the minimum, median, mean and deviation
+// per element. Results can be written as JSON and checked against such a
+// file from an earlier run: any case whose median got slower by more than
+// the threshold is a regression and fails the run.
+//
+// Before timing, the batch easing curves of every instruction set the CPU
+// runs are checked against the scalar cglm ones, a mismatch fails the run.
+//
+// Usage: mathbench [-n <samples>] [-f <case filter>] [-j <output.json>] [-b <baseline.json>] [-t <threshold %>]
+// 15 samples and a 10% threshold by default.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define HAS_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAS_RDTSC
+#endif
+
+#include <SDL_timer.h>
+#include "../cglm/affine.h"
+#include "../cglm/bezier.h"
+#include "../cglm/cam.h"
+#include "../cglm/ease.h"
+#include "../cglm/quat.h"
+#include "../simd.h"
+
+#define MAX_ELEMENTS 1048576
+#define SAMPLE_ELEMENTS 1048576
+#define WARMUP_SAMPLES 3
+#define DEFAULT_SAMPLES 15
+#define MAX_SAMPLES 255
+#define DEFAULT_THRESHOLD 10.0
+#define NAME_SIZE 64
+#define LINE_BUFFER_SIZE 256
+// Odd, so that the kernels take their partial register path too
+#define CHECK_ELEMENTS 4099
+#define CHECK_TOLERANCE 1e-5f
+#define BEZIER_C0 0.25f
+#define BEZIER_C1 1.2f
+
+struct data
+{
+	versor* a;
+	versor* b;
+	versor* quat_dest;
+	vec3* v;
+	vec3* vec_dest;
+	vec3* eyes;
+	mat4* m;
+	mat4* mat_dest;
+	vec4* spins;
+	float* t;
+	float* t_dest;
+};
+
+struct bench
+{
+	const char* name;
+	void (*run)(struct data* data, unsigned count);
+};
+
+struct result
+{
+	char name[NAME_SIZE];
+	unsigned size;
+	double min_ns;
+	double median_ns;
+	double mean_ns;
+	double stddev_ns;
+	double median_cycles;
+};
+
+static const unsigned SIZES[] = { 1, 64, 4096, 65536, 1048576 };
+
+// Scalar references of the batch curves, in the order of simd_ease_curve
+static float (*const CURVES[SIMD_EASE_COUNT])(float t) =
+{
+	glm_ease_linear,
+	glm_ease_sine_in,
+	glm_ease_sine_out,
+	glm_ease_sine_inout,
+	glm_ease_quad_in,
+	glm_ease_quad_out,
+	glm_ease_quad_inout,
+	glm_ease_cubic_in,
+	glm_ease_cubic_out,
+	glm_ease_cubic_inout,
+	glm_ease_quart_in,
+	glm_ease_quart_out,
+	glm_ease_quart_inout,
+	glm_ease_quint_in,
+	glm_ease_quint_out,
+	glm_ease_quint_inout,
+	glm_ease_exp_in,
+	glm_ease_exp_out,
+	glm_ease_exp_inout,
+	glm_ease_circ_in,
+	glm_ease_circ_out,
+	glm_ease_circ_inout,
+	glm_ease_back_in,
+	glm_ease_back_out,
+	glm_ease_back_inout,
+	glm_ease_elast_in,
+	glm_ease_elast_out,
+	glm_ease_elast_inout,
+	glm_ease_bounce_in,
+	glm_ease_bounce_out,
+	glm_ease_bounce_inout
+};
+
+static unsigned seed = 1;
+
+static float random_float(float min, float max)
+{
+	seed = seed * 1664525u + 1013904223u;
+	return min + (max - min) * (float)(seed >> 8) / 16777216.0f;
+}
+
+static Uint64 read_cycles(void)
+{
+#ifdef HAS_RDTSC
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+static void run_quat_rotatev(struct data* d, unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; ++i)
+		glm_quat_rotatev(d->a[i], d->v[i], d->vec_dest[i]);
+}
+
+static void run_quat_mul(struct data* d, unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; ++i)
+		glm_quat_mul(d->a[i], d->b[i], d->quat_dest[i]);
+}
+
+// One 16 ms frame of spinning
+static void run_quat_integrate(struct data* d, unsigned count)
+{
+	versor step;
+	unsigned i;
+	for (i = 0; i < count; ++i)
+	{
+		glm_quatv(step, 16.0f * d->spins[i][3], d->spins[i]);
+		glm_quat_mul(step, d->a[i], d->quat_dest[i]);
+	}
+}
+
+static void run_quat_slerp(struct data* d, unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; ++i)
+		glm_quat_slerp(d->a[i], d->b[i], d->t[i], d->quat_dest[i]);
+}
+
+static void run_ease_sine_inout(struct data* d, unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; ++i)
+		d->t_dest[i] = glm_ease_sine_inout(d->t[i]);
+}
+
+static void run_ease_elast_out(struct data* d, unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; ++i)
+		d->t_dest[i] = glm_ease_elast_out(d->t[i]);
+}
+
+static void run_ease_bounce_out(struct data* d, unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; ++i)
+		d->t_dest[i] = glm_ease_bounce_out(d->t[i]);
+}
+
+static void run_bezier(struct data* d, unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; ++i)
+		d->t_dest[i] = glm_bezier(d->t[i], 0.0f, BEZIER_C0, BEZIER_C1, 1.0f);
+}
+
+static void run_look(struct data* d, unsigned count)
+{
+	vec3 up = { 0.0f, 1.0f, 0.0f };
+	unsigned i;
+	for (i = 0; i < count; ++i)
+		glm_look(d->eyes[i], d->v[i], up, d->mat_dest[i]);
+}
+
+static void run_mat4_inv(struct data* d, unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; ++i)
+		glm_mat4_inv(d->m[i], d->mat_dest[i]);
+}
+
+static void run_mat4_mul(struct data* d, unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; ++i)
+		glm_mat4_mul(d->m[0], d->m[i], d->mat_dest[i]);
+}
+
+// Camera update of process_events with yaw, pitch and forward held
+static void run_camera(struct data* d, unsigned count)
+{
+	versor rotate;
+	vec3 move;
+	unsigned i;
+	for (i = 0; i < count; ++i)
+	{
+		glm_quat_copy(d->a[i], d->quat_dest[i]);
+		glm_quat(rotate, 0.002f, 0.0f, 1.0f, 0.0f);
+		glm_quat_mul(d->quat_dest[i], rotate, d->quat_dest[i]);
+		glm_quat(rotate, 0.001f, 1.0f, 0.0f, 0.0f);
+		glm_quat_mul(d->quat_dest[i], rotate, d->quat_dest[i]);
+		glm_vec3_copy(d->v[i], move);
+		glm_normalize(move);
+		glm_quat_rotatev(d->quat_dest[i], move, d->vec_dest[i]);
+		glm_vec3_scale(d->vec_dest[i], 0.01f, move);
+		glm_vec3_add(d->eyes[i], move, d->vec_dest[i]);
+	}
+}
+
+static void run_batch_quat_rotatev(struct data* d, unsigned count)
+{
+	simd_quat_rotatev(d->a, d->v, d->vec_dest, count);
+}
+
+static void run_batch_quat_mul(struct data* d, unsigned count)
+{
+	simd_quat_mul(d->a, d->b, d->quat_dest, count);
+}
+
+static void run_batch_quat_integrate(struct data* d, unsigned count)
+{
+	simd_quat_integrate(d->quat_dest, d->spins, 16.0f, count);
+}
+
+static void run_batch_quat_nlerp(struct data* d, unsigned count)
+{
+	simd_quat_nlerp(d->a, d->b, d->t, d->quat_dest, count);
+}
+
+static void run_batch_quat_slerp(struct data* d, unsigned count)
+{
+	simd_quat_slerp(d->a, d->b, d->t, d->quat_dest, count);
+}
+
+static void run_batch_ease_sine_inout(struct data* d, unsigned count)
+{
+	simd_ease(SIMD_EASE_SINE_INOUT, d->t, d->t_dest, count);
+}
+
+static void run_batch_ease_elast_out(struct data* d, unsigned count)
+{
+	simd_ease(SIMD_EASE_ELASTIC_OUT, d->t, d->t_dest, count);
+}
+
+static void run_batch_ease_bounce_out(struct data* d, unsigned count)
+{
+	simd_ease(SIMD_EASE_BOUNCE_OUT, d->t, d->t_dest, count);
+}
+
+static void run_batch_bezier(struct data* d, unsigned count)
+{
+	simd_bezier(BEZIER_C0, BEZIER_C1, d->t, d->t_dest, count);
+}
+
+static void run_batch_mat4_inv(struct data* d, unsigned count)
+{
+	simd_mat4_inv(d->m, d->mat_dest, count);
+}
+
+static void run_batch_mat4_mul(struct data* d, unsigned count)
+{
+	simd_mat4_mul_left(d->m[0], d->m, d->mat_dest, count);
+}
+
+static const struct bench BENCHES[] =
+{
+	{ "quat_rotatev", run_quat_rotatev },
+	{ "quat_mul", run_quat_mul },
+	{ "quat_integrate", run_quat_integrate },
+	{ "quat_slerp", run_quat_slerp },
+	{ "ease_sine_inout", run_ease_sine_inout },
+	{ "ease_elast_out", run_ease_elast_out },
+	{ "ease_bounce_out", run_ease_bounce_out },
+	{ "bezier", run_bezier },
+	{ "look", run_look },
+	{ "mat4_inv", run_mat4_inv },
+	{ "mat4_mul", run_mat4_mul },
+	{ "camera", run_camera },
+	{ "batch_quat_rotatev", run_batch_quat_rotatev },
+	{ "batch_quat_mul", run_batch_quat_mul },
+	{ "batch_quat_integrate", run_batch_quat_integrate },
+	{ "batch_quat_nlerp", run_batch_quat_nlerp },
+	{ "batch_quat_slerp", run_batch_quat_slerp },
+	{ "batch_ease_sine_inout", run_batch_ease_sine_inout },
+	{ "batch_ease_elast_out", run_batch_ease_elast_out },
+	{ "batch_ease_bounce_out", run_batch_ease_bounce_out },
+	{ "batch_bezier", run_batch_bezier },
+	{ "batch_mat4_inv", run_batch_mat4_inv },
+	{ "batch_mat4_mul", run_batch_mat4_mul }
+};
+
+static int compare_doubles(const void* left, const void* right)
+{
+	double l = *(const double*)left, r = *(const double*)right;
+	return (l > r) - (l < r);
+}
+
+static double median(double* values, unsigned count)
+{
+	qsort(values, count, sizeof(double), compare_doubles);
+	return count & 1 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) * 0.5;
+}
+
+static void measure(const struct bench* bench, struct data* data, unsigned size, unsigned samples, struct result* result)
+{
+	double ns[MAX_SAMPLES], cycles[MAX_SAMPLES], sum = 0.0, deviation = 0.0;
+	double frequency = (double)SDL_GetPerformanceFrequency();
+	unsigned repeats = size < SAMPLE_ELEMENTS ? SAMPLE_ELEMENTS / size : 1;
+	unsigned sample, repeat;
+	Uint64 start, start_cycles;
+
+	for (sample = 0; sample < WARMUP_SAMPLES + samples; ++sample)
+	{
+		start_cycles = read_cycles();
+		start = SDL_GetPerformanceCounter();
+		for (repeat = 0; repeat < repeats; ++repeat)
+			bench->run(data, size);
+		if (sample < WARMUP_SAMPLES)
+			continue;
+		ns[sample - WARMUP_SAMPLES] = (double)(SDL_GetPerformanceCounter() - start) * 1e9 / frequency / ((double)repeats * size);
+		cycles[sample - WARMUP_SAMPLES] = (double)(read_cycles() - start_cycles) / ((double)repeats * size);
+	}
+
+	for (sample = 0; sample < samples; ++sample)
+		sum += ns[sample];
+	result->mean_ns = sum / samples;
+	for (sample = 0; sample < samples; ++sample)
+		deviation += (ns[sample] - result->mean_ns) * (ns[sample] - result->mean_ns);
+	result->stddev_ns = samples > 1 ? sqrt(deviation / (samples - 1)) : 0.0;
+	result->median_ns = median(ns, samples);
+	result->min_ns = ns[0]; // median sorted the samples
+	result->median_cycles = median(cycles, samples);
+	strncpy(result->name, bench->name, NAME_SIZE - 1);
+	result->name[NAME_SIZE - 1] = '\0';
+	result->size = size;
+}
+
+static int write_json(const char* filename, const struct result* results, unsigned count, unsigned samples)
+{
+	unsigned i;
+	FILE* file = fopen(filename, "w");
+	if (!file)
+	{
+		fprintf(stderr, "mathbench: failed to create file %s.\n", filename);
+		return 0;
+	}
+	// One result per line, read back by read_baseline
+	fprintf(file, "{\n\t\"isa\": \"%s\",\n\t\"samples\": %u,\n\t\"results\": [\n", simd_isa_name(simd_current()), samples);
+	for (i = 0; i < count; ++i)
+		fprintf(file, "\t\t{ \"name\": \"%s\", \"size\": %u, \"min_ns\": %.4f, \"median_ns\": %.4f, \"mean_ns\": %.4f, \"stddev_ns\": %.4f, \"median_cycles\": %.2f }%s\n",
+				results[i].name, results[i].size, results[i].min_ns, results[i].median_ns, results[i].mean_ns, results[i].stddev_ns,
+				results[i].median_cycles, i + 1 < count ? "," : "");
+	fprintf(file, "\t]\n}\n");
+	fclose(file);
+	return 1;
+}
+
+static struct result* read_baseline(const char* filename, unsigned* count)
+{
+	char line[LINE_BUFFER_SIZE];
+	struct result entry;
+	struct result* results = NULL;
+	unsigned capacity = 0;
+	FILE* file = fopen(filename, "r");
+	if (!file)
+	{
+		fprintf(stderr, "mathbench: failed to open file %s.\n", filename);
+		return NULL;
+	}
+	*count = 0;
+	while (fgets(line, sizeof(line), file))
+	{
+		if (sscanf(line, " { \"name\": \"%63[^\"]\", \"size\": %u, \"min_ns\": %lf, \"median_ns\": %lf", entry.name, &entry.size,
+				   &entry.min_ns, &entry.median_ns) != 4)
+			continue;
+		if (*count == capacity)
+		{
+			capacity = capacity ? capacity * 2 : 64;
+			results = (struct result*)realloc(results, capacity * sizeof(struct result));
+		}
+		results[(*count)++] = entry;
+	}
+	fclose(file);
+	if (!*count)
+		fprintf(stderr, "mathbench: no results in %s.\n", filename);
+	return results;
+}
+
+static const struct result* find_result(const struct result* results, unsigned count, const struct result* key)
+{
+	unsigned i;
+	for (i = 0; i < count; ++i)
+		if (results[i].size == key->size && !strcmp(results[i].name, key->name))
+			return &results[i];
+	return NULL;
+}
+
+static void fill_data(struct data* data)
+{
+	vec3 axis;
+	unsigned i;
+	for (i = 0; i < MAX_ELEMENTS; ++i)
+	{
+		axis[0] = random_float(-1.0f, 1.0f);
+		axis[1] = random_float(-1.0f, 1.0f);
+		axis[2] = random_float(0.1f, 1.0f);
+		glm_vec3_normalize(axis);
+		glm_quatv(data->a[i], random_float(0.0f, GLM_PIf * 2.0f), axis);
+		glm_quatv(data->b[i], random_float(0.0f, GLM_PIf * 2.0f), axis);
+		data->v[i][0] = random_float(-1.0f, 1.0f);
+		data->v[i][1] = random_float(-1.0f, 1.0f);
+		data->v[i][2] = random_float(0.1f, 1.0f);
+		data->eyes[i][0] = random_float(-100.0f, 100.0f);
+		data->eyes[i][1] = random_float(-100.0f, 100.0f);
+		data->eyes[i][2] = random_float(-100.0f, 100.0f);
+		glm_translate_make(data->m[i], data->eyes[i]);
+		glm_quat_rotate(data->m[i], data->a[i], data->m[i]);
+		glm_scale_uni(data->m[i], random_float(0.5f, 2.0f));
+		glm_quat_copy(data->a[i], data->quat_dest[i]);
+		glm_vec3_copy(axis, data->spins[i]);
+		data->spins[i][3] = random_float(-0.01f, 0.01f);
+		data->t[i] = random_float(0.0f, 1.0f);
+	}
+}
+
+static float max_error(const float* t, const float* dest, float c0, float c1, float (*curve)(float t))
+{
+	float expected, error = 0.0f;
+	unsigned i;
+	for (i = 0; i < CHECK_ELEMENTS; ++i)
+	{
+		expected = curve ? curve(t[i]) : glm_bezier(t[i], 0.0f, c0, c1, 1.0f);
+		error = glm_max(error, fabsf(dest[i] - expected));
+	}
+	return error;
+}
+
+// Every curve and a bezier through every instruction set the CPU runs,
+// the edges and middle of 0..1 first and then random amounts. Leaves the
+// widest kernels selected.
+static int check_curves(const float* random)
+{
+	float t[CHECK_ELEMENTS], dest[CHECK_ELEMENTS];
+	float error, worst;
+	unsigned isa, curve, i, failed = 0;
+
+	for (i = 0; i < 5; ++i)
+		t[i] = (float)i * 0.25f;
+	for (; i < CHECK_ELEMENTS; ++i)
+		t[i] = random[i];
+
+	for (isa = 0; isa < SIMD_ISA_COUNT; ++isa)
+	{
+		if (!simd_select((enum simd_isa)isa))
+			continue;
+		worst = 0.0f;
+		for (curve = 0; curve < SIMD_EASE_COUNT; ++curve)
+		{
+			simd_ease((enum simd_ease_curve)curve, t, dest, CHECK_ELEMENTS);
+			error = max_error(t, dest, 0.0f, 0.0f, CURVES[curve]);
+			if (error > CHECK_TOLERANCE)
+			{
+				fprintf(stderr, "mathbench: %s easing curve %u is off by %g.\n", simd_isa_name(simd_current()), curve, error);
+				++failed;
+			}
+			worst = glm_max(worst, error);
+		}
+		simd_bezier(BEZIER_C0, BEZIER_C1, t, dest, CHECK_ELEMENTS);
+		error = max_error(t, dest, BEZIER_C0, BEZIER_C1, NULL);
+		if (error > CHECK_TOLERANCE)
+		{
+			fprintf(stderr, "mathbench: %s bezier is off by %g.\n", simd_isa_name(simd_current()), error);
+			++failed;
+		}
+		worst = glm_max(worst, error);
+		printf("Easing curves: %s off by %g at most\n", simd_isa_name(simd_current()), worst);
+	}
+	simd_init();
+	return !failed;
+}
+
+int main(int argc, char** argv)
+{
+	struct data data;
+	struct result* results;
+	struct result* baseline = NULL;
+	const struct result* previous;
+	const char* filter = NULL;
+	const char* json_file = NULL;
+	const char* baseline_file = NULL;
+	double threshold = DEFAULT_THRESHOLD, change;
+	unsigned samples = DEFAULT_SAMPLES, baseline_count = 0, result_count = 0, regressions = 0;
+	unsigned bench, size;
+	int arg = 1, accurate;
+
+	while (arg + 1 < argc && argv[arg][0] == '-')
+	{
+		if (!strcmp(argv[arg], "-n"))
+			samples = (unsigned)atoi(argv[arg + 1]);
+		else if (!strcmp(argv[arg], "-f"))
+			filter = argv[arg + 1];
+		else if (!strcmp(argv[arg], "-j"))
+			json_file = argv[arg + 1];
+		else if (!strcmp(argv[arg], "-b"))
+			baseline_file = argv[arg + 1];
+		else if (!strcmp(argv[arg], "-t"))
+			threshold = atof(argv[arg + 1]);
+		else
+			break;
+		arg += 2;
+	}
+	if (arg < argc || !samples || samples > MAX_SAMPLES || threshold <= 0.0)
+	{
+		fprintf(stderr, "Usage: mathbench [-n <samples>] [-f <case filter>] [-j <output.json>] [-b <baseline.json>] [-t <threshold %%>]\n");
+		return 1;
+	}
+
+	if (baseline_file)
+	{
+		baseline = read_baseline(baseline_file, &baseline_count);
+		if (!baseline)
+			return 1;
+	}
+
+	data.a = (versor*)malloc(MAX_ELEMENTS * sizeof(versor));
+	data.b = (versor*)malloc(MAX_ELEMENTS * sizeof(versor));
+	data.quat_dest = (versor*)malloc(MAX_ELEMENTS * sizeof(versor));
+	data.v = (vec3*)malloc(MAX_ELEMENTS * sizeof(vec3));
+	data.vec_dest = (vec3*)malloc(MAX_ELEMENTS * sizeof(vec3));
+	data.eyes = (vec3*)malloc(MAX_ELEMENTS * sizeof(vec3));
+	data.m = (mat4*)malloc(MAX_ELEMENTS * sizeof(mat4));
+	data.mat_dest = (mat4*)malloc(MAX_ELEMENTS * sizeof(mat4));
+	data.spins = (vec4*)malloc(MAX_ELEMENTS * sizeof(vec4));
+	data.t = (float*)malloc(MAX_ELEMENTS * sizeof(float));
+	data.t_dest = (float*)malloc(MAX_ELEMENTS * sizeof(float));
+	results = (struct result*)malloc(sizeof(BENCHES) / sizeof(BENCHES[0]) * sizeof(SIZES) / sizeof(SIZES[0]) * sizeof(struct result));
+	fill_data(&data);
+
+	accurate = check_curves(data.t);
+	printf("Batch kernels: %s, %u samples of %u elements after %u warmup samples\n", simd_isa_name(simd_current()), samples,
+		   SAMPLE_ELEMENTS, WARMUP_SAMPLES);
+	printf("%-22s %8s %10s %10s %8s %10s %10s\n", "case", "size", "median ns", "min ns", "stddev", "cycles", baseline ? "change" : "");
+	for (bench = 0; bench < sizeof(BENCHES) / sizeof(BENCHES[0]); ++bench)
+	{
+		if (filter && !strstr(BENCHES[bench].name, filter))
+			continue;
+		for (size = 0; size < sizeof(SIZES) / sizeof(SIZES[0]); ++size)
+		{
+			struct result* result = &results[result_count++];
+			measure(&BENCHES[bench], &data, SIZES[size], samples, result);
+			printf("%-22s %8u %10.3f %10.3f %7.1f%% %10.2f", result->name, result->size, result->median_ns, result->min_ns,
+				   result->stddev_ns / result->mean_ns * 100.0, result->median_cycles);
+
+			previous = baseline ? find_result(baseline, baseline_count, result) : NULL;
+			if (previous)
+			{
+				change = (result->median_ns / previous->median_ns - 1.0) * 100.0;
+				printf(" %+9.1f%%%s", change, change > threshold ? "  REGRESSION" : "");
+				regressions += change > threshold;
+			}
+			printf("\n");
+		}
+	}
+
+	if (json_file && !write_json(json_file, results, result_count, samples))
+		regressions = ~0u;
+	if (baseline)
+		printf("%u regressions over %.1f%% against %s\n", regressions, threshold, baseline_file);
+
+	free(baseline);
+	free(results);
+	free(data.t_dest);
+	free(data.t);
+	free(data.spins);
+	free(data.mat_dest);
+	free(data.m);
+	free(data.eyes);
+	free(data.vec_dest);
+	free(data.v);
+	free(data.quat_dest);
+	free(data.b);
+	free(data.a);
+	return regressions || !accurate ? 1 : 0;
+}
@@ -0,0 +1,381 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// MVP benchmark: draws many dense spheres with per-object uniforms, once
+// with shaders that multiply the view-projection and model matrices for
+// every vertex and once with model-view-projection matrices built on the
+// CPU by batch_transforms, and times the matrix work on its own. Frames
+// are drawn whole and with rasterisation discarded, which leaves only the
+// vertex stage. The best frame of each run is reported.
+//
+// Usage: mvpbench [objects] [frames]
+// A thousand objects of 16641 vertices and 20 frames by default.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+#include "../cglm/affine.h"
+#include "../cglm/cam.h"
+#include "../simd.h"
+#include "../transform_batch.h"
+
+#define SPHERE_SEGMENTS 128
+#define SPHERE_VERTICES ((SPHERE_SEGMENTS + 1) * (SPHERE_SEGMENTS + 1))
+#define SPHERE_INDICES (SPHERE_SEGMENTS * SPHERE_SEGMENTS * 6)
+#define MATRIX_OBJECTS 1000000
+#define WARMUP_FRAMES 2
+
+// Same shader as sample 10 before the change
+static const char VERTEX_PER_VERTEX[] =
+	"#version 330 core\n"
+	"layout (location = 0) in vec3 aPos;\n"
+	"layout (location = 1) in vec3 aNormals;\n"
+	"uniform mat4 cViewProj;\n"
+	"uniform mat4 cModel;\n"
+	"uniform mat4 cModelInv;\n"
+	"out vec3 vNormal;\n"
+	"out vec3 vFragPos;\n"
+	"void main()\n"
+	"{\n"
+	"	vNormal = mat3(cModelInv) * aNormals;\n"
+	"	vFragPos = (cModel * vec4(aPos, 1.0)).xyz;\n"
+	"	gl_Position = cViewProj * cModel * vec4(aPos, 1.0);\n"
+	"}\n";
+
+static const char VERTEX_PRECOMPUTED[] =
+	"#version 330 core\n"
+	"layout (location = 0) in vec3 aPos;\n"
+	"layout (location = 1) in vec3 aNormals;\n"
+	"uniform mat4 cModelViewProj;\n"
+	"uniform mat4 cModel;\n"
+	"uniform mat3 cNormalMatrix;\n"
+	"out vec3 vNormal;\n"
+	"out vec3 vFragPos;\n"
+	"void main()\n"
+	"{\n"
+	"	vNormal = cNormalMatrix * aNormals;\n"
+	"	vFragPos = (cModel * vec4(aPos, 1.0)).xyz;\n"
+	"	gl_Position = cModelViewProj * vec4(aPos, 1.0);\n"
+	"}\n";
+
+static const char FRAGMENT[] =
+	"#version 330 core\n"
+	"in vec3 vNormal;\n"
+	"in vec3 vFragPos;\n"
+	"out vec4 fColor;\n"
+	"void main()\n"
+	"{\n"
+	"	fColor = vec4(vec3(max(dot(normalize(vNormal), normalize(vec3(0.0, 10.0, 0.0) - vFragPos)), 0.1)), 1.0);\n"
+	"}\n";
+
+static unsigned compile_shader(GLenum type, const char* source)
+{
+	char log[1024];
+	int status;
+	unsigned shader = glCreateShader(type);
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (!status)
+	{
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		fprintf(stderr, "mvpbench: %s\n", log);
+		glDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+static unsigned create_benchmark_program(const char* vertex_source)
+{
+	char log[1024];
+	int status;
+	unsigned program, vertex, fragment;
+
+	vertex = compile_shader(GL_VERTEX_SHADER, vertex_source);
+	fragment = compile_shader(GL_FRAGMENT_SHADER, FRAGMENT);
+	if (!vertex || !fragment)
+	{
+		glDeleteShader(vertex);
+		glDeleteShader(fragment);
+		return 0;
+	}
+	program = glCreateProgram();
+	glAttachShader(program, vertex);
+	glAttachShader(program, fragment);
+	glLinkProgram(program);
+	glDeleteShader(vertex);
+	glDeleteShader(fragment);
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (!status)
+	{
+		glGetProgramInfoLog(program, sizeof(log), NULL, log);
+		fprintf(stderr, "mvpbench: %s\n", log);
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+// Unit sphere, positions double as normals
+static void build_sphere(vec3* vertices, unsigned* indices)
+{
+	unsigned x, y, i = 0;
+	float theta, phi;
+	for (y = 0; y <= SPHERE_SEGMENTS; ++y)
+		for (x = 0; x <= SPHERE_SEGMENTS; ++x)
+		{
+			theta = (float)y / SPHERE_SEGMENTS * GLM_PIf;
+			phi = (float)x / SPHERE_SEGMENTS * GLM_PIf * 2.0f;
+			vertices[y * (SPHERE_SEGMENTS + 1) + x][0] = sinf(theta) * cosf(phi);
+			vertices[y * (SPHERE_SEGMENTS + 1) + x][1] = cosf(theta);
+			vertices[y * (SPHERE_SEGMENTS + 1) + x][2] = sinf(theta) * sinf(phi);
+		}
+	for (y = 0; y < SPHERE_SEGMENTS; ++y)
+		for (x = 0; x < SPHERE_SEGMENTS; ++x)
+		{
+			indices[i++] = y * (SPHERE_SEGMENTS + 1) + x;
+			indices[i++] = (y + 1) * (SPHERE_SEGMENTS + 1) + x;
+			indices[i++] = y * (SPHERE_SEGMENTS + 1) + x + 1;
+			indices[i++] = y * (SPHERE_SEGMENTS + 1) + x + 1;
+			indices[i++] = (y + 1) * (SPHERE_SEGMENTS + 1) + x;
+			indices[i++] = (y + 1) * (SPHERE_SEGMENTS + 1) + x + 1;
+		}
+}
+
+static void object_model(unsigned object, unsigned side, float angle, mat4 model)
+{
+	glm_translate_make(model, (vec3){ ((float)(object % side) - side * 0.5f) * 3.0f, 0.0f, ((float)(object / side) - side * 0.5f) * 3.0f });
+	glm_rotate(model, angle + (float)object, GLM_YUP);
+}
+
+// Per object matrix work of both conventions, without any drawing
+static void benchmark_matrices(mat4 viewproj)
+{
+	mat4* models = (mat4*)malloc(MATRIX_OBJECTS * sizeof(mat4));
+	mat4* mvps = (mat4*)malloc(MATRIX_OBJECTS * sizeof(mat4));
+	mat3* normals = (mat3*)malloc(MATRIX_OBJECTS * sizeof(mat3));
+	mat4 model_inv;
+	double seconds;
+	Uint64 start;
+	unsigned i;
+	float checksum = 0.0f;
+
+	if (!models || !mvps || !normals)
+	{
+		fprintf(stderr, "mvpbench: out of memory.\n");
+		exit(1);
+	}
+	for (i = 0; i < MATRIX_OBJECTS; ++i)
+		object_model(i, 1000, 0.0f, models[i]);
+	batch_transforms(viewproj, models, mvps, normals, MATRIX_OBJECTS);
+
+	start = SDL_GetPerformanceCounter();
+	for (i = 0; i < MATRIX_OBJECTS; ++i)
+	{
+		glm_mat4_inv(models[i], model_inv);
+		glm_mat4_transpose(model_inv);
+		checksum += model_inv[0][0];
+	}
+	seconds = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+	printf("inverse transpose:   %6.1f ns/object\n", seconds / MATRIX_OBJECTS * 1e9);
+
+	start = SDL_GetPerformanceCounter();
+	batch_transforms(viewproj, models, mvps, normals, MATRIX_OBJECTS);
+	seconds = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+	printf("batch_transforms:    %6.1f ns/object%s\n", seconds / MATRIX_OBJECTS * 1e9, checksum != checksum ? " (NaN)" : "");
+
+	free(normals);
+	free(mvps);
+	free(models);
+}
+
+int main(int argc, char** argv)
+{
+	vec3* vertices;
+	unsigned* indices;
+	mat4* models;
+	mat4* mvps;
+	mat3* normals;
+	mat4 proj, view, viewproj, model_inv;
+	unsigned vbo, ebo, vao, programs[2];
+	unsigned i, count, frames, frame, run, variant, discard, side;
+	int locations[2][3];
+	double cpu_seconds, frame_seconds, seconds;
+	Uint64 start, cpu_start;
+
+	count = argc > 1 ? (unsigned)atoi(argv[1]) : 1000;
+	frames = argc > 2 ? (unsigned)atoi(argv[2]) : 20;
+	if (!count || !frames)
+	{
+		fprintf(stderr, "Usage: mvpbench [objects] [frames]\n");
+		return 1;
+	}
+
+	if (SDL_Init(SDL_INIT_VIDEO) < 0)
+	{
+		fprintf(stderr, "mvpbench: %s\n", SDL_GetError());
+		return 1;
+	}
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_Window* window = SDL_CreateWindow("mvpbench", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+										  256, 256, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+	SDL_GLContext context = window ? SDL_GL_CreateContext(window) : NULL;
+	glewExperimental = GL_TRUE;
+	if (!context || glewInit() != GLEW_OK)
+	{
+		fprintf(stderr, "mvpbench: %s\n", SDL_GetError());
+		if (context)
+			SDL_GL_DeleteContext(context);
+		if (window)
+			SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+	SDL_GL_SetSwapInterval(0);
+
+	vertices = (vec3*)malloc(SPHERE_VERTICES * sizeof(vec3));
+	indices = (unsigned*)malloc(SPHERE_INDICES * sizeof(unsigned));
+	models = (mat4*)malloc(count * sizeof(mat4));
+	mvps = (mat4*)malloc(count * sizeof(mat4));
+	normals = (mat3*)malloc(count * sizeof(mat3));
+	if (!vertices || !indices || !models || !mvps || !normals)
+	{
+		fprintf(stderr, "mvpbench: out of memory.\n");
+		return 1;
+	}
+	build_sphere(vertices, indices);
+
+	programs[0] = create_benchmark_program(VERTEX_PER_VERTEX);
+	programs[1] = create_benchmark_program(VERTEX_PRECOMPUTED);
+	if (!programs[0] || !programs[1])
+		return 1;
+	locations[0][0] = glGetUniformLocation(programs[0], "cViewProj");
+	locations[0][1] = glGetUniformLocation(programs[0], "cModel");
+	locations[0][2] = glGetUniformLocation(programs[0], "cModelInv");
+	locations[1][0] = glGetUniformLocation(programs[1], "cModelViewProj");
+	locations[1][1] = glGetUniformLocation(programs[1], "cModel");
+	locations[1][2] = glGetUniformLocation(programs[1], "cNormalMatrix");
+
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, SPHERE_VERTICES * sizeof(vec3), vertices, GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), (void*)0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), (void*)0);
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glGenBuffers(1, &ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, SPHERE_INDICES * sizeof(unsigned), indices, GL_STATIC_DRAW);
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_CULL_FACE);
+	glViewport(0, 0, 256, 256);
+
+	// The whole field from far above, spheres are a few pixels wide and
+	// the frame is bound by vertex work
+	for (side = 1; side * side < count; ++side)
+		;
+	glm_perspective(glm_rad(60.0f), 1.0f, 1.0f, side * 12.0f, proj);
+	glm_lookat((vec3){ 0.0f, side * 3.0f, side * 1.0f }, GLM_VEC3_ZERO, GLM_YUP, view);
+	glm_mat4_mul(proj, view, viewproj);
+
+	printf("%u objects, %u vertices each, %u frames, %s kernels\n", count, SPHERE_VERTICES, frames, simd_isa_name(simd_init()));
+	for (run = 0; run < 4; ++run)
+	{
+		variant = run & 1;
+		discard = run >> 1;
+		if (discard)
+			glEnable(GL_RASTERIZER_DISCARD);
+		glUseProgram(programs[variant]);
+		cpu_seconds = 1e9;
+		frame_seconds = 1e9;
+		for (frame = 0; frame < WARMUP_FRAMES + frames; ++frame)
+		{
+			start = SDL_GetPerformanceCounter();
+			for (i = 0; i < count; ++i)
+				object_model(i, side, (float)frame * 0.01f, models[i]);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			cpu_start = SDL_GetPerformanceCounter();
+			if (variant)
+			{
+				batch_transforms(viewproj, models, mvps, normals, count);
+				for (i = 0; i < count; ++i)
+				{
+					glUniformMatrix4fv(locations[1][0], 1, GL_FALSE, mvps[i][0]);
+					glUniformMatrix4fv(locations[1][1], 1, GL_FALSE, models[i][0]);
+					glUniformMatrix3fv(locations[1][2], 1, GL_FALSE, normals[i][0]);
+					glDrawElements(GL_TRIANGLES, SPHERE_INDICES, GL_UNSIGNED_INT, 0);
+				}
+			}
+			else
+			{
+				glUniformMatrix4fv(locations[0][0], 1, GL_FALSE, viewproj[0]);
+				for (i = 0; i < count; ++i)
+				{
+					glm_mat4_inv(models[i], model_inv);
+					glm_mat4_transpose(model_inv);
+					glUniformMatrix4fv(locations[0][1], 1, GL_FALSE, models[i][0]);
+					glUniformMatrix4fv(locations[0][2], 1, GL_FALSE, model_inv[0]);
+					glDrawElements(GL_TRIANGLES, SPHERE_INDICES, GL_UNSIGNED_INT, 0);
+				}
+			}
+			seconds = (double)(SDL_GetPerformanceCounter() - cpu_start) / (double)SDL_GetPerformanceFrequency();
+			if (frame >= WARMUP_FRAMES)
+				cpu_seconds = glm_min(cpu_seconds, seconds);
+			glFinish();
+			seconds = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+			if (frame >= WARMUP_FRAMES)
+				frame_seconds = glm_min(frame_seconds, seconds);
+		}
+		printf("%-13s %-12s submit %7.2f ms, frame %8.2f ms\n", discard ? "vertices only" : "full frame",
+			   variant ? "precomputed" : "per vertex", cpu_seconds * 1000.0, frame_seconds * 1000.0);
+	}
+	glDisable(GL_RASTERIZER_DISCARD);
+	glUseProgram(0);
+
+	benchmark_matrices(viewproj);
+
+	glBindVertexArray(0);
+	glDeleteVertexArrays(1, &vao);
+	glDeleteBuffers(1, &ebo);
+	glDeleteBuffers(1, &vbo);
+	glDeleteProgram(programs[1]);
+	glDeleteProgram(programs[0]);
+	free(normals);
+	free(mvps);
+	free(models);
+	free(indices);
+	free(vertices);
+	SDL_GL_DeleteContext(context);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+	return 0;
+}
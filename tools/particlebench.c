@@ -0,0 +1,157 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Particle benchmark: keeps a full particle system in steady state,
+// refilling it with as many particles as died each frame, with each
+// instruction set of simd.h. Reports the update with its compaction, the
+// emission and the packing for drawing per frame, and checks that every
+// instruction set ends with the particles of the baseline.
+//
+// Usage: particlebench [particles] [frames]
+// 1048576 particles and 100 frames by default.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL_timer.h>
+#include "../jobs.h"
+#include "../particles.h"
+#include "../simd.h"
+
+#define WARMUP_FRAMES 3
+#define FRAME_TIME 16.0f
+#define SEED 12345u
+// Relative error allowed against the baseline, FMA rounds differently
+#define TOLERANCE 1e-4f
+
+static double seconds_since(Uint64 start)
+{
+	return (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+static float max_error(const float* result, const float* reference, unsigned count)
+{
+	float error, max = 0.0f;
+	unsigned i;
+	for (i = 0; i < count; ++i)
+	{
+		error = fabsf(result[i] - reference[i]) / (1.0f + fabsf(reference[i]));
+		if (!(error <= max))
+			max = error;
+	}
+	return max;
+}
+
+int main(int argc, char** argv)
+{
+	static const struct particle_emitter emitter =
+	{
+		{ 0.0f, 0.0f, 0.0f },
+		{ 0.0f, 0.01f, 0.0f },
+		{ 0.002f, 0.002f, 0.002f },
+		1000.0f,
+		1000.0f
+	};
+	vec3 gravity = { 0.0f, -0.00001f, 0.0f };
+	struct particle_system system;
+	float* packed;
+	float* reference;
+	double update, emit, pack;
+	float error;
+	Uint64 start;
+	unsigned count = 1048576, frames = 100, reference_count = 0, frame;
+	int isa, failed = 0;
+
+	if (argc > 1)
+		count = (unsigned)strtoul(argv[1], NULL, 10);
+	if (argc > 2)
+		frames = (unsigned)strtoul(argv[2], NULL, 10);
+	if (!count || !frames)
+	{
+		fprintf(stderr, "Usage: particlebench [particles] [frames]\n");
+		return 1;
+	}
+
+	packed = (float*)malloc(count * 4 * sizeof(float));
+	reference = (float*)malloc(count * 4 * sizeof(float));
+	if (!packed || !reference || !jobs_init(0))
+	{
+		fprintf(stderr, "particlebench: out of memory\n");
+		return 1;
+	}
+
+	printf("%u particles, %u frames, %u threads\n", count, frames, jobs_thread_count());
+	printf("%-10s %10s %12s %12s %12s %12s\n", "isa", "alive", "update ms", "emit ms", "pack ms", "max error");
+	for (isa = SIMD_BASELINE; isa < SIMD_ISA_COUNT; ++isa)
+	{
+		if (!simd_select((enum simd_isa)isa))
+			continue;
+		if (!create_particle_system(&system, count, SEED))
+		{
+			fprintf(stderr, "particlebench: out of memory\n");
+			return 1;
+		}
+		emit_particles(&system, &emitter, count);
+
+		update = emit = pack = 0.0;
+		for (frame = 0; frame < frames + WARMUP_FRAMES; ++frame)
+		{
+			if (frame == WARMUP_FRAMES)
+				update = emit = pack = 0.0;
+
+			start = SDL_GetPerformanceCounter();
+			update_particles(&system, gravity, FRAME_TIME);
+			update += seconds_since(start);
+
+			start = SDL_GetPerformanceCounter();
+			emit_particles(&system, &emitter, count - system.count);
+			emit += seconds_since(start);
+
+			start = SDL_GetPerformanceCounter();
+			pack_particles(&system, packed);
+			pack += seconds_since(start);
+		}
+
+		// Lives only subtract, so every instruction set keeps the same particles
+		if (isa == SIMD_BASELINE)
+		{
+			memcpy(reference, packed, system.count * 4 * sizeof(float));
+			reference_count = system.count;
+		}
+		error = system.count == reference_count ? max_error(packed, reference, system.count * 4) : INFINITY;
+		if (!(error <= TOLERANCE))
+			failed = 1;
+
+		printf("%-10s %10u %12.4f %12.4f %12.4f %12.3g%s\n", simd_isa_name((enum simd_isa)isa), system.count,
+			   update * 1000.0 / frames, emit * 1000.0 / frames, pack * 1000.0 / frames, (double)error,
+			   error <= TOLERANCE ? "" : "  MISMATCH");
+		destroy_particle_system(&system);
+	}
+
+	jobs_shutdown();
+	free(reference);
+	free(packed);
+	return failed;
+}
@@ -0,0 +1,187 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Resource compiler: packs data files into a single page-aligned read-only
+// blob and a sorted lookup table consumed by find_resource().
+//
+// Usage: rescomp <output.c> [-C <directory>] <file>...
+// Files are named by the path given on the command line, -C changes the
+// directory they are read from (like tar) without affecting their names.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../resource.h"
+
+#define PATH_BUFFER_SIZE 1024
+#define BYTES_PER_LINE 16
+
+struct entry
+{
+	char* name;
+	unsigned char* data;
+	unsigned size;
+	unsigned offset;
+};
+
+static int compare_entries(const void* left, const void* right)
+{
+	return strcmp(((const struct entry*)left)->name, ((const struct entry*)right)->name);
+}
+
+static int read_entry(struct entry* entry, const char* directory, const char* name)
+{
+	char path[PATH_BUFFER_SIZE];
+	char* c;
+
+	if (directory)
+		snprintf(path, PATH_BUFFER_SIZE, "%s/%s", directory, name);
+	else
+		snprintf(path, PATH_BUFFER_SIZE, "%s", name);
+
+	FILE* file = fopen(path, "rb");
+	if (!file)
+	{
+		fprintf(stderr, "rescomp: failed to open file %s.\n", path);
+		return 0;
+	}
+	fseek(file, 0, SEEK_END);
+	entry->size = ftell(file);
+	rewind(file);
+	entry->data = (unsigned char*)malloc(entry->size + 1);
+	if (fread(entry->data, 1, entry->size, file) != entry->size)
+	{
+		fprintf(stderr, "rescomp: failed to read file %s.\n", path);
+		free(entry->data);
+		fclose(file);
+		return 0;
+	}
+	fclose(file);
+
+	entry->name = (char*)malloc(strlen(name) + 1);
+	strcpy(entry->name, name);
+	for (c = entry->name; *c; ++c)
+		if (*c == '\\')
+			*c = '/';
+	return 1;
+}
+
+static void write_escaped(FILE* file, const char* name)
+{
+	for (; *name; ++name)
+	{
+		if (*name == '"' || *name == '\\')
+			fputc('\\', file);
+		fputc(*name, file);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: rescomp <output.c> [-C <directory>] <file>...\n");
+		return 1;
+	}
+
+	struct entry* entries = (struct entry*)calloc(argc, sizeof(struct entry));
+	const char* directory = NULL;
+	unsigned count = 0;
+	unsigned total = 0;
+	unsigned i, j;
+	int arg;
+
+	for (arg = 2; arg < argc; ++arg)
+	{
+		if (!strcmp(argv[arg], "-C") && arg + 1 < argc)
+		{
+			directory = argv[++arg];
+			continue;
+		}
+		if (!read_entry(&entries[count], directory, argv[arg]))
+			return 1;
+		++count;
+	}
+
+	qsort(entries, count, sizeof(struct entry), compare_entries);
+	for (i = 0; i < count; ++i)
+	{
+		if (i && !strcmp(entries[i].name, entries[i - 1].name))
+		{
+			fprintf(stderr, "rescomp: duplicate resource %s.\n", entries[i].name);
+			return 1;
+		}
+		// Every entry keeps at least one trailing zero so text resources are C strings
+		entries[i].offset = total;
+		total += (entries[i].size + RESOURCE_ALIGNMENT) & ~(RESOURCE_ALIGNMENT - 1);
+	}
+
+	FILE* file = fopen(argv[1], "w");
+	if (!file)
+	{
+		fprintf(stderr, "rescomp: failed to create file %s.\n", argv[1]);
+		return 1;
+	}
+
+	fprintf(file, "// Generated by rescomp. Do not edit.\n\n");
+	fprintf(file, "#include <stddef.h>\n");
+	fprintf(file, "#include \"resource.h\"\n\n");
+	fprintf(file, "#ifdef _MSC_VER\n#pragma section(\".lglres\", read)\n#endif\n\n");
+
+	fprintf(file, "RESOURCE_SECTION static const unsigned char resource_data[%u] =\n{", total ? total : 1);
+	for (i = 0; i < count; ++i)
+	{
+		fprintf(file, "\n\t// %s", entries[i].name);
+		for (j = 0; j < entries[i].size; ++j)
+		{
+			if (j % BYTES_PER_LINE == 0)
+				fprintf(file, "\n\t");
+			fprintf(file, "0x%02x,", entries[i].data[j]);
+		}
+		fprintf(file, "\n\t");
+		for (j = entries[i].offset + entries[i].size; j < (i + 1 < count ? entries[i + 1].offset : total); ++j)
+			fprintf(file, "0x00,");
+	}
+	fprintf(file, "\n};\n\n");
+
+	fprintf(file, "const struct resource resources[] =\n{\n");
+	for (i = 0; i < count; ++i)
+	{
+		fprintf(file, "\t{ \"");
+		write_escaped(file, entries[i].name);
+		fprintf(file, "\", resource_data + %u, %u, RESOURCE_EMBEDDED },\n", entries[i].offset, entries[i].size);
+	}
+	if (!count)
+		fprintf(file, "\t{ NULL, NULL, 0, 0 }\n");
+	fprintf(file, "};\n\n");
+	fprintf(file, "const unsigned resources_count = %u;\n", count);
+
+	fclose(file);
+	for (i = 0; i < count; ++i)
+	{
+		free(entries[i].name);
+		free(entries[i].data);
+	}
+	free(entries);
+	return 0;
+}
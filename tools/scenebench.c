@@ -0,0 +1,218 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Scene graph benchmark: builds hierarchies of different shapes and times
+// update_scene_graph after moving every root, a single root, a single leaf
+// and nothing at all. World matrices are checked against a plain walk up
+// the parents.
+//
+// Usage: scenebench [nodes]
+// 100000 nodes by default.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL_timer.h>
+#include "../cglm/affine.h"
+#include "../jobs.h"
+#include "../scene_graph.h"
+
+#define RUNS 100
+#define TOLERANCE 1e-3f
+
+struct shape
+{
+	const char* name;
+	unsigned branching; // Children of every node, 0 for chains
+	unsigned chain; // Length of every chain
+};
+
+static const struct shape shapes[] =
+{
+	{ "wide", 16, 0 },
+	{ "binary", 2, 0 },
+	{ "chains", 0, 60 }
+};
+
+static unsigned seed = 1;
+
+static float random_float(float min, float max)
+{
+	seed = seed * 1664525u + 1013904223u;
+	return min + (max - min) * (float)(seed >> 8) / 16777216.0f;
+}
+
+static double seconds_since(Uint64 start)
+{
+	return (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+static void random_local(mat4 local)
+{
+	vec3 position = { random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f) };
+	vec3 axis = { random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f), random_float(0.1f, 1.0f) };
+	glm_translate_make(local, position);
+	glm_rotate(local, random_float(-0.2f, 0.2f), axis);
+}
+
+// Nodes are added parent first, so a parent handle is always smaller
+static unsigned build(struct scene_graph* graph, const struct shape* shape, unsigned count, unsigned* parents,
+					  mat4* locals, unsigned* roots)
+{
+	unsigned node, parent, roots_count = 0;
+	for (node = 0; node < count; ++node)
+	{
+		if (shape->branching)
+			parent = node ? (node - 1) / shape->branching : SCENE_ROOT;
+		else
+			parent = node % shape->chain ? node - 1 : SCENE_ROOT;
+		random_local(locals[node]);
+		parents[node] = parent;
+		if (parent == SCENE_ROOT)
+			roots[roots_count++] = node;
+		add_scene_node(graph, parent, locals[node]);
+	}
+	return roots_count;
+}
+
+static float check(struct scene_graph* graph, const unsigned* parents, mat4* locals, unsigned count)
+{
+	mat4 world;
+	float error, max_error = 0.0f;
+	unsigned node, parent, i;
+	const float* result;
+	for (node = 0; node < count; node += 97)
+	{
+		glm_mat4_copy(locals[node], world);
+		for (parent = parents[node]; parent != SCENE_ROOT; parent = parents[parent])
+			glm_mat4_mul(locals[parent], world, world);
+		result = scene_world(graph, node);
+		for (i = 0; i < 16; ++i)
+		{
+			error = fabsf(result[i] - world[i / 4][i % 4]) / (1.0f + fabsf(world[i / 4][i % 4]));
+			if (error > max_error)
+				max_error = error;
+		}
+	}
+	return max_error;
+}
+
+int main(int argc, char** argv)
+{
+	struct scene_graph graph;
+	const struct shape* shape;
+	unsigned* parents;
+	unsigned* roots;
+	mat4* locals;
+	double first, all, root, leaf, none;
+	float error;
+	Uint64 start;
+	unsigned count = 100000, roots_count, leaf_node, s, r, i;
+	int failed = 0;
+
+	if (argc > 1)
+		count = (unsigned)strtoul(argv[1], NULL, 10);
+	if (!count)
+	{
+		fprintf(stderr, "scenebench: invalid node count\n");
+		return 1;
+	}
+
+	parents = (unsigned*)malloc(count * sizeof(unsigned));
+	roots = (unsigned*)malloc(count * sizeof(unsigned));
+	locals = (mat4*)malloc(count * sizeof(mat4));
+	if (!parents || !roots || !locals || !jobs_init(0))
+	{
+		fprintf(stderr, "scenebench: out of memory\n");
+		return 1;
+	}
+
+	printf("%u nodes, %u threads\n", count, jobs_thread_count());
+	printf("%-8s %7s %7s %12s %12s %12s %12s %12s\n", "shape", "roots", "levels", "first ms", "all ms", "root ms",
+		   "leaf ms", "static ms");
+	for (s = 0; s < sizeof(shapes) / sizeof(shapes[0]); ++s)
+	{
+		shape = &shapes[s];
+		if (!create_scene_graph(&graph, count))
+		{
+			fprintf(stderr, "scenebench: out of memory\n");
+			return 1;
+		}
+		roots_count = build(&graph, shape, count, parents, locals, roots);
+
+		start = SDL_GetPerformanceCounter();
+		update_scene_graph(&graph);
+		first = seconds_since(start);
+
+		start = SDL_GetPerformanceCounter();
+		for (r = 0; r < RUNS; ++r)
+		{
+			random_local(locals[roots[r % roots_count]]);
+			for (i = 0; i < roots_count; ++i)
+				set_scene_local(&graph, roots[i], locals[roots[i]]);
+			update_scene_graph(&graph);
+		}
+		all = seconds_since(start) / RUNS;
+		error = check(&graph, parents, locals, count);
+
+		start = SDL_GetPerformanceCounter();
+		for (r = 0; r < RUNS; ++r)
+		{
+			random_local(locals[roots[roots_count - 1]]);
+			set_scene_local(&graph, roots[roots_count - 1], locals[roots[roots_count - 1]]);
+			update_scene_graph(&graph);
+		}
+		root = seconds_since(start) / RUNS;
+
+		leaf_node = count - 1;
+		start = SDL_GetPerformanceCounter();
+		for (r = 0; r < RUNS; ++r)
+		{
+			random_local(locals[leaf_node]);
+			set_scene_local(&graph, leaf_node, locals[leaf_node]);
+			update_scene_graph(&graph);
+		}
+		leaf = seconds_since(start) / RUNS;
+
+		start = SDL_GetPerformanceCounter();
+		for (r = 0; r < RUNS; ++r)
+			update_scene_graph(&graph);
+		none = seconds_since(start) / RUNS;
+
+		if (check(&graph, parents, locals, count) > error)
+			error = check(&graph, parents, locals, count);
+		printf("%-8s %7u %7u %12.4f %12.4f %12.4f %12.4f %12.4f  error %g%s\n", shape->name, roots_count,
+			   graph.levels_count, first * 1000.0, all * 1000.0, root * 1000.0, leaf * 1000.0, none * 1000.0,
+			   (double)error, error > TOLERANCE ? " FAILED" : "");
+		if (error > TOLERANCE)
+			failed = 1;
+		destroy_scene_graph(&graph);
+	}
+
+	jobs_shutdown();
+	free(locals);
+	free(roots);
+	free(parents);
+	return failed;
+}
@@ -0,0 +1,488 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Skinning benchmark: animates a crowd of tentacles sharing a skeleton,
+// a clip and a mesh, then skins and draws them every frame three ways.
+// The CPU path skins into a mapped buffer across the job threads, once
+// per instruction set of simd.h; the GPU paths upload the joint palettes
+// to a uniform buffer drawn one character at a time or to a texture
+// buffer drawn instanced, and skin in the vertex shader. Reports the
+// animation, the skinning or upload and the whole frame per frame.
+//
+// Usage: skinbench [characters] [frames]
+// 1024 characters and 100 frames by default.
+
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+#include "../cglm/affine.h"
+#include "../cglm/cam.h"
+#include "../cglm/quat.h"
+#include "../jobs.h"
+#include "../simd.h"
+#include "../skeleton.h"
+
+#define WARMUP_FRAMES 3
+#define FIELD_SPACING 1.5f
+#define JOINTS_COUNT 16
+#define SEGMENT_LENGTH 0.25f
+#define SEGMENT_RINGS 2
+#define RINGS_COUNT (JOINTS_COUNT * SEGMENT_RINGS + 1)
+#define RING_SIDES 16
+#define MESH_VERTICES (RINGS_COUNT * RING_SIDES)
+#define MESH_INDICES ((RINGS_COUNT - 1) * RING_SIDES * 6)
+#define CLIP_FRAMES 30
+#define CLIP_FRAME_TIME 50.0f
+#define FRAME_TIME 16.0f
+
+enum path
+{
+	PATH_CPU,
+	PATH_UBO,
+	PATH_TBO
+};
+
+static const char VERTEX_CPU[] =
+	"#version 330 core\n"
+	"layout (location = 0) in vec3 aPos;\n"
+	"layout (location = 1) in vec3 aNormal;\n"
+	"uniform mat4 cViewProj;\n"
+	"out vec3 vNormal;\n"
+	"void main()\n"
+	"{\n"
+	"	vNormal = aNormal;\n"
+	"	gl_Position = cViewProj * vec4(aPos, 1.0);\n"
+	"}\n";
+
+static const char VERTEX_UBO[] =
+	"#version 330 core\n"
+	"layout (location = 0) in vec3 aPos;\n"
+	"layout (location = 1) in vec3 aNormal;\n"
+	"layout (location = 2) in uvec4 aJoints;\n"
+	"layout (location = 3) in vec4 aWeights;\n"
+	"layout (std140) uniform Palette { mat4 cJoints[64]; };\n"
+	"uniform mat4 cViewProj;\n"
+	"out vec3 vNormal;\n"
+	"void main()\n"
+	"{\n"
+	"	mat4 skin = cJoints[aJoints.x] * aWeights.x + cJoints[aJoints.y] * aWeights.y +\n"
+	"				cJoints[aJoints.z] * aWeights.z + cJoints[aJoints.w] * aWeights.w;\n"
+	"	vNormal = mat3(skin) * aNormal;\n"
+	"	gl_Position = cViewProj * skin * vec4(aPos, 1.0);\n"
+	"}\n";
+
+static const char VERTEX_TBO[] =
+	"#version 330 core\n"
+	"layout (location = 0) in vec3 aPos;\n"
+	"layout (location = 1) in vec3 aNormal;\n"
+	"layout (location = 2) in uvec4 aJoints;\n"
+	"layout (location = 3) in vec4 aWeights;\n"
+	"uniform samplerBuffer sPalettes;\n"
+	"uniform int cJointsCount;\n"
+	"uniform mat4 cViewProj;\n"
+	"out vec3 vNormal;\n"
+	"mat4 joint(uint index)\n"
+	"{\n"
+	"	int texel = (gl_InstanceID * cJointsCount + int(index)) * 4;\n"
+	"	return mat4(texelFetch(sPalettes, texel), texelFetch(sPalettes, texel + 1),\n"
+	"				texelFetch(sPalettes, texel + 2), texelFetch(sPalettes, texel + 3));\n"
+	"}\n"
+	"void main()\n"
+	"{\n"
+	"	mat4 skin = joint(aJoints.x) * aWeights.x + joint(aJoints.y) * aWeights.y +\n"
+	"				joint(aJoints.z) * aWeights.z + joint(aJoints.w) * aWeights.w;\n"
+	"	vNormal = mat3(skin) * aNormal;\n"
+	"	gl_Position = cViewProj * skin * vec4(aPos, 1.0);\n"
+	"}\n";
+
+static const char FRAGMENT[] =
+	"#version 330 core\n"
+	"in vec3 vNormal;\n"
+	"out vec4 fColor;\n"
+	"void main()\n"
+	"{\n"
+	"	fColor = vec4(vec3(max(dot(normalize(vNormal), vec3(0.267, 0.802, 0.535)), 0.1)), 1.0);\n"
+	"}\n";
+
+static unsigned compile_shader(GLenum type, const char* source)
+{
+	char log[1024];
+	int status;
+	unsigned shader = glCreateShader(type);
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (!status)
+	{
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		fprintf(stderr, "skinbench: %s\n", log);
+		glDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+static unsigned create_benchmark_program(const char* vertex_source)
+{
+	char log[1024];
+	int status;
+	unsigned program, vertex, fragment;
+
+	vertex = compile_shader(GL_VERTEX_SHADER, vertex_source);
+	fragment = compile_shader(GL_FRAGMENT_SHADER, FRAGMENT);
+	if (!vertex || !fragment)
+	{
+		glDeleteShader(vertex);
+		glDeleteShader(fragment);
+		return 0;
+	}
+	program = glCreateProgram();
+	glAttachShader(program, vertex);
+	glAttachShader(program, fragment);
+	glLinkProgram(program);
+	glDeleteShader(vertex);
+	glDeleteShader(fragment);
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (!status)
+	{
+		glGetProgramInfoLog(program, sizeof(log), NULL, log);
+		fprintf(stderr, "skinbench: %s\n", log);
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+// Open tube with a joint every SEGMENT_LENGTH, rings blend between the
+// joints above and below them. Triangles are not culled.
+static void build_tentacle(struct skin_vertex* vertices, unsigned* indices)
+{
+	struct skin_vertex* vertex;
+	unsigned ring, side, segment, first, next, index = 0;
+	float angle, blend;
+
+	for (ring = 0; ring < RINGS_COUNT; ++ring)
+	{
+		segment = ring / SEGMENT_RINGS;
+		blend = (float)(ring % SEGMENT_RINGS) / SEGMENT_RINGS;
+		if (segment >= JOINTS_COUNT - 1)
+		{
+			segment = JOINTS_COUNT - 1;
+			blend = 0.0f;
+		}
+		for (side = 0; side < RING_SIDES; ++side)
+		{
+			angle = GLM_PIf * 2.0f * side / RING_SIDES;
+			vertex = &vertices[ring * RING_SIDES + side];
+			memset(vertex, 0, sizeof(struct skin_vertex));
+			vertex->position[0] = cosf(angle) * 0.1f;
+			vertex->position[1] = (float)ring * SEGMENT_LENGTH / SEGMENT_RINGS;
+			vertex->position[2] = sinf(angle) * 0.1f;
+			vertex->normal[0] = cosf(angle);
+			vertex->normal[2] = sinf(angle);
+			vertex->joints[0] = (unsigned char)segment;
+			vertex->joints[1] = (unsigned char)(blend > 0.0f ? segment + 1 : segment);
+			vertex->weights[0] = 1.0f - blend;
+			vertex->weights[1] = blend;
+		}
+	}
+	for (ring = 0; ring < RINGS_COUNT - 1; ++ring)
+		for (side = 0; side < RING_SIDES; ++side)
+		{
+			first = ring * RING_SIDES + side;
+			next = ring * RING_SIDES + (side + 1) % RING_SIDES;
+			indices[index++] = first;
+			indices[index++] = next;
+			indices[index++] = next + RING_SIDES;
+			indices[index++] = next + RING_SIDES;
+			indices[index++] = first + RING_SIDES;
+			indices[index++] = first;
+		}
+}
+
+static void build_sway_clip(struct animation_clip* clip)
+{
+	versor sway, bend;
+	float phase;
+	unsigned frame, joint;
+
+	for (frame = 0; frame < CLIP_FRAMES; ++frame)
+		for (joint = 0; joint < JOINTS_COUNT; ++joint)
+		{
+			phase = GLM_PIf * 2.0f * frame / CLIP_FRAMES;
+			glm_quatv(sway, 0.2f * sinf(phase + joint * 0.5f), GLM_ZUP);
+			glm_quatv(bend, 0.1f * cosf(phase + joint * 0.3f), GLM_XUP);
+			glm_quat_mul(sway, bend, clip->rotations[frame * JOINTS_COUNT + joint]);
+			glm_vec4_zero(clip->translations[frame * JOINTS_COUNT + joint]);
+			clip->translations[frame * JOINTS_COUNT + joint][1] = joint ? SEGMENT_LENGTH : 0.0f;
+		}
+}
+
+static double seconds_since(Uint64 start)
+{
+	return (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+int main(int argc, char** argv)
+{
+	struct skin_vertex vertices[MESH_VERTICES];
+	unsigned indices[MESH_INDICES];
+	unsigned char parents[JOINTS_COUNT];
+	mat4 binds[JOINTS_COUNT];
+	struct skeleton skeleton;
+	struct animation_clip clip;
+	float* times;
+	mat4* worlds;
+	mat4* palettes;
+	unsigned char* mapped;
+	unsigned vbo, ebo, stream, texture, vao, program;
+	unsigned i, count, frames, frame, side, palette_stride, frame_size;
+	int alignment, viewproj_location;
+	enum path path;
+	enum simd_isa isa;
+	mat4 proj, view, viewproj;
+	double animate_seconds, skin_seconds, frame_seconds;
+	Uint64 start, stage_start;
+
+	count = argc > 1 ? (unsigned)atoi(argv[1]) : 1024;
+	frames = argc > 2 ? (unsigned)atoi(argv[2]) : 100;
+	if (!count || !frames)
+	{
+		fprintf(stderr, "Usage: skinbench [characters] [frames]\n");
+		return 1;
+	}
+
+	if (SDL_Init(SDL_INIT_VIDEO) < 0)
+	{
+		fprintf(stderr, "skinbench: %s\n", SDL_GetError());
+		return 1;
+	}
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_Window* window = SDL_CreateWindow("skinbench", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+										  512, 512, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+	SDL_GLContext context = window ? SDL_GL_CreateContext(window) : NULL;
+	glewExperimental = GL_TRUE;
+	if (!context || glewInit() != GLEW_OK)
+	{
+		fprintf(stderr, "skinbench: %s\n", SDL_GetError());
+		if (context)
+			SDL_GL_DeleteContext(context);
+		if (window)
+			SDL_DestroyWindow(window);
+		SDL_Quit();
+		return 1;
+	}
+	SDL_GL_SetSwapInterval(0);
+
+	times = (float*)malloc(count * sizeof(float));
+	worlds = (mat4*)malloc(count * sizeof(mat4));
+	palettes = (mat4*)malloc(count * JOINTS_COUNT * sizeof(mat4));
+	for (i = 0; i < JOINTS_COUNT; ++i)
+	{
+		parents[i] = i ? (unsigned char)(i - 1) : SKELETON_ROOT;
+		glm_translate_make(binds[i], (vec3){ 0.0f, i * SEGMENT_LENGTH, 0.0f });
+	}
+	if (!times || !worlds || !palettes || !jobs_init(0) || !create_skeleton(&skeleton, parents, binds, JOINTS_COUNT) ||
+		!create_animation_clip(&clip, JOINTS_COUNT, CLIP_FRAMES, CLIP_FRAME_TIME))
+	{
+		fprintf(stderr, "skinbench: out of memory.\n");
+		return 1;
+	}
+	build_sway_clip(&clip);
+	build_tentacle(vertices, indices);
+
+	// Square field of tentacles seen from above, every one on screen
+	for (side = 1; side * side < count; ++side)
+		;
+	for (i = 0; i < count; ++i)
+	{
+		times[i] = (float)(i * 37 % 1500);
+		glm_translate_make(worlds[i], (vec3){ ((float)(i % side) - side * 0.5f) * FIELD_SPACING, 0.0f,
+											  ((float)(i / side) - side * 0.5f) * FIELD_SPACING });
+	}
+	glm_perspective(glm_rad(60.0f), 1.0f, 1.0f, side * FIELD_SPACING * 2.0f, proj);
+	glm_lookat((vec3){ 0.0f, side * FIELD_SPACING, side * FIELD_SPACING * 0.25f }, GLM_VEC3_ZERO, GLM_YUP, view);
+	glm_mat4_mul(proj, view, viewproj);
+
+	// Uniform blocks span SKELETON_MAX_JOINTS matrices at the uniform alignment
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	palette_stride = (SKELETON_MAX_JOINTS * sizeof(mat4) + alignment - 1) / alignment * alignment;
+
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	glGenBuffers(1, &ebo);
+	glGenBuffers(1, &stream);
+	glGenTextures(1, &texture);
+	glEnable(GL_DEPTH_TEST);
+	glViewport(0, 0, 512, 512);
+
+	printf("%u characters, %u joints, %u vertices each, %u frames, %u threads\n", count, JOINTS_COUNT, MESH_VERTICES, frames,
+		   jobs_thread_count());
+	for (path = PATH_CPU, isa = SIMD_BASELINE; path <= PATH_TBO;)
+	{
+		// The CPU path runs once per instruction set, the GPU ones with the widest
+		if (path == PATH_CPU && !simd_select(isa))
+		{
+			if (++isa == SIMD_ISA_COUNT)
+				path = PATH_UBO;
+			continue;
+		}
+		if (path != PATH_CPU)
+			simd_init();
+
+		program = create_benchmark_program(path == PATH_CPU ? VERTEX_CPU : path == PATH_UBO ? VERTEX_UBO : VERTEX_TBO);
+		if (!program)
+			break;
+		viewproj_location = glGetUniformLocation(program, "cViewProj");
+		glUseProgram(program);
+		glUniformMatrix4fv(viewproj_location, 1, GL_FALSE, viewproj[0]);
+		if (path == PATH_UBO)
+			glUniformBlockBinding(program, glGetUniformBlockIndex(program, "Palette"), 0);
+		else if (path == PATH_TBO)
+		{
+			glUniform1i(glGetUniformLocation(program, "sPalettes"), 0);
+			glUniform1i(glGetUniformLocation(program, "cJointsCount"), JOINTS_COUNT);
+		}
+
+		if (path == PATH_CPU)
+			frame_size = count * MESH_VERTICES * sizeof(struct skinned_vertex);
+		else if (path == PATH_UBO)
+			frame_size = count * palette_stride;
+		else
+			frame_size = count * JOINTS_COUNT * sizeof(mat4);
+
+		glGenVertexArrays(1, &vao);
+		glBindVertexArray(vao);
+		if (path == PATH_CPU)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, stream);
+			glBufferData(GL_ARRAY_BUFFER, frame_size, NULL, GL_STREAM_DRAW);
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(struct skinned_vertex), (void*)offsetof(struct skinned_vertex, position));
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(struct skinned_vertex), (void*)offsetof(struct skinned_vertex, normal));
+		}
+		else
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, vbo);
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(struct skin_vertex), (void*)offsetof(struct skin_vertex, position));
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(struct skin_vertex), (void*)offsetof(struct skin_vertex, normal));
+			glVertexAttribIPointer(2, 4, GL_UNSIGNED_BYTE, sizeof(struct skin_vertex), (void*)offsetof(struct skin_vertex, joints));
+			glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(struct skin_vertex), (void*)offsetof(struct skin_vertex, weights));
+			glEnableVertexAttribArray(2);
+			glEnableVertexAttribArray(3);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, stream);
+			glBufferData(GL_COPY_WRITE_BUFFER, frame_size, NULL, GL_STREAM_DRAW);
+		}
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+		if (path == PATH_TBO)
+		{
+			glBindTexture(GL_TEXTURE_BUFFER, texture);
+			glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, stream);
+		}
+
+		// Every frame animates, orphans and maps the stream buffer, skins
+		// or uploads into it and waits for the draws to finish
+		animate_seconds = 0.0;
+		skin_seconds = 0.0;
+		frame_seconds = 0.0;
+		for (frame = 0; frame < WARMUP_FRAMES + frames; ++frame)
+		{
+			start = SDL_GetPerformanceCounter();
+			for (i = 0; i < count; ++i)
+				times[i] += FRAME_TIME;
+			animate_characters(&skeleton, &clip, times, worlds, palettes, count);
+			if (frame >= WARMUP_FRAMES)
+				animate_seconds += seconds_since(start);
+
+			stage_start = SDL_GetPerformanceCounter();
+			glBindBuffer(GL_COPY_WRITE_BUFFER, stream);
+			glBufferData(GL_COPY_WRITE_BUFFER, frame_size, NULL, GL_STREAM_DRAW);
+			mapped = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, frame_size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+			if (path == PATH_CPU)
+				skin_characters(vertices, MESH_VERTICES, palettes, JOINTS_COUNT, (struct skinned_vertex*)mapped, count);
+			else if (path == PATH_UBO)
+				for (i = 0; i < count; ++i)
+					memcpy(mapped + i * palette_stride, palettes + i * JOINTS_COUNT, JOINTS_COUNT * sizeof(mat4));
+			else
+				memcpy(mapped, palettes, count * JOINTS_COUNT * sizeof(mat4));
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+			if (frame >= WARMUP_FRAMES)
+				skin_seconds += seconds_since(stage_start);
+
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			if (path == PATH_CPU)
+				for (i = 0; i < count; ++i)
+					glDrawElementsBaseVertex(GL_TRIANGLES, MESH_INDICES, GL_UNSIGNED_INT, 0, (int)(i * MESH_VERTICES));
+			else if (path == PATH_UBO)
+				for (i = 0; i < count; ++i)
+				{
+					glBindBufferRange(GL_UNIFORM_BUFFER, 0, stream, i * palette_stride, SKELETON_MAX_JOINTS * sizeof(mat4));
+					glDrawElements(GL_TRIANGLES, MESH_INDICES, GL_UNSIGNED_INT, 0);
+				}
+			else
+				glDrawElementsInstanced(GL_TRIANGLES, MESH_INDICES, GL_UNSIGNED_INT, 0, count);
+			glFinish();
+			if (frame >= WARMUP_FRAMES)
+				frame_seconds += seconds_since(start);
+		}
+
+		printf("%-4s %-8s %8.2f MB/frame, animate %8.2f ms, %-6s %8.2f ms, frame %8.2f ms\n",
+			   path == PATH_CPU ? "cpu" : path == PATH_UBO ? "ubo" : "tbo", simd_isa_name(simd_current()),
+			   frame_size / 1048576.0, animate_seconds * 1000.0 / frames, path == PATH_CPU ? "skin" : "upload",
+			   skin_seconds * 1000.0 / frames, frame_seconds * 1000.0 / frames);
+
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+		glUseProgram(0);
+		glBindVertexArray(0);
+		glDeleteVertexArrays(1, &vao);
+		glDeleteProgram(program);
+		if (path != PATH_CPU)
+			path = (enum path)(path + 1);
+		else if (++isa == SIMD_ISA_COUNT)
+			path = PATH_UBO;
+	}
+
+	glDeleteTextures(1, &texture);
+	glDeleteBuffers(1, &stream);
+	glDeleteBuffers(1, &ebo);
+	glDeleteBuffers(1, &vbo);
+	destroy_animation_clip(&clip);
+	jobs_shutdown();
+	free(palettes);
+	free(worlds);
+	free(times);
+	SDL_GL_DeleteContext(context);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+	return 0;
+}
@@ -0,0 +1,211 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Texture cooker: converts an image into a mipmapped, block compressed
+// texture loaded by load_texture().
+//
+// Usage: texcook [-f r8|rgb8|rgba8|bc1|bc3|bc4] [-m box|kaiser] [-linear]
+//                [-a <alpha reference>] <image> <output.tex>
+// Without -f the format is picked from the contents: BC3 when the alpha
+// channel is used, BC4 for greyscale images and BC1 otherwise.
+// Mipmaps are filtered in linear space with a Kaiser windowed sinc unless
+// -m box is given; -linear marks images that are not sRGB colour (masks,
+// specular maps) and -a keeps alpha test coverage constant across levels.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <SDL_timer.h>
+#include "../jobs.h"
+#include "../mipmap.h"
+#include "../simd.h"
+#include "../stb_image.h"
+#include "../texture_compress.h"
+
+static const char* FORMAT_NAMES[] = { "r8", "rgb8", "rgba8", "bc1", "bc3", "bc4" };
+static const char* FILTER_NAMES[] = { "box", "kaiser" };
+
+static unsigned find_name(const char* name, const char** names, unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; ++i)
+		if (!strcmp(name, names[i]))
+			return i;
+	return ~0u;
+}
+
+static unsigned detect_format(const unsigned char* image, unsigned pixels, unsigned channels)
+{
+	int grey = 1;
+	unsigned i;
+
+	for (i = 0; i < pixels; ++i)
+	{
+		if ((channels == 2 || channels == 4) && image[i * channels + channels - 1] != 255)
+			return TEXTURE_FORMAT_BC3;
+		if (channels >= 3 && (image[i * channels] != image[i * channels + 1] || image[i * channels] != image[i * channels + 2]))
+			grey = 0;
+	}
+	return grey ? TEXTURE_FORMAT_BC4 : TEXTURE_FORMAT_BC1;
+}
+
+int main(int argc, char** argv)
+{
+	struct texture_header header;
+	unsigned format = ~0u, filter = MIPMAP_FILTER_KAISER, flags = MIPMAP_SRGB;
+	unsigned width, height, channels, level, size, total = 0;
+	unsigned char *image, *chain, *mip, *data, *decompressed;
+	float alpha_reference = 0.5f;
+	double psnr = 0.0, seconds;
+	Uint64 start;
+	int arg = 1;
+
+	while (arg < argc && argv[arg][0] == '-')
+	{
+		if (!strcmp(argv[arg], "-linear"))
+		{
+			flags &= ~MIPMAP_SRGB;
+			++arg;
+			continue;
+		}
+		if (arg + 1 >= argc)
+			break;
+		if (!strcmp(argv[arg], "-f"))
+		{
+			format = find_name(argv[arg + 1], FORMAT_NAMES, sizeof(FORMAT_NAMES) / sizeof(FORMAT_NAMES[0]));
+			if (format == ~0u)
+			{
+				fprintf(stderr, "texcook: unknown format %s.\n", argv[arg + 1]);
+				return 1;
+			}
+		}
+		else if (!strcmp(argv[arg], "-m"))
+		{
+			filter = find_name(argv[arg + 1], FILTER_NAMES, sizeof(FILTER_NAMES) / sizeof(FILTER_NAMES[0]));
+			if (filter == ~0u)
+			{
+				fprintf(stderr, "texcook: unknown filter %s.\n", argv[arg + 1]);
+				return 1;
+			}
+		}
+		else if (!strcmp(argv[arg], "-a"))
+		{
+			alpha_reference = (float)atof(argv[arg + 1]);
+			flags |= MIPMAP_ALPHA_COVERAGE;
+		}
+		else
+			break;
+		arg += 2;
+	}
+	if (argc - arg != 2)
+	{
+		fprintf(stderr, "Usage: texcook [-f r8|rgb8|rgba8|bc1|bc3|bc4] [-m box|kaiser] [-linear] [-a <alpha reference>] <image> <output.tex>\n");
+		return 1;
+	}
+
+	int image_width, image_height, image_channels;
+	stbi_set_flip_vertically_on_load(1);
+	image = stbi_load(argv[arg], &image_width, &image_height, &image_channels, 0);
+	if (!image)
+	{
+		fprintf(stderr, "texcook: failed to load image %s: %s.\n", argv[arg], stbi_failure_reason());
+		return 1;
+	}
+	width = (unsigned)image_width;
+	height = (unsigned)image_height;
+	channels = (unsigned)image_channels;
+	if (format == ~0u)
+		format = detect_format(image, width * height, channels);
+
+	// Raw formats are stored with exactly their own channel count
+	if (!texture_format_compressed(format) && texture_format_channels(format) != channels)
+	{
+		fprintf(stderr, "texcook: image %s has %u channels, %s needs %u.\n", argv[arg], channels, FORMAT_NAMES[format], texture_format_channels(format));
+		stbi_image_free(image);
+		return 1;
+	}
+
+	memset(&header, 0, sizeof(header));
+	header.magic = TEXTURE_MAGIC;
+	header.format = format;
+	header.width = width;
+	header.height = height;
+	header.levels = mipmap_levels(width, height);
+	for (level = 0; level < header.levels; ++level)
+	{
+		header.sizes[level] = texture_level_size(format, width >> level ? width >> level : 1, height >> level ? height >> level : 1);
+		total += header.sizes[level];
+	}
+
+	jobs_init(0);
+	simd_init();
+	data = (unsigned char*)malloc(total);
+	chain = (unsigned char*)malloc(mipmap_chain_size(width, height, channels));
+
+	start = SDL_GetPerformanceCounter();
+	generate_mipmaps(chain, image, width, height, channels, filter, flags, alpha_reference);
+	for (level = 0, size = 0, mip = chain; level < header.levels; ++level)
+	{
+		const unsigned level_width = width >> level ? width >> level : 1;
+		const unsigned level_height = height >> level ? height >> level : 1;
+		if (texture_format_compressed(format))
+			compress_texture(data + size, mip, level_width, level_height, channels, format);
+		else
+			memcpy(data + size, mip, header.sizes[level]);
+		size += header.sizes[level];
+		mip += level_width * level_height * channels;
+	}
+	seconds = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+	jobs_shutdown();
+
+	if (texture_format_compressed(format))
+	{
+		decompressed = (unsigned char*)malloc(width * height * texture_format_channels(format));
+		decompress_texture(decompressed, data, width, height, format);
+		psnr = texture_psnr(decompressed, texture_format_channels(format), image, channels, width, height);
+		free(decompressed);
+	}
+
+	FILE* file = fopen(argv[arg + 1], "wb");
+	if (!file || fwrite(&header, sizeof(header), 1, file) != 1 || fwrite(data, 1, total, file) != total)
+	{
+		fprintf(stderr, "texcook: failed to write file %s.\n", argv[arg + 1]);
+		if (file)
+			fclose(file);
+		return 1;
+	}
+	fclose(file);
+
+	printf("%s: %ux%u %s, %u levels, %u bytes (%.1f:1)", argv[arg], width, height, FORMAT_NAMES[format], header.levels, total,
+		   (double)width * height * channels * 4.0 / 3.0 / (double)total);
+	if (texture_format_compressed(format))
+		printf(", PSNR %.2f dB, %.1f MB/s", psnr, (double)width * height * channels * 4.0 / 3.0 / seconds / (1024.0 * 1024.0));
+	printf("\n");
+
+	free(chain);
+	free(data);
+	stbi_image_free(image);
+	return 0;
+}
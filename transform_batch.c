@@ -0,0 +1,51 @@
+//
+// Copyright (c) 2021-2022 Yuriy Zinchenko.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "cglm/mat4.h"
+#include "cglm/vec3.h"
+#include "simd.h"
+#include "transform_batch.h"
+
+// Columns of the inverse transpose are the cross products of the other two
+// columns over the determinant, cheaper than a full inverse and transpose
+static void normal_matrix(mat4 model, mat3 normal)
+{
+	float det;
+	glm_vec3_cross(model[1], model[2], normal[0]);
+	glm_vec3_cross(model[2], model[0], normal[1]);
+	glm_vec3_cross(model[0], model[1], normal[2]);
+	det = glm_vec3_dot(model[0], normal[0]);
+	det = det != 0.0f ? 1.0f / det : 0.0f;
+	glm_vec3_scale(normal[0], det, normal[0]);
+	glm_vec3_scale(normal[1], det, normal[1]);
+	glm_vec3_scale(normal[2], det, normal[2]);
+}
+
+void batch_transforms(mat4 viewproj, mat4* models, mat4* mvps, mat3* normals, unsigned count)
+{
+	unsigned i;
+	simd_mat4_mul_left(viewproj, models, mvps, count);
+	if (normals)
+		for (i = 0; i < count; ++i)
+			normal_matrix(models[i], normals[i]);
+}